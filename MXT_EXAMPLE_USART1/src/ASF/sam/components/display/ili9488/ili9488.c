@@ -618,96 +618,133 @@ void ili9488_set_window(uint16_t x, uint16_t y, uint16_t width, uint16_t height
  * \return 0 if initialization succeeds, otherwise fails.
  */
 uint32_t ili9488_init(struct ili9488_opt_t *p_opt)
+{
+	uint32_t step = 0;
+	uint32_t wait_ms;
+	enum ili9488_init_status status;
+
+	do {
+		status = ili9488_init_step(p_opt, &step, &wait_ms);
+		ili9488_delay(wait_ms);
+	} while (status == ILI9488_INIT_BUSY);
+
+	return (status == ILI9488_INIT_DONE) ? 0 : 1;
+}
+
+/**
+ * \brief Run one step of the ILI9488 initialization.
+ *
+ * Lets the application overlap the reset and sleep-out waits of the LCD
+ * with other work instead of blocking inside ili9488_init().
+ *
+ * \param p_opt pointer to ILI9488 option structure.
+ * \param p_step step counter, must start at 0; advanced by this function.
+ * \param p_wait_ms time the caller must wait before the next step.
+ *
+ * \return ILI9488_INIT_BUSY while there are steps left, ILI9488_INIT_DONE
+ * when the LCD is ready or ILI9488_INIT_ERROR if the chip id is wrong.
+ */
+enum ili9488_init_status ili9488_init_step(struct ili9488_opt_t *p_opt,
+		uint32_t *p_step, uint32_t *p_wait_ms)
 {
 	ili9488_color_t param;
 	uint32_t chipid;
+
+	*p_wait_ms = 0;
+
+	switch (*p_step) {
+	case 0:
 #ifdef ILI9488_EBIMODE
-	/* Enable peripheral clock */
-	pmc_enable_periph_clk(ID_SMC);
-
-	/* Configure SMC, NCS3 is assigned to LCD */
-	smc_set_setup_timing(SMC, BOARD_ILI9488_EBI_NPCS, SMC_SETUP_NWE_SETUP(0)
-			| SMC_SETUP_NCS_WR_SETUP(0)
-			| SMC_SETUP_NRD_SETUP(0)
-			| SMC_SETUP_NCS_RD_SETUP(0));
-	smc_set_pulse_timing(SMC, BOARD_ILI9488_EBI_NPCS , SMC_PULSE_NWE_PULSE(3)
-			| SMC_PULSE_NCS_WR_PULSE(0x4)
-			| SMC_PULSE_NRD_PULSE(0xA)
-			| SMC_PULSE_NCS_RD_PULSE(0xA));
-	smc_set_cycle_timing(SMC, BOARD_ILI9488_EBI_NPCS, SMC_CYCLE_NWE_CYCLE(0x4)
-			| SMC_CYCLE_NRD_CYCLE(0xA));
-
-
-	smc_set_mode(SMC, BOARD_ILI9488_EBI_NPCS, SMC_MODE_READ_MODE
-			| SMC_MODE_WRITE_MODE
-			| SMC_MODE_DBW_16_BIT
-			| SMC_MODE_EXNW_MODE_DISABLED
-			| SMC_MODE_TDF_CYCLES(0xF));
+	{
+		/* Enable peripheral clock */
+		pmc_enable_periph_clk(ID_SMC);
+
+		/* Configure SMC, NCS3 is assigned to LCD */
+		smc_set_setup_timing(SMC, BOARD_ILI9488_EBI_NPCS, SMC_SETUP_NWE_SETUP(0)
+				| SMC_SETUP_NCS_WR_SETUP(0)
+				| SMC_SETUP_NRD_SETUP(0)
+				| SMC_SETUP_NCS_RD_SETUP(0));
+		smc_set_pulse_timing(SMC, BOARD_ILI9488_EBI_NPCS , SMC_PULSE_NWE_PULSE(3)
+				| SMC_PULSE_NCS_WR_PULSE(0x4)
+				| SMC_PULSE_NRD_PULSE(0xA)
+				| SMC_PULSE_NCS_RD_PULSE(0xA));
+		smc_set_cycle_timing(SMC, BOARD_ILI9488_EBI_NPCS, SMC_CYCLE_NWE_CYCLE(0x4)
+				| SMC_CYCLE_NRD_CYCLE(0xA));
+
+
+		smc_set_mode(SMC, BOARD_ILI9488_EBI_NPCS, SMC_MODE_READ_MODE
+				| SMC_MODE_WRITE_MODE
+				| SMC_MODE_DBW_16_BIT
+				| SMC_MODE_EXNW_MODE_DISABLED
+				| SMC_MODE_TDF_CYCLES(0xF));
+	}
 #endif
 #ifdef ILI9488_SPIMODE
-	struct spi_device ILI9488_SPI_DEVICE = {
-		// Board specific chip select configuration
-		.id = BOARD_ILI9488_SPI_NPCS
-	};
-
-	/* Init, select and configure the chip */
-	spi_master_init(BOARD_ILI9488_SPI);
-	spi_master_setup_device(BOARD_ILI9488_SPI, &ILI9488_SPI_DEVICE, SPI_MODE_3, ILI9488_SPI_BAUDRATE, 0);
-	spi_configure_cs_behavior(BOARD_ILI9488_SPI, BOARD_ILI9488_SPI_NPCS, SPI_CS_RISE_NO_TX);
-	spi_select_device(BOARD_ILI9488_SPI, &ILI9488_SPI_DEVICE);
-
-	/* Enable the SPI peripheral */
-	spi_enable(BOARD_ILI9488_SPI);
-	spi_enable_interrupt(BOARD_ILI9488_SPI, SPI_IER_RDRF);
+	{
+		struct spi_device ILI9488_SPI_DEVICE = {
+			// Board specific chip select configuration
+			.id = BOARD_ILI9488_SPI_NPCS
+		};
+
+		/* Init, select and configure the chip */
+		spi_master_init(BOARD_ILI9488_SPI);
+		spi_master_setup_device(BOARD_ILI9488_SPI, &ILI9488_SPI_DEVICE, SPI_MODE_3, ILI9488_SPI_BAUDRATE, 0);
+		spi_configure_cs_behavior(BOARD_ILI9488_SPI, BOARD_ILI9488_SPI_NPCS, SPI_CS_RISE_NO_TX);
+		spi_select_device(BOARD_ILI9488_SPI, &ILI9488_SPI_DEVICE);
+
+		/* Enable the SPI peripheral */
+		spi_enable(BOARD_ILI9488_SPI);
+		spi_enable_interrupt(BOARD_ILI9488_SPI, SPI_IER_RDRF);
+	}
 #endif
 
-	ili9488_write_register(ILI9488_CMD_SOFTWARE_RESET, 0x0000, 0);
-	ili9488_delay(200);
+		ili9488_write_register(ILI9488_CMD_SOFTWARE_RESET, 0x0000, 0);
+		*p_wait_ms = ILI9488_RESET_WAIT_MS;
+		break;
 
-	ili9488_write_register(ILI9488_CMD_SLEEP_OUT, 0x0000, 0);
-	ili9488_delay(200);
+	case 1:
+		ili9488_write_register(ILI9488_CMD_SLEEP_OUT, 0x0000, 0);
+		*p_wait_ms = ILI9488_SLEEP_OUT_WAIT_MS;
+		break;
 
-	/** read chipid */
-	chipid = ili9488_read_chipid();
-	if (chipid != ILI9488_DEVICE_CODE) {
-		return 1;
-	}
+	default:
+		/** read chipid */
+		chipid = ili9488_read_chipid();
+		if (chipid != ILI9488_DEVICE_CODE) {
+			return ILI9488_INIT_ERROR;
+		}
 
-	/** make it tRGB and reverse the column order */
-	param = 0x48;
-	ili9488_write_register(ILI9488_CMD_MEMORY_ACCESS_CONTROL, &param, 1);
-	ili9488_delay(100);
+		/** make it tRGB and reverse the column order */
+		param = 0x48;
+		ili9488_write_register(ILI9488_CMD_MEMORY_ACCESS_CONTROL, &param, 1);
 
-	param = 0x04;
-	ili9488_write_register(ILI9488_CMD_CABC_CONTROL_9, &param, 1);
-	ili9488_delay(100);
+		param = 0x04;
+		ili9488_write_register(ILI9488_CMD_CABC_CONTROL_9, &param, 1);
 #ifdef ILI9488_EBIMODE
-	/** Set ILI9488 Pixel Format in SMC mode.*/
-	param = 0x05;
-	ili9488_write_register(ILI9488_CMD_COLMOD_PIXEL_FORMAT_SET, &param, 1);
-	ili9488_delay(100);
-	ili9488_write_register(ILI9488_CMD_PARTIAL_MODE_ON, 0, 0);
-	ili9488_delay(100);
+		/** Set ILI9488 Pixel Format in SMC mode.*/
+		param = 0x05;
+		ili9488_write_register(ILI9488_CMD_COLMOD_PIXEL_FORMAT_SET, &param, 1);
+		ili9488_write_register(ILI9488_CMD_PARTIAL_MODE_ON, 0, 0);
 #endif
 #ifdef ILI9488_SPIMODE
-	param = 0x06;
-	ili9488_write_register(ILI9488_CMD_COLMOD_PIXEL_FORMAT_SET, &param, 1);
-	ili9488_delay(100);
-	ili9488_write_register(ILI9488_CMD_NORMAL_DISP_MODE_ON, 0, 0);
-	ili9488_delay(100);
+		param = 0x06;
+		ili9488_write_register(ILI9488_CMD_COLMOD_PIXEL_FORMAT_SET, &param, 1);
+		ili9488_write_register(ILI9488_CMD_NORMAL_DISP_MODE_ON, 0, 0);
 #endif
 
-	ili9488_display_on();
-	ili9488_delay(100);
+		ili9488_display_on();
 
-	ili9488_set_display_direction(PORTRAIT);
-	ili9488_delay(100);
+		ili9488_set_display_direction(PORTRAIT);
 
-	ili9488_set_window(0, 0,p_opt->ul_width,p_opt->ul_height);
-	ili9488_set_foreground_color(p_opt->foreground_color);
-	ili9488_set_cursor_position(0, 0);
+		ili9488_set_window(0, 0,p_opt->ul_width,p_opt->ul_height);
+		ili9488_set_foreground_color(p_opt->foreground_color);
+		ili9488_set_cursor_position(0, 0);
 
-	return 0;
+		return ILI9488_INIT_DONE;
+	}
+
+	(*p_step)++;
+	return ILI9488_INIT_BUSY;
 }
 
 /**
@@ -1478,6 +1515,42 @@ void ili9488_copy_pixels_from_screen(uint16_t *pixels, uint32_t count)
 #endif
 }
 
+/**
+ * \brief Read a rectangle of the GRAM with a single memory read command
+ *
+ * Unlike ili9488_copy_pixels_from_screen(), the whole rectangle comes back in
+ * one SPI transfer instead of one transfer per pixel.
+ *
+ * \param ul_x X coordinate of the upper-left corner.
+ * \param ul_y Y coordinate of the upper-left corner.
+ * \param ul_width Rectangle width.
+ * \param ul_height Rectangle height.
+ * \param p_rgb Destination, 3 bytes per pixel (R, G, B; 6 significant
+ * bits each, left aligned), ul_width * ul_height * 3 bytes.
+ */
+void ili9488_read_window(uint32_t ul_x, uint32_t ul_y, uint32_t ul_width,
+		uint32_t ul_height, uint8_t *p_rgb)
+{
+	ili9488_set_window(ul_x, ul_y, ul_width, ul_height);
+	ili9488_write_register(ILI9488_CMD_MEMORY_READ, 0x0000, 0);
+#ifdef ILI9488_SPIMODE
+	uint8_t dummy;
+	pio_set_pin_high(LCD_SPI_CDS_PIO);
+	/* The first data is dummy */
+	spi_read_packet(BOARD_ILI9488_SPI, &dummy, 1);
+	spi_read_packet(BOARD_ILI9488_SPI, p_rgb, ul_width * ul_height * 3);
+#endif
+#ifdef ILI9488_EBIMODE
+	pio_set(PIN_EBI_CDS_PIO, PIN_EBI_CDS_MASK);
+	for (uint32_t i = 0; i < ul_width * ul_height; i++) {
+		uint16_t color = LCD_RD();
+		*p_rgb++ = (color >> 8) & 0xF8;
+		*p_rgb++ = (color >> 3) & 0xFC;
+		*p_rgb++ = (color << 3) & 0xF8;
+	}
+#endif
+}
+
 /// @cond 0
 /**INDENT-OFF**/
 #ifdef __cplusplus
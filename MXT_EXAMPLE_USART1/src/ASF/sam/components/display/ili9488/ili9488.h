@@ -323,8 +323,23 @@ enum ili9488_display_direction{
 	PORTRAIT   = 1
 };
 
+/**
+ * Result of one ili9488_init_step() call
+ */
+enum ili9488_init_status{
+	ILI9488_INIT_BUSY  = 0,
+	ILI9488_INIT_DONE  = 1,
+	ILI9488_INIT_ERROR = 2
+};
+
+/** Wait after software reset before the next command (datasheet: 5 ms) */
+#define ILI9488_RESET_WAIT_MS       5
+/** Wait after sleep out before the display is stable (datasheet: 120 ms) */
+#define ILI9488_SLEEP_OUT_WAIT_MS   120
 
 uint32_t ili9488_init(struct ili9488_opt_t *p_opt);
+enum ili9488_init_status ili9488_init_step(struct ili9488_opt_t *p_opt,
+		uint32_t *p_step, uint32_t *p_wait_ms);
 void ili9488_set_display_direction(enum ili9488_display_direction direction);
 void ili9488_set_window( uint16_t dwX, uint16_t dwY, uint16_t dwWidth, uint16_t dwHeight );
 void ili9488_display_on(void);
@@ -361,6 +376,8 @@ void ili9488_set_orientation(uint8_t flags);
 void ili9488_copy_pixels_to_screen(const uint16_t *pixels,
 		uint32_t count);
 void ili9488_copy_pixels_from_screen(uint16_t *pixels, uint32_t count);
+void ili9488_read_window(uint32_t ul_x, uint32_t ul_y, uint32_t ul_width,
+		uint32_t ul_height, uint8_t *p_rgb);
 void ili9488_duplicate_pixel(const uint16_t color, uint32_t count);
 /// @cond 0
 /**INDENT-OFF**/
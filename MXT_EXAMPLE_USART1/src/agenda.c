@@ -0,0 +1,115 @@
+/*
+ * agenda.c
+ *
+ * Contas do inicio agendado (ver agenda.h).
+ */
+
+#include <stddef.h>
+#include "agenda.h"
+
+static const char *const nomes_modo[N_AGENDA_MODOS] = {
+	"INICIAR AS",
+	"TERMINAR AS",
+};
+
+void agenda_sugere(struct agenda *a, uint32_t agora_s)
+{
+	uint32_t m;
+
+	if (a->definido) {
+		return;
+	}
+	/* Arredonda para cima no passo da tela */
+	m = agora_s / 60 + AGENDA_SUGESTAO_MIN + AGENDA_PASSO_MIN - 1;
+	a->alvo_min = (m - m % AGENDA_PASSO_MIN) % AGENDA_DIA_MIN;
+	a->definido = true;
+}
+
+void agenda_ajusta(struct agenda *a, int passo_min)
+{
+	int32_t m = (int32_t)a->alvo_min + passo_min;
+
+	m %= (int32_t)AGENDA_DIA_MIN;
+	if (m < 0) {
+		m += AGENDA_DIA_MIN;
+	}
+	a->alvo_min = m;
+	a->definido = true;
+}
+
+void agenda_troca_modo(struct agenda *a)
+{
+	a->modo = (a->modo + 1) % N_AGENDA_MODOS;
+}
+
+static bool bissexto(uint16_t ano)
+{
+	return (ano % 4 == 0 && ano % 100 != 0) || ano % 400 == 0;
+}
+
+static uint8_t dias_no_mes(uint16_t ano, uint8_t mes)
+{
+	static const uint8_t dias[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+	if (mes == 2 && bissexto(ano)) {
+		return 29;
+	}
+	return mes >= 1 && mes <= 12 ? dias[mes - 1] : 31;
+}
+
+void agenda_amanha(struct agenda_data *d)
+{
+	if (d->dia < dias_no_mes(d->ano, d->mes)) {
+		d->dia++;
+		return;
+	}
+	d->dia = 1;
+	if (d->mes < 12) {
+		d->mes++;
+		return;
+	}
+	d->mes = 1;
+	d->ano++;
+}
+
+bool agenda_planeja(const struct agenda *a, uint32_t agora_s,
+		const struct agenda_data *hoje, uint32_t duracao_s, struct agenda_plano *p)
+{
+	/* Proxima vez que o relogio marca o horario; o instante de agora
+	 * conta como amanha */
+	uint32_t ate_alvo = (a->alvo_min * 60u + AGENDA_DIA_S - agora_s % AGENDA_DIA_S) % AGENDA_DIA_S;
+	uint32_t inicio_s;
+
+	if (ate_alvo == 0) {
+		ate_alvo = AGENDA_DIA_S;
+	}
+	if (a->modo == AGENDA_FIM) {
+		if (ate_alvo < duracao_s) {
+			return false;
+		}
+		p->espera_s = ate_alvo - duracao_s;
+	}
+	else {
+		p->espera_s = ate_alvo;
+	}
+	if (p->espera_s < AGENDA_ANTECEDENCIA_S) {
+		return false;
+	}
+
+	inicio_s = agora_s % AGENDA_DIA_S + p->espera_s;
+	p->data = *hoje;
+	if (inicio_s >= AGENDA_DIA_S) {
+		inicio_s -= AGENDA_DIA_S;
+		agenda_amanha(&p->data);
+	}
+	p->hora = inicio_s / 3600;
+	p->minuto = inicio_s / 60 % 60;
+	p->segundo = inicio_s % 60;
+	p->fim_min = (inicio_s + duracao_s + 59) / 60 % AGENDA_DIA_MIN;
+	return true;
+}
+
+const char *agenda_modo_nome(enum agenda_modo modo)
+{
+	return modo < N_AGENDA_MODOS ? nomes_modo[modo] : "?";
+}
@@ -0,0 +1,85 @@
+/*
+ * agenda.h
+ *
+ * Inicio agendado da lavagem: "iniciar as HH:MM" ou "terminar as HH:MM".
+ * O horario escolhido vira o instante de ligar (dia e hora do alarme do
+ * RTC); para terminar a tempo desconta a duracao prevista em segundos de
+ * relogio (estima_relogio_s). Um horario que ja passou hoje fica para
+ * amanha; terminar antes do que o programa leva, ou ligar antes de dar
+ * tempo de apagar a tela e dormir, e recusado.
+ *
+ * Aqui so ha as contas e o horario em edicao; o alarme e o sono ficam em
+ * sono.h. Nao depende do ASF.
+ */
+
+#ifndef AGENDA_H_
+#define AGENDA_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define AGENDA_DIA_S         86400u
+#define AGENDA_DIA_MIN       1440u
+
+/* Passo das teclas de minuto da tela */
+#define AGENDA_PASSO_MIN     5
+
+/* Espera minima: confirmar, apagar a tela e entrar no sono */
+#define AGENDA_ANTECEDENCIA_S  60
+
+/* Horario sugerido ao abrir a tela a primeira vez: daqui a tanto */
+#define AGENDA_SUGESTAO_MIN  60
+
+enum agenda_modo {
+	AGENDA_INICIO = 0,     // liga no horario
+	AGENDA_FIM,            // termina ate o horario
+	N_AGENDA_MODOS
+};
+
+struct agenda_data {
+	uint16_t ano;
+	uint8_t mes;           // 1-12
+	uint8_t dia;           // 1-31
+};
+
+/* Resultado das contas, pronto para o alarme */
+struct agenda_plano {
+	uint32_t espera_s;     // de agora ate ligar
+	struct agenda_data data;
+	uint8_t hora, minuto, segundo;
+	uint16_t fim_min;      // fim previsto, minutos do dia
+};
+
+struct agenda {
+	uint8_t modo;          // enum agenda_modo
+	uint16_t alvo_min;     // HH:MM escolhido, minutos do dia
+	bool definido;         // alvo_min ja foi sugerido ou escolhido
+};
+
+/** \brief Sugere um horario a partir de \a agora_s (segundos do dia) na primeira vez */
+void agenda_sugere(struct agenda *a, uint32_t agora_s);
+
+/** \brief Soma \a passo_min ao horario escolhido, dando a volta na meia-noite */
+void agenda_ajusta(struct agenda *a, int passo_min);
+
+void agenda_troca_modo(struct agenda *a);
+
+/**
+ * \brief Quando ligar para cumprir o horario de \a a.
+ *
+ * \param agora_s    segundos do dia no RTC
+ * \param hoje       data no RTC
+ * \param duracao_s  duracao prevista do programa, em segundos de relogio
+ *
+ * \return false se o programa nao termina ate o horario (AGENDA_FIM) ou
+ * se faltam menos de AGENDA_ANTECEDENCIA_S para ligar
+ */
+bool agenda_planeja(const struct agenda *a, uint32_t agora_s,
+		const struct agenda_data *hoje, uint32_t duracao_s, struct agenda_plano *p);
+
+/** \brief Dia seguinte, com ano bissexto */
+void agenda_amanha(struct agenda_data *d);
+
+const char *agenda_modo_nome(enum agenda_modo modo);
+
+#endif /* AGENDA_H_ */
@@ -0,0 +1,41 @@
+/*
+ * agua.c
+ *
+ * Modelo de enchimento e drenagem (ver agua.h).
+ */
+
+#include "agua.h"
+
+/* Uniforme em [0, 1), mesmo gerador do tambor.c */
+static float sorteia(struct agua *a)
+{
+	a->sorteio = a->sorteio * 1664525u + 1013904223u;
+	return (float)(a->sorteio >> 8) / 16777216.0f;
+}
+
+static float varia(struct agua *a)
+{
+	return 1.0f + AGUA_VARIACAO * (2.0f * sorteia(a) - 1.0f);
+}
+
+void agua_init(struct agua *a, float carga_kg, uint32_t semente)
+{
+	a->sorteio = semente;
+	a->pressao = AGUA_PRESSAO_MIN + (AGUA_PRESSAO_MAX - AGUA_PRESSAO_MIN) * sorteia(a);
+	a->bomba = AGUA_BOMBA_MIN + (1.0f - AGUA_BOMBA_MIN) * sorteia(a);
+	a->absorver_l = AGUA_ABSORCAO_L_KG * (carga_kg > 0.0f ? carga_kg : 0.0f);
+}
+
+uint32_t agua_enche_s(struct agua *a)
+{
+	float litros = AGUA_NIVEL_L + a->absorver_l;
+
+	/* Depois do primeiro enchimento a roupa ja esta encharcada */
+	a->absorver_l = 0.0f;
+	return (uint32_t)(litros / (AGUA_VAZAO_L_S * a->pressao) * varia(a) + 0.5f);
+}
+
+uint32_t agua_drena_s(struct agua *a)
+{
+	return (uint32_t)(AGUA_NIVEL_L / (AGUA_BOMBA_L_S * a->bomba) * varia(a) + 0.5f);
+}
@@ -0,0 +1,53 @@
+/*
+ * agua.h
+ *
+ * Modelo da agua para quando nao ha valvula, bomba nem sensor de nivel
+ * ligados: diz quanto tempo cada enchimento e cada drenagem levam, para
+ * as fases que terminam por sensor (ciclo.h).
+ *
+ * A pressao da rede muda de uma lavagem para outra e a roupa seca bebe
+ * agua no primeiro enchimento (mais com carga pesada); a bomba perde
+ * vazao com o filtro sujo. Cada operacao ainda varia um pouco.
+ */
+
+#ifndef AGUA_H_
+#define AGUA_H_
+
+#include <stdint.h>
+
+#ifndef AGUA_NIVEL_L
+#define AGUA_NIVEL_L         40.0f   // agua livre no nivel de lavagem
+#endif
+#ifndef AGUA_ABSORCAO_L_KG
+#define AGUA_ABSORCAO_L_KG   2.0f    // retida pela roupa molhada
+#endif
+#ifndef AGUA_VAZAO_L_S
+#define AGUA_VAZAO_L_S       0.4f    // valvula com a pressao nominal
+#endif
+#ifndef AGUA_BOMBA_L_S
+#define AGUA_BOMBA_L_S       0.7f
+#endif
+
+/* Pressao da rede (fracao da nominal) sorteada por lavagem */
+#define AGUA_PRESSAO_MIN     0.6f
+#define AGUA_PRESSAO_MAX     1.2f
+/* Filtro da bomba e variacao de cada operacao */
+#define AGUA_BOMBA_MIN       0.85f
+#define AGUA_VARIACAO        0.05f
+
+struct agua {
+	float pressao;
+	float bomba;
+	float absorver_l;      // que a roupa ainda vai reter
+	uint32_t sorteio;
+};
+
+void agua_init(struct agua *a, float carga_kg, uint32_t semente);
+
+/** \brief Segundos (do programa) ate o nivel de lavagem a partir de vazio */
+uint32_t agua_enche_s(struct agua *a);
+
+/** \brief Segundos para a bomba tirar a agua livre */
+uint32_t agua_drena_s(struct agua *a);
+
+#endif /* AGUA_H_ */
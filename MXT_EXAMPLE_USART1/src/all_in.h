@@ -7,15 +7,15 @@
 #include "conf_uart_serial.h"
 
 #define MAX_ENTRIES        3
-#define STRING_LENGTH     70
 #define USART_TX_MAX_LENGTH     0xff
 
 struct ili9488_opt_t g_ili9488_display_opt;
 
-#define YEAR        0
-#define MOUNTH      0
-#define DAY         0
-#define WEEK        0
+/* Data valida: o alarme de data do inicio agendado compara dia e mes */
+#define YEAR        2019
+#define MOUNTH      1
+#define DAY         1
+#define WEEK        2
 #define HOUR        0
 #define MINUTE      0
 #define SECONDS     0
\ No newline at end of file
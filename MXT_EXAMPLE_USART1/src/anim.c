@@ -0,0 +1,294 @@
+/*
+ * anim.c
+ *
+ * Motor de animacoes em ponto fixo (ver anim.h).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "anim.h"
+#include "widgets.h"
+#include "render.h"
+#include "sched.h"
+
+struct anim {
+	struct widget *w;
+	struct anim_stats *st;
+	uint32_t inicio_ms;
+	uint32_t dur_ms;
+	int32_t de;
+	int32_t para;
+	uint8_t prop;          // enum anim_prop
+	uint8_t easing;        // enum anim_easing
+	bool ativa;
+	bool no_quadro;        // mudou algo no quadro que esta sendo desenhado
+};
+
+static struct anim anims[ANIM_MAX];
+static struct anim_stats stats[ANIM_MAX_STATS];
+
+static uint32_t periodo_ms = ANIM_PERIODO_MS;
+static uint32_t degradacoes;
+static int tarefa = SCHED_INVALID;
+static bool quadro_pedido;
+
+q16_t anim_ease(enum anim_easing e, q16_t t)
+{
+	int64_t u;
+
+	if (t <= 0) return 0;
+	if (t >= ANIM_Q16_UM) return ANIM_Q16_UM;
+
+	switch (e) {
+		case ANIM_ENTRA:
+			return (q16_t)(((int64_t)t * t) >> 16);
+
+		case ANIM_SAI:
+			u = ANIM_Q16_UM - t;
+			return ANIM_Q16_UM - (q16_t)((u * u) >> 16);
+
+		case ANIM_ENTRA_SAI:
+			if (t < ANIM_Q16_UM / 2) {
+				/* 4 t^3 */
+				return (q16_t)((4 * (((int64_t)t * t) >> 16) * t) >> 16);
+			}
+			/* 1 - (2 - 2t)^3 / 2 */
+			u = 2 * (int64_t)(ANIM_Q16_UM - t);
+			return ANIM_Q16_UM - (q16_t)(((((u * u) >> 16) * u) >> 16) / 2);
+
+		default:
+			return t;
+	}
+}
+
+int32_t anim_lerp(int32_t de, int32_t para, q16_t k)
+{
+	return de + (int32_t)(((int64_t)(para - de) * k) >> 16);
+}
+
+uint32_t anim_lerp_cor(uint32_t de, uint32_t para, q16_t k)
+{
+	uint32_t cor = 0;
+
+	for (int s = 0; s < 24; s += 8) {
+		int32_t c = anim_lerp((de >> s) & 0xFF, (para >> s) & 0xFF, k);
+		cor |= (uint32_t)(c & 0xFF) << s;
+	}
+	return cor;
+}
+
+static struct anim_stats *stats_de(const char *nome)
+{
+	struct anim_stats *livre = NULL;
+
+	for (int i = 0; i < ANIM_MAX_STATS; i++) {
+		if (stats[i].nome != NULL && strcmp(stats[i].nome, nome) == 0) {
+			return &stats[i];
+		}
+		if (stats[i].nome == NULL && livre == NULL) {
+			livre = &stats[i];
+		}
+	}
+	if (livre != NULL) {
+		livre->nome = nome;
+	}
+	return livre;
+}
+
+static void aplica(struct anim *a, q16_t k)
+{
+	int32_t v = a->prop == ANIM_COR ? (int32_t)anim_lerp_cor(a->de, a->para, k)
+			: anim_lerp(a->de, a->para, k);
+	struct widget *w = a->w;
+
+	switch (a->prop) {
+		case ANIM_X:
+			widget_move(w, v, w->y);
+			break;
+		case ANIM_Y:
+			widget_move(w, w->x, v);
+			break;
+		case ANIM_COR:
+			widget_cor_set(w, v);
+			break;
+		case ANIM_CLIP:
+			widget_tamanho(w, v, w->h);
+			break;
+	}
+}
+
+static void passo(void *ctx)
+{
+	uint32_t agora = sched_now_ms();
+
+	UNUSED(ctx);
+	tarefa = SCHED_INVALID;
+
+	for (struct anim *a = anims; a < anims + ANIM_MAX; a++) {
+		if (!a->ativa) {
+			continue;
+		}
+		uint32_t dt = agora - a->inicio_ms;
+		q16_t t = dt >= a->dur_ms ? ANIM_Q16_UM
+				: (q16_t)(((uint64_t)dt << 16) / a->dur_ms);
+
+		aplica(a, anim_ease(a->easing, t));
+		a->no_quadro = true;
+		if (t == ANIM_Q16_UM) {
+			a->ativa = false;
+			if (a->st != NULL) {
+				a->st->execucoes++;
+			}
+		}
+	}
+
+	/* Mesmo sem widget sujo o render roda e devolve o quadro_feito */
+	quadro_pedido = true;
+	render_pede(RENDER_WIDGETS);
+}
+
+static void agenda(uint32_t atraso_ms)
+{
+	if (tarefa == SCHED_INVALID && !quadro_pedido) {
+		tarefa = sched_after("anim", atraso_ms, periodo_ms, SCHED_PRIO_HIGH, passo, NULL);
+	}
+}
+
+bool anim_start(const char *nome, struct widget *w, enum anim_prop prop,
+		int32_t de, int32_t para, uint32_t dur_ms, enum anim_easing e)
+{
+	struct anim *a = NULL;
+
+	if (w == NULL || prop >= N_ANIM_PROPS) {
+		return false;
+	}
+	if (!anim_ativa()) {
+		periodo_ms = ANIM_PERIODO_MS;
+	}
+
+	for (int i = 0; i < ANIM_MAX; i++) {
+		if (anims[i].ativa && anims[i].w == w && anims[i].prop == prop) {
+			a = &anims[i];
+			break;
+		}
+		if (!anims[i].ativa && a == NULL) {
+			a = &anims[i];
+		}
+	}
+	if (a == NULL) {
+		return false;
+	}
+
+	a->w = w;
+	a->st = stats_de(nome);
+	a->prop = prop;
+	a->easing = e < N_ANIM_EASING ? e : ANIM_LINEAR;
+	a->de = de;
+	a->para = para;
+	a->dur_ms = dur_ms > 0 ? dur_ms : 1;
+	a->inicio_ms = sched_now_ms();
+	a->ativa = true;
+	a->no_quadro = false;
+
+	aplica(a, 0);
+	agenda(periodo_ms);
+	return true;
+}
+
+void anim_cancela_todas(void)
+{
+	for (int i = 0; i < ANIM_MAX; i++) {
+		anims[i].ativa = false;
+		anims[i].no_quadro = false;
+	}
+	if (tarefa != SCHED_INVALID) {
+		sched_cancel(tarefa);
+		tarefa = SCHED_INVALID;
+	}
+	quadro_pedido = false;
+}
+
+bool anim_ativa(void)
+{
+	for (int i = 0; i < ANIM_MAX; i++) {
+		if (anims[i].ativa) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void anim_quadro_feito(uint32_t us)
+{
+	uint32_t orcamento_us = periodo_ms * 10 * ANIM_ORCAMENTO_PCT;
+
+	if (!quadro_pedido) {
+		return;
+	}
+	quadro_pedido = false;
+
+	for (struct anim *a = anims; a < anims + ANIM_MAX; a++) {
+		if (!a->no_quadro) {
+			continue;
+		}
+		a->no_quadro = false;
+		if (a->st != NULL) {
+			a->st->quadros++;
+			a->st->soma_us += us;
+			if (us > a->st->max_us) a->st->max_us = us;
+			if (us > orcamento_us) a->st->acima++;
+		}
+	}
+
+	/* Barramento saturado: menos quadros por segundo; folgado: volta */
+	if (us > orcamento_us && periodo_ms < ANIM_PERIODO_MAX_MS) {
+		periodo_ms *= 2;
+		if (periodo_ms > ANIM_PERIODO_MAX_MS) {
+			periodo_ms = ANIM_PERIODO_MAX_MS;
+		}
+		degradacoes++;
+	}
+	else if (us * 4 < orcamento_us && periodo_ms > ANIM_PERIODO_MS) {
+		periodo_ms /= 2;
+		if (periodo_ms < ANIM_PERIODO_MS) {
+			periodo_ms = ANIM_PERIODO_MS;
+		}
+	}
+
+	if (anim_ativa()) {
+		/* O quadro ja gastou parte do periodo */
+		uint32_t gasto_ms = us / 1000;
+		agenda(gasto_ms < periodo_ms ? periodo_ms - gasto_ms : 0);
+	}
+}
+
+uint32_t anim_periodo_ms(void)
+{
+	return periodo_ms;
+}
+
+void anim_stats_reset(void)
+{
+	for (int i = 0; i < ANIM_MAX_STATS; i++) {
+		const char *nome = stats[i].nome;
+		memset(&stats[i], 0, sizeof(stats[i]));
+		stats[i].nome = nome;
+	}
+	degradacoes = 0;
+}
+
+void anim_dump(void)
+{
+	printf("anim: periodo %lu ms, %lu reducoes de taxa\n\r",
+			(unsigned long)periodo_ms, (unsigned long)degradacoes);
+	for (int i = 0; i < ANIM_MAX_STATS; i++) {
+		const struct anim_stats *s = &stats[i];
+		if (s->nome == NULL) {
+			continue;
+		}
+		printf("  %-10s %4lu vezes %5lu quadros, medio %5lu us, pior %5lu us, %lu acima do orcamento\n\r",
+				s->nome, (unsigned long)s->execucoes, (unsigned long)s->quadros,
+				(unsigned long)(s->quadros ? s->soma_us / s->quadros : 0),
+				(unsigned long)s->max_us, (unsigned long)s->acima);
+	}
+}
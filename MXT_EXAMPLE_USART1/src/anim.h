@@ -0,0 +1,103 @@
+/*
+ * anim.h
+ *
+ * Animacoes de propriedades de widgets (posicao, cor, recorte) com
+ * interpolacao e curvas de easing em ponto fixo Q16.16, sem FPU.
+ *
+ * Cada passo so muda as propriedades; o desenho e feito pelo estagio de
+ * render (render.h) e apenas os widgets animados sao redesenhados. O
+ * proximo passo so e agendado depois que o quadro anterior terminou de
+ * sair pelo SPI: se o quadro ocupar o barramento mais que
+ * ANIM_ORCAMENTO_PCT do periodo, o periodo dobra (ate ANIM_PERIODO_MAX_MS).
+ * Como o progresso e calculado pelo tempo, a animacao so perde quadros
+ * intermediarios, nunca fica mais lenta.
+ */
+
+#ifndef ANIM_H_
+#define ANIM_H_
+
+#include <compiler.h>
+
+struct widget;
+
+#define ANIM_MAX             8
+#define ANIM_MAX_STATS       8
+
+#ifndef ANIM_PERIODO_MS
+#define ANIM_PERIODO_MS      20     // 50 quadros/s com o SPI livre
+#endif
+#ifndef ANIM_PERIODO_MAX_MS
+#define ANIM_PERIODO_MAX_MS  160
+#endif
+/* Fracao do periodo (%) que um quadro pode ocupar o SPI */
+#ifndef ANIM_ORCAMENTO_PCT
+#define ANIM_ORCAMENTO_PCT   60
+#endif
+
+/* Ponto fixo Q16.16: 1.0 = ANIM_Q16_UM */
+typedef int32_t q16_t;
+#define ANIM_Q16_UM          (1 << 16)
+
+enum anim_easing {
+	ANIM_LINEAR = 0,
+	ANIM_ENTRA,            // quadratica, comeca devagar
+	ANIM_SAI,              // quadratica, termina devagar
+	ANIM_ENTRA_SAI,        // cubica, devagar nas duas pontas
+	N_ANIM_EASING
+};
+
+enum anim_prop {
+	ANIM_X = 0,            // widget_move
+	ANIM_Y,
+	ANIM_COR,              // widget_cor_set, interpolada por canal RGB
+	ANIM_CLIP,             // largura visivel (widget_tamanho)
+	N_ANIM_PROPS
+};
+
+/* Estatisticas por nome de animacao (acumulam entre execucoes) */
+struct anim_stats {
+	const char *nome;
+	uint32_t execucoes;
+	uint32_t quadros;
+	uint32_t acima;        // quadros acima do orcamento
+	uint64_t soma_us;
+	uint32_t max_us;
+};
+
+/** \brief Curva de easing aplicada a t em [0, ANIM_Q16_UM] */
+q16_t anim_ease(enum anim_easing e, q16_t t);
+
+int32_t anim_lerp(int32_t de, int32_t para, q16_t k);
+
+/** \brief Interpola duas cores 0xRRGGBB canal a canal */
+uint32_t anim_lerp_cor(uint32_t de, uint32_t para, q16_t k);
+
+/**
+ * \brief Anima uma propriedade de um widget de \a de ate \a para.
+ *
+ * O valor inicial e aplicado na hora. Uma animacao da mesma propriedade
+ * do mesmo widget e substituida.
+ *
+ * \param nome  string constante, chave das estatisticas
+ * \return false se nao ha slot livre
+ */
+bool anim_start(const char *nome, struct widget *w, enum anim_prop prop,
+		int32_t de, int32_t para, uint32_t dur_ms, enum anim_easing e);
+
+/** \brief Para todas as animacoes (troca de tela: os widgets deixam de existir) */
+void anim_cancela_todas(void);
+
+bool anim_ativa(void);
+
+/**
+ * \brief Avisado pelo render ao fim de cada quadro, com o SPI ja vazio.
+ * Contabiliza o quadro, ajusta a taxa e agenda o proximo passo.
+ */
+void anim_quadro_feito(uint32_t us);
+
+uint32_t anim_periodo_ms(void);
+
+void anim_stats_reset(void);
+void anim_dump(void);
+
+#endif /* ANIM_H_ */
@@ -0,0 +1,130 @@
+/*
+ * boot.c
+ *
+ * Sequenciador de inicializacao (ver boot.h).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "boot.h"
+#include "latency.h"
+#include "trace.h"
+
+struct boot_event {
+	const char *task;     // NULL para marcos
+	const char *name;
+	uint32_t t_us;        // inicio, desde latency_init
+	uint32_t dur_us;
+	bool failed;
+};
+
+static struct boot_event events[BOOT_MAX_EVENTS];
+static uint8_t n_events;
+
+static uint32_t now_us(void)
+{
+	return latency_cycles_to_us(latency_now());
+}
+
+static void record(const char *task, const char *name, uint32_t t, uint32_t dur,
+		bool failed)
+{
+	if (n_events < BOOT_MAX_EVENTS) {
+		events[n_events].task = task;
+		events[n_events].name = name;
+		events[n_events].t_us = t;
+		events[n_events].dur_us = dur;
+		events[n_events].failed = failed;
+		n_events++;
+	}
+}
+
+bool boot_run(const struct boot_task *tasks, uint8_t n_tasks)
+{
+	uint8_t next[BOOT_MAX_TASKS] = {0};
+	uint32_t ready_at[BOOT_MAX_TASKS] = {0};
+	uint8_t pending = n_tasks;
+	bool ok = true;
+
+	if (n_tasks > BOOT_MAX_TASKS) {
+		return false;
+	}
+
+	while (pending) {
+		bool ran = false;
+
+		for (uint8_t i = 0; i < n_tasks; i++) {
+			const struct boot_task *task = &tasks[i];
+			const struct boot_step *step;
+			uint32_t t0, wait;
+
+			if (next[i] >= task->n_steps) {
+				continue;
+			}
+			t0 = now_us();
+			/* diferenca com sinal: sobrevive a volta do contador */
+			if ((int32_t)(t0 - ready_at[i]) < 0) {
+				continue;
+			}
+
+			step = &task->steps[next[i]];
+			wait = step->run(task->ctx);
+			record(task->name, step->name, t0, now_us() - t0, wait == BOOT_FAIL);
+			ran = true;
+
+			if (wait == BOOT_FAIL) {
+				TRACE("boot: %s/%s falhou", (uint32_t)task->name, (uint32_t)step->name);
+				ok = false;
+				next[i] = task->n_steps;
+			}
+			else {
+				next[i]++;
+				ready_at[i] = now_us() + wait * 1000;
+			}
+			if (next[i] >= task->n_steps) {
+				pending--;
+			}
+		}
+
+		/* Ninguem pronto: todos esperando o proprio prazo */
+		if (!ran) {
+			__NOP();
+		}
+	}
+	return ok;
+}
+
+void boot_milestone(const char *name)
+{
+	record(NULL, name, now_us(), 0, false);
+}
+
+uint32_t boot_milestone_us(const char *name)
+{
+	for (uint8_t i = 0; i < n_events; i++) {
+		if (events[i].task == NULL && strcmp(events[i].name, name) == 0) {
+			return events[i].t_us;
+		}
+	}
+	return 0;
+}
+
+void boot_print_timeline(void)
+{
+	printf("\n\r# boot (ms desde latency_init)\n\r");
+	for (uint8_t i = 0; i < n_events; i++) {
+		const struct boot_event *e = &events[i];
+		if (e->task == NULL) {
+			printf("%4lu.%01lu  ** %s\n\r",
+					(unsigned long)(e->t_us / 1000),
+					(unsigned long)(e->t_us / 100 % 10), e->name);
+		}
+		else {
+			printf("%4lu.%01lu  %-6s %-12s %6lu us%s\n\r",
+					(unsigned long)(e->t_us / 1000),
+					(unsigned long)(e->t_us / 100 % 10),
+					e->task, e->name, (unsigned long)e->dur_us,
+					e->failed ? "  FALHOU" : "");
+		}
+	}
+}
@@ -0,0 +1,55 @@
+/*
+ * boot.h
+ *
+ * Sequenciador de inicializacao: cada subsistema e uma lista de etapas
+ * que nao bloqueiam; cada etapa diz quanto tempo esperar antes da
+ * proxima. As esperas de um subsistema (ex.: sleep out do LCD) sao usadas
+ * para rodar etapas dos outros (ex.: leitura do info block do maXTouch).
+ *
+ * Todas as etapas ficam registradas numa linha do tempo que pode ser
+ * impressa depois que a USART estiver pronta.
+ */
+
+#ifndef BOOT_H_
+#define BOOT_H_
+
+#include <asf.h>
+
+/* Retorno de etapa: aborta as etapas restantes do subsistema */
+#define BOOT_FAIL        0xFFFFFFFFu
+
+#define BOOT_MAX_TASKS   4
+#define BOOT_MAX_EVENTS  24
+
+/* Numero de elementos de uma tabela de etapas/subsistemas */
+#define BOOT_N(tab)      (sizeof(tab) / sizeof((tab)[0]))
+
+struct boot_step {
+	const char *name;
+	/* Executa a etapa; retorna a espera (ms) antes da proxima ou BOOT_FAIL */
+	uint32_t (*run)(void *ctx);
+};
+
+struct boot_task {
+	const char *name;
+	const struct boot_step *steps;
+	uint8_t n_steps;
+	void *ctx;
+};
+
+/**
+ * \brief Roda todos os subsistemas intercalados ate o fim.
+ *
+ * \return false se alguma etapa falhou
+ */
+bool boot_run(const struct boot_task *tasks, uint8_t n_tasks);
+
+/** \brief Marca um ponto importante (ex.: tela inicial desenhada) */
+void boot_milestone(const char *name);
+
+/** \brief Tempo (us) desde latency_init em que o marco foi atingido, 0 se nao foi */
+uint32_t boot_milestone_us(const char *name);
+
+void boot_print_timeline(void);
+
+#endif /* BOOT_H_ */
@@ -1,3 +1,8 @@
+#ifndef BUTTONS_H_
+#define BUTTONS_H_
+
+#include "image_types.h"
+
 /** \brief Touch event struct */
 struct botao {
 	uint16_t x;
@@ -8,14 +13,24 @@ struct botao {
 	void (*p_handler)(void);
 };
 
-struct botao botaoLavagemDiaria;
-struct botao botaoLavagemPesada;
-struct botao botaoLavagemRapida;
-struct botao botaoDireita;
-struct botao botaoEsquerda;
-struct botao botaoLock;
-struct botao botaoUnlock;
-struct botao botaoHome;
-struct botao botaoPlayPause;
-struct botao botaoOk;
-struct botao imageNop;
\ No newline at end of file
+extern struct botao botaoLavagemDiaria;
+extern struct botao botaoLavagemPesada;
+extern struct botao botaoLavagemRapida;
+extern struct botao botaoLavagemEnxague;
+extern struct botao botaoLavagemCentrifuga;
+extern struct botao botaoLavagemUsuario;
+extern struct botao botaoDireita;
+extern struct botao botaoEsquerda;
+extern struct botao botaoLock;
+extern struct botao botaoUnlock;
+extern struct botao botaoHome;
+extern struct botao botaoPlayPause;
+extern struct botao botaoOk;
+extern struct botao imageNop;
+extern struct botao botaoEditar;
+extern struct botao botaoSalvar;
+extern struct botao botaoVoltar;
+extern struct botao botaoAgendar;
+extern struct botao botaoModo;
+
+#endif /* BUTTONS_H_ */
@@ -0,0 +1,316 @@
+/*
+ * ciclo.c
+ *
+ * Linha do tempo de um programa de lavagem (ver ciclo.h).
+ */
+
+#include <stddef.h>
+#include "ciclo.h"
+
+static const char *const nomes[N_FASE_TIPOS] = {
+	"ENCHENDO",
+	"LAVANDO",
+	"ENXAGUE",
+	"DRENANDO",
+	"DISTRIBUINDO",
+	"ACELERANDO",
+	"CENTRIFUGANDO",
+	"FREANDO",
+};
+
+static uint32_t min_s(int min)
+{
+	return min > 0 ? (uint32_t)min * 60 : 0;
+}
+
+static uint32_t rampa_s(int rpm, uint32_t acel)
+{
+	return rpm > 0 ? CICLO_RAMPA_S((uint32_t)rpm, acel) : 0;
+}
+
+static uint32_t sobe_s(int rpm, bool pesado)
+{
+	return rampa_s(rpm - CICLO_DISTRIBUI_RPM,
+			pesado ? CICLO_ACEL_PESADO_RPM_S : CICLO_ACEL_RPM_S);
+}
+
+/* Fases com o motor acelerando ou medindo andam em tempo real */
+static bool tempo_real(enum fase_tipo tipo)
+{
+	return tipo == FASE_DISTRIBUI || tipo == FASE_SOBE || tipo == FASE_DESCE;
+}
+
+/* Nivel da agua e rpm alcancado dizem quando acabam */
+static bool por_sensor(enum fase_tipo tipo)
+{
+	return tipo == FASE_ENCHE || tipo == FASE_DRENA ||
+			tipo == FASE_SOBE || tipo == FASE_DESCE;
+}
+
+uint8_t ciclo_expande(const t_ciclo *c, struct fase *fases, uint8_t max)
+{
+	uint8_t n = 0;
+	int enxagues = c->enxagueQnt;
+
+#define FASE(t, r, rpm_, dur) do {                                   \
+		if (n < max && (dur) > 0) {                                  \
+			fases[n].tipo = (t);                                     \
+			fases[n].rodada = (r);                                   \
+			fases[n].bolhas = c->bubblesOn && (t) == FASE_LAVA;      \
+			fases[n].pesado = c->heavy;                              \
+			fases[n].rpm = (rpm_);                                   \
+			fases[n].real = tempo_real(t);                           \
+			fases[n].externo = por_sensor(t);                        \
+			fases[n].dur_s = (dur);                                  \
+			fases[n].real_s = 0;                                     \
+			n++;                                                     \
+		}                                                            \
+	} while (0)
+
+	if (enxagues < 0) enxagues = 0;
+	if (enxagues > CICLO_MAX_ENXAGUES) enxagues = CICLO_MAX_ENXAGUES;
+
+	/* Lavagem principal: carga pesada lava o dobro do tempo do enxague.
+	 * Sem tempo de enxague (so centrifugacao) o tambor nem enche */
+	if (c->enxagueTempo > 0) {
+		FASE(FASE_ENCHE, 0, 0, CICLO_ENCHE_S);
+		FASE(FASE_LAVA, 0, 0, min_s(c->enxagueTempo) * (c->heavy ? 2 : 1));
+		FASE(FASE_DRENA, 0, 0, CICLO_DRENA_S);
+
+		for (int i = 1; i <= enxagues; i++) {
+			FASE(FASE_ENCHE, i, 0, CICLO_ENCHE_S);
+			FASE(FASE_ENXAGUE, i, 0, min_s(c->enxagueTempo));
+			FASE(FASE_DRENA, i, 0, CICLO_DRENA_S);
+		}
+	}
+
+	if (c->centrifugacaoRPM > 0 && c->centrifugacaoTempo > 0) {
+		FASE(FASE_DISTRIBUI, 0, CICLO_DISTRIBUI_RPM, CICLO_DISTRIBUI_S);
+		FASE(FASE_SOBE, 0, c->centrifugacaoRPM, sobe_s(c->centrifugacaoRPM, c->heavy));
+		FASE(FASE_CENTRIFUGA, 0, c->centrifugacaoRPM, min_s(c->centrifugacaoTempo));
+		FASE(FASE_DESCE, 0, c->centrifugacaoRPM, rampa_s(c->centrifugacaoRPM, CICLO_FREIO_RPM_S));
+	}
+#undef FASE
+
+	return n;
+}
+
+uint32_t ciclo_total_s(const t_ciclo *c)
+{
+	struct fase fases[CICLO_MAX_FASES];
+	uint8_t n = ciclo_expande(c, fases, CICLO_MAX_FASES);
+	uint32_t total = 0;
+
+	for (uint8_t i = 0; i < n; i++) {
+		total += fases[i].dur_s;
+	}
+	return total;
+}
+
+int ciclo_total_min(const t_ciclo *c)
+{
+	return (c->total_s + 59) / 60;
+}
+
+void ciclo_inicia(struct ciclo_exec *e, const t_ciclo *c, uint32_t escala)
+{
+	e->ciclo = c;
+	e->n_fases = ciclo_expande(c, e->fases, CICLO_MAX_FASES);
+	e->atual = 0;
+	e->n_enxagues = 0;
+	e->escala = escala > 0 ? escala : 1;
+	e->resto_ms = 0;
+	e->fase_s = 0;
+	e->feito_s = 0;
+	e->total_s = 0;
+	e->pausado = false;
+	for (uint8_t i = 0; i < e->n_fases; i++) {
+		e->total_s += e->fases[i].dur_s;
+		if (e->fases[i].rodada > e->n_enxagues) {
+			e->n_enxagues = e->fases[i].rodada;
+		}
+	}
+}
+
+bool ciclo_avanca_ms(struct ciclo_exec *e, uint32_t dt_ms)
+{
+	bool mudou = false;
+
+	if (e->pausado || ciclo_terminou(e)) {
+		return false;
+	}
+
+	/* Tempo real -> segundos do programa com a escala de cada fase, sem
+	 * perder a fracao */
+	while (dt_ms > 0 && !ciclo_terminou(e)) {
+		struct fase *f = &e->fases[e->atual];
+		uint32_t escala = f->real ? 1 : e->escala;
+		uint64_t fim_ms = UINT64_MAX;
+
+		/* Fase por sensor nao acaba pelo relogio */
+		if (!f->externo) {
+			uint64_t falta_ms = (uint64_t)(f->dur_s - e->fase_s) * 1000 - e->resto_ms;
+			fim_ms = (falta_ms + escala - 1) / escala;
+		}
+
+		if (dt_ms >= fim_ms) {
+			/* Fase acaba dentro do passo; o resto vai para a proxima */
+			e->feito_s += f->dur_s - e->fase_s;
+			f->real_s += f->dur_s - e->fase_s;
+			dt_ms -= (uint32_t)fim_ms;
+			e->atual++;
+			e->fase_s = 0;
+			e->resto_ms = 0;
+			mudou = true;
+		}
+		else {
+			uint64_t prog_ms = (uint64_t)dt_ms * escala + e->resto_ms;
+			uint32_t s = (uint32_t)(prog_ms / 1000);
+
+			/* Passou da nominal: o que exceder entra no total */
+			if (e->fase_s + s > f->dur_s) {
+				uint32_t desde = e->fase_s > f->dur_s ? e->fase_s : f->dur_s;
+				e->total_s += e->fase_s + s - desde;
+			}
+			e->fase_s += s;
+			e->feito_s += s;
+			f->real_s += s;
+			e->resto_ms = prog_ms % 1000;
+			dt_ms = 0;
+		}
+	}
+	if (ciclo_terminou(e)) {
+		e->resto_ms = 0;
+	}
+	return mudou;
+}
+
+void ciclo_pausa(struct ciclo_exec *e, bool pausado)
+{
+	e->pausado = pausado;
+}
+
+void ciclo_conclui_fase(struct ciclo_exec *e, uint32_t gasto_s)
+{
+	struct fase *f;
+	uint32_t contado, sobra;
+
+	if (ciclo_terminou(e)) {
+		return;
+	}
+	f = &e->fases[e->atual];
+	if (gasto_s > e->fase_s) {
+		gasto_s = e->fase_s;
+	}
+	sobra = e->fase_s - gasto_s;
+
+	/* No total a fase valia a nominal (ou o que ja passou dela) */
+	contado = e->fase_s > f->dur_s ? e->fase_s : f->dur_s;
+	e->total_s -= contado - gasto_s;
+	e->feito_s -= sobra;
+	f->real_s -= sobra;
+
+	e->atual++;
+	e->fase_s = 0;
+	e->resto_ms = 0;
+}
+
+void ciclo_repete_fase(struct ciclo_exec *e)
+{
+	if (ciclo_terminou(e)) {
+		return;
+	}
+	/* O que ja passou fica no total e a fase conta a nominal de novo */
+	e->total_s += e->fase_s > e->fases[e->atual].dur_s ?
+			e->fases[e->atual].dur_s : e->fase_s;
+	e->fase_s = 0;
+	e->resto_ms = 0;
+}
+
+void ciclo_limita_rpm(struct ciclo_exec *e, uint16_t rpm)
+{
+	for (uint8_t i = e->atual; i < e->n_fases; i++) {
+		struct fase *f = &e->fases[i];
+		uint32_t dur = f->dur_s;
+		uint32_t contado = i == e->atual && e->fase_s > dur ? e->fase_s : dur;
+
+		if (f->rpm <= rpm || (f->tipo != FASE_SOBE && f->tipo != FASE_CENTRIFUGA &&
+				f->tipo != FASE_DESCE)) {
+			continue;
+		}
+		f->rpm = rpm;
+		if (f->tipo == FASE_SOBE) {
+			dur = sobe_s(rpm, f->pesado);
+		}
+		else if (f->tipo == FASE_DESCE) {
+			dur = rampa_s(rpm, CICLO_FREIO_RPM_S);
+		}
+		/* Fase em andamento nao termina antes do que ja passou */
+		if (i == e->atual && dur < e->fase_s) {
+			dur = e->fase_s;
+		}
+		e->total_s = e->total_s - contado + dur;
+		f->dur_s = dur;
+	}
+}
+
+bool ciclo_terminou(const struct ciclo_exec *e)
+{
+	return e->ciclo == NULL || e->atual >= e->n_fases;
+}
+
+bool ciclo_rodando(const struct ciclo_exec *e)
+{
+	return !ciclo_terminou(e) && !e->pausado;
+}
+
+const struct fase *ciclo_fase(const struct ciclo_exec *e)
+{
+	return ciclo_terminou(e) ? NULL : &e->fases[e->atual];
+}
+
+uint32_t ciclo_restante_s(const struct ciclo_exec *e)
+{
+	return e->ciclo == NULL ? 0 : e->total_s - e->feito_s;
+}
+
+uint16_t ciclo_progresso(const struct ciclo_exec *e)
+{
+	if (e->ciclo == NULL || e->total_s == 0) {
+		return ciclo_terminou(e) && e->ciclo != NULL ? 1000 : 0;
+	}
+	return (uint16_t)((uint64_t)e->feito_s * 1000 / e->total_s);
+}
+
+uint16_t ciclo_fase_progresso(const struct ciclo_exec *e)
+{
+	const struct fase *f = ciclo_fase(e);
+
+	if (f == NULL || e->fase_s >= f->dur_s) {
+		return 1000;
+	}
+	return (uint16_t)((uint64_t)e->fase_s * 1000 / f->dur_s);
+}
+
+uint16_t ciclo_rpm(const struct ciclo_exec *e)
+{
+	const struct fase *f = ciclo_fase(e);
+
+	if (f == NULL || e->pausado) {
+		return 0;
+	}
+	switch (f->tipo) {
+		case FASE_DISTRIBUI:
+			return e->fase_s < CICLO_TOMBA_S ? 0 : f->rpm;
+		case FASE_SOBE:
+		case FASE_CENTRIFUGA:
+			return f->rpm;
+		default:
+			return 0;
+	}
+}
+
+const char *ciclo_fase_nome(enum fase_tipo tipo)
+{
+	return tipo < N_FASE_TIPOS ? nomes[tipo] : "?";
+}
@@ -0,0 +1,207 @@
+/*
+ * ciclo.h
+ *
+ * Execucao de um programa de lavagem. O t_ciclo e expandido numa linha do
+ * tempo de fases (encher, lavar, N enxagues com enchimento e drenagem,
+ * drenar, subida, centrifugacao e descida do motor) que anda com um tick
+ * monotonico em ms.
+ *
+ * Os tempos do t_ciclo sao em minutos do programa; a escala da execucao
+ * diz quantos segundos do programa passam por segundo real (60 = um
+ * minuto por segundo, como na demonstracao). As fases em que o motor
+ * acelera ou mede vibracao (distribuicao, subida e descida) andam sempre
+ * em tempo real, porque o tambor (motor.h) nao acelera com a escala.
+ *
+ * Encher, drenar e as rampas do motor terminam por sensor (nivel da agua,
+ * rpm alcancado) com ciclo_conclui_fase: a duracao delas e so a nominal,
+ * e a fase que passa dela aumenta o total. O tempo real de cada fase fica
+ * em fase.real_s para o estimador (estima.h).
+ * Nao depende do ASF: com uma escala grande um programa roda no host em
+ * milissegundos.
+ */
+
+#ifndef CICLO_H_
+#define CICLO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lavagens.h"
+
+#define CICLO_MAX_ENXAGUES   6
+/* encher + lavar + drenar + 3 por enxague + 4 da centrifugacao */
+#define CICLO_MAX_FASES      (7 + 3 * CICLO_MAX_ENXAGUES)
+
+/* Tempos fixos das fases hidraulicas, em segundos do programa */
+#ifndef CICLO_ENCHE_S
+#define CICLO_ENCHE_S        120
+#endif
+#ifndef CICLO_DRENA_S
+#define CICLO_DRENA_S        60
+#endif
+
+/* Aceleracao do tambor (rpm/s); cargas pesadas sobem mais devagar */
+#ifndef CICLO_ACEL_RPM_S
+#define CICLO_ACEL_RPM_S        20
+#endif
+#ifndef CICLO_ACEL_PESADO_RPM_S
+#define CICLO_ACEL_PESADO_RPM_S 10
+#endif
+#ifndef CICLO_FREIO_RPM_S
+#define CICLO_FREIO_RPM_S       40
+#endif
+/* Variacao maxima da aceleracao (rpm/s^2) nas rampas em S do motor */
+#ifndef CICLO_JERK_RPM_S2
+#define CICLO_JERK_RPM_S2       10
+#endif
+
+/*
+ * Distribuicao antes da centrifugacao: o tambor tomba parado por
+ * CICLO_TOMBA_S (a roupa cai e se espalha), sobe para CICLO_DISTRIBUI_RPM
+ * (roupa grudada na parede) e o desbalanceamento e medido (vibra.h).
+ */
+#ifndef CICLO_DISTRIBUI_RPM
+#define CICLO_DISTRIBUI_RPM  90
+#endif
+#ifndef CICLO_DISTRIBUI_S
+#define CICLO_DISTRIBUI_S    20
+#endif
+#ifndef CICLO_TOMBA_S
+#define CICLO_TOMBA_S        5
+#endif
+
+/* Segundos do programa por segundo real */
+#ifndef CICLO_ESCALA
+#define CICLO_ESCALA         60
+#endif
+
+/* Periodo da tarefa que anda a lavagem em main.c */
+#ifndef CICLO_TICK_MS
+#define CICLO_TICK_MS        250
+#endif
+
+/*
+ * Rampa em S de 0 ate rpm (ou de volta) com a aceleracao dada: rpm/a mais
+ * a/jerk para a aceleracao subir e descer, cada termo arredondado para
+ * cima. Mesma conta de rampa_duracao_ms (rampa.h) quando a chega no limite.
+ */
+#define CICLO_RAMPA_S(rpm, acel)  (((rpm) + (acel) - 1) / (acel) + \
+		((acel) + CICLO_JERK_RPM_S2 - 1) / CICLO_JERK_RPM_S2)
+
+/*
+ * Mesma conta de ciclo_expande, em expressao constante: o catalogo
+ * (lavagens.c) guarda o total pronto e confere os limites na compilacao.
+ */
+#define CICLO_TOTAL_S(enx_t, enx_n, rpm, cent_t, pesado)                       \
+	(((enx_t) > 0 ?                                                            \
+	  CICLO_ENCHE_S + (enx_t) * 60u * ((pesado) ? 2 : 1) + CICLO_DRENA_S +       \
+	  (enx_n) * (CICLO_ENCHE_S + (enx_t) * 60u + CICLO_DRENA_S) : 0u) +        \
+	 ((rpm) > 0 && (cent_t) > 0 ?                                              \
+	  CICLO_DISTRIBUI_S +                                                      \
+	  CICLO_RAMPA_S((rpm) - CICLO_DISTRIBUI_RPM,                               \
+			(pesado) ? CICLO_ACEL_PESADO_RPM_S : CICLO_ACEL_RPM_S) +              \
+	  (cent_t) * 60u + CICLO_RAMPA_S((rpm), CICLO_FREIO_RPM_S) : 0u))
+
+enum fase_tipo {
+	FASE_ENCHE = 0,
+	FASE_LAVA,
+	FASE_ENXAGUE,
+	FASE_DRENA,
+	FASE_DISTRIBUI,      // tomba, sobe a CICLO_DISTRIBUI_RPM e mede o desbalanceamento
+	FASE_SOBE,           // rampa da distribuicao ate o rpm da centrifugacao
+	FASE_CENTRIFUGA,
+	FASE_DESCE,          // rampa ate parar
+	N_FASE_TIPOS
+};
+
+struct fase {
+	uint8_t tipo;        // enum fase_tipo
+	uint8_t rodada;      // enxague 1..N (0 fora dos enxagues)
+	bool bolhas;         // smart bubbles ligado nesta fase
+	bool pesado;
+	uint16_t rpm;        // rpm alvo (rampas: rpm final da subida / inicial da descida)
+	bool real;           // anda em tempo real, sem a escala
+	bool externo;        // termina por sensor (ciclo_conclui_fase), dur_s e nominal
+	uint32_t dur_s;
+	uint32_t real_s;     // tempo gasto ate agora, com as repeticoes
+};
+
+struct ciclo_exec {
+	const t_ciclo *ciclo;
+	struct fase fases[CICLO_MAX_FASES];
+	uint8_t n_fases;
+	uint8_t atual;       // n_fases = terminou
+	uint8_t n_enxagues;
+	uint32_t escala;
+	uint32_t resto_ms;   // ms do programa que ainda nao viraram um segundo
+	uint32_t fase_s;     // segundos ja passados na fase atual
+	uint32_t feito_s;
+	uint32_t total_s;
+	bool pausado;
+};
+
+/**
+ * \brief Expande o programa em fases.
+ *
+ * \return numero de fases escritas (no maximo \a max)
+ */
+uint8_t ciclo_expande(const t_ciclo *c, struct fase *fases, uint8_t max);
+
+/** \brief Duracao total do programa, em segundos do programa (expande as fases) */
+uint32_t ciclo_total_s(const t_ciclo *c);
+
+/** \brief Duracao total (t_ciclo.total_s) arredondada para cima, em minutos */
+int ciclo_total_min(const t_ciclo *c);
+
+void ciclo_inicia(struct ciclo_exec *e, const t_ciclo *c, uint32_t escala);
+
+/**
+ * \brief Avanca \a dt_ms de tempo real.
+ *
+ * \return true se a fase mudou (ou o programa terminou)
+ */
+bool ciclo_avanca_ms(struct ciclo_exec *e, uint32_t dt_ms);
+
+void ciclo_pausa(struct ciclo_exec *e, bool pausado);
+
+/**
+ * \brief Sensor terminou a fase atual depois de \a gasto_s segundos nela.
+ *
+ * O tick passa do instante do sensor; a sobra (fase_s - gasto_s) e
+ * descartada, como se a fase tivesse acabado na hora certa.
+ */
+void ciclo_conclui_fase(struct ciclo_exec *e, uint32_t gasto_s);
+
+/**
+ * \brief Recomeca a fase atual (ex.: nova distribuicao da roupa). O tempo
+ * ja passado nela entra no total: o progresso nunca volta.
+ */
+void ciclo_repete_fase(struct ciclo_exec *e);
+
+/**
+ * \brief Limita o rpm das fases de centrifugacao que ainda nao passaram
+ * (carga desbalanceada). As rampas encurtam e o total e refeito.
+ */
+void ciclo_limita_rpm(struct ciclo_exec *e, uint16_t rpm);
+
+bool ciclo_rodando(const struct ciclo_exec *e);
+bool ciclo_terminou(const struct ciclo_exec *e);
+
+/** \brief Fase atual, NULL se terminou */
+const struct fase *ciclo_fase(const struct ciclo_exec *e);
+
+uint32_t ciclo_restante_s(const struct ciclo_exec *e);
+
+/** \brief Progresso do programa e da fase atual, em milesimos */
+uint16_t ciclo_progresso(const struct ciclo_exec *e);
+uint16_t ciclo_fase_progresso(const struct ciclo_exec *e);
+
+/**
+ * \brief Rpm alvo do tambor na fase atual (0 fora da centrifugacao, no
+ * tombamento, na descida e pausado). A rampa ate ele fica com o motor
+ * (motor.h).
+ */
+uint16_t ciclo_rpm(const struct ciclo_exec *e);
+
+const char *ciclo_fase_nome(enum fase_tipo tipo);
+
+#endif /* CICLO_H_ */
@@ -0,0 +1,29 @@
+/*
+ * conf_touch_filter.h
+ *
+ * Parametros padrao do filtro de toque (touch_filter.c).
+ */
+
+#ifndef CONF_TOUCH_FILTER_H_
+#define CONF_TOUCH_FILTER_H_
+
+/* Numero maximo de ids de toque acompanhados (T9 report ids) */
+#define TOUCH_FILTER_MAX_IDS        10
+
+/* Tamanho maximo da janela da mediana (impar) */
+#define TOUCH_FILTER_MAX_MEDIAN     5
+
+/* Janela da mediana usada por padrao (1 desliga) */
+#define TOUCH_FILTER_MEDIAN_N       3
+
+/* Ganho do IIR em q15: y += alpha * (x - y). 0x7FFF desliga a suavizacao */
+#define TOUCH_FILTER_IIR_ALPHA      0x4000
+
+/* Movimentos menores que isso (em unidades do maXTouch, 0-4095) sao
+ * ignorados */
+#define TOUCH_FILTER_JITTER         24
+
+/* Toques mais curtos que isso sao descartados como fantasmas */
+#define TOUCH_FILTER_MIN_PRESS_MS   30
+
+#endif /* CONF_TOUCH_FILTER_H_ */
@@ -0,0 +1,52 @@
+/*
+ * desbalanco.c
+ *
+ * FFT da vibracao e amplitude na rotacao do tambor (ver desbalanco.h).
+ */
+
+#include <arm_math.h>
+#include "desbalanco.h"
+
+static arm_rfft_fast_instance_f32 fft;
+static float32_t hann[DESBALANCO_N];
+static float32_t espectro[DESBALANCO_N];
+
+bool desbalanco_init(void)
+{
+	for (int i = 0; i < DESBALANCO_N; i++) {
+		hann[i] = 0.5f - 0.5f * arm_cos_f32(2.0f * PI * i / DESBALANCO_N);
+	}
+	return arm_rfft_fast_init_f32(&fft, DESBALANCO_N) == ARM_MATH_SUCCESS;
+}
+
+/* |X_k|^2 de um bin do formato do arm_rfft_fast (re, im a partir de k = 1) */
+static float32_t potencia(int k)
+{
+	if (k <= 0 || k >= DESBALANCO_N / 2) {
+		return 0.0f;
+	}
+	return espectro[2 * k] * espectro[2 * k] + espectro[2 * k + 1] * espectro[2 * k + 1];
+}
+
+float desbalanco_amplitude_g(float *amostras, float fs, float freq_hz)
+{
+	float32_t media;
+	int k = (int)(freq_hz * DESBALANCO_N / fs + 0.5f);
+
+	/* Sem a media (gravidade, offset do sensor) o DC nao vaza para a rotacao */
+	arm_mean_f32(amostras, DESBALANCO_N, &media);
+	arm_offset_f32(amostras, -media, amostras, DESBALANCO_N);
+	arm_mult_f32(amostras, hann, amostras, DESBALANCO_N);
+	arm_rfft_fast_f32(&fft, amostras, espectro, 0);
+
+	/*
+	 * A rotacao cai entre bins: soma a energia do bin mais proximo e dos
+	 * vizinhos. Uma senoide de amplitude A com Hann da sqrt(soma) = A N / 4
+	 * vezes sqrt(3/8) / (1/2) (~1,22) no lobulo principal.
+	 */
+	float32_t soma = potencia(k - 1) + potencia(k) + potencia(k + 1);
+	float32_t raiz;
+
+	arm_sqrt_f32(soma, &raiz);
+	return raiz * 4.0f / DESBALANCO_N / 1.2247449f;
+}
@@ -0,0 +1,50 @@
+/*
+ * desbalanco.h
+ *
+ * Analise de vibracao para detectar carga desbalanceada: uma janela de
+ * amostras do acelerometro passa por Hann e pela FFT real do CMSIS-DSP
+ * (arm_rfft_fast_f32, libarm_cortexM7lfsp_math_softfp) e a amplitude na
+ * frequencia de rotacao do tambor e comparada com um limiar.
+ *
+ * Massa desbalanceada gira junto com o tambor, entao a forca aparece em
+ * rpm/60 Hz; ruido e vibracao de outras fontes ficam fora desse bin.
+ * Depende so do arm_math.h.
+ */
+
+#ifndef DESBALANCO_H_
+#define DESBALANCO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Tamanho da FFT (potencia de 2 aceita pelo arm_rfft_fast) */
+#define DESBALANCO_N         256    // 1,28 s a VIBRA_HZ
+
+/* Amplitude na rotacao (g) acima da qual a carga e desbalanceada, medida
+ * a CICLO_DISTRIBUI_RPM. */
+#ifndef DESBALANCO_LIMIAR_G
+#define DESBALANCO_LIMIAR_G  0.02f
+#endif
+
+/* Novas distribuicoes antes de desistir da velocidade cheia */
+#ifndef DESBALANCO_TENTATIVAS
+#define DESBALANCO_TENTATIVAS 2
+#endif
+/* Centrifugacao com carga que continua desbalanceada */
+#ifndef DESBALANCO_RPM_SEGURO
+#define DESBALANCO_RPM_SEGURO 600
+#endif
+
+/** \brief Prepara a tabela da FFT e a janela de Hann */
+bool desbalanco_init(void);
+
+/**
+ * \brief Amplitude (g) da componente de \a freq_hz em \a amostras.
+ *
+ * \param amostras  DESBALANCO_N amostras em g; o vetor e usado como
+ *                  area de trabalho e volta destruido
+ * \param fs        taxa de amostragem (Hz)
+ */
+float desbalanco_amplitude_g(float *amostras, float fs, float freq_hz);
+
+#endif /* DESBALANCO_H_ */
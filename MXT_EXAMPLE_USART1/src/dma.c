@@ -0,0 +1,64 @@
+/*
+ * dma.c
+ *
+ * Apoio comum ao XDMAC (ver dma.h).
+ */
+
+#include "dma.h"
+
+static dma_callback_t callbacks[XDMACCHID_NUMBER];
+
+void dma_init(void)
+{
+	pmc_enable_periph_clk(ID_XDMAC);
+
+	NVIC_ClearPendingIRQ(XDMAC_IRQn);
+	NVIC_SetPriority(XDMAC_IRQn, 2);
+	NVIC_EnableIRQ(XDMAC_IRQn);
+}
+
+void dma_set_callback(uint8_t ch, dma_callback_t cb)
+{
+	callbacks[ch] = cb;
+}
+
+void dma_clean_dcache(const void *addr, uint32_t len)
+{
+	uint32_t start = (uint32_t)addr & ~(DMA_CACHE_LINE - 1);
+	uint32_t end = (uint32_t)addr + len;
+
+	__DSB();
+	for (uint32_t a = start; a < end; a += DMA_CACHE_LINE) {
+		SCB->DCCMVAC = a;
+	}
+	__DSB();
+	__ISB();
+}
+
+void dma_invalidate_dcache(const void *addr, uint32_t len)
+{
+	uint32_t start = (uint32_t)addr & ~(DMA_CACHE_LINE - 1);
+	uint32_t end = (uint32_t)addr + len;
+
+	/* Nesta versao do core_cm7.h o DCIMVAC (0x25C) se chama DCIMVAU */
+	__DSB();
+	for (uint32_t a = start; a < end; a += DMA_CACHE_LINE) {
+		SCB->DCIMVAU = a;
+	}
+	__DSB();
+	__ISB();
+}
+
+void XDMAC_Handler(void)
+{
+	uint32_t pending = XDMAC->XDMAC_GIS;
+
+	for (uint8_t ch = 0; pending; ch++, pending >>= 1) {
+		if (pending & 1) {
+			uint32_t status = XDMAC->XDMAC_CHID[ch].XDMAC_CIS;
+			if (callbacks[ch]) {
+				callbacks[ch](status);
+			}
+		}
+	}
+}
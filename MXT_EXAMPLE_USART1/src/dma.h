@@ -0,0 +1,67 @@
+/*
+ * dma.h
+ *
+ * Apoio comum ao XDMAC: despacho da interrupcao por canal e manutencao da
+ * D-Cache para buffers usados pelo DMA (a cache esta ligada em
+ * conf_board.h).
+ */
+
+#ifndef DMA_H_
+#define DMA_H_
+
+#include <asf.h>
+
+/* Canais do XDMAC usados pela aplicacao */
+#define DMA_CH_UART_TX    0
+#define DMA_CH_VIBRA      1
+
+/* Identificadores de periferico do XDMAC (datasheet SAME70, tabela 36-1) */
+#define DMA_PERID_USART1_TX   9
+#define DMA_PERID_USART1_RX   10
+#define DMA_PERID_AFEC0       35
+
+/* Linha da D-Cache do Cortex-M7 */
+#define DMA_CACHE_LINE    32
+
+/* Para declarar buffers que o DMA le ou escreve */
+#define DMA_ALIGNED       __attribute__((aligned(DMA_CACHE_LINE)))
+
+/*
+ * Descritor de lista encadeada, visao 1 (proximo descritor, tamanho do
+ * bloco e endereco de destino). O component/xdmac.h nao traz os campos
+ * do MBR_UBC.
+ */
+#define DMA_UBC_UBLEN(n)      ((uint32_t)(n) & 0xFFFFFFu)
+#define DMA_UBC_NDE           (1u << 24)   // busca o proximo descritor
+#define DMA_UBC_NSEN          (1u << 25)   // proximo atualiza a origem
+#define DMA_UBC_NDEN          (1u << 26)   // proximo atualiza o destino
+#define DMA_UBC_NVIEW_1       (1u << 27)
+
+struct dma_desc_v1 {
+	uint32_t mbr_nda;
+	uint32_t mbr_ubc;
+	uint32_t mbr_da;
+};
+
+typedef void (*dma_callback_t)(uint32_t status);
+
+void dma_init(void);
+
+/**
+ * \brief Registra a funcao chamada (na interrupcao) quando o canal \p ch
+ * gera alguma interrupcao habilitada. \p status e o XDMAC_CIS lido.
+ */
+void dma_set_callback(uint8_t ch, dma_callback_t cb);
+
+/** \brief Escreve da D-Cache para a RAM antes do DMA ler */
+void dma_clean_dcache(const void *addr, uint32_t len);
+
+/** \brief Descarta a D-Cache depois do DMA escrever */
+void dma_invalidate_dcache(const void *addr, uint32_t len);
+
+static inline bool dma_channel_busy(uint8_t ch)
+{
+	return (XDMAC->XDMAC_GS & (1u << ch)) != 0;
+}
+
+#endif /* DMA_H_ */
@@ -0,0 +1,289 @@
+/*
+ * estima.c
+ *
+ * Modelo de duracao das fases e tempo restante suavizado (ver estima.h).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "estima.h"
+
+/* FNV-1a dos campos que mudam a duracao: programa editado comeca do zero */
+static uint32_t chave(const t_ciclo *c)
+{
+	uint8_t campos[] = {
+		c->enxagueTempo, c->enxagueQnt,
+		(uint8_t)c->centrifugacaoRPM, (uint8_t)(c->centrifugacaoRPM >> 8),
+		c->centrifugacaoTempo, c->heavy,
+	};
+	uint32_t h = 2166136261u;
+
+	for (const char *p = c->nome; *p; p++) {
+		h = (h ^ (uint8_t)*p) * 16777619u;
+	}
+	for (unsigned i = 0; i < sizeof(campos); i++) {
+		h = (h ^ campos[i]) * 16777619u;
+	}
+	return h != 0 ? h : 1;
+}
+
+static const struct estima_programa *procura(const struct estima_modelo *m, uint32_t k)
+{
+	for (int i = 0; i < ESTIMA_MAX_PROGRAMAS; i++) {
+		if (m->prog[i].chave == k) {
+			return &m->prog[i];
+		}
+	}
+	return NULL;
+}
+
+/* Programa novo toma o lugar do que tem menos execucoes */
+static struct estima_programa *reserva(struct estima_modelo *m, uint32_t k)
+{
+	struct estima_programa *p = (struct estima_programa *)procura(m, k);
+
+	if (p != NULL) {
+		return p;
+	}
+	p = &m->prog[0];
+	for (int i = 1; i < ESTIMA_MAX_PROGRAMAS && p->chave != 0; i++) {
+		if (m->prog[i].chave == 0 || m->prog[i].execucoes < p->execucoes) {
+			p = &m->prog[i];
+		}
+	}
+	memset(p, 0, sizeof(*p));
+	p->chave = k;
+	for (int t = 0; t < N_FASE_TIPOS; t++) {
+		p->razao[t] = ESTIMA_UM;
+	}
+	return p;
+}
+
+void estima_modelo_init(struct estima_modelo *m)
+{
+	memset(m, 0, sizeof(*m));
+	m->versao = ESTIMA_VERSAO;
+	m->tamanho = sizeof(*m);
+}
+
+bool estima_modelo_valido(const struct estima_modelo *m)
+{
+	return m->versao == ESTIMA_VERSAO && m->tamanho == sizeof(*m);
+}
+
+static uint32_t aplica(uint32_t nominal_s, uint16_t razao)
+{
+	return (uint32_t)(((uint64_t)nominal_s * razao + ESTIMA_UM / 2) / ESTIMA_UM);
+}
+
+uint32_t estima_previsto_s(const struct estima_modelo *m, const t_ciclo *c)
+{
+	return estima_relogio_s(m, c, 1);
+}
+
+uint32_t estima_relogio_s(const struct estima_modelo *m, const t_ciclo *c, uint32_t escala)
+{
+	struct fase fases[CICLO_MAX_FASES];
+	const struct estima_programa *p = procura(m, chave(c));
+	uint8_t n = ciclo_expande(c, fases, CICLO_MAX_FASES);
+	uint32_t escalado = 0, real = 0;
+
+	for (uint8_t i = 0; i < n; i++) {
+		uint32_t s = p != NULL ? aplica(fases[i].dur_s, p->razao[fases[i].tipo]) : fases[i].dur_s;
+
+		if (fases[i].real) {
+			real += s;
+		}
+		else {
+			escalado += s;
+		}
+	}
+	if (escala == 0) {
+		escala = 1;
+	}
+	return real + (escalado + escala - 1) / escala;
+}
+
+/* Razao para as fases que faltam: o que esta execucao ja mediu pesa metade */
+static uint16_t razao(const struct estima *s, uint8_t tipo)
+{
+	uint16_t modelo = s->prog->execucoes > 0 ? s->prog->razao[tipo] : 0;
+	uint32_t agora;
+
+	if (s->soma_nominal[tipo] == 0) {
+		return modelo > 0 ? modelo : ESTIMA_UM;
+	}
+	agora = (uint32_t)((uint64_t)s->soma_real[tipo] * ESTIMA_UM / s->soma_nominal[tipo]);
+	if (agora > UINT16_MAX) {
+		agora = UINT16_MAX;
+	}
+	return modelo > 0 ? (uint16_t)((agora + modelo) / 2) : (uint16_t)agora;
+}
+
+static void soma_fases(struct estima *s, const struct ciclo_exec *e)
+{
+	for (; s->contadas < e->atual && s->contadas < e->n_fases; s->contadas++) {
+		const struct fase *f = &e->fases[s->contadas];
+		s->soma_real[f->tipo] += f->real_s;
+		s->soma_nominal[f->tipo] += f->dur_s;
+	}
+}
+
+void estima_inicia(struct estima *s, struct estima_modelo *m, const struct ciclo_exec *e)
+{
+	memset(s, 0, sizeof(*s));
+	s->modelo = m;
+	s->prog = reserva(m, chave(e->ciclo));
+	s->feito_s = e->feito_s;
+	s->fixo_s = e->total_s;
+	s->previsto_s = estima_restante_s(s, e);
+	s->mostrado_s = s->previsto_s;
+}
+
+uint32_t estima_restante_s(const struct estima *s, const struct ciclo_exec *e)
+{
+	uint32_t total = 0;
+
+	for (uint8_t i = e->atual; i < e->n_fases; i++) {
+		const struct fase *f = &e->fases[i];
+		uint32_t esperado = aplica(f->dur_s, razao(s, f->tipo));
+
+		if (i == e->atual) {
+			esperado = esperado > e->fase_s ? esperado - e->fase_s : 0;
+			/* Fase de relogio nao acaba antes da hora */
+			if (!f->externo && f->dur_s > e->fase_s && esperado < f->dur_s - e->fase_s) {
+				esperado = f->dur_s - e->fase_s;
+			}
+		}
+		total += esperado;
+	}
+	return total;
+}
+
+uint32_t estima_atualiza(struct estima *s, const struct ciclo_exec *e)
+{
+	/* Fase terminada por sensor devolve a sobra do tick: feito_s pode voltar */
+	uint32_t dt = e->feito_s > s->feito_s ? e->feito_s - s->feito_s : 0;
+	uint32_t alvo, passo;
+
+	s->feito_s = e->feito_s;
+	soma_fases(s, e);
+	if (ciclo_terminou(e)) {
+		s->mostrado_s = 0;
+		return 0;
+	}
+
+	alvo = estima_restante_s(s, e);
+	s->mostrado_s = s->mostrado_s > dt ? s->mostrado_s - dt : 0;
+	if (alvo > s->mostrado_s) {
+		/* No maximo para o relogio */
+		passo = alvo - s->mostrado_s;
+		s->mostrado_s += passo < dt ? passo : dt;
+	}
+	else {
+		passo = s->mostrado_s - alvo;
+		if (passo > dt * ESTIMA_CORRECAO_PCT / 100) {
+			passo = dt * ESTIMA_CORRECAO_PCT / 100;
+		}
+		s->mostrado_s -= passo;
+	}
+
+	/* Marcas igualmente espacadas no tempo previsto no inicio */
+	while (s->n_marcas < ESTIMA_MARCAS &&
+			e->feito_s >= s->previsto_s * s->n_marcas / ESTIMA_MARCAS) {
+		s->marca_feito[s->n_marcas] = e->feito_s;
+		s->marca_mostrado[s->n_marcas] = s->mostrado_s;
+		s->n_marcas++;
+	}
+	return s->mostrado_s;
+}
+
+uint16_t estima_progresso(const struct estima *s, const struct ciclo_exec *e)
+{
+	uint32_t total = e->feito_s + s->mostrado_s;
+
+	if (ciclo_terminou(e)) {
+		return 1000;
+	}
+	return total > 0 ? (uint16_t)((uint64_t)e->feito_s * 1000 / total) : 0;
+}
+
+static uint32_t distancia(uint32_t a, uint32_t b)
+{
+	return a > b ? a - b : b - a;
+}
+
+void estima_fim(struct estima *s, const struct ciclo_exec *e)
+{
+	struct estima_programa *p = s->prog;
+	struct estima_stats *st = &s->modelo->stats;
+	uint32_t fim = e->feito_s;
+
+	soma_fases(s, e);
+
+	/* Media movel por tipo de fase; a primeira execucao entra inteira */
+	for (int t = 0; t < N_FASE_TIPOS; t++) {
+		if (s->soma_nominal[t] == 0) {
+			continue;
+		}
+		uint64_t r = (uint64_t)s->soma_real[t] * ESTIMA_UM / s->soma_nominal[t];
+		int32_t medido = r > UINT16_MAX ? UINT16_MAX : (int32_t)r;
+
+		if (p->execucoes == 0) {
+			p->razao[t] = (uint16_t)medido;
+		}
+		else {
+			p->razao[t] = (uint16_t)(p->razao[t] +
+					(medido - p->razao[t]) * ESTIMA_ALFA_PCT / 100);
+		}
+	}
+	if (p->execucoes < UINT16_MAX) {
+		p->execucoes++;
+	}
+
+	st->execucoes++;
+	st->soma_erro_ini_s += distancia(s->previsto_s, fim);
+	for (uint8_t i = 0; i < s->n_marcas; i++) {
+		uint32_t real = fim - s->marca_feito[i];
+		uint32_t fixo = s->fixo_s > s->marca_feito[i] ? s->fixo_s - s->marca_feito[i] : 0;
+		uint32_t erro = distancia(s->marca_mostrado[i], real);
+
+		st->marcas++;
+		st->soma_erro_s += erro;
+		st->soma_vies_s += (int32_t)s->marca_mostrado[i] - (int32_t)real;
+		st->soma_erro_fixo_s += distancia(fixo, real);
+		if (erro > st->pior_s) {
+			st->pior_s = erro;
+		}
+	}
+}
+
+void estima_stats_reset(struct estima_modelo *m)
+{
+	memset(&m->stats, 0, sizeof(m->stats));
+}
+
+void estima_dump(const struct estima_modelo *m)
+{
+	const struct estima_stats *st = &m->stats;
+	uint32_t n = st->marcas ? st->marcas : 1;
+	uint32_t x = st->execucoes ? st->execucoes : 1;
+
+	printf("estima: %lu execucoes, erro medio %lu s (vies %ld s, pior %lu s), "
+			"contagem fixa %lu s, previsto no inicio %lu s\n\r",
+			(unsigned long)st->execucoes, (unsigned long)(st->soma_erro_s / n),
+			(long)(st->soma_vies_s / (int32_t)n), (unsigned long)st->pior_s,
+			(unsigned long)(st->soma_erro_fixo_s / n),
+			(unsigned long)(st->soma_erro_ini_s / x));
+	for (int i = 0; i < ESTIMA_MAX_PROGRAMAS; i++) {
+		const struct estima_programa *p = &m->prog[i];
+		if (p->chave == 0) {
+			continue;
+		}
+		printf("  %08lx %3u x, real/nominal %%:", (unsigned long)p->chave, p->execucoes);
+		for (int t = 0; t < N_FASE_TIPOS; t++) {
+			printf(" %lu", (unsigned long)((p->razao[t] * 100 + ESTIMA_UM / 2) / ESTIMA_UM));
+		}
+		printf("\n\r");
+	}
+}
@@ -0,0 +1,120 @@
+/*
+ * estima.h
+ *
+ * Estimativa do tempo que falta na lavagem. Encher, drenar e as rampas
+ * duram o que a agua e o motor deixarem (ciclo.h); cada execucao mede o
+ * tempo real de cada tipo de fase contra o nominal e o modelo guarda,
+ * por programa, a razao real/nominal em media movel exponencial. Dentro
+ * da execucao as fases ja medidas corrigem as proximas do mesmo tipo.
+ *
+ * O tempo mostrado nao salta: anda com o relogio do programa e so e
+ * puxado para a estimativa ate ESTIMA_CORRECAO_PCT mais rapido, ou para
+ * (nunca volta) quando a estimativa cresce. O erro do mostrado contra o
+ * fim real e medido em ESTIMA_MARCAS pontos de cada execucao, junto com o
+ * erro da contagem fixa antiga, e acumulado em estima_stats.
+ *
+ * O estima_modelo e um bloco de tamanho fixo com versao, para ser gravado
+ * inteiro. Nao depende do ASF.
+ */
+
+#ifndef ESTIMA_H_
+#define ESTIMA_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ciclo.h"
+
+#define ESTIMA_VERSAO        1
+#define ESTIMA_MAX_PROGRAMAS 8
+
+/* Razao real/nominal em Q12: ESTIMA_UM = 1.0 */
+#define ESTIMA_UM            4096
+
+/* Peso (%) da execucao nova na media do programa */
+#ifndef ESTIMA_ALFA_PCT
+#define ESTIMA_ALFA_PCT      25
+#endif
+/* O mostrado anda entre parado e (100 + ESTIMA_CORRECAO_PCT)% do relogio */
+#ifndef ESTIMA_CORRECAO_PCT
+#define ESTIMA_CORRECAO_PCT  50
+#endif
+#define ESTIMA_MARCAS        10
+
+struct estima_programa {
+	uint32_t chave;        // hash dos parametros do t_ciclo, 0 = livre
+	uint16_t execucoes;
+	uint16_t razao[N_FASE_TIPOS];
+};
+
+/* Erros em segundos do programa, acumulados entre execucoes */
+struct estima_stats {
+	uint32_t execucoes;
+	uint32_t marcas;
+	uint32_t soma_erro_s;      // |mostrado - real| nas marcas
+	int32_t soma_vies_s;       // mostrado - real (positivo = pessimista)
+	uint32_t pior_s;
+	uint32_t soma_erro_fixo_s; // mesma conta com a contagem fixa
+	uint32_t soma_erro_ini_s;  // |previsto no inicio - total real|
+};
+
+struct estima_modelo {
+	uint16_t versao;
+	uint16_t tamanho;          // sizeof, confere o bloco lido
+	struct estima_programa prog[ESTIMA_MAX_PROGRAMAS];
+	struct estima_stats stats;
+};
+
+/* Estado de uma execucao */
+struct estima {
+	struct estima_modelo *modelo;
+	struct estima_programa *prog;
+	uint32_t soma_real[N_FASE_TIPOS];
+	uint32_t soma_nominal[N_FASE_TIPOS];
+	uint8_t contadas;          // fases ja somadas
+	uint32_t feito_s;          // ultimo feito_s visto
+	uint32_t mostrado_s;
+	uint32_t previsto_s;
+	uint32_t fixo_s;           // soma nominal, a contagem antiga
+	uint8_t n_marcas;
+	uint32_t marca_feito[ESTIMA_MARCAS];
+	uint32_t marca_mostrado[ESTIMA_MARCAS];
+};
+
+void estima_modelo_init(struct estima_modelo *m);
+
+/** \brief Confere versao e tamanho de um modelo lido de fora */
+bool estima_modelo_valido(const struct estima_modelo *m);
+
+/** \brief Duracao prevista de \a c pelo modelo (menu) */
+uint32_t estima_previsto_s(const struct estima_modelo *m, const t_ciclo *c);
+
+/**
+ * \brief Duracao prevista de \a c em segundos de relogio, rodando com
+ * \a escala (ciclo_inicia): as fases em tempo real nao encolhem (agenda)
+ */
+uint32_t estima_relogio_s(const struct estima_modelo *m, const t_ciclo *c, uint32_t escala);
+
+/** \brief Comeca a acompanhar \a e, ja iniciada com ciclo_inicia */
+void estima_inicia(struct estima *s, struct estima_modelo *m, const struct ciclo_exec *e);
+
+/** \brief Estimativa crua do que falta, sem suavizar */
+uint32_t estima_restante_s(const struct estima *s, const struct ciclo_exec *e);
+
+/**
+ * \brief Soma as fases que terminaram e anda o tempo mostrado. Chamada a
+ * cada tick da lavagem.
+ *
+ * \return segundos mostrados
+ */
+uint32_t estima_atualiza(struct estima *s, const struct ciclo_exec *e);
+
+/** \brief Progresso pelo tempo mostrado, em milesimos */
+uint16_t estima_progresso(const struct estima *s, const struct ciclo_exec *e);
+
+/** \brief Fim da execucao: atualiza o modelo do programa e os erros */
+void estima_fim(struct estima *s, const struct ciclo_exec *e);
+
+void estima_stats_reset(struct estima_modelo *m);
+void estima_dump(const struct estima_modelo *m);
+
+#endif /* ESTIMA_H_ */
@@ -0,0 +1,78 @@
+/*
+ * events.c
+ *
+ * Bits de evento e sono do loop principal (ver events.h).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "events.h"
+
+static volatile uint32_t pending;
+
+/* Ciclo do primeiro event_post desde o ultimo event_wait (0 = nenhum) */
+static volatile uint32_t first_post;
+
+static struct latency_hist wake_hist;
+static uint32_t sleeps;
+static uint32_t wakes;
+
+void event_post(uint32_t events)
+{
+	irqflags_t flags = cpu_irq_save();
+
+	if (first_post == 0) {
+		first_post = latency_now() | 1u;
+	}
+	pending |= events;
+	cpu_irq_restore(flags);
+}
+
+uint32_t event_wait(void)
+{
+	uint32_t ev, posted;
+
+	/*
+	 * Testa e dorme com as interrupcoes mascaradas: o WFI acorda com a
+	 * interrupcao pendente mesmo com PRIMASK ligado, e ela e atendida
+	 * logo depois do cpu_irq_enable. O pmc_sleep() habilita as
+	 * interrupcoes antes do WFI, e um evento que chegasse entre as duas
+	 * instrucoes so seria visto na interrupcao seguinte.
+	 */
+	cpu_irq_disable();
+	while (pending == 0) {
+		SCB->SCR &= (uint32_t)~SCB_SCR_SLEEPDEEP_Msk;
+		sleeps++;
+		__DSB();
+		__WFI();
+		cpu_irq_enable();
+		__ISB();
+		cpu_irq_disable();
+	}
+	ev = pending;
+	posted = first_post;
+	pending = 0;
+	first_post = 0;
+	cpu_irq_enable();
+
+	/* O DWT para durante o sono, mas o post ja foi feito acordado */
+	latency_hist_add(&wake_hist, latency_cycles_to_us(latency_now() - posted));
+	wakes++;
+	return ev;
+}
+
+void event_stats_reset(void)
+{
+	memset(&wake_hist, 0, sizeof(wake_hist));
+	sleeps = wakes = 0;
+}
+
+void event_dump(void)
+{
+	printf("eventos: %lu despertares, %lu vezes dormindo\n\r",
+			(unsigned long)wakes, (unsigned long)sleeps);
+	printf("evento -> loop: p50 %lu us, p99 %lu us, max %lu us\n\r",
+			(unsigned long)latency_percentile(&wake_hist, 50),
+			(unsigned long)latency_percentile(&wake_hist, 99),
+			(unsigned long)wake_hist.max_us);
+}
@@ -0,0 +1,43 @@
+/*
+ * events.h
+ *
+ * Eventos do loop principal. Cada interrupcao so liga um bit com
+ * event_post(); o loop pega todos os bits pendentes com event_wait() e
+ * dorme (sleep mode, WFI) quando nao ha nada para fazer.
+ *
+ * Mede tambem o tempo entre o primeiro event_post() e o loop acordar
+ * para trata-lo (impresso pela tecla 'w' do console).
+ */
+
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include <asf.h>
+#include "latency.h"
+
+enum event {
+	EV_TOUCH    = 1u << 0,  // borda do /CHG do maXTouch (ou ainda ha mensagens)
+	EV_RTC_SEC  = 1u << 1,  // segundo do RTC (a lavagem anda pelo sched)
+	EV_DOOR     = 1u << 2,  // botao da porta
+	EV_UNLOCK   = 1u << 3,  // botao fisico de destravar ou cadeado na tela
+	EV_UART_RX  = 1u << 4,  // byte recebido no console
+	EV_UART_TX  = 1u << 5,  // DMA da USART terminou um trecho (abriu espaco)
+	EV_TRACE    = 1u << 6,  // registro novo no TRACE
+	EV_WORK     = 1u << 7,  // trabalho em andamento pede mais uma volta do loop
+	EV_TIMER    = 1u << 8,  // alguma tarefa do escalonador venceu (sched.h)
+	EV_VIBRA    = 1u << 9,  // janela de vibracao completa (vibra.h)
+	EV_ALARME   = 1u << 10, // alarme do RTC: hora do inicio agendado (sono.h)
+};
+
+/** \brief Marca eventos pendentes. Pode ser chamada de qualquer interrupcao. */
+void event_post(uint32_t events);
+
+/**
+ * \brief Retorna e limpa os eventos pendentes; dorme ate chegar algum.
+ */
+uint32_t event_wait(void);
+
+void event_stats_reset(void);
+void event_dump(void);
+
+#endif /* EVENTS_H_ */
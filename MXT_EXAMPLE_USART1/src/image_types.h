@@ -0,0 +1,32 @@
+/*
+ * image_types.h
+ *
+ * Tipos das imagens e fontes geradas (icones/ e fontes/), separados dos
+ * dados para poderem ser usados por outros modulos.
+ */
+
+#ifndef IMAGE_TYPES_H_
+#define IMAGE_TYPES_H_
+
+#include <stdint.h>
+
+ typedef struct {
+	 const uint8_t *data;
+	 uint16_t width;
+	 uint16_t height;
+	 uint8_t dataSize;
+ } tImage;
+ 
+  typedef struct {
+	  long int code;
+	  const tImage *image;
+  } tChar;
+  
+  typedef struct {
+	  int length;
+	  const tChar *chars;
+	  char start_char;
+	  char end_char;
+  } tFont;
+
+#endif /* IMAGE_TYPES_H_ */
@@ -1,22 +1,5 @@
- typedef struct {
-	 const uint8_t *data;
-	 uint16_t width;
-	 uint16_t height;
-	 uint8_t dataSize;
- } tImage;
- 
-  typedef struct {
-	  long int code;
-	  const tImage *image;
-  } tChar;
-  
-  typedef struct {
-	  int length;
-	  const tChar *chars;
-	  char start_char;
-	  char end_char;
-  } tFont;
- 
+#include "image_types.h"
+
 #include "icones/diario.h"
 #include "icones/right_arrow.h"
 #include "icones/left_arrow.h"
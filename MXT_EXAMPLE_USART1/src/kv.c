@@ -0,0 +1,451 @@
+/*
+ * kv.c
+ *
+ * Log de chave-valor com indice em RAM e segmentos em rodizio (ver kv.h).
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "kv.h"
+
+#define KV_MAGICA            0x4B565331u   // "KVS1"
+#define KV_BRANCO            0xFFFFu
+#define KV_BLOCOS_SEG        (KV_SEGMENTO / KV_FLASH_BLOCO)
+
+#define ALINHA(n)            (((n) + KV_FLASH_GRANULO - 1) & ~(KV_FLASH_GRANULO - 1))
+
+/* Primeiro granulo(s) do segmento, gravado por ultimo na compactacao */
+struct cabecalho {
+	uint32_t magica;
+	uint32_t seq;              // maior seq valida = segmento ativo
+	uint32_t desgaste[KV_SEGMENTOS];   // vezes que cada segmento foi ativo
+	uint32_t crc;
+};
+
+/* Registro: tamanho 0 remove a chave */
+struct registro {
+	uint16_t chave;
+	uint16_t tamanho;
+	uint32_t crc;              // chave, tamanho e dados
+};
+
+#define CAB_BYTES            ALINHA(sizeof(struct cabecalho))
+#define REG_BYTES(n)         ALINHA(sizeof(struct registro) + (n))
+
+enum seg_estado {
+	SEG_LIMPO = 0,
+	SEG_SUJO,                  // precisa apagar antes de usar
+	SEG_ATIVO,
+};
+
+struct entrada {
+	uint16_t chave;
+	uint16_t tamanho;
+	uint32_t dados;            // endereco dos dados na area
+};
+
+static struct entrada indice[KV_MAX_CHAVES];
+static uint8_t n_chaves;
+
+static uint8_t estado[KV_SEGMENTOS];
+static uint32_t desgaste[KV_SEGMENTOS];
+static int ativo = -1;
+static uint32_t seq;
+static uint32_t fim;           // proxima posicao livre no ativo
+static uint32_t lixo;          // bytes de versoes velhas no ativo
+static bool compactar;         // registro corrompido no ativo
+
+/* Registro montado aqui; palavras alinhadas para o latch do EEFC */
+static uint32_t buf[REG_BYTES(KV_MAX_DADOS) / 4];
+
+static struct kv_stats stats;
+
+/* CRC-32 (IEEE) por nibble: 16 entradas em vez de 256 */
+static uint32_t crc32(uint32_t crc, const void *dados, uint32_t n)
+{
+	static const uint32_t tab[16] = {
+		0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+		0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+		0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+		0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+	};
+	const uint8_t *p = dados;
+
+	while (n--) {
+		crc ^= *p++;
+		crc = (crc >> 4) ^ tab[crc & 0xF];
+		crc = (crc >> 4) ^ tab[crc & 0xF];
+	}
+	return crc;
+}
+
+static uint32_t crc_registro(const struct registro *r, const void *dados)
+{
+	uint32_t crc = crc32(0xFFFFFFFFu, r, 4);
+	return ~crc32(crc, dados, r->tamanho);
+}
+
+static uint32_t crc_cabecalho(const struct cabecalho *c)
+{
+	return ~crc32(0xFFFFFFFFu, c, offsetof(struct cabecalho, crc));
+}
+
+static uint32_t base(int s)
+{
+	return (uint32_t)s * KV_SEGMENTO;
+}
+
+static bool em_branco(uint32_t endereco, uint32_t n)
+{
+	uint32_t bloco[16];
+
+	while (n > 0) {
+		uint32_t trecho = n < sizeof(bloco) ? n : sizeof(bloco);
+		kv_flash_le(endereco, bloco, trecho);
+		for (uint32_t i = 0; i < trecho / 4; i++) {
+			if (bloco[i] != 0xFFFFFFFFu) {
+				return false;
+			}
+		}
+		endereco += trecho;
+		n -= trecho;
+	}
+	return true;
+}
+
+static struct entrada *procura(uint16_t chave)
+{
+	for (uint8_t i = 0; i < n_chaves; i++) {
+		if (indice[i].chave == chave) {
+			return &indice[i];
+		}
+	}
+	return NULL;
+}
+
+/* Registro valido lido ou gravado: o indice passa a apontar para ele */
+static void aplica(uint16_t chave, uint16_t tamanho, uint32_t dados)
+{
+	struct entrada *e = procura(chave);
+
+	if (e != NULL) {
+		lixo += REG_BYTES(e->tamanho);
+		if (tamanho == 0) {
+			lixo += REG_BYTES(0);
+			*e = indice[--n_chaves];
+			return;
+		}
+		e->tamanho = tamanho;
+		e->dados = dados;
+		return;
+	}
+	if (tamanho == 0) {
+		lixo += REG_BYTES(0);
+	}
+	else if (n_chaves < KV_MAX_CHAVES) {
+		indice[n_chaves].chave = chave;
+		indice[n_chaves].tamanho = tamanho;
+		indice[n_chaves].dados = dados;
+		n_chaves++;
+	}
+}
+
+/*
+ * Proximo segmento apagado depois do ativo, em rodizio circular. So
+ * depende do ativo, que esta na flash: um reset no meio nao faz o rodizio
+ * voltar sempre para os mesmos segmentos.
+ */
+static int proximo(void)
+{
+	for (int i = 1; i <= (int)KV_SEGMENTOS; i++) {
+		int s = (ativo + i + (int)KV_SEGMENTOS) % (int)KV_SEGMENTOS;
+		if (estado[s] == SEG_LIMPO) {
+			return s;
+		}
+	}
+	return -1;
+}
+
+/* O desgaste de \a s sobe no mesmo cabecalho que o torna ativo */
+static bool grava_cabecalho(int s)
+{
+	struct cabecalho c;
+
+	memset(buf, 0xFF, CAB_BYTES);
+	c.magica = KV_MAGICA;
+	c.seq = seq + 1;
+	memcpy(c.desgaste, desgaste, sizeof(c.desgaste));
+	c.desgaste[s]++;
+	c.crc = crc_cabecalho(&c);
+	memcpy(buf, &c, sizeof(c));
+	if (!kv_flash_programa(base(s), buf, CAB_BYTES)) {
+		return false;
+	}
+	seq++;
+	desgaste[s]++;
+	return true;
+}
+
+/*
+ * Copia os registros vivos para um segmento apagado, com \a extra bytes
+ * de folga para o registro que vai ser gravado. O cabecalho vai por
+ * ultimo; ate ele o segmento antigo continua valendo.
+ */
+static bool compacta(uint32_t extra)
+{
+	uint32_t novo[KV_MAX_CHAVES];
+	uint32_t pos = CAB_BYTES;
+	int d = proximo();
+
+	if (d < 0) {
+		return false;
+	}
+	for (uint8_t i = 0; i < n_chaves; i++) {
+		pos += REG_BYTES(indice[i].tamanho);
+	}
+	if (pos + extra > KV_SEGMENTO) {
+		return false;
+	}
+
+	pos = CAB_BYTES;
+	for (uint8_t i = 0; i < n_chaves; i++) {
+		uint32_t n = REG_BYTES(indice[i].tamanho);
+
+		memset(buf, 0xFF, n);
+		kv_flash_le(indice[i].dados - sizeof(struct registro), buf,
+				sizeof(struct registro) + indice[i].tamanho);
+		if (!kv_flash_programa(base(d) + pos, buf, n)) {
+			estado[d] = SEG_SUJO;
+			return false;
+		}
+		novo[i] = base(d) + pos + sizeof(struct registro);
+		pos += n;
+	}
+	if (!grava_cabecalho(d)) {
+		estado[d] = SEG_SUJO;
+		return false;
+	}
+
+	if (ativo >= 0) {
+		estado[ativo] = SEG_SUJO;
+	}
+	ativo = d;
+	estado[d] = SEG_ATIVO;
+	for (uint8_t i = 0; i < n_chaves; i++) {
+		indice[i].dados = novo[i];
+	}
+	fim = pos;
+	lixo = 0;
+	compactar = false;
+	stats.compactacoes++;
+	return true;
+}
+
+/*
+ * Le o log do ativo ate o resto do segmento estar em branco. Um registro
+ * cortado (crc invalido) e pulado granulo a granulo ate o proximo valido:
+ * o que foi gravado depois dele continua valendo.
+ */
+static void varre_ativo(void)
+{
+	uint32_t pos = CAB_BYTES;
+	uint32_t minimo = 0;       // fim do ultimo registro cortado
+	bool cortado = false;
+	struct registro r;
+
+	while (pos + sizeof(r) <= KV_SEGMENTO) {
+		uint32_t n;
+
+		kv_flash_le(base(ativo) + pos, &r, sizeof(r));
+		if (r.chave == KV_BRANCO && em_branco(base(ativo) + pos, KV_SEGMENTO - pos)) {
+			break;
+		}
+		n = REG_BYTES(r.tamanho);
+		if (r.chave != KV_BRANCO && r.tamanho <= KV_MAX_DADOS && pos + n <= KV_SEGMENTO) {
+			kv_flash_le(base(ativo) + pos + sizeof(r), buf, r.tamanho);
+			if (crc_registro(&r, buf) == r.crc) {
+				aplica(r.chave, r.tamanho, base(ativo) + pos + sizeof(r));
+				pos += n;
+				cortado = false;
+				continue;
+			}
+			/* Granulos do registro cortado podem parecer apagados, mas
+			 * nao podem ser programados de novo */
+			if (pos + n > minimo) {
+				minimo = pos + n;
+			}
+		}
+		if (!cortado) {
+			stats.corrompidos++;
+			cortado = true;
+		}
+		compactar = true;
+		lixo += KV_FLASH_GRANULO;
+		pos += KV_FLASH_GRANULO;
+	}
+
+	fim = pos;
+	if (minimo > fim) {
+		lixo += minimo - fim;
+		fim = minimo;
+	}
+}
+
+void kv_init(void)
+{
+	struct cabecalho c;
+
+	n_chaves = 0;
+	ativo = -1;
+	seq = 0;
+	fim = 0;
+	lixo = 0;
+	compactar = false;
+	memset(desgaste, 0, sizeof(desgaste));
+
+	for (int s = 0; s < (int)KV_SEGMENTOS; s++) {
+		kv_flash_le(base(s), &c, sizeof(c));
+		if (c.magica == KV_MAGICA && c.crc == crc_cabecalho(&c) &&
+				(ativo < 0 || c.seq > seq)) {
+			ativo = s;
+			seq = c.seq;
+			memcpy(desgaste, c.desgaste, sizeof(desgaste));
+		}
+	}
+	for (int s = 0; s < (int)KV_SEGMENTOS; s++) {
+		estado[s] = s == ativo ? SEG_ATIVO
+				: em_branco(base(s), KV_SEGMENTO) ? SEG_LIMPO : SEG_SUJO;
+	}
+	if (ativo >= 0) {
+		varre_ativo();
+	}
+}
+
+uint16_t kv_le(uint16_t chave, void *dst, uint16_t max)
+{
+	struct entrada *e = procura(chave);
+	uint16_t n;
+
+	if (e == NULL) {
+		return 0;
+	}
+	n = e->tamanho < max ? e->tamanho : max;
+	kv_flash_le(e->dados, dst, n);
+	return n;
+}
+
+static bool acrescenta(uint16_t chave, const void *dados, uint16_t n)
+{
+	struct registro r = {chave, n, 0};
+	uint32_t tam = REG_BYTES(n);
+
+	/* Primeira gravacao numa flash sem log: segmento vazio com cabecalho */
+	if (ativo < 0) {
+		int s = proximo();
+		if (s < 0 || !grava_cabecalho(s)) {
+			stats.recusadas++;
+			return false;
+		}
+		ativo = s;
+		estado[s] = SEG_ATIVO;
+		fim = CAB_BYTES;
+	}
+	if (fim + tam > KV_SEGMENTO && !compacta(tam)) {
+		stats.recusadas++;
+		return false;
+	}
+
+	r.crc = crc_registro(&r, dados);
+	memset(buf, 0xFF, tam);
+	memcpy(buf, &r, sizeof(r));
+	memcpy((uint8_t *)buf + sizeof(r), dados, n);
+	if (!kv_flash_programa(base(ativo) + fim, buf, tam)) {
+		/* Granulos em estado desconhecido: pula e compacta depois */
+		fim += tam;
+		lixo += tam;
+		compactar = true;
+		stats.recusadas++;
+		return false;
+	}
+	aplica(chave, n, base(ativo) + fim + sizeof(r));
+	fim += tam;
+	stats.gravacoes++;
+	return true;
+}
+
+bool kv_grava(uint16_t chave, const void *dados, uint16_t n)
+{
+	struct entrada *e = procura(chave);
+
+	if (chave == KV_BRANCO || n == 0 || n > KV_MAX_DADOS) {
+		return false;
+	}
+	/* Mesmo valor: nao gasta a flash */
+	if (e != NULL && e->tamanho == n) {
+		kv_flash_le(e->dados, buf, n);
+		if (memcmp(buf, dados, n) == 0) {
+			return true;
+		}
+	}
+	if (e == NULL && n_chaves >= KV_MAX_CHAVES) {
+		stats.recusadas++;
+		return false;
+	}
+	return acrescenta(chave, dados, n);
+}
+
+bool kv_remove(uint16_t chave)
+{
+	return procura(chave) == NULL || acrescenta(chave, "", 0);
+}
+
+bool kv_manutencao(void)
+{
+	for (int s = 0; s < (int)KV_SEGMENTOS; s++) {
+		if (estado[s] != SEG_SUJO) {
+			continue;
+		}
+		/* Um bloco por chamada; bloco que ja esta em branco nao gasta */
+		for (uint32_t b = 0; b < KV_BLOCOS_SEG; b++) {
+			uint32_t end = base(s) + b * KV_FLASH_BLOCO;
+			if (!em_branco(end, KV_FLASH_BLOCO)) {
+				if (kv_flash_apaga(end)) {
+					stats.apagamentos++;
+				}
+				return true;
+			}
+		}
+		estado[s] = SEG_LIMPO;
+		return true;
+	}
+
+	if (ativo >= 0 && (compactar || lixo * 100 > KV_SEGMENTO * KV_LIXO_PCT) &&
+			proximo() >= 0) {
+		compacta(0);
+		return true;
+	}
+	return false;
+}
+
+void kv_stats_reset(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+void kv_dump(void)
+{
+	printf("kv: %u chaves, segmento %d (seq %lu) com %lu/%u bytes, %lu de lixo\n\r",
+			n_chaves, ativo, (unsigned long)seq, (unsigned long)fim,
+			KV_SEGMENTO, (unsigned long)lixo);
+	printf("  %lu gravacoes, %lu recusadas, %lu compactacoes, %lu blocos apagados, "
+			"%lu corrompidos, pior bloqueio %lu us\n\r",
+			(unsigned long)stats.gravacoes, (unsigned long)stats.recusadas,
+			(unsigned long)stats.compactacoes, (unsigned long)stats.apagamentos,
+			(unsigned long)stats.corrompidos, (unsigned long)kv_flash_pior_us());
+	printf("  desgaste:");
+	for (int s = 0; s < (int)KV_SEGMENTOS; s++) {
+		printf(" %lu%c", (unsigned long)desgaste[s], "LSA"[estado[s]]);
+	}
+	printf("\n\r");
+}
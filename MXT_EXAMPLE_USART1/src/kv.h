@@ -0,0 +1,94 @@
+/*
+ * kv.h
+ *
+ * Chave-valor persistente na flash interna (kv_flash.h), em log: cada
+ * gravacao acrescenta um registro (chave, tamanho, dados, crc32) no fim
+ * do segmento ativo e a versao anterior vira lixo. O indice em RAM
+ * (chave -> endereco) e montado numa passada no boot; ler e so copiar da
+ * flash.
+ *
+ * A area tem KV_SEGMENTOS segmentos. Quando o ativo enche, ou tem lixo
+ * demais e o sistema esta ocioso, os registros vivos sao copiados para
+ * o proximo segmento apagado depois do ativo (rodizio circular, que
+ * iguala o desgaste sem contador em RAM) e o cabecalho (com sequencia
+ * maior) e gravado por ultimo: se a energia cair antes, o segmento antigo
+ * continua valendo. Registro cortado no meio falha no crc e e ignorado.
+ *
+ * Gravar nunca apaga: os segmentos velhos sao apagados aos poucos, um
+ * bloco por chamada de kv_manutencao, pelo loop quando nada mais precisa
+ * da CPU. Sem segmento apagado quando o ativo enche, kv_grava devolve
+ * false e a gravacao e tentada de novo depois.
+ */
+
+#ifndef KV_H_
+#define KV_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "kv_flash.h"
+
+#define KV_SEGMENTO          (2u * KV_FLASH_BLOCO)
+#define KV_SEGMENTOS         (KV_FLASH_BYTES / KV_SEGMENTO)
+#define KV_MAX_CHAVES        16
+#define KV_MAX_DADOS         512
+
+/* Lixo (%) no ativo que faz a manutencao compactar antes de encher */
+#ifndef KV_LIXO_PCT
+#define KV_LIXO_PCT          50
+#endif
+
+/* Periodo da manutencao em main.c: um bloco apagado por vez */
+#ifndef KV_MANUTENCAO_MS
+#define KV_MANUTENCAO_MS     200
+#endif
+
+/* Chaves gravadas pela aplicacao; nunca reaproveitar um numero */
+enum kv_chave {
+	KV_CALIB_TOQUE = 1,    // struct touch_calib
+	KV_ESTIMA      = 2,    // struct estima_modelo
+	KV_USO         = 3,    // struct kv_uso
+	KV_PROGRAMAS   = 4,    // programas do usuario (programas.c)
+};
+
+/* Contadores de uso da maquina */
+struct kv_uso {
+	uint32_t lavagens;
+	uint32_t boots;
+};
+
+struct kv_stats {
+	uint32_t gravacoes;
+	uint32_t recusadas;    // sem segmento apagado ou sem espaco
+	uint32_t compactacoes;
+	uint32_t apagamentos;  // blocos
+	uint32_t corrompidos;  // registros com crc invalido no boot
+};
+
+/** \brief Acha o segmento ativo e monta o indice (uma passada) */
+void kv_init(void);
+
+/**
+ * \brief Copia o valor de \a chave para \a dst.
+ *
+ * \return bytes copiados (no maximo \a max), 0 se a chave nao existe
+ */
+uint16_t kv_le(uint16_t chave, void *dst, uint16_t max);
+
+/** \brief Grava (ou troca) o valor de \a chave. Nao apaga flash. */
+bool kv_grava(uint16_t chave, const void *dados, uint16_t n);
+
+/** \brief Remove \a chave */
+bool kv_remove(uint16_t chave);
+
+/**
+ * \brief Um passo de manutencao: apaga um bloco de segmento velho ou
+ * compacta o ativo com lixo demais.
+ *
+ * \return true se ainda ha trabalho
+ */
+bool kv_manutencao(void);
+
+void kv_stats_reset(void);
+void kv_dump(void);
+
+#endif /* KV_H_ */
@@ -0,0 +1,42 @@
+/*
+ * kv_flash.h
+ *
+ * Acesso a area de flash do kv (kv.h). Enderecos sao relativos ao comeco
+ * da area. Na placa e o ultimo setor da flash interna pelo EEFC
+ * (kv_flash_eefc.c); no PC, tools/kvflash/kv_flash_host.c simula apagar
+ * e programar, inclusive falta de energia no meio.
+ *
+ * Regras da flash do SAME70: apagar leva tudo para 0xFF, em blocos de
+ * KV_FLASH_BLOCO; programar so desce bits, em granulos de KV_FLASH_GRANULO
+ * (o ECC cobre 128 bits) e cada granulo so uma vez entre apagamentos.
+ * Nao depende do ASF.
+ */
+
+#ifndef KV_FLASH_H_
+#define KV_FLASH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define KV_FLASH_BYTES       (128u * 1024u)  // ultimo setor, fora do flash.ld
+#define KV_FLASH_PAGINA      512u
+#define KV_FLASH_BLOCO       (16u * KV_FLASH_PAGINA)  // EPA de 16 paginas
+#define KV_FLASH_GRANULO     16u
+
+void kv_flash_le(uint32_t endereco, void *dst, uint32_t n);
+
+/**
+ * \brief Programa \a n bytes. \a endereco e \a n sao multiplos de
+ * KV_FLASH_GRANULO e os granulos estao apagados.
+ *
+ * \return false se a flash recusou (ou a energia "caiu" no host)
+ */
+bool kv_flash_programa(uint32_t endereco, const void *src, uint32_t n);
+
+/** \brief Apaga o bloco de KV_FLASH_BLOCO que comeca em \a endereco */
+bool kv_flash_apaga(uint32_t endereco);
+
+/** \brief Maior tempo (us) com a CPU parada num comando, 0 no host */
+uint32_t kv_flash_pior_us(void);
+
+#endif /* KV_FLASH_H_ */
@@ -0,0 +1,110 @@
+/*
+ * kv_flash_eefc.c
+ *
+ * Area do kv no ultimo setor da flash interna, pelos registradores do
+ * EEFC (o ASF do projeto nao traz o driver efc).
+ *
+ * Enquanto o EEFC programa ou apaga, a flash nao pode ser lida: o comando
+ * e a espera rodam da RAM (RAMFUNC) com as interrupcoes desligadas, ja que
+ * a tabela de vetores e os handlers estao na flash. O pior caso e o
+ * apagamento de um bloco de 16 paginas, por isso o kv so apaga na
+ * manutencao, com o sistema ocioso.
+ *
+ * O MPU nao e configurado (CONF_BOARD_CONFIG_MPU_AT_INIT desligado): a
+ * regiao de codigo fica write-through no mapa padrao e as escritas no
+ * latch chegam ao EEFC. Depois de programar ou apagar, a D-Cache da area
+ * e descartada.
+ */
+
+#include <string.h>
+#include <asf.h>
+#include "kv_flash.h"
+#include "dma.h"
+#include "latency.h"
+
+#define KV_FLASH_INICIO      (IFLASH_ADDR + IFLASH_SIZE - KV_FLASH_BYTES)
+
+#define EEFC_ERROS           (EEFC_FSR_FCMDE | EEFC_FSR_FLOCKE | EEFC_FSR_FLERR)
+
+static uint32_t pior_us;
+
+/* Roda da RAM: nada aqui pode tocar a flash */
+static RAMFUNC __attribute__((noinline)) uint32_t eefc_comando(uint32_t cmd, uint32_t arg)
+{
+	uint32_t fsr;
+
+	EFC->EEFC_FCR = EEFC_FCR_FKEY_PASSWD | EEFC_FCR_FARG(arg) | cmd;
+	do {
+		fsr = EFC->EEFC_FSR;
+	} while (!(fsr & EEFC_FSR_FRDY));
+	return fsr;
+}
+
+static bool comando(uint32_t cmd, uint32_t arg)
+{
+	irqflags_t flags = cpu_irq_save();
+	uint32_t t0 = latency_now();
+	uint32_t fsr = eefc_comando(cmd, arg);
+	uint32_t us = latency_cycles_to_us(latency_now() - t0);
+
+	cpu_irq_restore(flags);
+	if (us > pior_us) {
+		pior_us = us;
+	}
+	return (fsr & EEFC_ERROS) == 0;
+}
+
+void kv_flash_le(uint32_t endereco, void *dst, uint32_t n)
+{
+	memcpy(dst, (const void *)(KV_FLASH_INICIO + endereco), n);
+}
+
+bool kv_flash_programa(uint32_t endereco, const void *src, uint32_t n)
+{
+	const uint8_t *p = src;
+	bool ok = true;
+
+	while (n > 0 && ok) {
+		uint32_t end = KV_FLASH_INICIO + endereco;
+		uint32_t pagina = (end - IFLASH_ADDR) / KV_FLASH_PAGINA;
+		uint32_t inicio = (end - IFLASH_ADDR) % KV_FLASH_PAGINA;
+		uint32_t trecho = KV_FLASH_PAGINA - inicio;
+		volatile uint32_t *latch = (volatile uint32_t *)end;
+
+		if (trecho > n) {
+			trecho = n;
+		}
+		/* O latch guarda a pagina inteira; o que nao foi escrito fica 0xFF
+		 * e nao muda a flash */
+		for (uint32_t i = 0; i < trecho; i += 4) {
+			uint32_t w;
+			memcpy(&w, p + i, 4);
+			*latch++ = w;
+		}
+		__DSB();
+		ok = comando(EEFC_FCR_FCMD_WP, pagina);
+		dma_invalidate_dcache((const void *)end, trecho);
+
+		endereco += trecho;
+		p += trecho;
+		n -= trecho;
+	}
+	return ok;
+}
+
+bool kv_flash_apaga(uint32_t endereco)
+{
+	uint32_t end = KV_FLASH_INICIO + endereco;
+	uint32_t pagina = (end - IFLASH_ADDR) / KV_FLASH_PAGINA;
+	bool ok;
+
+	/* EPA com FARG[1:0] = 2: 16 paginas, primeira alinhada em 16 */
+	ok = comando(EEFC_FCR_FCMD_EPA, pagina | 2);
+	dma_invalidate_dcache((const void *)end, KV_FLASH_BLOCO);
+	return ok;
+}
+
+uint32_t kv_flash_pior_us(void)
+{
+	return pior_us;
+}
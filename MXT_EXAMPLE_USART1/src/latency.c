@@ -0,0 +1,214 @@
+/*
+ * latency.c
+ *
+ * Instrumentacao de latencia toque -> tela (ver latency.h).
+ */
+
+#include <asf.h>
+#include <stdio.h>
+#include <string.h>
+#include "latency.h"
+#include "events.h"
+
+#define CHG_PIO          PIOA
+#define CHG_PIO_ID       ID_PIOA
+#define CHG_PIO_IDX_MASK (1u << (MAXTOUCH_XPRO_CHG_PIO & 0x1F))
+
+static const char *const stage_names[LAT_N_STAGES] = {
+	"chg->twi",
+	"twi->cb",
+	"cb->spi",
+	"total",
+};
+
+static struct latency_hist hist[N_TELAS][LAT_N_STAGES];
+
+/* Amostra em andamento; 0 = marca ainda nao registrada */
+static volatile uint32_t sample[LAT_N_MARKS];
+
+/* Amostra cujo callback ja rodou e que espera o estagio de render */
+static uint32_t deferred[LAT_N_MARKS];
+static bool has_deferred;
+
+static uint32_t cycles_per_us;
+
+static void chg_edge_handler(uint32_t id, uint32_t mask)
+{
+	UNUSED(id);
+	UNUSED(mask);
+
+	/* So a primeira borda conta: o /CHG continua baixo enquanto houver
+	 * mensagens na fila */
+	if (sample[LAT_MARK_CHG] == 0) {
+		sample[LAT_MARK_CHG] = latency_now() | 1u;
+	}
+	event_post(EV_TOUCH);
+}
+
+void latency_init(void)
+{
+	cycles_per_us = sysclk_get_cpu_hz() / 1000000UL;
+
+	/* Habilita o contador de ciclos do DWT */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	/* Interrupcao so para carimbar a borda do /CHG; a leitura continua
+	 * sendo feita no loop principal */
+	pmc_enable_periph_clk(CHG_PIO_ID);
+	pio_handler_set(CHG_PIO, CHG_PIO_ID, CHG_PIO_IDX_MASK, PIO_IT_FALL_EDGE,
+			chg_edge_handler);
+	pio_enable_interrupt(CHG_PIO, CHG_PIO_IDX_MASK);
+	NVIC_EnableIRQ(CHG_PIO_ID);
+	NVIC_SetPriority(CHG_PIO_ID, 3);
+
+	latency_reset();
+}
+
+uint32_t latency_cycles_to_us(uint32_t cycles)
+{
+	return cycles / cycles_per_us;
+}
+
+void latency_mark(enum latency_mark mark)
+{
+	/* bit 0 forcado em 1 para nunca confundir um carimbo com "vazio" */
+	sample[mark] = latency_now() | 1u;
+}
+
+void latency_discard(void)
+{
+	for (int i = 0; i < LAT_N_MARKS; i++) {
+		sample[i] = 0;
+	}
+}
+
+void latency_hist_add(struct latency_hist *h, uint32_t us)
+{
+	uint32_t b = (us == 0) ? 0 : 32 - __CLZ(us);
+
+	if (b >= LAT_HIST_BUCKETS) {
+		b = LAT_HIST_BUCKETS - 1;
+	}
+	h->bucket[b]++;
+	h->count++;
+	h->sum_us += us;
+	if (us > h->max_us) {
+		h->max_us = us;
+	}
+}
+
+static void add_stage(enum tela t, enum latency_stage s,
+		enum latency_mark from, enum latency_mark to)
+{
+	if (sample[from] == 0 || sample[to] == 0) {
+		return;
+	}
+	latency_hist_add(&hist[t][s], latency_cycles_to_us(sample[to] - sample[from]));
+}
+
+void latency_redraw_done(enum tela t)
+{
+	/* Espera o ultimo byte sair do shift register do SPI do LCD */
+	while (!(BOARD_ILI9488_SPI->SPI_SR & SPI_SR_TXEMPTY)) {
+	}
+	latency_mark(LAT_MARK_REDRAW);
+
+	/* Sem borda de CHG (eventos seguintes da mesma rajada): conta a
+	 * partir da leitura */
+	if (sample[LAT_MARK_CHG] == 0) {
+		sample[LAT_MARK_CHG] = sample[LAT_MARK_READ];
+	}
+
+	if (t < N_TELAS) {
+		add_stage(t, LAT_STAGE_CHG_READ, LAT_MARK_CHG, LAT_MARK_READ);
+		add_stage(t, LAT_STAGE_READ_CALLBACK, LAT_MARK_READ, LAT_MARK_CALLBACK);
+		add_stage(t, LAT_STAGE_CALLBACK_REDRAW, LAT_MARK_CALLBACK, LAT_MARK_REDRAW);
+		add_stage(t, LAT_STAGE_TOTAL, LAT_MARK_CHG, LAT_MARK_REDRAW);
+	}
+	latency_discard();
+}
+
+void latency_defer(void)
+{
+	/* Um toque mais novo substitui o anterior: so ele chega a ser desenhado */
+	for (int i = 0; i < LAT_N_MARKS; i++) {
+		deferred[i] = sample[i];
+	}
+	has_deferred = true;
+	latency_discard();
+}
+
+void latency_render_done(enum tela t)
+{
+	uint32_t in_flight[LAT_N_MARKS];
+
+	if (!has_deferred) {
+		return;
+	}
+
+	/* O /CHG do proximo toque pode ja ter marcado a amostra em andamento */
+	for (int i = 0; i < LAT_N_MARKS; i++) {
+		in_flight[i] = sample[i];
+		sample[i] = deferred[i];
+	}
+	has_deferred = false;
+	latency_redraw_done(t);
+	for (int i = 0; i < LAT_N_MARKS; i++) {
+		if (sample[i] == 0) {
+			sample[i] = in_flight[i];
+		}
+	}
+}
+
+void latency_reset(void)
+{
+	memset(hist, 0, sizeof(hist));
+	latency_discard();
+}
+
+uint32_t latency_percentile(const struct latency_hist *h, uint32_t pct)
+{
+	uint32_t target, acc = 0;
+
+	if (h->count == 0) {
+		return 0;
+	}
+	target = (h->count * pct + 99) / 100;
+	for (int b = 0; b < LAT_HIST_BUCKETS; b++) {
+		acc += h->bucket[b];
+		if (acc >= target) {
+			/* limite superior do bucket, sem passar do maximo visto */
+			uint32_t upper = (b == 0) ? 1 : (1u << b);
+			return min(upper, h->max_us);
+		}
+	}
+	return h->max_us;
+}
+
+const struct latency_hist *latency_get_hist(enum tela t, enum latency_stage s)
+{
+	return &hist[t][s];
+}
+
+void latency_dump(void)
+{
+	printf("\n\r# latencia toque->tela (us)\n\r");
+	printf("# tela           etapa        n     p50     p99     max    media\n\r");
+	for (int t = 0; t < N_TELAS; t++) {
+		for (int s = 0; s < LAT_N_STAGES; s++) {
+			const struct latency_hist *h = &hist[t][s];
+			if (h->count == 0) {
+				continue;
+			}
+			printf("%-16s %-9s %5lu %7lu %7lu %7lu %8lu\n\r",
+					telas_nome(t), stage_names[s],
+					(unsigned long)h->count,
+					(unsigned long)latency_percentile(h, 50),
+					(unsigned long)latency_percentile(h, 99),
+					(unsigned long)h->max_us,
+					(unsigned long)(h->sum_us / h->count));
+		}
+	}
+}
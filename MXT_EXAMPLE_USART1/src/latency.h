@@ -0,0 +1,92 @@
+/*
+ * latency.h
+ *
+ * Instrumentacao de latencia toque -> tela usando o contador de ciclos
+ * do DWT (CMSIS core_cm7.h).
+ *
+ * Cada toque passa por quatro marcas:
+ *  - LAT_MARK_CHG:      borda de descida do /CHG do maXTouch (interrupcao)
+ *  - LAT_MARK_READ:     fim da leitura TWI em mxt_handler
+ *  - LAT_MARK_CALLBACK: entrada no callback do botao
+ *  - LAT_MARK_REDRAW:   ultimo byte SPI do redesenho enviado
+ *
+ * As diferencas entre marcas vao para histogramas log2 (em us) separados
+ * por tela, que podem ser impressos na USART de console.
+ */
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <compiler.h>
+#include "telas.h"
+
+enum latency_mark {
+	LAT_MARK_CHG = 0,
+	LAT_MARK_READ,
+	LAT_MARK_CALLBACK,
+	LAT_MARK_REDRAW,
+	LAT_N_MARKS
+};
+
+enum latency_stage {
+	LAT_STAGE_CHG_READ = 0,     // CHG -> leitura TWI
+	LAT_STAGE_READ_CALLBACK,    // leitura -> callback
+	LAT_STAGE_CALLBACK_REDRAW,  // callback -> ultimo byte SPI
+	LAT_STAGE_TOTAL,            // CHG -> ultimo byte SPI
+	LAT_N_STAGES
+};
+
+/* Bucket i conta amostras em [2^(i-1), 2^i) us; o ultimo acumula o resto */
+#define LAT_HIST_BUCKETS 24
+
+struct latency_hist {
+	uint32_t count;
+	uint32_t max_us;
+	uint64_t sum_us;
+	uint32_t bucket[LAT_HIST_BUCKETS];
+};
+
+/** \brief Liga o DWT->CYCCNT e a interrupcao do /CHG do maXTouch */
+void latency_init(void);
+
+/** \brief Le o contador de ciclos */
+static inline uint32_t latency_now(void)
+{
+	return DWT->CYCCNT;
+}
+
+uint32_t latency_cycles_to_us(uint32_t cycles);
+
+/** \brief Registra uma marca da amostra em andamento */
+void latency_mark(enum latency_mark mark);
+
+/**
+ * \brief Espera o SPI do LCD esvaziar, registra LAT_MARK_REDRAW e fecha a
+ * amostra nos histogramas da tela \p t.
+ */
+void latency_redraw_done(enum tela t);
+
+/** \brief Descarta a amostra em andamento (toque que nao disparou callback) */
+void latency_discard(void);
+
+/**
+ * \brief Guarda a amostra cujo callback ja rodou ate o estagio de render
+ * (render.h) e libera as marcas para o proximo toque.
+ */
+void latency_defer(void);
+
+/** \brief Fecha a amostra guardada por latency_defer, se houver */
+void latency_render_done(enum tela t);
+
+void latency_reset(void);
+void latency_dump(void);
+
+/** \brief Acrescenta uma amostra (us) a um histograma */
+void latency_hist_add(struct latency_hist *h, uint32_t us);
+
+/** \brief Percentil \p pct (0-100) do histograma, em us (limite do bucket) */
+uint32_t latency_percentile(const struct latency_hist *h, uint32_t pct);
+
+const struct latency_hist *latency_get_hist(enum tela t, enum latency_stage s);
+
+#endif /* LATENCY_H_ */
@@ -0,0 +1,54 @@
+/*
+ * lavagens.c
+ *
+ * Catalogo dos programas de lavagem. Cada programa e uma linha de
+ * LAVAGENS; a ordem das linhas e a ordem do carrossel. A tabela e const
+ * (fica na flash) e os parametros sao conferidos na compilacao.
+ */
+
+#include "lavagens.h"
+#include "ciclo.h"
+#include "buttons.h"
+
+/*  X(nome,        icone,                   enxague min, enxagues, rpm,  centrif. min, pesado, bolhas) */
+#define LAVAGENS(X)                                                                    \
+	X("DIARIA",     &botaoLavagemDiaria,     15,          2,        1200, 8,            0,      1)  \
+	X("PESADA",     &botaoLavagemPesada,     10,          3,        1200, 10,           1,      1)  \
+	X("RAPIDA",     &botaoLavagemRapida,     5,           3,        900,  5,            0,      1)  \
+	X("ENXAGUE",    &botaoLavagemEnxague,    10,          1,        0,    0,            0,      0)  \
+	X("CENTRIFUGA", &botaoLavagemCentrifuga, 0,           0,        1200, 10,           0,      0)
+
+#define LAVAGEM_ENTRADA(nome_, icone, enx_t, enx_n, rpm, cent_t, pesado, bolhas) \
+	{                                                                          \
+		.nome = nome_,                                                         \
+		.enxagueTempo = (enx_t),                                               \
+		.enxagueQnt = (enx_n),                                                 \
+		.centrifugacaoRPM = (rpm),                                             \
+		.centrifugacaoTempo = (cent_t),                                        \
+		.heavy = (pesado),                                                     \
+		.bubblesOn = (bolhas),                                                 \
+		.botao = (icone),                                                      \
+		.total_s = CICLO_TOTAL_S(enx_t, enx_n, rpm, cent_t, pesado),           \
+	},
+
+const t_ciclo lavagens[] = {
+	LAVAGENS(LAVAGEM_ENTRADA)
+};
+
+const uint8_t n_lavagens = sizeof(lavagens) / sizeof(lavagens[0]);
+
+#define LAVAGEM_CONFERE(nome_, icone, enx_t, enx_n, rpm, cent_t, pesado, bolhas)         \
+	_Static_assert(sizeof(nome_) <= LAVAGEM_NOME_MAX, "nome maior que t_ciclo.nome");    \
+	_Static_assert((enx_t) >= 0 && (enx_t) <= UINT8_MAX, "tempo de enxague invalido");   \
+	_Static_assert((enx_n) >= 0 && (enx_n) <= CICLO_MAX_ENXAGUES, "enxagues demais");    \
+	_Static_assert((cent_t) >= 0 && (cent_t) <= UINT8_MAX, "tempo de centrifugacao invalido"); \
+	_Static_assert((rpm) >= 0 && (rpm) <= LAVAGEM_RPM_MAX, "rpm fora do limite do motor"); \
+	_Static_assert((rpm) == 0 || (rpm) > CICLO_DISTRIBUI_RPM, "rpm abaixo da distribuicao"); \
+	_Static_assert((enx_t) > 0 || ((rpm) > 0 && (cent_t) > 0), "programa sem fase nenhuma"); \
+	_Static_assert((CICLO_TOTAL_S(enx_t, enx_n, rpm, cent_t, pesado) + 59) / 60 <= 99,    \
+			"duracao nao cabe nos 2 digitos da contagem");
+
+LAVAGENS(LAVAGEM_CONFERE)
+
+_Static_assert(sizeof(lavagens) / sizeof(lavagens[0]) > 0 &&
+		sizeof(lavagens) / sizeof(lavagens[0]) < UINT8_MAX, "catalogo vazio ou grande demais");
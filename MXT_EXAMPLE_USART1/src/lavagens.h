@@ -1,20 +1,34 @@
+#ifndef LAVAGENS_H_
+#define LAVAGENS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
 typedef struct ciclo t_ciclo;
 
+struct botao;
+
+#define LAVAGEM_NOME_MAX     32
+
+/* Limites do motor do tambor */
+#ifndef LAVAGEM_RPM_MAX
+#define LAVAGEM_RPM_MAX      1400
+#endif
+
 struct ciclo{
-	char nome[32];           // nome do ciclo, para ser exibido
-	int  enxagueTempo;       // tempo que fica em cada enxague
-	int  enxagueQnt;         // quantidade de enxagues
-	int  centrifugacaoRPM;   // velocidade da centrifugacao
-	int  centrifugacaoTempo; // tempo que centrifuga
-	char heavy;              // modo pesado de lavagem
-	char bubblesOn;          // smart bubbles on (???)
-	t_ciclo *previous;
-	t_ciclo *next;
+	char nome[LAVAGEM_NOME_MAX]; // nome do ciclo, para ser exibido
+	uint8_t  enxagueTempo;       // tempo que fica em cada enxague (min)
+	uint8_t  enxagueQnt;         // quantidade de enxagues
+	uint16_t centrifugacaoRPM;   // velocidade da centrifugacao
+	uint8_t  centrifugacaoTempo; // tempo que centrifuga (min)
+	bool heavy;                  // modo pesado de lavagem
+	bool bubblesOn;              // smart bubbles on (???)
+	struct botao *botao;         // icone e area de toque no carrossel
+	uint32_t total_s;            // duracao do programa (ciclo_total_s), calculada na compilacao
 };
 
+/* Programas, na ordem do carrossel (lista circular). Ficam na flash. */
+extern const t_ciclo lavagens[];
+extern const uint8_t n_lavagens;
 
-t_ciclo c_rapido;
-t_ciclo c_diario;
-t_ciclo c_pesado;
-
-int calculate_total_time(t_ciclo act_cicle);
\ No newline at end of file
+#endif /* LAVAGENS_H_ */
@@ -86,620 +86,721 @@
 
 #include "main.h"
 
-volatile int n_botoes_na_tela = 0;
-volatile uint8_t print_time_value;
+/* Minutos que faltam na lavagem em andamento (0 = parada) */
 volatile int time_left = 0;
 
-/*
-* 0 - diaria
-* 1 - pesada
-* 2 - rapida
-*/
-volatile int laundry_event = 0;
+/* Lavagem em andamento e a tarefa que a faz andar */
+static struct ciclo_exec lavagem;
+static int tarefa_ciclo = SCHED_INVALID;
+static uint32_t ciclo_ms;
+
+/* Duracao real das fases por programa e o tempo mostrado (estima.h) */
+static struct estima_modelo modelo_tempo;
+static struct estima estimativa;
+
+/* Contadores gravados na flash (kv.h) */
+static struct kv_uso uso;
+
+/* Chaves que o kv recusou (1 << chave): o kv_tick grava de novo */
+static uint32_t kv_pendentes;
 
-struct botao botoes[10];
+/* Agua (modelo) e o fim das fases por sensor */
+static struct agua agua;
+static uint8_t fase_vista;
+static uint32_t fim_agua_s;
+
+/* Desbalanceamento medido na distribuicao: novas tentativas e decisao */
+static uint8_t redistribuicoes;
+static bool balanco_decidido;
+
+/* Inicio agendado: horario em edicao, plano armado e a espera para apagar */
+static struct agenda agenda;
+static struct agenda_plano plano;
+static int tarefa_agenda = SCHED_INVALID;
+static bool pode_dormir;
 
 volatile bool unlocked_flag = true;
 volatile bool door_open;
-volatile bool lock_unlock;
+
+/* Widgets da tela atual que mudam sem trocar de tela (NULL se a tela nao tem) */
+static struct widget *w_unlock;
+static struct widget *w_lock;
+static struct widget *w_tempo;
+static struct widget *w_progresso;
+static struct widget *w_fase;
+static struct widget *w_campo[N_CAMPOS];
+static struct widget *w_total;
+static struct widget *w_relogio;
+static struct widget *w_modo;
+static struct widget *w_hora;
+static struct widget *w_minuto;
+static struct widget *w_plano;
+static struct widget *w_fim;
+static void update_cycle_widgets(void);
+static void update_editor_widgets(void);
+static void update_schedule_widgets(void);
+static void kv_salva(enum kv_chave chave);
+
+/* Ultimo botao tocado e sentido da troca de ciclo, para as animacoes */
+static const struct botao *botao_tocado;
+static int8_t slide_dir;
+
+/* Deslocamento (px) de onde o icone do ciclo entra deslizando */
+#define CAROUSEL_SLIDE   40
+
+/* Tela do agendamento confirmado fica acesa antes de dormir */
+#define AGENDA_APAGA_MS  5000
 
 
 void door_callback(){
 	door_open = !door_open;
+	event_post(EV_DOOR);
 }
 
-void home_callback(void){
+/* Botoes so geram eventos; o que cada um faz em cada tela esta em telas_fluxo */
+static void ui_evento(enum tela_evento ev){
 	if(unlocked_flag){
-		draw_screen();
-		switch(laundry_event){
-			case 0:
-				draw_diary_page();
-				botoes[0] = botaoLavagemPesada;
-				break;
-			
-			case 1:
-				draw_heavy_page();
-				botoes[0] = botaoLavagemRapida;
-				break;
-				
-			case 2:
-				draw_fast_page();
-				botoes[0] = botaoLavagemDiaria;
-				break;
-		}
-		botoes[1] = botaoDireita;
-		botoes[2] = botaoEsquerda;
-		botoes[3] = botaoUnlock;
-		botoes[4] = botaoLock;
-		n_botoes_na_tela = 5;
+		telas_evento(ev);
 	}
 }
 
+void home_callback(void){
+	ui_evento(TELA_EV_HOME);
+}
+
+void ok_callback(void){
+	ui_evento(TELA_EV_OK);
+}
+
 void play_pause_callback(void){
+	ui_evento(TELA_EV_INICIA);
+}
+
+void lavagem_callback(void){
+	ui_evento(TELA_EV_ESCOLHE);
+}
+
+void edit_callback(void){
+	ui_evento(TELA_EV_EDITA);
+}
+
+void schedule_callback(void){
+	ui_evento(TELA_EV_AGENDA);
+}
+
+/* Modo e horario do agendamento: so os textos que mudaram sao redesenhados */
+void mode_callback(void){
 	if(unlocked_flag){
-		draw_screen();
-	
-		if(!door_open){
-			
-			switch(laundry_event){
-				case 0:
-					time_left = calculate_total_time(c_diario);
-					break;
-				
-				case 1:
-					time_left = calculate_total_time(c_pesado);
-					break;
-				
-				case 2:
-					time_left = calculate_total_time(c_rapido);
-					break;
-			}
-			n_botoes_na_tela = 0;
-			
-			draw_working(time_left);
-	
-			rtc_enable_interrupt(RTC,  RTC_IER_SECEN);
-		}
-		else{
-			draw_door_open();
+		agenda_troca_modo(&agenda);
+		update_schedule_widgets();
+	}
+}
+
+void time_callback(void){
+	if(!unlocked_flag){
+		return;
+	}
+	for(int i = 0; i < 4; i++){
+		if(botao_tocado == &botoesHorario[i]){
+			agenda_ajusta(&agenda, passos_horario[i]);
+			update_schedule_widgets();
 		}
 	}
 }
 
-void lavagem_callback(void){
-	if(unlocked_flag){
-		draw_screen();
-		draw_laundry_menu();
-		
-		botoes[0] = botaoHome;
-		botoes[1] = botaoPlayPause;
-		botoes[2] = botaoUnlock;
-		botoes[3] = botaoLock;
-		
-		n_botoes_na_tela = 4;
+/* - / + do editor: so o valor do campo e o total sao redesenhados */
+void field_callback(void){
+	if(!unlocked_flag){
+		return;
+	}
+	for(int c = 0; c < N_CAMPOS; c++){
+		for(int s = 0; s < 2; s++){
+			if(botao_tocado == &botoesCampo[c][s] && programas_ajusta(c, s ? 1 : -1)){
+				update_editor_widgets();
+			}
+		}
 	}
 }
 
 void slice_right_callback(void){
+	slide_dir = 1;
+	ui_evento(TELA_EV_PROXIMO);
+}
+
+void slice_left_callback(void){
+	slide_dir = -1;
+	ui_evento(TELA_EV_ANTERIOR);
+}
+
+/* TELA_INICIA: com a porta aberta a tabela manda para o aviso */
+static bool start_cycle(const t_ciclo *ciclo){
+	if(door_open){
+		return false;
+	}
+	ciclo_inicia(&lavagem, ciclo, CICLO_ESCALA);
+	agua_init(&agua, ciclo->heavy ? MOTOR_CARGA_PESADA_KG : MOTOR_CARGA_KG, latency_now());
+	fase_vista = CICLO_MAX_FASES;
+	estima_inicia(&estimativa, &modelo_tempo, &lavagem);
+	time_left = (estimativa.mostrado_s + 59) / 60;
+	ciclo_ms = sched_now_ms();
+	redistribuicoes = 0;
+	balanco_decidido = false;
+	if(tarefa_ciclo == SCHED_INVALID){
+		tarefa_ciclo = sched_every("ciclo", CICLO_TICK_MS, CICLO_TICK_MS / 2,
+				SCHED_PRIO_NORMAL, cycle_tick, NULL);
+	}
+	return true;
+}
+
+/* TELA_PAUSA: o tick continua rodando, mas o programa nao anda */
+static void pause_cycle(void){
+	ciclo_pausa(&lavagem, !lavagem.pausado);
+	motor_alvo(ciclo_rpm(&lavagem), lavagem.ciclo->heavy);
+	update_cycle_widgets();
+}
+
+/* TELA_SALVA: o carrossel passa a mostrar o programa salvo */
+static bool save_program(void){
+	int i = programas_salva();
+	uint8_t n;
+	const t_ciclo *const *lista = programas_lista(&n);
 	
-	if(unlocked_flag){
-		draw_screen();
-		switch(laundry_event){
-			case 0:
-				laundry_event = 1;
-				draw_heavy_page();
-				botoes[0] = botaoLavagemPesada;
-				break;
-			
-			case 1:
-				laundry_event = 2;
-				draw_fast_page();
-				botoes[0] = botaoLavagemRapida;
-				break;
-			
-			case 2:
-				laundry_event = 0;
-				draw_diary_page();
-				botoes[0] = botaoLavagemDiaria;
-				break;
-		}
-		botoes[1] = botaoDireita;
-		botoes[2] = botaoEsquerda;
-		botoes[3] = botaoUnlock;
-		botoes[4] = botaoLock;
-		n_botoes_na_tela = 5;
+	if(i < 0){
+		return false;
 	}
+	/* Sem flash livre o programa vale ate desligar ou o kv_tick gravar */
+	kv_salva(KV_PROGRAMAS);
+	telas_set_ciclos(lista, n, i);
+	return true;
 }
 
-void slice_left_callback(void){
+/* Segundos do dia e data no RTC */
+static uint32_t read_clock(struct agenda_data *hoje){
+	uint32_t h, m, s, ano, mes, dia, semana;
 	
-	if(unlocked_flag){
-		draw_screen();
-		switch(laundry_event){
-			case 0:
-				laundry_event = 2;
-				draw_fast_page();
-				botoes[0] = botaoLavagemRapida;
-				break;
-			
-			case 1:
-				laundry_event = 0;
-				draw_diary_page();
-				botoes[0] = botaoLavagemDiaria;
-				break;
-			
-			case 2:
-				laundry_event = 1;
-				draw_heavy_page();
-				botoes[0] = botaoLavagemPesada;
-				break;
-		}
+	rtc_get_time(RTC, &h, &m, &s);
+	rtc_get_date(RTC, &ano, &mes, &dia, &semana);
+	hoje->ano = ano;
+	hoje->mes = mes;
+	hoje->dia = dia;
+	return h * 3600 + m * 60 + s;
+}
 
-		botoes[1] = botaoDireita;
-		botoes[2] = botaoEsquerda;
-		botoes[3] = botaoUnlock;
-		botoes[4] = botaoLock;
-		n_botoes_na_tela = 5;
-	}
+/* Plano do horario escolhido contra o relogio de agora; false se nao da */
+static bool plan_schedule(const t_ciclo *ciclo, struct agenda_data *hoje){
+	uint32_t agora = read_clock(hoje);
 	
+	return agenda_planeja(&agenda, agora, hoje,
+			estima_relogio_s(&modelo_tempo, ciclo, CICLO_ESCALA), &plano);
+}
+
+static void schedule_sleep(void *ctx){
+	tarefa_agenda = SCHED_INVALID;
+	pode_dormir = true;
+}
+
+/* TELA_ARMA: alarme no inicio do plano; a tela apaga depois de AGENDA_APAGA_MS */
+static bool arm_schedule(const t_ciclo *ciclo){
+	struct agenda_data hoje;
+	
+	if(!plan_schedule(ciclo, &hoje) || !sono_alarme(&plano)){
+		return false;
+	}
+	pode_dormir = false;
+	tarefa_agenda = sched_after("agenda", AGENDA_APAGA_MS, 100, SCHED_PRIO_LOW,
+			schedule_sleep, NULL);
+	printf("agenda: %s liga %02u/%02u %02u:%02u:%02u\n\r", ciclo->nome,
+			plano.data.dia, plano.data.mes, plano.hora, plano.minuto, plano.segundo);
+	return true;
+}
+
+static void cancel_schedule(void){
+	sono_cancela();
+	sched_cancel(tarefa_agenda);
+	tarefa_agenda = SCHED_INVALID;
+	pode_dormir = false;
+}
+
+/*
+ * Sair da espera (cancelar, porta, alarme) desarma o agendamento. As duas
+ * telas do agendamento mostram o relogio: so nelas o RTC interrompe a
+ * cada segundo.
+ */
+static void screen_changed(enum tela t){
+	if(t != TELA_AGENDADA && sono_armado()){
+		cancel_schedule();
+	}
+	if(t == TELA_AGENDA || t == TELA_AGENDADA){
+		rtc_enable_interrupt(RTC, RTC_IER_SECEN);
+	}
+	else{
+		rtc_disable_interrupt(RTC, RTC_IDR_SECDIS);
+	}
+	render_tela_mudou(t);
+}
+
+/* Alarme do agendamento: liga o ciclo; com a porta aberta a tabela manda para o aviso */
+static void start_scheduled(void){
+	if(tela_atual != TELA_AGENDADA){
+		return;
+	}
+	telas_evento(TELA_EV_INICIA);
+	if(tela_atual == TELA_LAVANDO){
+		sono_rodando();
+	}
+}
+
+static const struct tela_ops ops_telas = {
+	.inicia = start_cycle,
+	.pausa  = pause_cycle,
+	.mudou  = screen_changed,
+	.edita  = programas_edita,
+	.salva  = save_program,
+	.arma   = arm_schedule,
+};
+
+/* Icone da trava conforme unlocked_flag; so os dois widgets sao redesenhados */
+static void update_lock_widgets(void){
+	widget_mostra(w_unlock, unlocked_flag);
+	widget_mostra(w_lock, !unlocked_flag);
 }
 
 void unlock_callback(void){
 	if(unlocked_flag == true){
-		//deixa lugar do botao branco
-		ili9488_set_foreground_color(COLOR_CONVERT(COLOR_WHITE));
-		ili9488_draw_filled_rectangle(botaoLock.x, botaoLock.y, botaoLock.x + botaoLock.image->width, botaoLock.y + botaoLock.image->height);
-		ili9488_draw_filled_rectangle(botaoUnlock.x, botaoUnlock.y, botaoUnlock.x + botaoUnlock.image->width, botaoUnlock.y + botaoUnlock.image->height);
-		
-		ili9488_draw_pixmap(botaoLock.x,
-							botaoLock.y,
-							botaoLock.image->width,
-							botaoLock.image->height,
-							botaoLock.image->data);
 		unlocked_flag = false;
+		update_lock_widgets();
 		pio_enable_interrupt(UNLOCK_PIO, UNLOCK_PIO_IDX_MASK);
 		return;
 	}
 }
 
 void lock_callback(void){
-	if (time_left <= 0){
-		lock_unlock = true;
+	if (time_left <= 0 && motor_parado()){
+		event_post(EV_UNLOCK);
 	}
 }
 
-int processa_touch(struct botao *b, struct botao *rtn, uint N ,uint x, uint y ){
-	for (int i=0; i<N; i++){
-		if (((x >= b->x) && (x <= b->x + b->size_x)) && ((y >= b->y) && (y <= b->y + b->size_y))){
-			*rtn = *b;
-			return 1;
-		}
-		b++;
+/* Estado da inicializacao em etapas (ver boot.h) */
+static uint32_t lcd_init_step;
+static enum mxt_config_result mxt_cfg = MXT_CONFIG_ERROR;
+
+static const usart_serial_options_t usart_serial_options = {
+	.baudrate     = USART_SERIAL_EXAMPLE_BAUDRATE,
+	.charlength   = USART_SERIAL_CHAR_LENGTH,
+	.paritytype   = USART_SERIAL_PARITY,
+	.stopbits     = USART_SERIAL_STOP_BIT
+};
+
+/* Uma chamada de ili9488_init_step; a espera volta para o sequenciador */
+static uint32_t boot_lcd_step(void *ctx)
+{
+	uint32_t wait_ms = 0;
+
+	if (ili9488_init_step(ctx, &lcd_init_step, &wait_ms) == ILI9488_INIT_ERROR) {
+		return BOOT_FAIL;
 	}
-	return 0;
+	return wait_ms;
 }
 
-	
-static void configure_lcd(void){
+static uint32_t boot_lcd_reset(void *ctx){
 	/* Initialize display parameter */
 	g_ili9488_display_opt.ul_width = ILI9488_LCD_WIDTH;
 	g_ili9488_display_opt.ul_height = ILI9488_LCD_HEIGHT;
 	g_ili9488_display_opt.foreground_color = COLOR_CONVERT(COLOR_WHITE);
 	g_ili9488_display_opt.background_color = COLOR_CONVERT(COLOR_WHITE);
-	
-	/* Initialize LCD */
-	ili9488_init(&g_ili9488_display_opt);
-}
 
-/**
- * \brief Set maXTouch configuration
- *
- * This function writes a set of predefined, optimal maXTouch configuration data
- * to the maXTouch Xplained Pro.
- *
- * \param device Pointer to mxt_device struct
- */
-static void mxt_init(struct mxt_device *device)
-{
-	enum status_code status;
-
-	/* T8 configuration object data */
-	uint8_t t8_object[] = {
-		0x0d, 0x00, 0x05, 0x0a, 0x4b, 0x00, 0x00,
-		0x00, 0x32, 0x19
-	};
-
-	/* T9 configuration object data */
-	uint8_t t9_object[] = {
-		0x8B, 0x00, 0x00, 0x0E, 0x08, 0x00, 0x80,
-		0x32, 0x05, 0x02, 0x0A, 0x03, 0x03, 0x20,
-		0x02, 0x0F, 0x0F, 0x0A, 0x00, 0x00, 0x00,
-		0x00, 0x18, 0x18, 0x20, 0x20, 0x00, 0x00,
-		0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x02,
-		0x02
-	};
+	lcd_init_step = 0;
+	return boot_lcd_step(ctx);
+}
 
-	/* T46 configuration object data */
-	uint8_t t46_object[] = {
-		0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x03,
-		0x00, 0x00
-	};
+static uint32_t boot_lcd_splash(void *ctx){
+	uint8_t n;
+	const t_ciclo *const *lista = programas_lista(&n);
 	
-	/* T56 configuration object data */
-	uint8_t t56_object[] = {
-		0x02, 0x00, 0x01, 0x18, 0x1E, 0x1E, 0x1E,
-		0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E,
-		0x1E, 0x1E, 0x1E, 0x1E, 0x00, 0x00, 0x00,
-		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-		0x00, 0x00, 0x00, 0x00, 0x00
-	};
+	build_buttons();
+	telas_init(telas_defs, telas_fluxo, lista, n, &ops_telas);
+	telas_vai(TELA_CARROSSEL);
+	render_run();
+	boot_milestone("splash");
+	return 0;
+}
 
+/* O maXTouch precisa de MXT_RESET_TIME depois de ligar para responder */
+static uint32_t boot_mxt_twi(void *ctx){
 	/* TWI configuration */
 	twihs_master_options_t twi_opt = {
 		.speed = MXT_TWI_SPEED,
 		.chip  = MAXTOUCH_TWI_ADDRESS,
 	};
 
-	status = (enum status_code)twihs_master_setup(MAXTOUCH_TWI_INTERFACE, &twi_opt);
-	Assert(status == STATUS_OK);
+	if (twihs_master_setup(MAXTOUCH_TWI_INTERFACE, &twi_opt) != STATUS_OK) {
+		return BOOT_FAIL;
+	}
+	return MXT_RESET_TIME;
+}
 
+static uint32_t boot_mxt_info(void *ctx){
 	/* Initialize the maXTouch device */
-	status = mxt_init_device(device, MAXTOUCH_TWI_INTERFACE,
-			MAXTOUCH_TWI_ADDRESS, MAXTOUCH_XPRO_CHG_PIO);
-	Assert(status == STATUS_OK);
+	if (mxt_init_device(ctx, MAXTOUCH_TWI_INTERFACE,
+			MAXTOUCH_TWI_ADDRESS, MAXTOUCH_XPRO_CHG_PIO) != STATUS_OK) {
+		return BOOT_FAIL;
+	}
 
-	/* Issue soft reset of maXTouch device by writing a non-zero value to
-	 * the reset register */
-	mxt_write_config_reg(device, mxt_get_object_address(device,
-			MXT_GEN_COMMANDPROCESSOR_T6, 0)
-			+ MXT_GEN_COMMANDPROCESSOR_RESET, 0x01);
+	/* Uma entrada da tabela de dedos por toque configurado no T9 */
+	touch_tracker_init(mxt_config_num_touch());
+	return 0;
+}
 
-	/* Wait for the reset of the device to complete */
-	delay_ms(MXT_RESET_TIME);
+/* So reescreve T7/T8/T9/T46/T56 se o CRC salvo no T38 nao bater */
+static uint32_t boot_mxt_config(void *ctx){
+	mxt_cfg = mxt_config_start(ctx, false);
 
-	/* Write data to configuration registers in T7 configuration object */
-	mxt_write_config_reg(device, mxt_get_object_address(device,
-			MXT_GEN_POWERCONFIG_T7, 0) + 0, 0x20);
-	mxt_write_config_reg(device, mxt_get_object_address(device,
-			MXT_GEN_POWERCONFIG_T7, 0) + 1, 0x10);
-	mxt_write_config_reg(device, mxt_get_object_address(device,
-			MXT_GEN_POWERCONFIG_T7, 0) + 2, 0x4b);
-	mxt_write_config_reg(device, mxt_get_object_address(device,
-			MXT_GEN_POWERCONFIG_T7, 0) + 3, 0x84);
+	if (mxt_cfg == MXT_CONFIG_ERROR) {
+		return BOOT_FAIL;
+	}
+	return mxt_cfg == MXT_CONFIG_WRITTEN ? MXT_BACKUP_TIME : 0;
+}
 
-	/* Write predefined configuration data to configuration objects */
-	mxt_write_config_object(device, mxt_get_object_address(device,
-			MXT_GEN_ACQUISITIONCONFIG_T8, 0), &t8_object);
-	mxt_write_config_object(device, mxt_get_object_address(device,
-			MXT_TOUCH_MULTITOUCHSCREEN_T9, 0), &t9_object);
-	mxt_write_config_object(device, mxt_get_object_address(device,
-			MXT_SPT_CTE_CONFIGURATION_T46, 0), &t46_object);
-	mxt_write_config_object(device, mxt_get_object_address(device,
-			MXT_PROCI_SHIELDLESS_T56, 0), &t56_object);
+static uint32_t boot_mxt_calibrate(void *ctx){
+	if (mxt_cfg == MXT_CONFIG_WRITTEN) {
+		mxt_config_finish(ctx);
+	}
+	return 0;
+}
 
-	/* Issue recalibration command to maXTouch device by writing a non-zero
-	 * value to the calibrate register */
-	mxt_write_config_reg(device, mxt_get_object_address(device,
-			MXT_GEN_COMMANDPROCESSOR_T6, 0)
-			+ MXT_GEN_COMMANDPROCESSOR_CALIBRATE, 0x01);
+static uint32_t boot_io_uart(void *ctx){
+	/* Initialize stdio on USART */
+	stdio_serial_init(USART_SERIAL_EXAMPLE, &usart_serial_options);
+	dma_init();
+	uart_dma_init();
+	/* A partir daqui o printf nao espera a transmissao */
+	uart_dma_stdio();
+	/* Console de um caractere e comandos remotos pela interrupcao de RX */
+	remote_init(console_command, remote_command, ctx);
+	telemetry_init();
+	return 0;
 }
 
-void draw_screen(void) {
-	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_WHITE));
-	ili9488_draw_filled_rectangle(0, 0, ILI9488_LCD_WIDTH-1, ILI9488_LCD_HEIGHT-1);
+static uint32_t boot_io_misc(void *ctx){
+	sched_init();
+	init_led();
+	init_but();
+	RTC_init();
+	touch_filter_init();
+	touch_calib_init();
+	motor_init();
+	vibra_init();
+	estima_modelo_init(&modelo_tempo);
+	return 0;
 }
 
-uint32_t convert_axis_system_x(uint32_t touch_y) {
-	// entrada: 4096 - 0 (sistema de coordenadas atual)
-	return ILI9488_LCD_HEIGHT - ILI9488_LCD_HEIGHT*touch_y/4096;
+/* Grava o valor atual de \p chave; recusada, fica para o kv_tick */
+static void kv_salva(enum kv_chave chave){
+	bool ok;
+	
+	switch(chave){
+		case KV_CALIB_TOQUE:
+			ok = kv_grava(chave, touch_calib_get(), sizeof(struct touch_calib));
+			break;
+		case KV_ESTIMA:
+			ok = kv_grava(chave, &modelo_tempo, sizeof(modelo_tempo));
+			break;
+		case KV_USO:
+			ok = kv_grava(chave, &uso, sizeof(uso));
+			break;
+		case KV_PROGRAMAS:
+			ok = programas_grava();
+			break;
+		default:
+			return;
+	}
+	if(ok){
+		kv_pendentes &= ~(1u << chave);
+	}else{
+		kv_pendentes |= 1u << chave;
+	}
 }
 
-uint32_t convert_axis_system_y(uint32_t touch_x) {
-	// entrada: 0 - 4096 (sistema de coordenadas atual)
+/* O EEFC segura a CPU enquanto apaga: so com a maquina parada e nada
+ * para desenhar ou ler do maXTouch. Acabada a manutencao, as gravacoes
+ * recusadas por falta de segmento apagado vao de novo */
+static void kv_tick(void *ctx){
+	struct mxt_device *device = ctx;
 	
-	return ILI9488_LCD_WIDTH - ILI9488_LCD_WIDTH*touch_x/4096;
+	if(ciclo_terminou(&lavagem) && motor_parado() && !render_pendente() &&
+			!mxt_is_message_pending(device) && !kv_manutencao()){
+		for(enum kv_chave k = KV_CALIB_TOQUE; k <= KV_PROGRAMAS; k++){
+			if(kv_pendentes & (1u << k)){
+				kv_salva(k);
+			}
+		}
+	}
+}
+
+/* Calibracao e modelo de tempo gravados substituem os de fabrica */
+static uint32_t boot_io_kv(void *ctx){
+	struct touch_calib cal;
+	struct estima_modelo m;
+	uint8_t n;
+	
+	kv_init();
+	if(kv_le(KV_CALIB_TOQUE, &cal, sizeof(cal)) == sizeof(cal)){
+		touch_calib_load(&cal);
+	}
+	if(kv_le(KV_ESTIMA, &m, sizeof(m)) == sizeof(m) && estima_modelo_valido(&m)){
+		modelo_tempo = m;
+	}
+	/* Programas do usuario no carrossel, mesmo que a tela ja esteja nele */
+	programas_carrega(&modelo_tempo);
+	const t_ciclo *const *lista = programas_lista(&n);
+	telas_set_ciclos(lista, n, telas_ciclo_indice());
+	
+	kv_le(KV_USO, &uso, sizeof(uso));
+	uso.boots++;
+	kv_salva(KV_USO);
+	sched_every("kv", KV_MANUTENCAO_MS, KV_MANUTENCAO_MS, SCHED_PRIO_LOW, kv_tick, ctx);
+	return 0;
 }
 
-void mxt_handler(struct mxt_device *device, struct botao *botoes, uint Nbotoes)
+static const struct boot_step boot_lcd[] = {
+	{"reset",     boot_lcd_reset},
+	{"sleep_out", boot_lcd_step},
+	{"config",    boot_lcd_step},
+	{"splash",    boot_lcd_splash},
+};
+
+static const struct boot_step boot_mxt[] = {
+	{"twi",       boot_mxt_twi},
+	{"info",      boot_mxt_info},
+	{"config",    boot_mxt_config},
+	{"calibra",   boot_mxt_calibrate},
+};
+
+static const struct boot_step boot_io[] = {
+	{"uart",      boot_io_uart},
+	{"perif",     boot_io_misc},
+	{"kv",        boot_io_kv},
+};
+
+/* Toque valido em pixels -> botao da tela atual. Retorna false se nao acertou nenhum */
+static bool dispatch_tap(uint32_t x, uint32_t y)
+{
+	uint8_t n;
+	struct botao *const *botoes = telas_botoes(&n);
+	struct botao *b = processa_touch(botoes, n, x, y);
+
+	if(b != NULL){
+		TRACE("tap (%lu,%lu) tela %d", x, y, tela_atual);
+		latency_mark(LAT_MARK_CALLBACK);
+		botao_tocado = b;
+		b->p_handler();
+		/* O desenho fica para o estagio de render; a amostra espera por ele */
+		if(render_pendente()){
+			latency_defer();
+		}
+		else{
+			latency_discard();
+		}
+		return true;
+	}
+	latency_discard();
+	return false;
+}
+
+/*
+ * Caminho de um evento cru do maXTouch ate o callback do botao. Usado
+ * pelo mxt_handler e pelos toques injetados pela USART (remote.h).
+ */
+static void process_touch_event(struct mxt_touch_event *touch_event)
+{
+	latency_mark(LAT_MARK_READ);
+	
+	/* Quadro binario para analise offline; so copia para o buffer
+	 * do DMA, nao espera a USART */
+	telemetry_touch(touch_event, latency_now());
+	
+	/* Mediana + IIR + debounce; so um toque valido vira TAP */
+	struct mxt_touch_event filtrado;
+	enum touch_filter_result res = touch_filter_process(touch_event, &filtrado);
+	
+	/* Dedos secundarios (mao apoiada, segundo toque) nao disparam nada */
+	const struct touch_track *dedo = touch_tracker_update(&filtrado);
+	if (dedo == NULL || !dedo->primary) {
+		res = TOUCH_FILTER_NONE;
+	}
+	
+	/* maXTouch -> pixels: matriz afim ja com a orientacao do LCD */
+	uint32_t conv_x, conv_y;
+	touch_calib_apply(touch_calib_active(), filtrado.x, filtrado.y, &conv_x, &conv_y);
+	
+	if (res == TOUCH_FILTER_TAP){
+		dispatch_tap(conv_x, conv_y);
+	}
+	else{
+		latency_discard();
+	}
+}
+
+/* Bit OFL do status do T6: a fila de mensagens do maXTouch estourou */
+#define MXT_T6_STATUS_OFL 0x40
+
+/*
+ * Como mxt_read_touch_event, mas olha tambem o T6: um estouro da fila
+ * e a unica prova de que um release pode ter se perdido.
+ */
+static status_code_t read_touch_event(struct mxt_device *device,
+		struct mxt_touch_event *touch_event)
+{
+	struct mxt_conf_messageprocessor_t5 message;
+	status_code_t status;
+
+	while (mxt_is_message_pending(device)) {
+		if ((status = mxt_read_message(device, &message)) != STATUS_OK) {
+			return status;
+		}
+
+		switch (mxt_get_object_type(device, &message)) {
+		case MXT_TOUCH_MULTITOUCHSCREEN_T9:
+			touch_event->id = message.reportid - device->multitouch_report_offset;
+			touch_event->status = message.message[0];
+			touch_event->x = (message.message[1] << 4) |
+					((message.message[3] & 0xf0) >> 4);
+			touch_event->y = (message.message[2] << 4) |
+					(message.message[3] & 0x0f);
+			touch_event->size = message.message[4];
+			return STATUS_OK;
+
+		case MXT_GEN_COMMANDPROCESSOR_T6:
+			if (message.message[0] & MXT_T6_STATUS_OFL) {
+				touch_tracker_overflow();
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return ERR_BAD_DATA;
+}
+
+void mxt_handler(struct mxt_device *device)
 {
-	/* USART tx buffer initialized to 0 */
-	char tx_buf[STRING_LENGTH * MAX_ENTRIES] = {0};
 	uint8_t i = 0; /* Iterator */
 
 	/* Temporary touch event data struct */
 	struct mxt_touch_event touch_event;
 
-	/* Collect touch events and put the data in a string,
-	 * maximum 2 events at the time */
+	/* Collect touch events, maximum MAX_ENTRIES events at the time */
 	do {
-		/* Temporary buffer for each new touch event line */
-		char buf[STRING_LENGTH];
-	
 		/* Read next next touch event in the queue, discard if read fails */
-		if (mxt_read_touch_event(device, &touch_event) != STATUS_OK) {
+		if (read_touch_event(device, &touch_event) != STATUS_OK) {
 			continue;
 		}
-		
-		 // eixos trocados (quando na vertical LCD)
-		//uint32_t conv_x = convert_axis_system_x(touch_event.y);
-		//uint32_t conv_y = convert_axis_system_y(touch_event.x);
-		uint32_t conv_x = convert_axis_system_y(touch_event.x);
-		uint32_t conv_y = convert_axis_system_x(touch_event.y);
-		
-		/* Format a new entry in the data string that will be sent over USART */
-		sprintf(buf, "X:%3d Y:%3d \n", conv_x, conv_y);
-		
-		if (touch_event.status == 32){
-			/* -----------------------------------------------------*/
-			struct botao bAtual;
-			if(processa_touch(botoes, &bAtual, Nbotoes, conv_x, conv_y)){
-				bAtual.p_handler();
-			}
-			//update_screen(conv_x, conv_y);
-			/* -----------------------------------------------------*/
-		}
-		/* Add the new string to the string buffer */
-		strcat(tx_buf, buf);
+		process_touch_event(&touch_event);
 		i++;
 
 		/* Check if there is still messages in the queue and
 		 * if we have reached the maximum numbers of events */
 	} while ((mxt_is_message_pending(device)) & (i < MAX_ENTRIES));
-
-	/* If there is any entries in the buffer, send them over USART */
-	if (i > 0) {
-		usart_serial_write_packet(USART_SERIAL_EXAMPLE, (uint8_t *)tx_buf, strlen(tx_buf));
-	}
-}
-
-void build_laundry_types(){
-	//c_rapido.nome = "Rapido";
-	c_rapido.enxagueTempo = 5;
-	c_rapido.enxagueQnt = 3;
-	c_rapido.centrifugacaoRPM = 900;
-	c_rapido.centrifugacaoTempo = 5;
-	c_rapido.heavy = 0;
-	c_rapido.bubblesOn = 1;
-
-	//c_diario.nome = "Diario";
-	c_diario.enxagueTempo = 15;
-	c_diario.enxagueQnt = 2;
-	c_diario.centrifugacaoRPM = 1200;
-	c_diario.centrifugacaoTempo = 8;
-	c_diario.heavy = 0;
-	c_diario.bubblesOn = 1;
-	
-	//c_pesado.nome = "Pesado";
-	c_pesado.enxagueTempo = 10;
-	c_pesado.enxagueQnt = 3;
-	c_pesado.centrifugacaoRPM = 1200;
-	c_pesado.centrifugacaoTempo = 10;
-	c_pesado.heavy = 1;
-	c_pesado.bubblesOn = 1;
 }
 
+/* Geometria e callbacks em telas_defs.c; as imagens sao da placa */
 void build_buttons(){
-	botaoLavagemDiaria.x = 150;
-	botaoLavagemDiaria.y = 50;
-	botaoLavagemDiaria.size_x = 180;
-	botaoLavagemDiaria.size_y = 180;
-	botaoLavagemDiaria.p_handler = lavagem_callback;
+	botoes_init();
 	botaoLavagemDiaria.image = &diario;
-	
-	botaoLavagemPesada.x = 150;
-	botaoLavagemPesada.y = 50;
-	botaoLavagemPesada.size_x = 180;
-	botaoLavagemPesada.size_y = 180;
-	botaoLavagemPesada.p_handler = lavagem_callback;
 	botaoLavagemPesada.image = &pesado;
-	
-	botaoLavagemRapida.x = 150;
-	botaoLavagemRapida.y = 50;
-	botaoLavagemRapida.size_x = 180;
-	botaoLavagemRapida.size_y = 180;
-	botaoLavagemRapida.p_handler = lavagem_callback;
 	botaoLavagemRapida.image = &rapido;
-
-	botaoDireita.x = 400;
-	botaoDireita.y = 90;
-	botaoDireita.size_x = 75;
-	botaoDireita.size_y = 110;
-	botaoDireita.p_handler = slice_right_callback;
+	/* Enxague e centrifuga nao tem icone proprio: usam o da rapida e o
+	 * da pesada */
+	botaoLavagemEnxague.image = &rapido;
+	botaoLavagemCentrifuga.image = &pesado;
+	/* Nao ha icone proprio: programas do usuario usam o da diaria */
+	botaoLavagemUsuario.image = &diario;
 	botaoDireita.image = &right_arrow;
-	
-	botaoEsquerda.x = 20;
-	botaoEsquerda.y = 90;
-	botaoEsquerda.size_x = 75;
-	botaoEsquerda.size_y = 110;
-	botaoEsquerda.p_handler = slice_left_callback;
 	botaoEsquerda.image = &left_arrow;
-
-	botaoUnlock.x = 400;
-	botaoUnlock.y = 240;
-	botaoUnlock.size_x = 70;
-	botaoUnlock.size_y = 70;
-	botaoUnlock.p_handler = unlock_callback;
 	botaoUnlock.image = &unlock;
-	
-	botaoLock.x = 20;
-	botaoLock.y = 240;
-	botaoLock.size_x = 70;
-	botaoLock.size_y = 70;
 	botaoLock.image = &lock;
-	
-	botaoHome.x = 20;
-	botaoHome.y = 90;
-	botaoHome.size_x = 100;
-	botaoHome.size_y = 100;
-	botaoHome.p_handler = home_callback;
 	botaoHome.image = &home;
-	
-	botaoPlayPause.x = 380;
-	botaoPlayPause.y = 90;
-	botaoPlayPause.size_x = 100;
-	botaoPlayPause.size_y = 100;
-	botaoPlayPause.p_handler = play_pause_callback;
 	botaoPlayPause.image = &play_pause;
-		
-	botaoOk.x = 175;
-	botaoOk.y = 105;
-	botaoOk.size_x = 100;
-	botaoOk.size_y = 100;
-	botaoOk.p_handler = home_callback;
 	botaoOk.image = &OK;
-	
-	imageNop.x = 115;
-	imageNop.y = 35;
-	imageNop.size_x = 251;
-	imageNop.size_y = 251;
 	imageNop.image = &nopImage;
 }
 
-void draw_laundry_menu(){
-	ili9488_draw_pixmap(botaoHome.x,
-	botaoHome.y,
-	botaoHome.image->width,
-	botaoHome.image->height,
-	botaoHome.image->data);
-	
-	ili9488_draw_pixmap(botaoPlayPause.x,
-	botaoPlayPause.y,
-	botaoPlayPause.image->width,
-	botaoPlayPause.image->height,
-	botaoPlayPause.image->data);
-	
-	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_BLACK));
-	ili9488_draw_string(botaoHome.x + 25,
-						botaoHome.y + botaoHome.image->height + 10,
-						"HOME" );
-	
-	ili9488_draw_string(botaoPlayPause.x + 5,
-	botaoPlayPause.y + botaoPlayPause.image->height + 10,
-	"INICIAR" );
-	
-	ili9488_draw_pixmap(botaoUnlock.x,
-	botaoUnlock.y,
-	botaoUnlock.image->width,
-	botaoUnlock.image->height,
-	botaoUnlock.image->data);
-	
-	switch(laundry_event){
-		case 0:
-			time_left = calculate_total_time(c_diario);
-			break;
-		
-		case 1:
-			time_left = calculate_total_time(c_pesado);
-			break;
-		
-		case 2:
-			time_left = calculate_total_time(c_rapido);
-			break;
+/* Toda tela comeca do zero: o proximo widgets_frame repinta o fundo */
+static void begin_screen(void){
+	widgets_limpa();
+	w_unlock = NULL;
+	w_lock = NULL;
+	w_tempo = NULL;
+	w_progresso = NULL;
+	w_fase = NULL;
+	w_total = NULL;
+	for(int c = 0; c < N_CAMPOS; c++){
+		w_campo[c] = NULL;
+	}
+	w_relogio = NULL;
+	w_modo = NULL;
+	w_hora = NULL;
+	w_minuto = NULL;
+	w_plano = NULL;
+	w_fim = NULL;
+}
+
+/* Contorno que some do azul para o fundo em volta do botao recem tocado */
+static void add_press_feedback(const struct botao *b){
+	if(botao_tocado != b){
+		return;
 	}
+	struct widget *w = widget_retangulo(b->x - 4, b->y - 4,
+			b->image->width + 8, b->image->height + 8, COLOR_BLUE, false);
+	anim_start("toque", w, ANIM_COR, COLOR_BLUE, WIDGET_FUNDO, 300, ANIM_ENTRA);
+}
+
+static void add_lock_widgets(void){
+	w_unlock = widget_botao(&botaoUnlock);
+	w_lock = widget_botao(&botaoLock);
+	update_lock_widgets();
+}
+
+void draw_laundry_menu(const t_ciclo *ciclo){
+	begin_screen();
 	
+	widget_botao(&botaoHome);
+	widget_botao(&botaoPlayPause);
+	widget_texto(botaoHome.x + 25, botaoHome.y + botaoHome.image->height + 10, "HOME");
+	widget_texto(botaoPlayPause.x + 5, botaoPlayPause.y + botaoPlayPause.image->height + 10, "INICIAR");
+	widget_tecla(&botaoEditar, "EDITAR");
+	widget_tecla(&botaoAgendar, "AGENDAR");
+	add_lock_widgets();
 	
-	char total_left[32];
-	
-	sprintf(total_left,"%02d",time_left);
-	font_draw_text(&calibri_36, total_left, 180, 150, 1);
-	
-	ili9488_draw_string(225, 160, "MINUTOS" );
-	
-	time_left = 0;
-}
-
-void draw_diary_page(){
-	ili9488_draw_pixmap(botaoLavagemDiaria.x,
-	botaoLavagemDiaria.y,
-	botaoLavagemDiaria.image->width,
-	botaoLavagemDiaria.image->height,
-	botaoLavagemDiaria.image->data);
-	
-	ili9488_draw_pixmap(botaoDireita.x,
-	botaoDireita.y,
-	botaoDireita.image->width,
-	botaoDireita.image->height,
-	botaoDireita.image->data);
-	
-	ili9488_draw_pixmap(botaoEsquerda.x,
-	botaoEsquerda.y,
-	botaoEsquerda.image->width,
-	botaoEsquerda.image->height,
-	botaoEsquerda.image->data);
-	
-	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_BLACK));
-	ili9488_draw_string(botaoLavagemDiaria.x + 5,
-						botaoLavagemDiaria.y + botaoLavagemDiaria.image->height + 10,
-						"LAVAGEM DIARIA" );
-						
-	ili9488_draw_pixmap(botaoUnlock.x,
-	botaoUnlock.y,
-	botaoUnlock.image->width,
-	botaoUnlock.image->height,
-	botaoUnlock.image->data);
-}
-
-void draw_fast_page(){
-	ili9488_draw_pixmap(botaoLavagemRapida.x,
-	botaoLavagemRapida.y,
-	botaoLavagemRapida.image->width,
-	botaoLavagemRapida.image->height,
-	botaoLavagemRapida.image->data);
-	
-	ili9488_draw_pixmap(botaoDireita.x,
-	botaoDireita.y,
-	botaoDireita.image->width,
-	botaoDireita.image->height,
-	botaoDireita.image->data);
-	
-	ili9488_draw_pixmap(botaoEsquerda.x,
-	botaoEsquerda.y,
-	botaoEsquerda.image->width,
-	botaoEsquerda.image->height,
-	botaoEsquerda.image->data);
-	
-	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_BLACK));
-	ili9488_draw_string(botaoLavagemRapida.x + 5,
-						botaoLavagemRapida.y + botaoLavagemRapida.image->height + 10,
-						"LAVAGEM RAPIDA" );
-						
-	ili9488_draw_pixmap(botaoUnlock.x,
-	botaoUnlock.y,
-	botaoUnlock.image->width,
-	botaoUnlock.image->height,
-	botaoUnlock.image->data);
-}
-
-void draw_heavy_page(){
-	ili9488_draw_pixmap(botaoLavagemPesada.x,
-	botaoLavagemPesada.y,
-	botaoLavagemPesada.image->width,
-	botaoLavagemPesada.image->height,
-	botaoLavagemPesada.image->data);
-	
-	ili9488_draw_pixmap(botaoDireita.x,
-	botaoDireita.y,
-	botaoDireita.image->width,
-	botaoDireita.image->height,
-	botaoDireita.image->data);
-	
-	ili9488_draw_pixmap(botaoEsquerda.x,
-	botaoEsquerda.y,
-	botaoEsquerda.image->width,
-	botaoEsquerda.image->height,
-	botaoEsquerda.image->data);
-	
-	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_BLACK));
-	ili9488_draw_string(botaoLavagemPesada.x + 5,
-						botaoLavagemPesada.y + botaoLavagemPesada.image->height + 10,
-						"LAVAGEM PESADA" );
-						
-						
-	ili9488_draw_pixmap(botaoUnlock.x,
-	botaoUnlock.y,
-	botaoUnlock.image->width,
-	botaoUnlock.image->height,
-	botaoUnlock.image->data);
+	widget_contagem(180, 150, &calibri_36, 2, (estima_previsto_s(&modelo_tempo, ciclo) + 59) / 60);
+	widget_texto(225, 160, "MINUTOS");
+}
+
+/* Pagina do carrossel: icone e nome vem do ciclo */
+void draw_cycle_page(const t_ciclo *ciclo){
+	const struct botao *icone = ciclo->botao;
+	char nome[WIDGET_TEXTO_MAX];
+	
+	begin_screen();
+	
+	struct widget *wi = widget_botao(icone);
+	widget_botao(&botaoDireita);
+	widget_botao(&botaoEsquerda);
+	snprintf(nome, sizeof(nome), "LAVAGEM %s", ciclo->nome);
+	widget_texto(icone->x + 5, icone->y + icone->image->height + 10, nome);
+	add_lock_widgets();
+	add_press_feedback(&botaoDireita);
+	add_press_feedback(&botaoEsquerda);
+	
+	/* Icone novo entra pelo lado da seta tocada */
+	if(slide_dir != 0){
+		anim_start("carrossel", wi, ANIM_X, icone->x + slide_dir * CAROUSEL_SLIDE,
+				icone->x, 180, ANIM_SAI);
+		slide_dir = 0;
+	}
+	botao_tocado = NULL;
 }
 
 void RTC_Handler(void)
@@ -713,7 +814,12 @@ void RTC_Handler(void)
 	*/
 	if ((ul_status & RTC_SR_SEC) == RTC_SR_SEC) {
 		rtc_clear_status(RTC, RTC_SCCR_SECCLR);
-		print_time_value = 1u;
+		event_post(EV_RTC_SEC);
+	}
+	
+	if ((ul_status & RTC_SR_ALARM) == RTC_SR_ALARM) {
+		rtc_clear_status(RTC, RTC_SCCR_ALRCLR);
+		event_post(EV_ALARME);
 	}
 	
 	rtc_clear_status(RTC, RTC_SCCR_ACKCLR);
@@ -740,106 +846,522 @@ void RTC_init(){
 	NVIC_EnableIRQ(RTC_IRQn);
 }
 
-int calculate_total_time(t_ciclo act_cicle){
-	int total = act_cicle.centrifugacaoTempo + 
-				(act_cicle.enxagueQnt * act_cicle.enxagueTempo);
-	return total;
+void draw_done_laundry(const t_ciclo *ciclo){
+	begin_screen();
+	
+	widget_texto(135, 75, "LAVAGEM CONCLUIDA");
+	widget_botao(&botaoOk);
+	
+	/* Sublinhado que se revela da esquerda para a direita */
+	struct widget *sub = widget_retangulo(135, 93, 0, 3, COLOR_BLUE, true);
+	anim_start("concluida", sub, ANIM_CLIP, 0, strlen("LAVAGEM CONCLUIDA") * 12, 400, ANIM_ENTRA_SAI);
 }
 
-void font_draw_text(tFont *font, const char *text, int x, int y, int spacing) {
-	char *p = text;
-	while(*p != NULL) {
-		char letter = *p;
-		int letter_offset = letter - font->start_char;
-		if(letter <= font->end_char) {
-			tChar *current_char = font->chars + letter_offset;
-			ili9488_draw_pixmap(x, y, current_char->image->width, current_char->image->height, current_char->image->data);
-			x += current_char->image->width + spacing;
-		}
-		p++;
+/* Contagem, fase e barra sao atualizadas pelo cycle_tick, sem repintar a tela */
+void draw_working(const t_ciclo *ciclo){
+	begin_screen();
+	
+	w_tempo = widget_contagem(60, 90, &arial_72, 2, time_left);
+	widget_texto(150, 140, "MINUTOS RESTANTES");
+	w_fase = widget_texto(60, 200, "");
+	widget_botao(&botaoPlayPause);
+	w_progresso = widget_progresso(40, 250, 400, 16, COLOR_BLUE, 1000);
+	update_cycle_widgets();
+}
+
+/* Editor: uma linha por campo com nome, valor, - e + */
+void draw_editor(const t_ciclo *ciclo){
+	const t_ciclo *r = programas_rascunho();
+	char titulo[WIDGET_TEXTO_MAX];
+	
+	begin_screen();
+	
+	snprintf(titulo, sizeof(titulo), "EDITAR %s", r->nome);
+	widget_texto(20, 10, titulo);
+	for(int c = 0; c < N_CAMPOS; c++){
+		uint16_t y = EDITOR_Y(c) + (EDITOR_TECLA_H - WIDGET_TEXTO_H) / 2;
+		widget_texto(20, y, programas_campo_nome(c));
+		w_campo[c] = widget_texto(200, y, "");
+		widget_tecla(&botoesCampo[c][0], "-");
+		widget_tecla(&botoesCampo[c][1], "+");
 	}
+	widget_tecla(&botaoVoltar, "VOLTAR");
+	w_total = widget_texto(165, 283, "");
+	widget_tecla(&botaoSalvar, "SALVAR");
+	update_editor_widgets();
 }
 
-void draw_done_laundry(){
-	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_WHITE));
-	draw_screen();
+/* Os setters so invalidam o que mudou: um toque redesenha um valor e o total */
+static void update_editor_widgets(void){
+	const t_ciclo *r = programas_rascunho();
+	char texto[WIDGET_TEXTO_MAX];
 	
-	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_BLACK));
-	ili9488_draw_string(135, 75, "LAVAGEM CONCLUIDA" );
+	for(int c = 0; c < N_CAMPOS; c++){
+		programas_campo_texto(r, c, texto, sizeof(texto));
+		widget_texto_set(w_campo[c], texto);
+	}
+	snprintf(texto, sizeof(texto), "TOTAL %lu MIN",
+			(unsigned long)(estima_previsto_s(&modelo_tempo, r) + 59) / 60);
+	widget_texto_set(w_total, texto);
+}
+
+/* Agendamento: modo, horario com - e + de hora e minuto e quando liga */
+void draw_schedule(const t_ciclo *ciclo){
+	struct agenda_data hoje;
+	char titulo[WIDGET_TEXTO_MAX];
 	
-	ili9488_draw_pixmap(botaoOk.x,
-	botaoOk.y,
-	botaoOk.image->width,
-	botaoOk.image->height,
-	botaoOk.image->data);
+	begin_screen();
+	agenda_sugere(&agenda, read_clock(&hoje));
 	
-	botoes[0] = botaoOk;
-	n_botoes_na_tela = 1;
+	snprintf(titulo, sizeof(titulo), "AGENDAR %s", ciclo->nome);
+	widget_texto(20, 10, titulo);
+	w_relogio = widget_texto(380, 10, "");
+	w_modo = widget_tecla(&botaoModo, "");
+	widget_tecla(&botoesHorario[0], "H -");
+	widget_tecla(&botoesHorario[1], "H +");
+	w_hora = widget_contagem(170, 105, &calibri_36, 2, 0);
+	widget_texto(218, 115, ":");
+	w_minuto = widget_contagem(232, 105, &calibri_36, 2, 0);
+	widget_tecla(&botoesHorario[2], "M -");
+	widget_tecla(&botoesHorario[3], "M +");
+	w_plano = widget_texto(20, 170, "");
+	w_fim = widget_texto(20, 195, "");
+	widget_tecla(&botaoVoltar, "VOLTAR");
+	widget_tecla(&botaoSalvar, "CONFIRMAR");
+	update_schedule_widgets();
 }
 
-void draw_working(int time_left){
-	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_WHITE));
-	draw_screen();
+/* Agendado: o plano armado fica na tela ate apagar */
+void draw_scheduled(const t_ciclo *ciclo){
+	struct agenda_data hoje;
+	char texto[WIDGET_TEXTO_MAX];
 	
-	char total_left[32];
+	begin_screen();
+	read_clock(&hoje);
 	
-	sprintf(total_left,"%02d",time_left);
-	font_draw_text(&arial_72, total_left, 120, 90, 1);
+	widget_texto(20, 10, "LAVAGEM AGENDADA");
+	widget_texto(20, 45, ciclo->nome);
+	snprintf(texto, sizeof(texto), "LIGA %s AS %02u:%02u",
+			plano.data.dia == hoje.dia ? "HOJE" : "AMANHA", plano.hora, plano.minuto);
+	widget_texto(20, 95, texto);
+	snprintf(texto, sizeof(texto), "TERMINA AS %02u:%02u",
+			plano.fim_min / 60, plano.fim_min % 60);
+	widget_texto(20, 120, texto);
+	w_relogio = widget_texto(20, 170, "");
+	widget_texto(20, 195, "A TELA VAI APAGAR");
+	widget_tecla(&botaoVoltar, "CANCELAR");
+	update_schedule_widgets();
+}
+
+/* Relogio a cada segundo do RTC; na edicao o plano e refeito com ele */
+static void update_schedule_widgets(void){
+	struct agenda_data hoje;
+	uint32_t agora = read_clock(&hoje);
+	char texto[WIDGET_TEXTO_MAX];
 	
-	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_BLACK));
-	ili9488_draw_string(210, 140, "MINUTOS RESTANTES" );
+	snprintf(texto, sizeof(texto), "%02lu:%02lu:%02lu", (unsigned long)agora / 3600,
+			(unsigned long)agora / 60 % 60, (unsigned long)agora % 60);
+	widget_texto_set(w_relogio, texto);
+	if(tela_atual != TELA_AGENDA){
+		return;
+	}
 	
+	widget_texto_set(w_modo, agenda_modo_nome(agenda.modo));
+	widget_valor_set(w_hora, agenda.alvo_min / 60);
+	widget_valor_set(w_minuto, agenda.alvo_min % 60);
+	if(plan_schedule(telas_ciclo(), &hoje)){
+		snprintf(texto, sizeof(texto), "LIGA %s AS %02u:%02u",
+				plano.data.dia == hoje.dia ? "HOJE" : "AMANHA", plano.hora, plano.minuto);
+		widget_texto_set(w_plano, texto);
+		snprintf(texto, sizeof(texto), "TERMINA AS %02u:%02u",
+				plano.fim_min / 60, plano.fim_min % 60);
+		widget_texto_set(w_fim, texto);
+	}
+	else{
+		widget_texto_set(w_plano, agenda.modo == AGENDA_FIM ? "NAO DA TEMPO" : "HORARIO MUITO PROXIMO");
+		widget_texto_set(w_fim, "");
+	}
 }
 
-void draw_door_open(){
-	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_WHITE));
-	draw_screen();
+void draw_door_open(const t_ciclo *ciclo){
+	begin_screen();
 	
-	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_BLACK));
-	ili9488_draw_string(135, 75, "A PORTA ESTA ABERTA" );
+	widget_texto(135, 75, "A PORTA ESTA ABERTA");
+	widget_botao(&botaoOk);
+}
+
+void draw_locked_door(const t_ciclo *ciclo){
+	begin_screen();
 	
-	ili9488_draw_pixmap(botaoOk.x,
-	botaoOk.y,
-	botaoOk.image->width,
-	botaoOk.image->height,
-	botaoOk.image->data);
+	widget_botao(&imageNop);
+	widget_texto(imageNop.x + 20, imageNop.y + imageNop.image->width + 10, "PORTA TRANCADA");
 	
-	botoes[0] = botaoOk;
-	n_botoes_na_tela = 1;
+	/* Aviso fica 1 s na tela sem travar o loop; a lavagem continua */
+	sched_after("porta", 1000, 50, SCHED_PRIO_NORMAL, locked_door_done, NULL);
+}
+
+void locked_door_done(void *ctx){
+	if(tela_atual == TELA_PORTA_TRANCADA){
+		telas_vai(time_left>0 ? TELA_LAVANDO : TELA_CONCLUIDA);
+	}
+}
+
+/* Fase atual ("ENXAGUE 2/3"), contagem e barra; os setters ignoram valor repetido */
+static void update_cycle_widgets(void){
+	const struct fase *f = ciclo_fase(&lavagem);
+	char texto[WIDGET_TEXTO_MAX];
 	
+	widget_valor_set(w_tempo, time_left);
+	widget_valor_set(w_progresso, estima_progresso(&estimativa, &lavagem));
+	if(f == NULL){
+		return;
+	}
+	if(lavagem.pausado){
+		snprintf(texto, sizeof(texto), "PAUSADO");
+	}
+	else if(f->rodada > 0){
+		snprintf(texto, sizeof(texto), "%s %u/%u", ciclo_fase_nome(f->tipo),
+				f->rodada, lavagem.n_enxagues);
+	}
+	else{
+		snprintf(texto, sizeof(texto), "%s", ciclo_fase_nome(f->tipo));
+	}
+	widget_texto_set(w_fase, texto);
 }
 
-void draw_locked_door(){
-	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_WHITE));
-	draw_screen();
+/*
+ * Encher e drenar acabam quando o modelo da agua diz (sorteado no comeco
+ * de cada fase); as rampas quando o motor chega no rpm ou para.
+ */
+static void check_phase_sensor(void){
+	const struct fase *f = ciclo_fase(&lavagem);
+	
+	if(f == NULL || !ciclo_rodando(&lavagem)){
+		return;
+	}
+	if(lavagem.atual != fase_vista){
+		fase_vista = lavagem.atual;
+		fim_agua_s = f->tipo == FASE_ENCHE ? agua_enche_s(&agua)
+				: f->tipo == FASE_DRENA ? agua_drena_s(&agua) : 0;
+	}
+	switch(f->tipo){
+		case FASE_ENCHE:
+		case FASE_DRENA:
+			if(lavagem.fase_s >= fim_agua_s){
+				ciclo_conclui_fase(&lavagem, fim_agua_s);
+			}
+			break;
+		case FASE_SOBE:
+			if(motor_referencia() == f->rpm){
+				ciclo_conclui_fase(&lavagem, lavagem.fase_s);
+			}
+			break;
+		case FASE_DESCE:
+			if(motor_parado() && motor_rpm() == 0){
+				ciclo_conclui_fase(&lavagem, lavagem.fase_s);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+/* Anda a lavagem pelo relogio do escalonador, sem depender do RTC */
+void cycle_tick(void *ctx){
+	uint32_t agora = sched_now_ms();
+	
+	ciclo_avanca_ms(&lavagem, agora - ciclo_ms);
+	ciclo_ms = agora;
+	check_phase_sensor();
 	
-	ili9488_draw_pixmap(imageNop.x,
-	imageNop.y,
-	imageNop.image->width,
-	imageNop.image->height,
-	imageNop.image->data);
+	/* O motor faz a rampa em S ate o rpm da fase; mesmo alvo nao recomeca */
+	motor_alvo(ciclo_rpm(&lavagem), lavagem.ciclo->heavy);
 	
-	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_BLACK));
-	ili9488_draw_string(imageNop.x + 20, 
-						imageNop.y + imageNop.image->width + 10,
-						"PORTA TRANCADA" );
+	if(ciclo_terminou(&lavagem)){
+		estima_fim(&estimativa, &lavagem);
+		uso.lavagens++;
+		kv_salva(KV_ESTIMA);
+		kv_salva(KV_USO);
+		sched_cancel(tarefa_ciclo);
+		tarefa_ciclo = SCHED_INVALID;
+		time_left = 0;
+		telas_evento(TELA_EV_FIM);
+		return;
+	}
+	
+	/* Mostrado suavizado; nunca 0 enquanto a lavagem nao acabou (porta) */
+	time_left = (estima_atualiza(&estimativa, &lavagem) + 59) / 60;
+	if(time_left < 1){
+		time_left = 1;
+	}
 	
-	delay_ms(1000);
-	time_left -= 1;
+	/* Com o aviso de porta trancada na tela, locked_door_done redesenha */
+	if(tela_atual != TELA_PORTA_TRANCADA){
+		update_cycle_widgets();
+	}
 }
 
-void print_time(void){	
-	time_left--;
+/*
+ * Janela de vibracao com o tambor parado na distribuicao: carga boa segue
+ * para a centrifugacao; desbalanceada tomba de novo a roupa, e depois de
+ * DESBALANCO_TENTATIVAS a centrifugacao fica limitada a um rpm seguro.
+ */
+static void check_balance(const struct vibra_janela *j){
+	const struct fase *f = ciclo_fase(&lavagem);
 	
-	if(time_left>0){	
-		draw_working(time_left);
+	if(f == NULL || f->tipo != FASE_DISTRIBUI || balanco_decidido || !ciclo_rodando(&lavagem)){
+		return;
+	}
+	/* So janela inteira com a referencia no rpm da distribuicao */
+	if(!j->estavel || motor_referencia() != f->rpm){
+		return;
+	}
+	
+	if(j->amplitude_g <= DESBALANCO_LIMIAR_G){
+		balanco_decidido = true;
+		printf("balanco: %lu mg a %u rpm, ok\n\r",
+				(unsigned long)(j->amplitude_g * 1000.0f + 0.5f), j->rpm);
+		return;
+	}
+	if(redistribuicoes < DESBALANCO_TENTATIVAS){
+		redistribuicoes++;
+		ciclo_repete_fase(&lavagem);
+		printf("balanco: %lu mg a %u rpm, redistribuindo (%u/%u)\n\r",
+				(unsigned long)(j->amplitude_g * 1000.0f + 0.5f), j->rpm,
+				redistribuicoes, DESBALANCO_TENTATIVAS);
 	}
 	else{
-		rtc_disable_interrupt(RTC,RTC_IER_SECEN);
-		draw_done_laundry();
+		balanco_decidido = true;
+		ciclo_limita_rpm(&lavagem, DESBALANCO_RPM_SEGURO);
+		printf("balanco: %lu mg a %u rpm, centrifugacao limitada a %u rpm\n\r",
+				(unsigned long)(j->amplitude_g * 1000.0f + 0.5f), j->rpm,
+				DESBALANCO_RPM_SEGURO);
+	}
+	
+	/* Tomba a roupa ja; o tempo mostrado se ajusta aos poucos no tick */
+	motor_alvo(ciclo_rpm(&lavagem), lavagem.ciclo->heavy);
+}
+
+void console_command(void *ctx, uint8_t c){
+	struct mxt_device *device = ctx;
+	
+	switch(c){
+		case 'c':
+			/* A calibracao segura o loop ate 3 alvos x TOUCH_CALIB_TIMEOUT_MS:
+			 * so com a maquina parada, e a tela volta como estava */
+			if(!unlocked_flag){
+				break;
+			}
+			if(!ciclo_terminou(&lavagem) || !motor_parado()){
+				printf("calib: so com a maquina parada\n\r");
+				break;
+			}
+			if(touch_calib_run(device)){
+				kv_salva(KV_CALIB_TOQUE);
+			}
+			widgets_invalida_tudo();
+			break;
+		
+		case 'l':
+			latency_dump();
+			break;
+		
+		case 'r':
+			latency_reset();
+			event_stats_reset();
+			sched_stats_reset();
+			render_stats_reset();
+			anim_stats_reset();
+			motor_stats_reset();
+			vibra_stats_reset();
+			estima_stats_reset(&modelo_tempo);
+			kv_stats_reset();
+			sono_stats_reset();
+			printf("latencia zerada\n\r");
+			break;
+		
+		case 's':
+			/* Quadros TELEM_SHOT_*, montados por tools/screenshot.py */
+			screenshot_start();
+			break;
+		
+		case 'w':
+			event_dump();
+			break;
+		
+		case 't':
+			sched_dump();
+			break;
+		
+		case 'q':
+			render_dump();
+			break;
+		
+		case 'a':
+			anim_dump();
+			break;
+		
+		case 'm':
+			motor_dump();
+			break;
+		
+		case 'v':
+			vibra_dump();
+			break;
+		
+		case 'e':
+			estima_dump(&modelo_tempo);
+			break;
+		
+		case 'k':
+			kv_dump();
+			printf("  %lu lavagens, %lu boots\n\r",
+					(unsigned long)uso.lavagens, (unsigned long)uso.boots);
+			break;
+		
+		case 'g':
+			sono_dump();
+			break;
+		
+		case 'z':
+			/* Tela apagada e MCU em wait mode por SONO_TESTE_S */
+			sono_teste();
+			break;
+		
+		case 'u': {
+			struct uart_dma_stats st;
+			uart_dma_get_stats(&st);
+			printf("uart: %lu bytes, %lu descartados, %lu sobrescritos, "
+					"%lu esperas, pico %lu/%u\n\r",
+					(unsigned long)st.written, (unsigned long)st.dropped,
+					(unsigned long)st.overwritten, (unsigned long)st.blocked,
+					(unsigned long)st.high_water, UART_DMA_TX_SIZE);
+			break;
+		}
 	}
 }
 
+/* Redesenha a tela atual sem mudar o estado. False se a tela nao suporta */
+bool redraw_screen(void){
+	/* draw_locked_door tambem agenda a volta para a contagem */
+	if(tela_atual == TELA_PORTA_TRANCADA){
+		return false;
+	}
+	telas_redesenha();
+	render_run();
+	return true;
+}
+
+static void put32(uint8_t **p, uint32_t v){
+	for (int i = 0; i < 4; i++) {
+		*(*p)++ = v & 0xFF;
+		v >>= 8;
+	}
+}
+
+/* Comandos recebidos pela USART (remote.h) */
+void remote_command(void *ctx, uint8_t cmd, uint8_t seq, const uint8_t *args, uint8_t len){
+	uint8_t payload[2 + LAT_N_STAGES * 16 + 4];
+	uint8_t *p = payload;
+	
+	switch(cmd){
+		case REMOTE_TOUCH: {
+			if (len < 5) break;
+			struct mxt_touch_event ev = {
+				.id = 0,
+				.status = args[0],
+				.x = remote_get16(&args[1]),
+				.y = remote_get16(&args[3]),
+				.size = 1,
+			};
+			latency_mark(LAT_MARK_CHG);
+			process_touch_event(&ev);
+			remote_ack(cmd, seq, REMOTE_OK);
+			return;
+		}
+		
+		case REMOTE_TAP:
+			if (len < 4) break;
+			latency_mark(LAT_MARK_CHG);
+			latency_mark(LAT_MARK_READ);
+			remote_ack(cmd, seq, dispatch_tap(remote_get16(&args[0]),
+					remote_get16(&args[2])) ? REMOTE_OK : REMOTE_MISS);
+			return;
+		
+		case REMOTE_STATE: {
+			uint8_t n_botoes;
+			telas_botoes(&n_botoes);
+			*p++ = seq;
+			*p++ = tela_atual;
+			*p++ = telas_ciclo_indice();
+			put32(&p, time_left);
+			*p++ = unlocked_flag;
+			*p++ = door_open;
+			*p++ = n_botoes;
+			telemetry_send(TELEM_STATE, payload, p - payload);
+			return;
+		}
+		
+		case REMOTE_PERF: {
+			if (len < 1 || args[0] >= N_TELAS) break;
+			*p++ = seq;
+			*p++ = args[0];
+			for (int s = 0; s < LAT_N_STAGES; s++) {
+				const struct latency_hist *h = latency_get_hist(args[0], s);
+				put32(&p, h->count);
+				put32(&p, latency_percentile(h, 50));
+				put32(&p, latency_percentile(h, 99));
+				put32(&p, h->max_us);
+			}
+			put32(&p, uart_dma_dropped());
+			telemetry_send(TELEM_PERF, payload, p - payload);
+			return;
+		}
+		
+		case REMOTE_REDRAW:
+			latency_mark(LAT_MARK_CHG);
+			latency_mark(LAT_MARK_READ);
+			latency_mark(LAT_MARK_CALLBACK);
+			if (redraw_screen()) {
+				latency_redraw_done(tela_atual);
+				remote_ack(cmd, seq, REMOTE_OK);
+			}
+			else {
+				latency_discard();
+				remote_ack(cmd, seq, REMOTE_UNSUPPORTED);
+			}
+			return;
+		
+		case REMOTE_SHOT:
+			remote_ack(cmd, seq, screenshot_start() ? REMOTE_OK : REMOTE_BUSY);
+			return;
+		
+		/* O RTC comeca numa data fixa: o agendamento precisa da hora certa */
+		case REMOTE_CLOCK:
+			if (len < 8) break;
+			if (rtc_set_date(RTC, remote_get16(&args[0]), args[2], args[3], args[4]) != 0 ||
+					rtc_set_time(RTC, args[5], args[6], args[7]) != 0) {
+				break;
+			}
+			remote_ack(cmd, seq, REMOTE_OK);
+			return;
+		
+		default:
+			remote_ack(cmd, seq, REMOTE_UNKNOWN);
+			return;
+	}
+	remote_ack(cmd, seq, REMOTE_BAD_ARGS);
+}
+
+/* Falha grave: descarrega o log que ainda estava no buffer antes de parar */
+void HardFault_Handler(void){
+	uart_dma_flush_on_fault();
+	trace_flush();
+	printf("\n\rHardFault: CFSR %08lx HFSR %08lx\n\r",
+			(unsigned long)SCB->CFSR, (unsigned long)SCB->HFSR);
+	while(1);
+}
+
 void init_led(void){
 	pmc_enable_periph_clk(LED1_PIO_ID);
 	
@@ -863,20 +1385,31 @@ void init_but(void){
 	NVIC_SetPriority(UNLOCK_PIO_ID, 3);
 }
 
+/* LED da porta e tela de porta trancada durante a lavagem */
+void update_door(void){
+	/* Abrir a porta cancela o inicio agendado */
+	if(door_open && tela_atual == TELA_AGENDADA){
+		telas_vai(TELA_MENU);
+	}
+	if(door_open){
+		/* Trancada enquanto lava ou o tambor ainda gira */
+		if(time_left>0 || !motor_parado()){
+			telas_vai(TELA_PORTA_TRANCADA);
+			door_open = false;
+		}
+		else{
+			pio_set(LED1_PIO,LED1_PIO_IDX_MASK);
+		}
+	}
+	else{
+		pio_clear(LED1_PIO,LED1_PIO_IDX_MASK);
+	}
+}
+
 void do_unlock(void){
 	if(unlocked_flag == false){
-		//deixa lugar do botao branco
-		ili9488_set_foreground_color(COLOR_CONVERT(COLOR_WHITE));
-		ili9488_draw_filled_rectangle(botaoUnlock.x, botaoUnlock.y, botaoUnlock.x + botaoUnlock.image->width, botaoUnlock.y + botaoUnlock.image->height);
-		ili9488_draw_filled_rectangle(botaoLock.x, botaoLock.y, botaoLock.x + botaoLock.image->width, botaoLock.y + botaoLock.image->height);
-
-		
-		ili9488_draw_pixmap(botaoUnlock.x,
-		botaoUnlock.y,
-		botaoUnlock.image->width,
-		botaoUnlock.image->height,
-		botaoUnlock.image->data);
 		unlocked_flag = true;
+		update_lock_widgets();
 		pio_disable_interrupt(UNLOCK_PIO, UNLOCK_PIO_IDX_MASK);
 		return;
 	}
@@ -886,74 +1419,119 @@ int main(void)
 {
 	struct mxt_device device; /* Device data container */
 
-	/* Initialize the USART configuration struct */
-	const usart_serial_options_t usart_serial_options = {
-		.baudrate     = USART_SERIAL_EXAMPLE_BAUDRATE,
-		.charlength   = USART_SERIAL_CHAR_LENGTH,
-		.paritytype   = USART_SERIAL_PARITY,
-		.stopbits     = USART_SERIAL_STOP_BIT
+	const struct boot_task boot_tasks[] = {
+		{"lcd",  boot_lcd, BOOT_N(boot_lcd), &g_ili9488_display_opt},
+		{"mxt",  boot_mxt, BOOT_N(boot_mxt), &device},
+		{"io",   boot_io,  BOOT_N(boot_io),  &device},
 	};
 
 	sysclk_init(); /* Initialize system clocks */
 	board_init();  /* Initialize board */
-	configure_lcd();
-	draw_screen();
-	init_led();
-	init_but();
-	
-	/* Initialize the mXT touch device */
-	mxt_init(&device);
 	
-	/* Initialize stdio on USART */
-	stdio_serial_init(USART_SERIAL_EXAMPLE, &usart_serial_options);
-
-	printf("\n\rmaXTouch data USART transmitter\n\r");
-	
-	RTC_init();
+	/* DWT e interrupcao do /CHG primeiro: o boot inteiro e medido */
+	latency_init();
+	trace_init();
 	
-	build_buttons();
-	build_laundry_types();
-	draw_diary_page();
+	/* LCD, maXTouch e perifericos intercalados nas esperas uns dos outros */
+	bool boot_ok = boot_run(boot_tasks, BOOT_N(boot_tasks));
 				
-	botoes[0] = botaoLavagemDiaria;
-	botoes[1] = botaoDireita;
-	botoes[2] = botaoEsquerda;
-	botoes[3] = botaoUnlock;
-	botoes[4] = botaoLock;
-	
-	n_botoes_na_tela = 5;
-	print_time_value = 0u;
 	door_open = false;
-	lock_unlock = false;
+	boot_milestone("toque");
+
+	printf("\n\rmaXTouch data USART transmitter\n\r");
+	printf("'l' imprime latencias, 'r' zera, 'c' calibra o toque, 'u' estatisticas da uart, 's' captura a tela, 'w' eventos, 't' tarefas, 'q' fila de render, 'a' animacoes, 'm' motor, 'v' vibracao, 'e' estimativa de tempo, 'k' flash, 'g' agendamento, 'z' sono de teste\n\r");
+	printf("maXTouch: config %s, crc %06lx\n\r",
+			mxt_cfg == MXT_CONFIG_CACHED ? "em cache" :
+			mxt_cfg == MXT_CONFIG_WRITTEN ? "gravada" : "ERRO",
+			(unsigned long)mxt_config_crc());
+	boot_print_timeline();
+	printf("boot %s: splash %lu ms (meta 300), toque %lu ms (meta 500)\n\r",
+			boot_ok ? "ok" : "com FALHAS",
+			(unsigned long)(boot_milestone_us("splash") / 1000),
+			(unsigned long)(boot_milestone_us("toque") / 1000));
 		
+	/* O /CHG pode ja estar baixo desde o boot, sem borda para acordar */
+	event_post(EV_TOUCH);
+	
 	while (true) {
+		/* Dorme ate alguma interrupcao postar um evento */
+		uint32_t ev = event_wait();
+		
 		/* Check for any pending messages and run message handler if any
 		 * message is found in the queue */
-		if (mxt_is_message_pending(&device)) {
-			mxt_handler(&device, botoes, n_botoes_na_tela);
+		if ((ev & EV_TOUCH) && mxt_is_message_pending(&device)) {
+			mxt_handler(&device);
+			/* /CHG continua baixo (sem nova borda) se sobrou mensagem */
+			if (mxt_is_message_pending(&device)) {
+				event_post(EV_TOUCH);
+			}
 		}
 		
-		if (print_time_value){
-			print_time();
-			print_time_value = 0u;
+		if (ev & EV_UART_RX){
+			remote_poll();
+		}
+		
+		if (ev & EV_TIMER){
+			sched_run();
+		}
+		
+		if (ev & EV_DOOR){
+			update_door();
+		}
+		
+		if (ev & EV_UNLOCK){
+			do_unlock();
 		}
 		
-		if(door_open){
-			if(time_left>0){
-				draw_locked_door();
-				door_open = false;
+		if (ev & EV_RTC_SEC){
+			update_schedule_widgets();
+		}
+		
+		if (ev & EV_ALARME){
+			start_scheduled();
+		}
+		
+		/* FFT da janela de vibracao fora da interrupcao */
+		if (ev & EV_VIBRA){
+			struct vibra_janela j;
+			if (vibra_processa(&j)){
+				check_balance(&j);
 			}
-			else{
-				pio_set(LED1_PIO,LED1_PIO_IDX_MASK);
+		}
+		
+		/* Render depois da entrada: com toques ainda na fila do maXTouch
+		 * (EV_TOUCH ja repostado) o desenho espera a proxima volta, e
+		 * toques seguidos custam um quadro so */
+		if (render_pronto(mxt_is_message_pending(&device))){
+			render_run();
+			if (tela_atual == TELA_LAVANDO){
+				sono_na_tela();
 			}
 		}
-		else{
-			pio_clear(LED1_PIO,LED1_PIO_IDX_MASK);
+		else if (render_pendente()){
+			/* Volta logo para esvaziar a fila e desenhar */
+			event_post(EV_TOUCH);
 		}
 		
-		if (lock_unlock){
-			do_unlock();
-			lock_unlock = false;
+		/* Registros do TRACE viram quadros de telemetria */
+		trace_flush();
+		
+		/* Captura de tela anda uma faixa por volta; o fim de cada
+		 * trecho do DMA (EV_UART_TX) tambem acorda o loop */
+		if (screenshot_busy()){
+			screenshot_poll();
+			event_post(EV_WORK);
+		}
+		
+		/* Agendado, com a tela desenhada e nada em andamento: dorme ate o
+		 * alarme (EV_ALARME) ou a porta, que cancela */
+		if (pode_dormir && tela_atual == TELA_AGENDADA && !render_pendente() &&
+				!screenshot_busy() && !mxt_is_message_pending(&device)){
+			pode_dormir = false;
+			if (sono_dorme() == SONO_PORTA){
+				telas_vai(TELA_MENU);
+			}
+			event_post(EV_WORK);
 		}
 	}
 
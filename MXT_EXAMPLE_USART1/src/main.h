@@ -1,6 +1,34 @@
 #include "all_in.h"
 #include "images.h"
 #include "buttons.h"
+#include "telas.h"
+#include "telas_defs.h"
+#include "latency.h"
+#include "events.h"
+#include "sched.h"
+#include "touch_filter.h"
+#include "touch_tracker.h"
+#include "touch_calib.h"
+#include "mxt_config.h"
+#include "dma.h"
+#include "uart_dma.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "remote.h"
+#include "screenshot.h"
+#include "boot.h"
+#include "widgets.h"
+#include "render.h"
+#include "anim.h"
+#include "ciclo.h"
+#include "motor.h"
+#include "vibra.h"
+#include "agua.h"
+#include "estima.h"
+#include "kv.h"
+#include "agenda.h"
+#include "sono.h"
 #include "functions.h"
 #include "lavagens.h"
+#include "programas.h"
 #include "pios.h"
\ No newline at end of file
@@ -0,0 +1,169 @@
+/*
+ * motor.c
+ *
+ * Laco de velocidade do tambor no TC0 (ver motor.h).
+ */
+
+#include <stdio.h>
+#include "motor.h"
+#include "tambor.h"
+#include "ciclo.h"
+#include "latency.h"
+
+static const struct rampa_limites limites_normal = {
+	CICLO_ACEL_RPM_S, CICLO_FREIO_RPM_S, CICLO_JERK_RPM_S2,
+};
+static const struct rampa_limites limites_pesado = {
+	CICLO_ACEL_PESADO_RPM_S, CICLO_FREIO_RPM_S, CICLO_JERK_RPM_S2,
+};
+
+static struct rampa rampa;
+static struct tambor tambor;
+static uint32_t periodo_pwm;
+
+/* Rampa em andamento, para medir a duracao */
+static volatile bool em_rampa;
+static uint32_t rampa_ticks;
+
+static volatile struct motor_stats stats;
+
+void TC0_Handler(void)
+{
+	uint32_t t0 = latency_now();
+
+	/* Le o SR para limpar o CPCS */
+	(void)MOTOR_TC->TC_CHANNEL[MOTOR_TC_CANAL].TC_SR;
+
+	rampa_passo(&rampa);
+	MOTOR_PWM->PWM_CH_NUM[MOTOR_PWM_CANAL].PWM_CDTYUPD =
+			(uint32_t)((uint64_t)rampa.v * periodo_pwm / RAMPA_Q16(LAVAGEM_RPM_MAX));
+
+	float alvo = (float)(rampa.alvo >> 16);
+	float rpm = tambor_passo(&tambor, (float)rampa.v / 65536.0f, 1.0f / MOTOR_HZ);
+	if (alvo > 0.0f && rpm - alvo > stats.sobressinal) {
+		stats.sobressinal = rpm - alvo;
+	}
+
+	if (em_rampa) {
+		rampa_ticks++;
+		if (rampa_parada(&rampa)) {
+			em_rampa = false;
+			stats.rampas++;
+			stats.ultima_ms = rampa_ticks * 1000 / MOTOR_HZ;
+		}
+	}
+
+	uint32_t ciclos = latency_now() - t0;
+	uint32_t us = latency_cycles_to_us(ciclos);
+	stats.ticks++;
+	stats.soma_ciclos += ciclos;
+	if (us > stats.max_us) {
+		stats.max_us = us;
+	}
+	if (us > MOTOR_ORCAMENTO_US) {
+		stats.acima++;
+	}
+}
+
+void motor_init(void)
+{
+	TcChannel *tc = &MOTOR_TC->TC_CHANNEL[MOTOR_TC_CANAL];
+	uint32_t mck = sysclk_get_peripheral_hz();
+
+	rampa_init(&rampa, MOTOR_HZ);
+	tambor_init(&tambor, MOTOR_CARGA_KG, latency_now());
+
+	/* PWM0: referencia para o inversor, comeca em 0 */
+	pmc_enable_periph_clk(MOTOR_PWM_ID);
+	pio_set_peripheral(MOTOR_PWM_PIO, MOTOR_PWM_PERIPH, MOTOR_PWM_PIO_MASK);
+	periodo_pwm = mck / MOTOR_PWM_HZ;
+	MOTOR_PWM->PWM_DIS = 1u << MOTOR_PWM_CANAL;
+	MOTOR_PWM->PWM_CH_NUM[MOTOR_PWM_CANAL].PWM_CMR = PWM_CMR_CPRE_MCK;
+	MOTOR_PWM->PWM_CH_NUM[MOTOR_PWM_CANAL].PWM_CPRD = periodo_pwm;
+	MOTOR_PWM->PWM_CH_NUM[MOTOR_PWM_CANAL].PWM_CDTY = 0;
+	MOTOR_PWM->PWM_ENA = 1u << MOTOR_PWM_CANAL;
+
+	/* TC0 canal 0: MCK/8, interrupcao no RC a MOTOR_HZ */
+	pmc_enable_periph_clk(MOTOR_TC_ID);
+	tc->TC_CCR = TC_CCR_CLKDIS;
+	tc->TC_IDR = 0xFFFFFFFF;
+	tc->TC_CMR = TC_CMR_TCCLKS_TIMER_CLOCK2 | TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC;
+	tc->TC_RC = mck / 8 / MOTOR_HZ;
+	tc->TC_IER = TC_IER_CPCS;
+
+	/* Acima do toque e do DMA: o laco tem taxa fixa e tempo limitado */
+	NVIC_ClearPendingIRQ(MOTOR_TC_IRQn);
+	NVIC_SetPriority(MOTOR_TC_IRQn, 1);
+	NVIC_EnableIRQ(MOTOR_TC_IRQn);
+	tc->TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG;
+}
+
+void motor_alvo(uint16_t rpm, bool pesado)
+{
+	const struct rampa_limites *lim = pesado ? &limites_pesado : &limites_normal;
+
+	if (rpm > LAVAGEM_RPM_MAX) {
+		rpm = LAVAGEM_RPM_MAX;
+	}
+
+	NVIC_DisableIRQ(MOTOR_TC_IRQn);
+	if (RAMPA_Q16(rpm) != rampa.alvo) {
+		/* Parado: o modelo troca de carga junto com o programa */
+		if (rampa_parada(&rampa) && rampa.v == 0) {
+			tambor_init(&tambor, pesado ? MOTOR_CARGA_PESADA_KG : MOTOR_CARGA_KG,
+					latency_now());
+		}
+		stats.ideal_ms = rampa_duracao_ms(rampa_rpm(&rampa), rpm, lim);
+		rampa_alvo(&rampa, rpm, lim);
+		rampa_ticks = 0;
+		em_rampa = true;
+	}
+	NVIC_EnableIRQ(MOTOR_TC_IRQn);
+}
+
+uint16_t motor_referencia(void)
+{
+	return rampa_rpm(&rampa);
+}
+
+uint16_t motor_rpm(void)
+{
+	float rpm = tambor.rpm;
+
+	return rpm > 0.0f ? (uint16_t)(rpm + 0.5f) : 0;
+}
+
+float motor_vibracao_g(void)
+{
+	return tambor_vibracao_g(&tambor);
+}
+
+bool motor_parado(void)
+{
+	return rampa.v == 0 && rampa.alvo == 0;
+}
+
+void motor_stats_reset(void)
+{
+	NVIC_DisableIRQ(MOTOR_TC_IRQn);
+	stats.ticks = 0;
+	stats.acima = 0;
+	stats.max_us = 0;
+	stats.soma_ciclos = 0;
+	stats.rampas = 0;
+	stats.sobressinal = 0.0f;
+	NVIC_EnableIRQ(MOTOR_TC_IRQn);
+}
+
+void motor_dump(void)
+{
+	printf("motor: alvo %ld rpm, referencia %u, tambor %u rpm\n\r",
+			(long)(rampa.alvo >> 16), motor_referencia(), motor_rpm());
+	printf("  %lu rampas, ultima %lu ms (ideal %lu), sobressinal %lu rpm\n\r",
+			(unsigned long)stats.rampas, (unsigned long)stats.ultima_ms,
+			(unsigned long)stats.ideal_ms, (unsigned long)(stats.sobressinal + 0.5f));
+	printf("  %lu ticks a %u Hz, medio %lu us, pior %lu us, %lu acima de %u us\n\r",
+			(unsigned long)stats.ticks, MOTOR_HZ,
+			(unsigned long)(stats.ticks ? latency_cycles_to_us(stats.soma_ciclos / stats.ticks) : 0),
+			(unsigned long)stats.max_us, (unsigned long)stats.acima, MOTOR_ORCAMENTO_US);
+}
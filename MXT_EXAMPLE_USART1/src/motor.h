@@ -0,0 +1,91 @@
+/*
+ * motor.h
+ *
+ * Controle de velocidade do tambor. Uma interrupcao do TC0 (canal 0) a
+ * MOTOR_HZ da um passo na rampa em S (rampa.h) e escreve a referencia como
+ * ciclo de trabalho no PWM0 (PWMH0 em PA0), que vai para o inversor do
+ * motor. O tempo de cada interrupcao e medido com o DWT e comparado com
+ * MOTOR_ORCAMENTO_US.
+ *
+ * Sem motor nem sensor ligados, o rpm "medido" vem do modelo do tambor
+ * (tambor.h), que segue a referencia na mesma interrupcao. Tempo de rampa,
+ * sobressinal e orcamento saem na tecla 'm' do console.
+ */
+
+#ifndef MOTOR_H_
+#define MOTOR_H_
+
+#include <asf.h>
+#include "rampa.h"
+
+/* Taxa do laco de controle */
+#ifndef MOTOR_HZ
+#define MOTOR_HZ             1000
+#endif
+/* Frequencia do PWM de referencia para o inversor */
+#ifndef MOTOR_PWM_HZ
+#define MOTOR_PWM_HZ         20000
+#endif
+/* Tempo maximo de uma interrupcao do laco */
+#ifndef MOTOR_ORCAMENTO_US
+#define MOTOR_ORCAMENTO_US   20
+#endif
+
+#define MOTOR_PWM            PWM0
+#define MOTOR_PWM_ID         ID_PWM0
+#define MOTOR_PWM_CANAL      0
+#define MOTOR_PWM_PIO        PIOA
+#define MOTOR_PWM_PIO_MASK   PIO_PA0A_PWMC0_PWMH0
+#define MOTOR_PWM_PERIPH     PIO_PERIPH_A
+
+#define MOTOR_TC             TC0
+#define MOTOR_TC_ID          ID_TC0
+#define MOTOR_TC_CANAL       0
+#define MOTOR_TC_IRQn        TC0_IRQn
+
+/* Carga de roupa suposta pelo modelo do tambor (kg) */
+#ifndef MOTOR_CARGA_KG
+#define MOTOR_CARGA_KG         5
+#endif
+#ifndef MOTOR_CARGA_PESADA_KG
+#define MOTOR_CARGA_PESADA_KG  8
+#endif
+
+struct motor_stats {
+	uint32_t ticks;
+	uint32_t acima;          // interrupcoes acima do orcamento
+	uint32_t max_us;
+	uint64_t soma_ciclos;
+	uint32_t rampas;
+	uint32_t ultima_ms;      // duracao da ultima rampa completa
+	uint32_t ideal_ms;       // rampa_duracao_ms da mesma rampa
+	float sobressinal;       // maior rpm do tambor acima do alvo
+};
+
+/** \brief Liga o PWM (ciclo 0) e a interrupcao do laco */
+void motor_init(void);
+
+/**
+ * \brief Novo alvo de rpm. Programas pesados sobem mais devagar
+ * (CICLO_ACEL_PESADO_RPM_S); a descida e sempre CICLO_FREIO_RPM_S.
+ */
+void motor_alvo(uint16_t rpm, bool pesado);
+
+/** \brief Rpm de referencia (saida da rampa) */
+uint16_t motor_referencia(void);
+
+/** \brief Rpm do tambor (modelo) */
+uint16_t motor_rpm(void);
+
+/**
+ * \brief Aceleracao do gabinete (modelo), em g. So das interrupcoes de
+ * prioridade do laco (vibra.c).
+ */
+float motor_vibracao_g(void);
+
+bool motor_parado(void);
+
+void motor_stats_reset(void);
+void motor_dump(void);
+
+#endif /* MOTOR_H_ */
@@ -0,0 +1,228 @@
+/*
+ * mxt_config.c
+ *
+ * Configuracao do maXTouch com cache por CRC (ver mxt_config.h).
+ */
+
+#include <string.h>
+#include "mxt_config.h"
+#include "touch_tracker.h"
+
+/* Marca gravada antes do CRC no T38, para nao confundir com lixo */
+#define USERDATA_MAGIC   0xA5
+
+/* Maior escrita agrupada (objetos vizinhos na memoria do maXTouch) */
+#define MAX_BATCH        128
+
+/* T7 configuration object data */
+static const uint8_t t7_object[] = {
+	0x20, 0x10, 0x4b, 0x84
+};
+
+/* T8 configuration object data */
+static const uint8_t t8_object[] = {
+	0x0d, 0x00, 0x05, 0x0a, 0x4b, 0x00, 0x00,
+	0x00, 0x32, 0x19
+};
+
+/* T9 configuration object data */
+static const uint8_t t9_object[] = {
+	0x8B, 0x00, 0x00, 0x0E, 0x08, 0x00, 0x80,
+	0x32, 0x05, 0x02, 0x0A, 0x03, 0x03, 0x20,
+	0x02, 0x0F, 0x0F, 0x0A, 0x00, 0x00, 0x00,
+	0x00, 0x18, 0x18, 0x20, 0x20, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x02,
+	0x02
+};
+
+/* T46 configuration object data */
+static const uint8_t t46_object[] = {
+	0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x03,
+	0x00, 0x00
+};
+
+/* T56 configuration object data */
+static const uint8_t t56_object[] = {
+	0x02, 0x00, 0x01, 0x18, 0x1E, 0x1E, 0x1E,
+	0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E,
+	0x1E, 0x1E, 0x1E, 0x1E, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+struct config_object {
+	uint8_t type;
+	const uint8_t *data;
+	uint8_t size;
+};
+
+static const struct config_object objects[] = {
+	{ MXT_GEN_POWERCONFIG_T7,        t7_object,  sizeof(t7_object) },
+	{ MXT_GEN_ACQUISITIONCONFIG_T8,  t8_object,  sizeof(t8_object) },
+	{ MXT_TOUCH_MULTITOUCHSCREEN_T9, t9_object,  sizeof(t9_object) },
+	{ MXT_SPT_CTE_CONFIGURATION_T46, t46_object, sizeof(t46_object) },
+	{ MXT_PROCI_SHIELDLESS_T56,      t56_object, sizeof(t56_object) },
+};
+
+#define N_OBJECTS  (sizeof(objects) / sizeof(objects[0]))
+
+/* Mesmo CRC-24 do info block em mxt_device_1.c (mxt_crc_24) */
+static uint32_t crc_24(uint32_t crc, uint8_t byte1, uint8_t byte2)
+{
+	static const uint32_t crcpoly = 0x80001B;
+	uint32_t result;
+	uint16_t data_word;
+
+	data_word = (uint16_t)((uint16_t)(byte2 << 8u) | byte1);
+	result = ((crc << 1u) ^ (uint32_t)data_word);
+
+	if (result & 0x1000000) {
+		result ^= crcpoly;
+	}
+
+	return result;
+}
+
+uint32_t mxt_config_crc(void)
+{
+	uint32_t crc = 0;
+
+	for (uint8_t o = 0; o < N_OBJECTS; o++) {
+		const struct config_object *obj = &objects[o];
+		/* tipo e tamanho tambem entram: mudar a ordem muda o CRC */
+		crc = crc_24(crc, obj->type, obj->size);
+		for (uint8_t i = 0; i < obj->size; i += 2) {
+			uint8_t b2 = (i + 1 < obj->size) ? obj->data[i + 1] : 0;
+			crc = crc_24(crc, obj->data[i], b2);
+		}
+	}
+	return crc & 0x00FFFFFF;
+}
+
+uint8_t mxt_config_num_touch(void)
+{
+	return t9_object[MXT_T9_NUMTOUCH];
+}
+
+static status_code_t write_block(struct mxt_device *device, uint16_t adr,
+		const uint8_t *data, uint32_t len)
+{
+	twihs_package_t packet = {
+		.addr[0]      = adr,
+		.addr[1]      = adr >> 8,
+		.addr_length  = sizeof(mxt_memory_adr),
+		.chip         = device->mxt_chip_adr,
+		.buffer       = (void *)data,
+		.length       = len
+	};
+
+	return twihs_master_write(device->interface, &packet);
+}
+
+static status_code_t read_block(struct mxt_device *device, uint16_t adr,
+		uint8_t *data, uint32_t len)
+{
+	twihs_package_t packet = {
+		.addr[0]      = adr,
+		.addr[1]      = adr >> 8,
+		.addr_length  = sizeof(mxt_memory_adr),
+		.chip         = device->mxt_chip_adr,
+		.buffer       = data,
+		.length       = len
+	};
+
+	return twihs_master_read(device->interface, &packet);
+}
+
+/*
+ * Escreve todos os objetos em ordem de endereco, juntando numa unica
+ * transferencia TWI os que sao vizinhos na memoria do controlador.
+ */
+static status_code_t write_objects(struct mxt_device *device)
+{
+	uint8_t order[N_OBJECTS];
+	uint16_t adr[N_OBJECTS];
+	uint8_t batch[MAX_BATCH];
+	uint16_t batch_adr = 0;
+	uint32_t batch_len = 0;
+
+	for (uint8_t o = 0; o < N_OBJECTS; o++) {
+		adr[o] = mxt_get_object_address(device, objects[o].type, 0);
+		order[o] = o;
+	}
+	/* insertion sort por endereco: 5 objetos */
+	for (uint8_t i = 1; i < N_OBJECTS; i++) {
+		uint8_t v = order[i];
+		int8_t j = i - 1;
+		while (j >= 0 && adr[order[j]] > adr[v]) {
+			order[j + 1] = order[j];
+			j--;
+		}
+		order[j + 1] = v;
+	}
+
+	for (uint8_t i = 0; i < N_OBJECTS; i++) {
+		const struct config_object *obj = &objects[order[i]];
+		uint16_t a = adr[order[i]];
+
+		if (a == 0) {
+			continue;  // objeto nao existe nesta variante
+		}
+		if (batch_len && (batch_adr + batch_len != a
+				|| batch_len + obj->size > MAX_BATCH)) {
+			if (write_block(device, batch_adr, batch, batch_len) != STATUS_OK) {
+				return ERR_IO_ERROR;
+			}
+			batch_len = 0;
+		}
+		if (batch_len == 0) {
+			batch_adr = a;
+		}
+		memcpy(&batch[batch_len], obj->data, obj->size);
+		batch_len += obj->size;
+	}
+	if (batch_len) {
+		return write_block(device, batch_adr, batch, batch_len);
+	}
+	return STATUS_OK;
+}
+
+enum mxt_config_result mxt_config_start(struct mxt_device *device, bool force)
+{
+	uint16_t t6 = mxt_get_object_address(device, MXT_GEN_COMMANDPROCESSOR_T6, 0);
+	uint16_t t38 = mxt_get_object_address(device, MXT_SPT_USERDATA_T38, 0);
+	uint32_t crc = mxt_config_crc();
+	uint8_t stored[4];
+	uint8_t wanted[4] = {
+		USERDATA_MAGIC, crc & 0xFF, (crc >> 8) & 0xFF, (crc >> 16) & 0xFF
+	};
+
+	/* Sem T38 nao ha onde guardar o CRC: escreve sempre */
+	if (!force && t38 != 0
+			&& read_block(device, t38, stored, sizeof(stored)) == STATUS_OK
+			&& memcmp(stored, wanted, sizeof(stored)) == 0) {
+		return MXT_CONFIG_CACHED;
+	}
+
+	if (write_objects(device) != STATUS_OK) {
+		return MXT_CONFIG_ERROR;
+	}
+	if (t38 != 0 && write_block(device, t38, wanted, sizeof(wanted)) != STATUS_OK) {
+		return MXT_CONFIG_ERROR;
+	}
+
+	/* Salva na NVM do maXTouch para o proximo boot */
+	mxt_write_config_reg(device, t6 + MXT_GEN_COMMANDPROCESSOR_BACKUPNV,
+			MXT_BACKUP_COMMAND);
+
+	return MXT_CONFIG_WRITTEN;
+}
+
+void mxt_config_finish(struct mxt_device *device)
+{
+	uint16_t t6 = mxt_get_object_address(device, MXT_GEN_COMMANDPROCESSOR_T6, 0);
+
+	/* Issue recalibration command to maXTouch device by writing a non-zero
+	 * value to the calibrate register */
+	mxt_write_config_reg(device, t6 + MXT_GEN_COMMANDPROCESSOR_CALIBRATE, 0x01);
+}
@@ -0,0 +1,52 @@
+/*
+ * mxt_config.h
+ *
+ * Configuracao do maXTouch (T7/T8/T9/T46/T56) com cache: o CRC-24 das
+ * tabelas embutidas fica gravado no objeto T38 (USERDATA) do controlador.
+ * No boot, se o CRC gravado bate com o das tabelas, a configuracao que
+ * ja esta na NVM do maXTouch e usada como esta (sem reset, sem
+ * reescrever registradores, sem recalibrar).
+ */
+
+#ifndef MXT_CONFIG_H_
+#define MXT_CONFIG_H_
+
+#include <asf.h>
+
+/* Objeto de dados do usuario do maXTouch (nao esta no enum do ASF) */
+#define MXT_SPT_USERDATA_T38   38
+
+/* Comando de backup para NVM escrito no T6 */
+#define MXT_BACKUP_COMMAND     0x55
+
+/* Tempo de gravacao da NVM depois do backup (datasheet mXT143E) */
+#define MXT_BACKUP_TIME        100
+
+enum mxt_config_result {
+	MXT_CONFIG_CACHED = 0,   // CRC bateu, nada foi escrito
+	MXT_CONFIG_WRITTEN,      // configuracao escrita e salva na NVM
+	MXT_CONFIG_ERROR,        // falha de comunicacao
+};
+
+/**
+ * \brief Garante que o maXTouch esta com a configuracao embutida, sem
+ * esperas.
+ *
+ * Se retornar MXT_CONFIG_WRITTEN, o chamador deve esperar MXT_BACKUP_TIME
+ * (o boot agenda o passo seguinte, boot.h) e entao chamar
+ * mxt_config_finish.
+ *
+ * \param force Escreve mesmo que o CRC bata
+ */
+enum mxt_config_result mxt_config_start(struct mxt_device *device, bool force);
+
+/** \brief Recalibra o maXTouch depois do backup para NVM */
+void mxt_config_finish(struct mxt_device *device);
+
+/** \brief CRC-24 das tabelas embutidas */
+uint32_t mxt_config_crc(void);
+
+/** \brief NUMTOUCH configurado no T9 */
+uint8_t mxt_config_num_touch(void);
+
+#endif /* MXT_CONFIG_H_ */
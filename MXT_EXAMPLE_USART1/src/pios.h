@@ -15,6 +15,4 @@
 
 void init_led(void);
 void init_but(void);
-void door_callback();
-void draw_door_open();
-void draw_locked_door();
\ No newline at end of file
+void door_callback();
\ No newline at end of file
@@ -0,0 +1,277 @@
+/*
+ * programas.c
+ *
+ * Lista do carrossel com os programas do usuario e o editor (ver
+ * programas.h).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "programas.h"
+#include "buttons.h"
+#include "ciclo.h"
+#include "estima.h"
+#include "kv.h"
+
+#define GRAVADO_PESADO       0x01
+#define GRAVADO_BOLHAS       0x02
+
+/* Formato no kv (KV_PROGRAMAS); o nome sai da posicao */
+struct programa_gravado {
+	uint8_t enxagueTempo;
+	uint8_t enxagueQnt;
+	uint8_t centrifugacaoTempo;
+	uint8_t flags;
+	uint16_t centrifugacaoRPM;
+};
+
+struct programas_gravados {
+	uint16_t versao;
+	uint8_t n;
+	uint8_t livre;
+	struct programa_gravado p[PROGRAMAS_USUARIO];
+};
+
+/* Os de fabrica apontam para o catalogo na flash, os do usuario para
+ * usuario[], na mesma ordem */
+static const t_ciclo *lista[PROGRAMAS_MAX];
+static t_ciclo usuario[PROGRAMAS_USUARIO];
+static uint8_t n_fabrica;
+static uint8_t n_lista;
+
+static t_ciclo rascunho;
+static const struct estima_modelo *modelo;
+static uint8_t destino;        // posicao do rascunho na lista (n_lista = novo)
+
+static const char *const nomes_campo[N_CAMPOS] = {
+	"ENXAGUE",
+	"ENXAGUES",
+	"CENTRIFUGA",
+	"TEMPO CENTRIF.",
+	"PESADO",
+	"BOLHAS",
+};
+
+/* Os mesmos limites que lavagens.c confere na compilacao */
+static bool valido(const t_ciclo *c)
+{
+	return c->enxagueTempo <= PROGRAMAS_ENXAGUE_MAX_MIN &&
+			(c->enxagueTempo > 0 || (c->centrifugacaoRPM > 0 && c->centrifugacaoTempo > 0)) &&
+			c->enxagueQnt <= CICLO_MAX_ENXAGUES &&
+			c->centrifugacaoTempo <= PROGRAMAS_CENTRIF_MAX_MIN &&
+			c->centrifugacaoRPM <= LAVAGEM_RPM_MAX &&
+			(c->centrifugacaoRPM == 0 || c->centrifugacaoRPM >= PROGRAMAS_RPM_MIN);
+}
+
+/* Minutos que o menu e a contagem mostram: o previsto pelo modelo, que
+ * cresce com a agua lenta e as rampas pesadas */
+static uint32_t previsto_min(const t_ciclo *c)
+{
+	uint32_t s = modelo != NULL ? estima_previsto_s(modelo, c) : ciclo_total_s(c);
+
+	return (s + 59) / 60;
+}
+
+static void fabrica(void)
+{
+	if (n_lista > 0) {
+		return;
+	}
+	n_fabrica = n_lavagens < PROGRAMAS_MAX - PROGRAMAS_USUARIO ?
+			n_lavagens : PROGRAMAS_MAX - PROGRAMAS_USUARIO;
+	for (uint8_t i = 0; i < n_fabrica; i++) {
+		lista[i] = &lavagens[i];
+	}
+	n_lista = n_fabrica;
+}
+
+static void nomeia(t_ciclo *c, uint8_t posicao)
+{
+	snprintf(c->nome, LAVAGEM_NOME_MAX, "USUARIO %u", posicao - n_fabrica + 1);
+	c->botao = &botaoLavagemUsuario;
+}
+
+void programas_carrega(const struct estima_modelo *m)
+{
+	struct programas_gravados g;
+
+	modelo = m;
+	fabrica();
+	n_lista = n_fabrica;
+	if (kv_le(KV_PROGRAMAS, &g, sizeof(g)) != sizeof(g) || g.versao != PROGRAMAS_VERSAO) {
+		return;
+	}
+	for (uint8_t i = 0; i < g.n && i < PROGRAMAS_USUARIO; i++) {
+		t_ciclo *c = &usuario[n_lista - n_fabrica];
+
+		memset(c, 0, sizeof(*c));
+		c->enxagueTempo = g.p[i].enxagueTempo;
+		c->enxagueQnt = g.p[i].enxagueQnt;
+		c->centrifugacaoTempo = g.p[i].centrifugacaoTempo;
+		c->centrifugacaoRPM = g.p[i].centrifugacaoRPM;
+		c->heavy = (g.p[i].flags & GRAVADO_PESADO) != 0;
+		c->bubblesOn = (g.p[i].flags & GRAVADO_BOLHAS) != 0;
+		if (valido(c)) {
+			nomeia(c, n_lista);
+			c->total_s = ciclo_total_s(c);
+			lista[n_lista++] = c;
+		}
+	}
+}
+
+const t_ciclo *const *programas_lista(uint8_t *n)
+{
+	fabrica();
+	*n = n_lista;
+	return lista;
+}
+
+bool programas_do_usuario(const t_ciclo *c)
+{
+	return c >= usuario && c < usuario + (n_lista - n_fabrica);
+}
+
+bool programas_edita(const t_ciclo *c)
+{
+	fabrica();
+	if (programas_do_usuario(c)) {
+		destino = n_fabrica + (c - usuario);
+	}
+	else if (n_lista - n_fabrica < PROGRAMAS_USUARIO) {
+		destino = n_lista;
+	}
+	else {
+		return false;
+	}
+	rascunho = *c;
+	nomeia(&rascunho, destino);
+	return true;
+}
+
+const t_ciclo *programas_rascunho(void)
+{
+	return &rascunho;
+}
+
+/* Centrifugacao desligada (0) ou de PROGRAMAS_RPM_MIN ate o limite do motor */
+static uint16_t proximo_rpm(uint16_t rpm, int passo)
+{
+	if (passo > 0) {
+		return rpm == 0 ? PROGRAMAS_RPM_MIN : rpm + PROGRAMAS_RPM_PASSO;
+	}
+	if (rpm <= PROGRAMAS_RPM_MIN) {
+		return 0;
+	}
+	return rpm - PROGRAMAS_RPM_PASSO;
+}
+
+bool programas_ajusta(enum programa_campo campo, int passo)
+{
+	t_ciclo c = rascunho;
+
+	switch (campo) {
+		case CAMPO_ENXAGUE_MIN:
+			c.enxagueTempo += passo;
+			break;
+		case CAMPO_ENXAGUES:
+			c.enxagueQnt += passo;
+			break;
+		case CAMPO_RPM:
+			c.centrifugacaoRPM = proximo_rpm(c.centrifugacaoRPM, passo);
+			break;
+		case CAMPO_CENTRIF_MIN:
+			c.centrifugacaoTempo += passo;
+			break;
+		case CAMPO_PESADO:
+			c.heavy = !c.heavy;
+			break;
+		case CAMPO_BOLHAS:
+			c.bubblesOn = !c.bubblesOn;
+			break;
+		default:
+			return false;
+	}
+	/* uint8_t que passa de 0 da a volta e cai fora do limite */
+	if (!valido(&c) || (campo == CAMPO_RPM && c.centrifugacaoRPM == rascunho.centrifugacaoRPM)) {
+		return false;
+	}
+	/* O modelo pode ja ter levado o rascunho acima do limite: ai so
+	 * deixa diminuir */
+	uint32_t min = previsto_min(&c);
+	if (min > PROGRAMAS_MAX_MIN && min > previsto_min(&rascunho)) {
+		return false;
+	}
+	c.total_s = ciclo_total_s(&c);
+	rascunho = c;
+	return true;
+}
+
+int programas_salva(void)
+{
+	if (destino < n_fabrica || destino > n_lista || destino - n_fabrica >= PROGRAMAS_USUARIO) {
+		return -1;
+	}
+	usuario[destino - n_fabrica] = rascunho;
+	lista[destino] = &usuario[destino - n_fabrica];
+	if (destino == n_lista) {
+		n_lista++;
+	}
+	return destino;
+}
+
+bool programas_grava(void)
+{
+	struct programas_gravados g;
+
+	memset(&g, 0, sizeof(g));
+	g.versao = PROGRAMAS_VERSAO;
+	g.n = n_lista - n_fabrica;
+	for (uint8_t i = 0; i < g.n; i++) {
+		const t_ciclo *c = lista[n_fabrica + i];
+
+		g.p[i].enxagueTempo = c->enxagueTempo;
+		g.p[i].enxagueQnt = c->enxagueQnt;
+		g.p[i].centrifugacaoTempo = c->centrifugacaoTempo;
+		g.p[i].centrifugacaoRPM = c->centrifugacaoRPM;
+		g.p[i].flags = (c->heavy ? GRAVADO_PESADO : 0) | (c->bubblesOn ? GRAVADO_BOLHAS : 0);
+	}
+	return kv_grava(KV_PROGRAMAS, &g, sizeof(g));
+}
+
+const char *programas_campo_nome(enum programa_campo campo)
+{
+	return campo < N_CAMPOS ? nomes_campo[campo] : "?";
+}
+
+void programas_campo_texto(const t_ciclo *c, enum programa_campo campo,
+		char *texto, size_t n)
+{
+	switch (campo) {
+		case CAMPO_ENXAGUE_MIN:
+			snprintf(texto, n, "%u MIN", c->enxagueTempo);
+			break;
+		case CAMPO_ENXAGUES:
+			snprintf(texto, n, "%u", c->enxagueQnt);
+			break;
+		case CAMPO_RPM:
+			if (c->centrifugacaoRPM > 0) {
+				snprintf(texto, n, "%u RPM", c->centrifugacaoRPM);
+			}
+			else {
+				snprintf(texto, n, "NAO");
+			}
+			break;
+		case CAMPO_CENTRIF_MIN:
+			snprintf(texto, n, "%u MIN", c->centrifugacaoTempo);
+			break;
+		case CAMPO_PESADO:
+			snprintf(texto, n, "%s", c->heavy ? "SIM" : "NAO");
+			break;
+		case CAMPO_BOLHAS:
+			snprintf(texto, n, "%s", c->bubblesOn ? "SIM" : "NAO");
+			break;
+		default:
+			snprintf(texto, n, "?");
+			break;
+	}
+}
@@ -0,0 +1,99 @@
+/*
+ * programas.h
+ *
+ * Programas do carrossel: os de fabrica (lavagens.c) seguidos dos do
+ * usuario, gravados no kv (kv.h). A lista e de ponteiros: os de fabrica
+ * continuam na flash e so os do usuario ocupam RAM.
+ *
+ * O editor trabalha num rascunho: editar um programa do usuario troca o
+ * programa ao salvar; editar um de fabrica cria um programa do usuario
+ * novo a partir dele. Cada ajuste respeita os mesmos limites que o
+ * catalogo confere na compilacao (lavagens.c) e refaz o total_s; a
+ * duracao que o menu mostra (estima.h) nao pode passar de
+ * PROGRAMAS_MAX_MIN. Nao depende do ASF.
+ */
+
+#ifndef PROGRAMAS_H_
+#define PROGRAMAS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lavagens.h"
+
+struct estima_modelo;
+
+#define PROGRAMAS_USUARIO    4
+#define PROGRAMAS_MAX        16     // fabrica + usuario
+
+#define PROGRAMAS_VERSAO     1
+
+/* Limites e passos do editor */
+#define PROGRAMAS_ENXAGUE_MAX_MIN  30
+#define PROGRAMAS_CENTRIF_MAX_MIN  15
+#define PROGRAMAS_RPM_MIN          400   // abaixo disso, sem centrifugacao
+#define PROGRAMAS_RPM_PASSO        100
+#define PROGRAMAS_MAX_MIN          99    // 2 digitos da contagem (previsto)
+
+enum programa_campo {
+	CAMPO_ENXAGUE_MIN = 0,
+	CAMPO_ENXAGUES,
+	CAMPO_RPM,
+	CAMPO_CENTRIF_MIN,
+	CAMPO_PESADO,
+	CAMPO_BOLHAS,
+	N_CAMPOS
+};
+
+/**
+ * \brief Le os programas do usuario gravados no kv (depois do kv_init).
+ * O carrossel precisa pegar a lista de novo (telas_set_ciclos).
+ *
+ * \param m modelo de tempo que o menu usa, para o limite do editor; o
+ * editor guarda o ponteiro
+ */
+void programas_carrega(const struct estima_modelo *m);
+
+/** \brief Lista do carrossel; os de fabrica estao sempre nela */
+const t_ciclo *const *programas_lista(uint8_t *n);
+
+bool programas_do_usuario(const t_ciclo *c);
+
+/**
+ * \brief Comeca a editar \a c (da lista).
+ *
+ * \return false se \a c e de fabrica e nao cabe mais programa do usuario
+ */
+bool programas_edita(const t_ciclo *c);
+
+const t_ciclo *programas_rascunho(void);
+
+/**
+ * \brief Soma \a passo (+1 / -1) a um campo do rascunho; liga/desliga os
+ * booleanos.
+ *
+ * \return false se o campo ja esta no limite (nada mudou)
+ */
+bool programas_ajusta(enum programa_campo campo, int passo);
+
+/**
+ * \brief Copia o rascunho para a lista; programas_grava leva para o kv.
+ *
+ * \return posicao do programa na lista, -1 se nao foi salvo
+ */
+int programas_salva(void);
+
+/**
+ * \brief Grava os programas do usuario no kv (KV_PROGRAMAS).
+ *
+ * \return false se o kv recusou; a lista vale ate desligar
+ */
+bool programas_grava(void);
+
+const char *programas_campo_nome(enum programa_campo campo);
+
+/** \brief Valor do campo como aparece no editor ("15 MIN", "SIM") */
+void programas_campo_texto(const t_ciclo *c, enum programa_campo campo,
+		char *texto, size_t n);
+
+#endif /* PROGRAMAS_H_ */
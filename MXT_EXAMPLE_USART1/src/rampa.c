@@ -0,0 +1,137 @@
+/*
+ * rampa.c
+ *
+ * Rampas em S da velocidade do tambor (ver rampa.h).
+ */
+
+#include "rampa.h"
+
+void rampa_init(struct rampa *r, uint32_t hz)
+{
+	struct rampa_limites zero = {0};
+
+	r->v = 0;
+	r->a = 0;
+	r->alvo = 0;
+	r->resto_v = 0;
+	r->resto_a = 0;
+	r->hz = hz > 0 ? hz : 1;
+	r->lim = zero;
+}
+
+void rampa_alvo(struct rampa *r, uint16_t rpm, const struct rampa_limites *lim)
+{
+	r->alvo = RAMPA_Q16(rpm);
+	r->lim = *lim;
+}
+
+/* x += taxa / hz, sem perder a fracao da divisao */
+static int32_t integra(int32_t x, int32_t taxa, int32_t *resto, uint32_t hz)
+{
+	int32_t soma = *resto + taxa;
+
+	*resto = soma % (int32_t)hz;
+	return x + soma / (int32_t)hz;
+}
+
+void rampa_passo(struct rampa *r)
+{
+	int32_t falta = r->alvo - r->v;
+	int32_t s = falta >= 0 ? 1 : -1;
+
+	if (falta == 0 && r->a == 0) {
+		return;
+	}
+
+	int32_t amax = RAMPA_Q16(s > 0 ? r->lim.acel : r->lim.freio);
+	int32_t j = RAMPA_Q16(r->lim.jerk);
+	int32_t as = s * r->a;            // aceleracao no sentido do alvo
+	int64_t para = 0;                 // rpm gastos zerando a aceleracao agora
+
+	if (amax <= 0 || j <= 0) {
+		/* Sem limites configurados: vai direto */
+		r->v = r->alvo;
+		r->a = 0;
+		return;
+	}
+
+	if (as > 0) {
+		/* a^2 / 2j: o que a velocidade ainda anda enquanto a aceleracao zera */
+		para = (int64_t)as * as / (2 * (int64_t)j);
+	}
+
+	if ((int64_t)s * falta <= para) {
+		/* Hora de aliviar: a aceleracao desce para zero com jerk limitado */
+		as = integra(as, -j, &r->resto_a, r->hz);
+		if (as < 0) {
+			as = 0;
+		}
+	}
+	else if (as < amax) {
+		as = integra(as, j, &r->resto_a, r->hz);
+		if (as > amax) {
+			as = amax;
+		}
+	}
+	else if (as > amax) {
+		/* Limite caiu (ex.: trocou de subida para freio) */
+		as = integra(as, -j, &r->resto_a, r->hz);
+		if (as < amax) {
+			as = amax;
+		}
+	}
+	r->a = s * as;
+	r->v = integra(r->v, r->a, &r->resto_v, r->hz);
+
+	/* Passou do alvo ou parou a um passo dele: encosta sem ultrapassar */
+	falta = r->alvo - r->v;
+	if ((int64_t)s * falta <= 0 || (as == 0 && (int64_t)s * falta <= j / (int32_t)r->hz / (int32_t)r->hz + 1)) {
+		r->v = r->alvo;
+		r->a = 0;
+		r->resto_v = 0;
+		r->resto_a = 0;
+	}
+}
+
+uint16_t rampa_rpm(const struct rampa *r)
+{
+	int32_t v = r->v + (1 << 15);
+
+	return v > 0 ? (uint16_t)(v >> 16) : 0;
+}
+
+bool rampa_parada(const struct rampa *r)
+{
+	return r->v == r->alvo && r->a == 0;
+}
+
+/* Raiz inteira (Newton), para o caso triangular */
+static uint32_t raiz(uint64_t x)
+{
+	uint64_t r = x, y = (x + 1) / 2;
+
+	while (y < r) {
+		r = y;
+		y = (r + x / r) / 2;
+	}
+	return (uint32_t)r;
+}
+
+uint32_t rampa_duracao_ms(uint16_t de, uint16_t para, const struct rampa_limites *lim)
+{
+	uint32_t dv = de < para ? para - de : de - para;
+	uint32_t a = de < para ? lim->acel : lim->freio;
+	uint32_t j = lim->jerk;
+
+	if (dv == 0) {
+		return 0;
+	}
+	if (a == 0 || j == 0) {
+		return 0;
+	}
+	/* Trapezio: dv/a + a/j; triangulo (a nao chega no limite): 2 sqrt(dv/j) */
+	if ((uint64_t)dv * j >= (uint64_t)a * a) {
+		return dv * 1000 / a + a * 1000 / j;
+	}
+	return 2 * raiz((uint64_t)dv * 1000000 / j);
+}
@@ -0,0 +1,60 @@
+/*
+ * rampa.h
+ *
+ * Gerador de rampas em S (jerk limitado) para a velocidade do tambor.
+ * A aceleracao sobe e desce com derivada limitada, entao o motor nunca
+ * recebe um degrau de torque, nem ao sair da parada nem ao chegar no alvo.
+ *
+ * Um passo por tick de controle, em ponto fixo Q16.16 e so com inteiros:
+ * cabe no orcamento da interrupcao do motor (motor.h). Nao depende do
+ * ASF e roda no host.
+ */
+
+#ifndef RAMPA_H_
+#define RAMPA_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Ponto fixo Q16.16 */
+#define RAMPA_Q16(x)         ((int32_t)(x) << 16)
+
+/* Limites de uma rampa; rpm/s e rpm/s^2 inteiros */
+struct rampa_limites {
+	uint16_t acel;         // aceleracao maxima subindo
+	uint16_t freio;        // aceleracao maxima descendo
+	uint16_t jerk;         // variacao maxima da aceleracao
+};
+
+struct rampa {
+	int32_t v;             // rpm atual, Q16
+	int32_t a;             // rpm/s atual, Q16
+	int32_t alvo;          // rpm, Q16
+	int32_t resto_v;       // fracao de v ainda nao integrada (Q16 * hz)
+	int32_t resto_a;
+	uint32_t hz;           // taxa de controle
+	struct rampa_limites lim;
+};
+
+void rampa_init(struct rampa *r, uint32_t hz);
+
+/** \brief Novo alvo; a rampa parte da velocidade e aceleracao atuais */
+void rampa_alvo(struct rampa *r, uint16_t rpm, const struct rampa_limites *lim);
+
+/** \brief Um tick de controle (1 / hz segundos) */
+void rampa_passo(struct rampa *r);
+
+/** \brief Rpm de referencia agora, arredondado */
+uint16_t rampa_rpm(const struct rampa *r);
+
+/** \brief true quando chegou no alvo com aceleracao zero */
+bool rampa_parada(const struct rampa *r);
+
+/**
+ * \brief Duracao ideal de uma rampa de \a de ate \a para, em ms: trapezio
+ * na aceleracao, ou triangulo se a variacao for curta demais para
+ * alcancar o limite.
+ */
+uint32_t rampa_duracao_ms(uint16_t de, uint16_t para, const struct rampa_limites *lim);
+
+#endif /* RAMPA_H_ */
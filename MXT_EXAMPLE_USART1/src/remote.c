@@ -0,0 +1,139 @@
+/*
+ * remote.c
+ *
+ * Recepcao e enquadramento dos comandos remotos (ver remote.h).
+ */
+
+#include "conf_uart_serial.h"
+#include "remote.h"
+#include "telemetry.h"
+#include "events.h"
+
+#define RX_MASK  (REMOTE_RX_SIZE - 1)
+
+enum rx_state {
+	RX_IDLE,
+	RX_SYNC,
+	RX_TYPE,
+	RX_LEN,
+	RX_PAYLOAD,
+	RX_CRC,
+};
+
+static uint8_t rx_buf[REMOTE_RX_SIZE];
+static volatile uint32_t rx_head;
+static volatile uint32_t rx_tail;
+static volatile uint32_t errors;
+
+static remote_console_t on_console;
+static remote_command_t on_command;
+static void *cb_ctx;
+
+static enum rx_state state;
+static uint8_t frame[2 + TELEM_MAX_PAYLOAD];
+static uint8_t pos;
+
+/* USART_SERIAL_EXAMPLE e a CONSOLE_UART, USART1 na SAME70 Xplained */
+void USART1_Handler(void)
+{
+	uint32_t c;
+
+	if (usart_read(USART_SERIAL_EXAMPLE, &c) == 0) {
+		if (rx_head - rx_tail < REMOTE_RX_SIZE) {
+			rx_buf[rx_head++ & RX_MASK] = c;
+			event_post(EV_UART_RX);
+		}
+		else {
+			errors++;
+		}
+	}
+}
+
+void remote_init(remote_console_t console, remote_command_t command, void *ctx)
+{
+	on_console = console;
+	on_command = command;
+	cb_ctx = ctx;
+	state = RX_IDLE;
+	rx_head = rx_tail = errors = 0;
+
+	usart_enable_interrupt(USART_SERIAL_EXAMPLE, US_IER_RXRDY);
+	NVIC_ClearPendingIRQ(USART1_IRQn);
+	NVIC_SetPriority(USART1_IRQn, 4);
+	NVIC_EnableIRQ(USART1_IRQn);
+}
+
+static void feed(uint8_t c)
+{
+	switch (state) {
+		case RX_IDLE:
+			if (c == TELEM_SYNC0) {
+				state = RX_SYNC;
+			}
+			else if (on_console) {
+				on_console(cb_ctx, c);
+			}
+			break;
+
+		case RX_SYNC:
+			if (c == TELEM_SYNC1) {
+				state = RX_TYPE;
+				break;
+			}
+			/* Era so um 0xA5 solto: devolve ao console */
+			state = RX_IDLE;
+			if (on_console) {
+				on_console(cb_ctx, TELEM_SYNC0);
+			}
+			feed(c);
+			break;
+
+		case RX_TYPE:
+			frame[0] = c;
+			state = RX_LEN;
+			break;
+
+		case RX_LEN:
+			frame[1] = c;
+			pos = 0;
+			state = c ? RX_PAYLOAD : RX_CRC;
+			break;
+
+		case RX_PAYLOAD:
+			frame[2 + pos++] = c;
+			if (pos == frame[1]) {
+				state = RX_CRC;
+			}
+			break;
+
+		case RX_CRC:
+			state = RX_IDLE;
+			if (telemetry_crc8(0, frame, 2 + frame[1]) != c || frame[1] == 0) {
+				errors++;
+			}
+			else if (on_command) {
+				on_command(cb_ctx, frame[0], frame[2], &frame[3], frame[1] - 1);
+			}
+			break;
+	}
+}
+
+void remote_poll(void)
+{
+	while (rx_tail != rx_head) {
+		feed(rx_buf[rx_tail & RX_MASK]);
+		rx_tail++;
+	}
+}
+
+bool remote_ack(uint8_t cmd, uint8_t seq, enum remote_status status)
+{
+	uint8_t payload[3] = {seq, cmd, status};
+
+	return telemetry_send(TELEM_ACK, payload, sizeof(payload));
+}
+
+uint32_t remote_errors(void)
+{
+	return errors;
+}
@@ -0,0 +1,71 @@
+/*
+ * remote.h
+ *
+ * Controle remoto da interface pela USART de console, para testes e
+ * benchmarks sem tocar no painel.
+ *
+ * Os comandos (PC -> placa) usam o mesmo quadro da telemetria
+ * (telemetry.h): 0xA5 0x5A | tipo | tamanho | payload | crc8. O primeiro
+ * byte do payload e um numero de sequencia que volta na resposta.
+ * Bytes fora de um quadro continuam indo para o console de um caractere.
+ *
+ * O cliente do PC esta em tools/remote.py; sem a placa ele fala com
+ * tools/host/loopback.c, que roda as telas deste firmware no PC.
+ */
+
+#ifndef REMOTE_H_
+#define REMOTE_H_
+
+#include <asf.h>
+
+enum remote_cmd {
+	REMOTE_TOUCH  = 0x80,  // seq, status maXTouch (1), x (2), y (2): evento cru, passa pelo filtro
+	REMOTE_TAP    = 0x81,  // seq, x (2), y (2) em pixels: direto para os botoes da tela
+	REMOTE_STATE  = 0x82,  // seq
+	REMOTE_PERF   = 0x83,  // seq, tela (1)
+	REMOTE_REDRAW = 0x84,  // seq
+	REMOTE_SHOT   = 0x85,  // seq: comeca uma captura (screenshot.h)
+	REMOTE_CLOCK  = 0x86,  // seq, ano (2), mes, dia, dia da semana (1-7), hora, min, seg: acerta o RTC
+};
+
+/* Resultado no TELEM_ACK */
+enum remote_status {
+	REMOTE_OK = 0,
+	REMOTE_MISS,       // toque fora de qualquer botao
+	REMOTE_BAD_ARGS,
+	REMOTE_UNKNOWN,
+	REMOTE_UNSUPPORTED,
+	REMOTE_BUSY,       // captura de tela ja em andamento
+};
+
+/* Bytes recebidos guardados pela interrupcao (potencia de 2) */
+#define REMOTE_RX_SIZE   256
+
+typedef void (*remote_console_t)(void *ctx, uint8_t c);
+typedef void (*remote_command_t)(void *ctx, uint8_t cmd, uint8_t seq,
+		const uint8_t *args, uint8_t len);
+
+/**
+ * \brief Liga a interrupcao de RX da USART de console.
+ *
+ * \param console  recebe os bytes que nao fazem parte de um quadro
+ * \param command  recebe cada comando com crc valido (fora da interrupcao)
+ * \param ctx      repassado para as duas funcoes
+ */
+void remote_init(remote_console_t console, remote_command_t command, void *ctx);
+
+/** \brief Processa os bytes recebidos. Chamar no loop principal. */
+void remote_poll(void);
+
+/** \brief Responde um comando com TELEM_ACK */
+bool remote_ack(uint8_t cmd, uint8_t seq, enum remote_status status);
+
+/** \brief Quadros descartados por crc invalido ou RX cheio */
+uint32_t remote_errors(void);
+
+static inline uint16_t remote_get16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+#endif /* REMOTE_H_ */
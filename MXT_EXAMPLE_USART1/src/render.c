@@ -0,0 +1,96 @@
+/*
+ * render.c
+ *
+ * Fila de desenho com pedidos juntados (ver render.h).
+ */
+
+#include <stdio.h>
+#include "render.h"
+#include "widgets.h"
+#include "anim.h"
+#include "latency.h"
+#include "sched.h"
+
+static uint32_t pedidos;
+static uint32_t desde_ms;      // quando o pedido mais antigo chegou
+static struct render_stats stats;
+
+void render_pede(uint32_t pedido)
+{
+	stats.pedidos++;
+	if ((pedidos & pedido) == pedido) {
+		stats.juntados++;
+	}
+	if (pedidos == 0) {
+		desde_ms = sched_now_ms();
+	}
+	pedidos |= pedido;
+}
+
+void render_tela_mudou(enum tela t)
+{
+	UNUSED(t);
+	render_pede(RENDER_TELA);
+}
+
+bool render_pendente(void)
+{
+	return pedidos != 0;
+}
+
+bool render_pronto(bool entrada_pendente)
+{
+	if (pedidos == 0) {
+		return false;
+	}
+	if (entrada_pendente && sched_now_ms() - desde_ms < RENDER_MAX_ESPERA_MS) {
+		stats.adiados++;
+		return false;
+	}
+	return true;
+}
+
+uint32_t render_run(void)
+{
+	uint32_t t0 = latency_now();
+	uint32_t p = pedidos;
+	uint32_t n;
+
+	pedidos = 0;
+	if ((p & RENDER_TELA) && telas_desenha()) {
+		stats.telas++;
+	}
+	n = widgets_frame();
+	latency_render_done(tela_atual);
+
+	/* Quadro so termina quando o ultimo byte sai do SPI do LCD */
+	while (!(BOARD_ILI9488_SPI->SPI_SR & SPI_SR_TXEMPTY)) {
+	}
+	uint32_t us = latency_cycles_to_us(latency_now() - t0);
+	stats.quadros++;
+	if (us > stats.max_us) {
+		stats.max_us = us;
+	}
+	anim_quadro_feito(us);
+	return n;
+}
+
+void render_get_stats(struct render_stats *st)
+{
+	*st = stats;
+}
+
+void render_stats_reset(void)
+{
+	struct render_stats zero = {0};
+	stats = zero;
+}
+
+void render_dump(void)
+{
+	printf("render: %lu pedidos (%lu juntados), %lu quadros, %lu telas, "
+			"%lu adiados pela entrada, pior quadro %lu us\n\r",
+			(unsigned long)stats.pedidos, (unsigned long)stats.juntados,
+			(unsigned long)stats.quadros, (unsigned long)stats.telas,
+			(unsigned long)stats.adiados, (unsigned long)stats.max_us);
+}
@@ -0,0 +1,65 @@
+/*
+ * render.h
+ *
+ * Fila de desenho. Callbacks de toque e eventos so mudam o estado da
+ * interface e pedem um desenho; o estagio de render do loop principal
+ * roda depois que a entrada esvaziou e atende todos os pedidos de uma vez.
+ * Pedidos repetidos se juntam: com varias trocas de tela seguidas so a
+ * ultima tela e desenhada.
+ */
+
+#ifndef RENDER_H_
+#define RENDER_H_
+
+#include <asf.h>
+#include "telas.h"
+
+/* Com toques ainda na fila do maXTouch o render espera, mas nunca mais que isto */
+#ifndef RENDER_MAX_ESPERA_MS
+#define RENDER_MAX_ESPERA_MS   20
+#endif
+
+enum render_pedido {
+	RENDER_WIDGETS = (1u << 0),   // so os widgets invalidados
+	RENDER_TELA    = (1u << 1),   // remonta a tela atual (telas_desenha)
+};
+
+struct render_stats {
+	uint32_t pedidos;       // chamadas de render_pede
+	uint32_t juntados;      // pedidos que cairam num pedido ja pendente
+	uint32_t quadros;       // vezes que o estagio de render rodou
+	uint32_t telas;         // telas remontadas
+	uint32_t adiados;       // voltas do loop em que a entrada tinha prioridade
+	uint32_t max_us;        // quadro mais lento
+};
+
+/** \brief Pede um desenho (enum render_pedido). Nao desenha nada */
+void render_pede(uint32_t pedido);
+
+/** \brief Gancho de telas_init: toda troca de tela vira RENDER_TELA */
+void render_tela_mudou(enum tela t);
+
+bool render_pendente(void);
+
+/**
+ * \brief Decide se o render roda agora.
+ *
+ * \param entrada_pendente  ainda ha toques para ler
+ * \return true se ha pedido e a entrada esvaziou (ou ja esperou
+ *         RENDER_MAX_ESPERA_MS)
+ */
+bool render_pronto(bool entrada_pendente);
+
+/**
+ * \brief Atende os pedidos: remonta a tela se mudou, desenha os widgets
+ * sujos e fecha a amostra de latencia do toque que pediu o desenho.
+ *
+ * \return quantos widgets foram desenhados
+ */
+uint32_t render_run(void);
+
+void render_get_stats(struct render_stats *st);
+void render_stats_reset(void);
+void render_dump(void);
+
+#endif /* RENDER_H_ */
@@ -0,0 +1,232 @@
+/*
+ * sched.c
+ *
+ * Escalonador cooperativo (ver sched.h).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "sched.h"
+#include "events.h"
+#include "latency.h"
+
+/* id = geracao << SCHED_ID_SLOT_BITS | entrada; sempre positivo */
+#define SCHED_ID_SLOT_BITS  8
+#define SCHED_ID_SLOT_MASK  ((1 << SCHED_ID_SLOT_BITS) - 1)
+
+_Static_assert(SCHED_MAX_TASKS <= SCHED_ID_SLOT_MASK, "SCHED_MAX_TASKS nao cabe no id");
+
+struct task {
+	const char *name;
+	sched_fn_t fn;
+	void *ctx;
+	uint32_t period_ms;     // 0 = uma vez so
+	uint32_t deadline_ms;
+	uint32_t next_ms;
+	uint8_t prio;
+	bool used;
+	uint16_t gen;           // muda a cada tarefa nova nesta entrada
+
+	/* estatisticas */
+	uint32_t runs;
+	uint32_t misses;
+	uint32_t max_late_ms;
+	uint32_t max_cycles;
+	uint64_t sum_cycles;
+};
+
+static struct task tasks[SCHED_MAX_TASKS];
+static volatile uint32_t now_ms;
+
+/* Menor next_ms entre as tarefas ativas: o SysTick so posta a partir dele */
+static volatile uint32_t next_due = UINT32_MAX;
+
+/* Diferenca com sinal: sobrevive a volta do contador de ms (49 dias) */
+static inline bool due(uint32_t t, uint32_t now)
+{
+	return (int32_t)(now - t) >= 0;
+}
+
+void SysTick_Handler(void)
+{
+	uint32_t now = ++now_ms;
+
+	if (next_due != UINT32_MAX && due(next_due, now)) {
+		event_post(EV_TIMER);
+	}
+}
+
+static void update_next_due(void)
+{
+	uint32_t best = UINT32_MAX;
+	int32_t best_delta = INT32_MAX;
+
+	for (int i = 0; i < SCHED_MAX_TASKS; i++) {
+		if (tasks[i].used) {
+			int32_t delta = (int32_t)(tasks[i].next_ms - now_ms);
+			if (delta < best_delta) {
+				best_delta = delta;
+				best = tasks[i].next_ms;
+			}
+		}
+	}
+	next_due = best;
+}
+
+void sched_init(void)
+{
+	now_ms = 0;
+	next_due = UINT32_MAX;
+	SysTick_Config(sysclk_get_cpu_hz() / 1000);
+	/* Abaixo dos perifericos: so conta tempo */
+	NVIC_SetPriority(SysTick_IRQn, 6);
+}
+
+uint32_t sched_now_ms(void)
+{
+	return now_ms;
+}
+
+static int add(const char *name, uint32_t delay_ms, uint32_t period_ms,
+		uint32_t deadline_ms, uint8_t prio, sched_fn_t fn, void *ctx)
+{
+	for (int i = 0; i < SCHED_MAX_TASKS; i++) {
+		struct task *t = &tasks[i];
+		if (t->used) {
+			continue;
+		}
+		uint16_t gen = t->gen + 1;
+		memset(t, 0, sizeof(*t));
+		t->gen = gen;
+		t->name = name;
+		t->fn = fn;
+		t->ctx = ctx;
+		t->period_ms = period_ms;
+		t->deadline_ms = deadline_ms;
+		t->prio = prio;
+		t->next_ms = now_ms + delay_ms;
+		t->used = true;
+
+		irqflags_t flags = cpu_irq_save();
+		update_next_due();
+		cpu_irq_restore(flags);
+		return ((int)gen << SCHED_ID_SLOT_BITS) | i;
+	}
+	return SCHED_INVALID;
+}
+
+int sched_every(const char *name, uint32_t period_ms, uint32_t deadline_ms,
+		uint8_t prio, sched_fn_t fn, void *ctx)
+{
+	return add(name, period_ms, period_ms ? period_ms : 1, deadline_ms, prio, fn, ctx);
+}
+
+int sched_after(const char *name, uint32_t delay_ms, uint32_t deadline_ms,
+		uint8_t prio, sched_fn_t fn, void *ctx)
+{
+	return add(name, delay_ms, 0, deadline_ms, prio, fn, ctx);
+}
+
+void sched_cancel(int id)
+{
+	int slot = id & SCHED_ID_SLOT_MASK;
+
+	if (id < 0 || slot >= SCHED_MAX_TASKS) {
+		return;
+	}
+	/* Outra geracao: a tarefa deste id ja acabou e a entrada e de outra */
+	if (tasks[slot].used && tasks[slot].gen == (uint16_t)(id >> SCHED_ID_SLOT_BITS)) {
+		tasks[slot].used = false;
+		irqflags_t flags = cpu_irq_save();
+		update_next_due();
+		cpu_irq_restore(flags);
+	}
+}
+
+/* Tarefa vencida de maior prioridade (e mais atrasada), ou NULL */
+static struct task *pick(uint32_t now)
+{
+	struct task *best = NULL;
+
+	for (int i = 0; i < SCHED_MAX_TASKS; i++) {
+		struct task *t = &tasks[i];
+		if (!t->used || !due(t->next_ms, now)) {
+			continue;
+		}
+		if (best == NULL || t->prio > best->prio
+				|| (t->prio == best->prio
+					&& (int32_t)(t->next_ms - best->next_ms) < 0)) {
+			best = t;
+		}
+	}
+	return best;
+}
+
+void sched_run(void)
+{
+	struct task *t;
+
+	/* Uma tarefa por vez: a que rodou pode ter agendado outra */
+	while ((t = pick(now_ms)) != NULL) {
+		uint32_t late = now_ms - t->next_ms;
+		uint32_t c0;
+
+		if (late > t->deadline_ms) {
+			t->misses++;
+		}
+		t->max_late_ms = max(t->max_late_ms, late);
+
+		if (t->period_ms) {
+			/* Sem deriva; periodos perdidos inteiros sao pulados */
+			t->next_ms += t->period_ms;
+			if (due(t->next_ms, now_ms)) {
+				t->next_ms = now_ms + t->period_ms;
+			}
+		}
+		else {
+			t->used = false;
+		}
+
+		c0 = latency_now();
+		t->fn(t->ctx);
+		c0 = latency_now() - c0;
+
+		t->runs++;
+		t->sum_cycles += c0;
+		t->max_cycles = max(t->max_cycles, c0);
+	}
+
+	irqflags_t flags = cpu_irq_save();
+	update_next_due();
+	cpu_irq_restore(flags);
+}
+
+void sched_stats_reset(void)
+{
+	for (int i = 0; i < SCHED_MAX_TASKS; i++) {
+		tasks[i].runs = tasks[i].misses = tasks[i].max_late_ms = 0;
+		tasks[i].max_cycles = 0;
+		tasks[i].sum_cycles = 0;
+	}
+}
+
+void sched_dump(void)
+{
+	printf("\n\r# tarefas (%lu ms)\n\r", (unsigned long)now_ms);
+	printf("%-12s %4s %7s %9s %6s %9s %8s %8s\n\r",
+			"nome", "prio", "periodo", "execucoes", "perdas", "atraso ms",
+			"medio us", "max us");
+	for (int i = 0; i < SCHED_MAX_TASKS; i++) {
+		struct task *t = &tasks[i];
+		if (!t->used && t->runs == 0) {
+			continue;
+		}
+		uint32_t avg = t->runs ? (uint32_t)(t->sum_cycles / t->runs) : 0;
+		printf("%-12s %4u %7lu %9lu %6lu %9lu %8lu %8lu\n\r",
+				t->name, t->prio, (unsigned long)t->period_ms,
+				(unsigned long)t->runs, (unsigned long)t->misses,
+				(unsigned long)t->max_late_ms,
+				(unsigned long)latency_cycles_to_us(avg),
+				(unsigned long)latency_cycles_to_us(t->max_cycles));
+	}
+}
@@ -0,0 +1,60 @@
+/*
+ * sched.h
+ *
+ * Escalonador cooperativo com base de tempo de 1 ms (SysTick).
+ *
+ * As tarefas rodam no loop principal, nunca na interrupcao: o
+ * SysTick_Handler so conta o tempo e posta EV_TIMER quando alguma tarefa
+ * venceu. sched_run() executa as tarefas vencidas por prioridade (maior
+ * primeiro) e, empatadas, pela mais atrasada.
+ *
+ * Cada tarefa tem um prazo: se rodar mais de deadline_ms depois do
+ * instante previsto, conta uma perda de prazo. Tempo de execucao
+ * (ciclos do DWT) e perdas saem na tecla 't' do console.
+ */
+
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include <asf.h>
+
+#define SCHED_MAX_TASKS    12
+#define SCHED_INVALID      (-1)
+
+/* Prioridades usuais; qualquer valor 0-255 serve */
+#define SCHED_PRIO_LOW     0
+#define SCHED_PRIO_NORMAL  64
+#define SCHED_PRIO_HIGH    128
+
+typedef void (*sched_fn_t)(void *ctx);
+
+/** \brief Liga o SysTick a 1 kHz */
+void sched_init(void);
+
+/** \brief Milissegundos desde sched_init */
+uint32_t sched_now_ms(void);
+
+/**
+ * \brief Tarefa periodica; a primeira execucao e daqui a \p period_ms.
+ *
+ * \return Identificador para sched_cancel, ou SCHED_INVALID se nao ha espaco.
+ * O identificador leva a geracao da entrada: depois que a tarefa acaba ou
+ * e cancelada, ele nao vale para a proxima tarefa que ocupar o lugar.
+ */
+int sched_every(const char *name, uint32_t period_ms, uint32_t deadline_ms,
+		uint8_t prio, sched_fn_t fn, void *ctx);
+
+/** \brief Tarefa que roda uma vez daqui a \p delay_ms */
+int sched_after(const char *name, uint32_t delay_ms, uint32_t deadline_ms,
+		uint8_t prio, sched_fn_t fn, void *ctx);
+
+/** \brief Cancela a tarefa; id velho (tarefa ja terminada) e ignorado */
+void sched_cancel(int id);
+
+/** \brief Executa as tarefas vencidas. Chamar no loop principal em EV_TIMER. */
+void sched_run(void);
+
+void sched_stats_reset(void);
+void sched_dump(void);
+
+#endif /* SCHED_H_ */
@@ -0,0 +1,188 @@
+/*
+ * screenshot.c
+ *
+ * Captura da tela em faixas (ver screenshot.h).
+ */
+
+#include <string.h>
+#include "screenshot.h"
+#include "latency.h"
+#include "telemetry.h"
+
+#define WIDTH      ILI9488_LCD_WIDTH
+#define HEIGHT     ILI9488_LCD_HEIGHT
+#define BAND_PX    (WIDTH * SCREENSHOT_ROWS)
+
+enum shot_state {
+	SHOT_IDLE,
+	SHOT_BEGIN,
+	SHOT_BAND,
+	SHOT_END,
+};
+
+static enum shot_state state;
+static uint8_t shot_id;
+static uint16_t next_y;
+
+/* Faixa atual: y, linhas e o RLE ainda nao enviado */
+static uint16_t band_y;
+static uint8_t band_rows;
+static uint32_t band_len;
+static uint32_t band_sent;
+static uint32_t worst_us;
+
+/* A leitura crua (3 bytes por pixel) vira RGB565 no mesmo lugar */
+static uint8_t raw[BAND_PX * 3] __attribute__((aligned(4)));
+static uint8_t rle[BAND_PX * 2 + BAND_PX / 128 + 1];
+
+static inline uint8_t *put16(uint8_t *p, uint16_t v)
+{
+	*p++ = v & 0xFF;
+	*p++ = v >> 8;
+	return p;
+}
+
+uint32_t screenshot_rle(const uint16_t *px, uint32_t n, uint8_t *out)
+{
+	uint8_t *o = out;
+	uint32_t i = 0;
+
+	while (i < n) {
+		uint32_t run = 1;
+		while (i + run < n && run < 128 && px[i + run] == px[i]) {
+			run++;
+		}
+
+		if (run >= 2) {
+			*o++ = 0x80 | (run - 1);
+			o = put16(o, px[i]);
+			i += run;
+			continue;
+		}
+
+		/* Literais ate o inicio da proxima repeticao */
+		uint32_t lit = 1;
+		while (i + lit < n && lit < 128
+				&& !(i + lit + 1 < n && px[i + lit] == px[i + lit + 1])) {
+			lit++;
+		}
+		*o++ = lit - 1;
+		for (uint32_t k = 0; k < lit; k++) {
+			o = put16(o, px[i + k]);
+		}
+		i += lit;
+	}
+	return o - out;
+}
+
+/* Le e comprime a proxima faixa */
+static void capture_band(void)
+{
+	uint32_t t0 = latency_now();
+	uint16_t *px = (uint16_t *)raw;
+	uint32_t n;
+
+	band_y = next_y;
+	band_rows = min(SCREENSHOT_ROWS, HEIGHT - next_y);
+	n = WIDTH * band_rows;
+
+	ili9488_read_window(0, band_y, WIDTH, band_rows, raw);
+	/* RGB666 (3 bytes) -> RGB565 (2 bytes); px[i] nunca passa de raw[3i] */
+	for (uint32_t i = 0; i < n; i++) {
+		uint8_t r = raw[3 * i], g = raw[3 * i + 1], b = raw[3 * i + 2];
+		px[i] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+	}
+	band_len = screenshot_rle(px, n, rle);
+	band_sent = 0;
+	next_y += band_rows;
+
+	worst_us = max(worst_us, latency_cycles_to_us(latency_now() - t0));
+}
+
+/* Manda o que couber da faixa; true quando terminou */
+static bool send_band(void)
+{
+	uint8_t payload[8 + SCREENSHOT_CHUNK];
+
+	while (band_sent < band_len) {
+		uint32_t n = min(band_len - band_sent, SCREENSHOT_CHUNK);
+		uint8_t *p = payload;
+
+		*p++ = shot_id;
+		p = put16(p, band_y);
+		*p++ = band_rows;
+		p = put16(p, band_len);
+		p = put16(p, band_sent);
+		memcpy(p, &rle[band_sent], n);
+
+		if (!telemetry_send(TELEM_SHOT_DATA, payload, p - payload + n)) {
+			return false;
+		}
+		band_sent += n;
+	}
+	return true;
+}
+
+bool screenshot_start(void)
+{
+	if (state != SHOT_IDLE) {
+		return false;
+	}
+	shot_id++;
+	next_y = 0;
+	band_len = band_sent = 0;
+	worst_us = 0;
+	state = SHOT_BEGIN;
+	return true;
+}
+
+bool screenshot_busy(void)
+{
+	return state != SHOT_IDLE;
+}
+
+void screenshot_poll(void)
+{
+	uint8_t payload[6];
+	uint8_t *p = payload;
+
+	switch (state) {
+		case SHOT_IDLE:
+			break;
+
+		case SHOT_BEGIN:
+			*p++ = shot_id;
+			p = put16(p, WIDTH);
+			p = put16(p, HEIGHT);
+			*p++ = SCREENSHOT_FMT_RGB565_RLE;
+			if (telemetry_send(TELEM_SHOT_BEGIN, payload, p - payload)) {
+				state = SHOT_BAND;
+			}
+			break;
+
+		case SHOT_BAND:
+			/* So le a proxima faixa depois de despachar a anterior:
+			 * no maximo uma leitura por volta do loop */
+			if (!send_band()) {
+				break;
+			}
+			if (next_y >= HEIGHT) {
+				state = SHOT_END;
+				break;
+			}
+			capture_band();
+			send_band();
+			break;
+
+		case SHOT_END:
+			*p++ = shot_id;
+			p[0] = worst_us & 0xFF;
+			p[1] = (worst_us >> 8) & 0xFF;
+			p[2] = (worst_us >> 16) & 0xFF;
+			p[3] = worst_us >> 24;
+			if (telemetry_send(TELEM_SHOT_END, payload, 5)) {
+				state = SHOT_IDLE;
+			}
+			break;
+	}
+}
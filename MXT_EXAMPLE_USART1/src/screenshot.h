@@ -0,0 +1,54 @@
+/*
+ * screenshot.h
+ *
+ * Captura da tela atual pela USART de console, sem travar a interface.
+ *
+ * Nao ha copia da tela em RAM (seriam 300 KB), entao a imagem e lida de
+ * volta do ILI9488 em faixas de SCREENSHOT_ROWS linhas, uma por volta do
+ * loop principal. Cada faixa vira RGB565, e comprimida com RLE e sai em
+ * quadros de telemetria pelo buffer nao bloqueante da USART (uart_dma).
+ *
+ * Quadros (telemetry.h):
+ *   TELEM_SHOT_BEGIN: id (1), largura (2), altura (2), formato (1)
+ *   TELEM_SHOT_DATA:  id (1), y (2), linhas (1), tamanho da faixa (2),
+ *                     deslocamento (2), bytes RLE (ate SCREENSHOT_CHUNK)
+ *   TELEM_SHOT_END:   id (1), maior tempo de captura de uma faixa em us (4)
+ *
+ * RLE sobre pixels RGB565 little-endian: cabecalho n; se n & 0x80, repete
+ * (n & 0x7F) + 1 vezes o pixel seguinte; senao vem n + 1 pixels literais.
+ *
+ * O PNG e montado por tools/screenshot.py.
+ */
+
+#ifndef SCREENSHOT_H_
+#define SCREENSHOT_H_
+
+#include <asf.h>
+
+/* Linhas lidas por vez: 8 linhas de 480 pixels levam ~5 ms no SPI a 20 MHz */
+#define SCREENSHOT_ROWS      8
+
+/* Bytes RLE por quadro TELEM_SHOT_DATA */
+#define SCREENSHOT_CHUNK     240
+
+#define SCREENSHOT_FMT_RGB565_RLE   1
+
+/** \brief Comeca uma captura. False se ja ha uma em andamento. */
+bool screenshot_start(void);
+
+bool screenshot_busy(void);
+
+/**
+ * \brief Avanca a captura: manda o que couber da faixa atual ou le a
+ * proxima. Chamar no loop principal.
+ */
+void screenshot_poll(void);
+
+/**
+ * \brief Comprime \p n pixels RGB565 com o RLE descrito acima.
+ *
+ * \return Bytes escritos em \p out (no maximo 2 * n + n / 128 + 1)
+ */
+uint32_t screenshot_rle(const uint16_t *px, uint32_t n, uint8_t *out);
+
+#endif /* SCREENSHOT_H_ */
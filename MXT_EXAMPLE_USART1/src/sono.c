@@ -0,0 +1,215 @@
+/*
+ * sono.c
+ *
+ * Alarme do RTC e wait mode do inicio agendado (ver sono.h).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "sono.h"
+#include "uart_dma.h"
+#include "conf_uart_serial.h"
+
+/* RTT no SLCK, 8192 Hz: divisores 1 e 2 sao proibidos */
+#define SONO_RTT_PRES        4
+#define SONO_RTT_HZ          (32768 / SONO_RTT_PRES)
+
+static bool armado;
+
+/* Ciclo do DWT ao acordar pelo alarme (0 = nada medindo) */
+static uint32_t acordou;
+
+/* Alarme -> pmc_sleep voltar, pelo RTT */
+static uint32_t alarme_us;
+
+static struct sono_stats stats;
+
+static uint32_t segundos_do_dia(void)
+{
+	uint32_t h, m, s;
+
+	rtc_get_time(RTC, &h, &m, &s);
+	return h * 3600 + m * 60 + s;
+}
+
+/* O RTT esta no dominio de backup: nao tem clock no PMC e so e zerado
+ * na primeira vez */
+static void rtt_liga(void)
+{
+	if ((RTT->RTT_MR & (RTT_MR_RTPRES_Msk | RTT_MR_RTTDIS)) != RTT_MR_RTPRES(SONO_RTT_PRES)) {
+		RTT->RTT_MR = RTT_MR_RTPRES(SONO_RTT_PRES) | RTT_MR_RTTRST;
+	}
+}
+
+/* RTT_VR muda fora do clock do nucleo: duas leituras iguais */
+static uint32_t rtt_le(void)
+{
+	uint32_t v;
+
+	do {
+		v = RTT->RTT_VR;
+	} while (v != RTT->RTT_VR);
+	return v;
+}
+
+/* RTT na proxima virada de segundo do RTC (espera ate 1 s) */
+static uint32_t rtt_na_virada(void)
+{
+	rtc_clear_status(RTC, RTC_SCCR_SECCLR);
+	while ((rtc_get_status(RTC) & RTC_SR_SEC) == 0) {
+	}
+	return rtt_le();
+}
+
+bool sono_alarme(const struct agenda_plano *p)
+{
+	rtc_disable_interrupt(RTC, RTC_IDR_ALRDIS);
+	rtc_clear_status(RTC, RTC_SCCR_ALRCLR);
+	/* Data e hora juntas: o alarme so casa no dia certo */
+	if (rtc_set_time_alarm(RTC, 1, p->hora, 1, p->minuto, 1, p->segundo) != 0 ||
+			rtc_set_date_alarm(RTC, 1, p->data.mes, 1, p->data.dia) != 0) {
+		sono_cancela();
+		return false;
+	}
+	rtc_enable_interrupt(RTC, RTC_IER_ALREN);
+	armado = true;
+	return true;
+}
+
+void sono_cancela(void)
+{
+	rtc_disable_interrupt(RTC, RTC_IDR_ALRDIS);
+	rtc_clear_time_alarm(RTC);
+	rtc_clear_date_alarm(RTC);
+	rtc_clear_status(RTC, RTC_SCCR_ALRCLR);
+	armado = false;
+}
+
+bool sono_armado(void)
+{
+	return armado;
+}
+
+enum sono_motivo sono_dorme(void)
+{
+	uint32_t antes, virada, rtt;
+	bool alarme;
+
+	/* A USART para junto com o clock: o que estiver no buffer sairia cortado */
+	while (uart_dma_free() != UART_DMA_TX_SIZE || !usart_is_tx_empty(USART_SERIAL_EXAMPLE)) {
+	}
+
+	pio_set_pin_low(LCD_SPI_BACKLIGHT_PIO);
+	ili9488_display_off();
+	rtt_liga();
+	stats.sonos++;
+
+	/*
+	 * O RTC_Handler limparia o status ao religar as interrupcoes dentro do
+	 * pmc_sleep: a interrupcao do RTC fica mascarada no NVIC ate o motivo
+	 * ser lido. O wait mode nao depende dela, o RTCAL acorda pelo PMC.
+	 * Com ela mascarada o SEC da virada tambem fica para a gente.
+	 */
+	NVIC_DisableIRQ(RTC_IRQn);
+	virada = rtt_na_virada();
+	antes = segundos_do_dia();
+	pmc_set_fast_startup_input(PMC_FSMR_RTCAL | PMC_FSMR_FSTT5);
+	pmc_sleep(SAM_PM_SMODE_WAIT);
+	rtt = rtt_le();
+	alarme = (rtc_get_status(RTC) & RTC_SR_ALARM) != 0;
+	acordou = alarme ? latency_now() | 1u : 0;
+	NVIC_EnableIRQ(RTC_IRQn);
+
+	/* O alarme caiu numa virada: o que passou do segundo e o atraso.
+	 * Como 2^32 e multiplo de SONO_RTT_HZ, a volta do RTT nao atrapalha */
+	if (alarme) {
+		alarme_us = (uint32_t)((uint64_t)((rtt - virada) % SONO_RTT_HZ) * 1000000u / SONO_RTT_HZ);
+		latency_hist_add(&stats.acordar, alarme_us);
+	}
+
+	/* A memoria do LCD nao se perde: a tela volta como estava */
+	ili9488_display_on();
+	pio_set_pin_high(LCD_SPI_BACKLIGHT_PIO);
+
+	stats.dormido_s += (segundos_do_dia() + AGENDA_DIA_S - antes) % AGENDA_DIA_S;
+	if (alarme) {
+		stats.alarmes++;
+		return SONO_ALARME;
+	}
+	stats.portas++;
+	return SONO_PORTA;
+}
+
+void sono_rodando(void)
+{
+	if (acordou != 0) {
+		latency_hist_add(&stats.rodando, alarme_us + latency_cycles_to_us(latency_now() - acordou));
+	}
+}
+
+void sono_na_tela(void)
+{
+	if (acordou != 0) {
+		latency_hist_add(&stats.tela, alarme_us + latency_cycles_to_us(latency_now() - acordou));
+		acordou = 0;
+	}
+}
+
+void sono_teste(void)
+{
+	struct agenda_plano p;
+	uint32_t ano, mes, dia, semana, inicio;
+
+	/* O alarme e um so: nao atropela um agendamento */
+	if (armado) {
+		printf("sono: ha um inicio agendado\n\r");
+		return;
+	}
+	rtc_get_date(RTC, &ano, &mes, &dia, &semana);
+	inicio = segundos_do_dia() + SONO_TESTE_S;
+	p.data.ano = ano;
+	p.data.mes = mes;
+	p.data.dia = dia;
+	if (inicio >= AGENDA_DIA_S) {
+		inicio -= AGENDA_DIA_S;
+		agenda_amanha(&p.data);
+	}
+	p.hora = inicio / 3600;
+	p.minuto = inicio / 60 % 60;
+	p.segundo = inicio % 60;
+	if (!sono_alarme(&p)) {
+		printf("sono: alarme recusado pelo RTC\n\r");
+		return;
+	}
+
+	printf("sono: %u s em wait mode (corrente no jumper do MCU)\n\r", SONO_TESTE_S);
+	enum sono_motivo motivo = sono_dorme();
+	sono_cancela();
+	acordou = 0;
+	printf("sono: acordou pel%s\n\r", motivo == SONO_ALARME ? "o alarme" : "a porta");
+}
+
+void sono_stats_reset(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+void sono_dump(void)
+{
+	printf("sono: %lu vezes, %lu s dormindo, %lu pelo alarme, %lu pela porta, %s\n\r",
+			(unsigned long)stats.sonos, (unsigned long)stats.dormido_s,
+			(unsigned long)stats.alarmes, (unsigned long)stats.portas,
+			armado ? "agendado" : "sem agendamento");
+	printf("alarme -> acordado: p50 %lu us, p99 %lu us, max %lu us (%lu)\n\r",
+			(unsigned long)latency_percentile(&stats.acordar, 50),
+			(unsigned long)latency_percentile(&stats.acordar, 99),
+			(unsigned long)stats.acordar.max_us, (unsigned long)stats.acordar.count);
+	printf("alarme -> lavando: p50 %lu us, p99 %lu us, max %lu us (%lu)\n\r",
+			(unsigned long)latency_percentile(&stats.rodando, 50),
+			(unsigned long)latency_percentile(&stats.rodando, 99),
+			(unsigned long)stats.rodando.max_us, (unsigned long)stats.rodando.count);
+	printf("alarme -> tela: p50 %lu us, p99 %lu us, max %lu us\n\r",
+			(unsigned long)latency_percentile(&stats.tela, 50),
+			(unsigned long)latency_percentile(&stats.tela, 99),
+			(unsigned long)stats.tela.max_us);
+}
@@ -0,0 +1,70 @@
+/*
+ * sono.h
+ *
+ * Espera do inicio agendado (agenda.h) com o menor consumo: alarme de
+ * data e hora no RTC, tela e backlight apagados e o SAME70 em wait mode
+ * (pmc_sleep). So o alarme do RTC e a porta (PD28 = WKUP5, nivel baixo)
+ * estao no fast startup; toque, USART e timers nao acordam.
+ *
+ * Em wait mode o clock do nucleo para: SysTick e DWT nao contam, e o
+ * escalonador (sched.h) continua de onde parou. O RTT conta o SLCK, como o
+ * RTC, e nao para: antes de dormir o RTT e lido numa virada de segundo do
+ * RTC, e o alarme dispara numa virada, entao o RTT lido quando pmc_sleep
+ * volta da o tempo desde o alarme (oscilador e PLL incluidos, passos de
+ * 122 us). Dali em diante o DWT mede ate a lavagem rodando e ate o
+ * primeiro quadro dela na tela.
+ *
+ * Para medir a corrente de sono ha sono_teste (tecla 'z' do console):
+ * dorme alguns segundos sem ligar nada ao acordar.
+ */
+
+#ifndef SONO_H_
+#define SONO_H_
+
+#include <asf.h>
+#include "agenda.h"
+#include "latency.h"
+
+/* Duracao do sono de teste da tecla 'z' */
+#define SONO_TESTE_S         10
+
+enum sono_motivo {
+	SONO_ALARME = 0,       // alarme do RTC: hora de ligar
+	SONO_PORTA,            // porta no WKUP5: cancela o agendamento
+};
+
+struct sono_stats {
+	uint32_t sonos;
+	uint32_t alarmes;
+	uint32_t portas;
+	uint32_t dormido_s;            // pelo RTC
+	struct latency_hist acordar;   // alarme -> pmc_sleep voltar (RTT)
+	struct latency_hist rodando;   // alarme -> lavagem iniciada
+	struct latency_hist tela;      // alarme -> primeiro quadro da lavagem
+};
+
+/** \brief Programa o alarme de data e hora do RTC para o inicio do plano */
+bool sono_alarme(const struct agenda_plano *p);
+
+/** \brief Desliga o alarme (cancelado ou ja disparou) */
+void sono_cancela(void);
+
+bool sono_armado(void);
+
+/**
+ * \brief Espera a USART esvaziar, apaga a tela e dorme em wait mode ate
+ * o alarme ou a porta; religa a tela antes de voltar.
+ */
+enum sono_motivo sono_dorme(void);
+
+/* Pontos da medida de latencia depois de acordar pelo alarme */
+void sono_rodando(void);
+void sono_na_tela(void);
+
+/** \brief Dorme SONO_TESTE_S segundos para medir a corrente do MCU */
+void sono_teste(void);
+
+void sono_stats_reset(void);
+void sono_dump(void);
+
+#endif /* SONO_H_ */
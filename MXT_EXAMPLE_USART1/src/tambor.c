@@ -0,0 +1,91 @@
+/*
+ * tambor.c
+ *
+ * Modelo do tambor e do laco de velocidade (ver tambor.h).
+ */
+
+#include "tambor.h"
+
+#define DOIS_PI          6.2831853f
+
+/* Uniforme em [0, 1) (gerador congruente do Numerical Recipes) */
+static float sorteia(struct tambor *t)
+{
+	t->sorteio = t->sorteio * 1664525u + 1013904223u;
+	return (float)(t->sorteio >> 8) / 16777216.0f;
+}
+
+void tambor_init(struct tambor *t, float carga_kg, uint32_t semente)
+{
+	if (carga_kg < 0.0f) {
+		carga_kg = 0.0f;
+	}
+	t->rpm = 0.0f;
+	t->integral = 0.0f;
+	t->inercia = TAMBOR_INERCIA + TAMBOR_INERCIA_KG * carga_kg;
+	t->saturado = false;
+	t->carga_kg = carga_kg;
+	t->angulo = 0.0f;
+	t->grudada = false;
+	t->sorteio = semente;
+	t->desbalanco_kg = TAMBOR_DESBALANCO_MAX_KG * sorteia(t);
+}
+
+float tambor_passo(struct tambor *t, float ref_rpm, float dt)
+{
+	float erro = ref_rpm - t->rpm;
+	float torque = TAMBOR_KP * erro + TAMBOR_KI * t->integral;
+
+	/* Anti-windup: com o torque no limite o integrador nao acumula */
+	t->saturado = torque > TAMBOR_TORQUE_MAX || torque < -TAMBOR_TORQUE_MAX;
+	if (torque > TAMBOR_TORQUE_MAX) {
+		torque = TAMBOR_TORQUE_MAX;
+	}
+	else if (torque < -TAMBOR_TORQUE_MAX) {
+		torque = -TAMBOR_TORQUE_MAX;
+	}
+	else {
+		t->integral += erro * dt;
+	}
+
+	t->rpm += (torque - TAMBOR_ATRITO * t->rpm) / t->inercia * dt;
+	if (t->rpm < 0.0f && ref_rpm <= 0.0f) {
+		t->rpm = 0.0f;
+	}
+
+	/* Roupa cai abaixo da velocidade de grudar e se ajeita de outro jeito */
+	if (t->rpm >= TAMBOR_RPM_GRUDA) {
+		t->grudada = true;
+	}
+	else if (t->grudada) {
+		t->grudada = false;
+		t->desbalanco_kg = TAMBOR_DESBALANCO_MAX_KG * sorteia(t);
+	}
+
+	t->angulo += t->rpm * (DOIS_PI / 60.0f) * dt;
+	if (t->angulo >= DOIS_PI) {
+		t->angulo -= DOIS_PI;
+	}
+	return t->rpm;
+}
+
+float tambor_vibracao_g(struct tambor *t)
+{
+	float w = t->rpm * (DOIS_PI / 60.0f);
+	float ruido = TAMBOR_RUIDO_G * (2.0f * sorteia(t) - 1.0f);
+	float g = 0.0f;
+
+	/* So a roupa presa na parede gira junto com o tambor */
+	if (t->grudada) {
+		/* sen por Bhaskara I: sem libm na interrupcao, erro < 0,2% */
+		float x = t->angulo <= DOIS_PI / 2 ? t->angulo : t->angulo - DOIS_PI / 2;
+		float s = 16.0f * x * (DOIS_PI / 2 - x) /
+				(5.0f * (DOIS_PI / 2) * (DOIS_PI / 2) - 4.0f * x * (DOIS_PI / 2 - x));
+		if (t->angulo > DOIS_PI / 2) {
+			s = -s;
+		}
+		g = t->desbalanco_kg * TAMBOR_RAIO_M * w * w /
+				((TAMBOR_MASSA_KG + t->carga_kg) * 9.81f) * s;
+	}
+	return g + ruido;
+}
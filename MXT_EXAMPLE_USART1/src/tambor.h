@@ -0,0 +1,78 @@
+/*
+ * tambor.h
+ *
+ * Modelo do tambor para quando nao ha motor nem sensor ligados: inercia
+ * que cresce com a carga, atrito viscoso e o laco PI de velocidade do
+ * inversor, com torque limitado. Recebe a referencia da rampa (rampa.h)
+ * e devolve o rpm "medido", para conferir tempo de rampa e sobressinal
+ * na placa (motor.c) e no host.
+ *
+ * Modela tambem o acelerometro do gabinete: a massa desbalanceada gira
+ * com o tambor e sacode o conjunto com forca m r w^2, mais ruido. Acima
+ * de TAMBOR_RPM_GRUDA a roupa fica presa na parede; quando o tambor
+ * desce abaixo disso ela cai e o desbalanceamento e sorteado de novo.
+ */
+
+#ifndef TAMBOR_H_
+#define TAMBOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef TAMBOR_INERCIA
+#define TAMBOR_INERCIA       1.0f    // tambor vazio, unidades de torque / (rpm/s)
+#endif
+#ifndef TAMBOR_INERCIA_KG
+#define TAMBOR_INERCIA_KG    0.1f    // por kg de roupa molhada
+#endif
+#ifndef TAMBOR_ATRITO
+#define TAMBOR_ATRITO        0.02f   // torque por rpm
+#endif
+#ifndef TAMBOR_TORQUE_MAX
+#define TAMBOR_TORQUE_MAX    100.0f
+#endif
+#ifndef TAMBOR_KP
+#define TAMBOR_KP            8.0f
+#endif
+#ifndef TAMBOR_KI
+#define TAMBOR_KI            4.0f
+#endif
+
+#ifndef TAMBOR_RAIO_M
+#define TAMBOR_RAIO_M        0.25f
+#endif
+#ifndef TAMBOR_MASSA_KG
+#define TAMBOR_MASSA_KG      40.0f   // tambor, cuba e contrapesos sobre a suspensao
+#endif
+#ifndef TAMBOR_DESBALANCO_MAX_KG
+#define TAMBOR_DESBALANCO_MAX_KG 0.6f
+#endif
+#ifndef TAMBOR_RPM_GRUDA
+#define TAMBOR_RPM_GRUDA     60.0f   // w^2 r = g com r = 0,25 m
+#endif
+#ifndef TAMBOR_RUIDO_G
+#define TAMBOR_RUIDO_G       0.01f
+#endif
+
+struct tambor {
+	float rpm;
+	float integral;
+	float inercia;
+	bool saturado;         // torque no limite no ultimo passo
+
+	float carga_kg;
+	float desbalanco_kg;   // massa fora do centro, sorteada a cada queda da roupa
+	float angulo;          // rad
+	bool grudada;
+	uint32_t sorteio;
+};
+
+void tambor_init(struct tambor *t, float carga_kg, uint32_t semente);
+
+/** \brief Avanca \a dt segundos seguindo a referencia \a ref_rpm */
+float tambor_passo(struct tambor *t, float ref_rpm, float dt);
+
+/** \brief Aceleracao horizontal do gabinete agora, em g */
+float tambor_vibracao_g(struct tambor *t);
+
+#endif /* TAMBOR_H_ */
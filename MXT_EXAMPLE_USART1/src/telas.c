@@ -0,0 +1,172 @@
+/*
+ * telas.c
+ *
+ * Motor da maquina de estados das telas (ver telas.h).
+ */
+
+#include <stddef.h>
+#include "telas.h"
+
+volatile enum tela tela_atual = TELA_CARROSSEL;
+
+static const struct tela_def *defs;
+static const struct tela_transicao (*transicoes)[N_TELA_EV];
+static const struct tela_ops *ops;
+
+/* Tela trocada e ainda nao desenhada */
+static bool pendente;
+
+/* Ponteiros: os de fabrica ficam na flash (lavagens.h) */
+static const t_ciclo *const *ciclos;
+static uint8_t n_ciclos;
+static uint8_t ciclo_atual;
+
+/* So ponteiros: o conjunto muda de tela sem copiar as structs botao */
+static struct botao *ativos[TELAS_MAX_BOTOES];
+static uint8_t n_ativos;
+
+static void entra(enum tela t)
+{
+	const struct tela_def *d = &defs[t];
+	uint8_t n = 0;
+
+	tela_atual = t;
+	if (d->botao_ciclo && ciclos[ciclo_atual]->botao != NULL) {
+		ativos[n++] = ciclos[ciclo_atual]->botao;
+	}
+	for (uint8_t i = 0; i < d->n_botoes && n < TELAS_MAX_BOTOES; i++) {
+		ativos[n++] = d->botoes[i];
+	}
+	n_ativos = n;
+
+	/* Desenho fica para telas_desenha: varias trocas seguidas viram uma so */
+	pendente = true;
+	if (ops != NULL && ops->mudou != NULL) {
+		ops->mudou(t);
+	}
+}
+
+void telas_init(const struct tela_def *telas,
+		const struct tela_transicao (*tabela)[N_TELA_EV],
+		const t_ciclo *const *c, uint8_t n, const struct tela_ops *o)
+{
+	defs = telas;
+	transicoes = tabela;
+	ops = o;
+	pendente = false;
+	ciclos = c;
+	n_ciclos = n;
+	ciclo_atual = 0;
+	n_ativos = 0;
+}
+
+bool telas_evento(enum tela_evento ev)
+{
+	if (defs == NULL || n_ciclos == 0 || ev >= N_TELA_EV) {
+		return false;
+	}
+
+	const struct tela_transicao *tr = &transicoes[tela_atual][ev];
+	enum tela proxima = tr->proxima;
+
+	switch (tr->acao) {
+		case TELA_IGNORA:
+			return false;
+
+		case TELA_ANTERIOR:
+			ciclo_atual = (ciclo_atual + n_ciclos - 1) % n_ciclos;
+			break;
+
+		case TELA_PROXIMO:
+			ciclo_atual = (ciclo_atual + 1) % n_ciclos;
+			break;
+
+		case TELA_INICIA:
+			if (ops != NULL && ops->inicia != NULL && !ops->inicia(ciclos[ciclo_atual])) {
+				proxima = tr->recusada;
+			}
+			break;
+
+		case TELA_EDITA:
+			if (ops == NULL || ops->edita == NULL || !ops->edita(ciclos[ciclo_atual])) {
+				proxima = tr->recusada;
+			}
+			break;
+
+		case TELA_SALVA:
+			if (ops == NULL || ops->salva == NULL || !ops->salva()) {
+				proxima = tr->recusada;
+			}
+			break;
+
+		case TELA_ARMA:
+			if (ops == NULL || ops->arma == NULL || !ops->arma(ciclos[ciclo_atual])) {
+				proxima = tr->recusada;
+			}
+			break;
+
+		case TELA_PAUSA:
+			if (ops != NULL && ops->pausa != NULL) {
+				ops->pausa();
+			}
+			return true;
+
+		default:
+			break;
+	}
+
+	entra(proxima);
+	return true;
+}
+
+void telas_vai(enum tela t)
+{
+	if (defs != NULL && n_ciclos > 0 && t < N_TELAS) {
+		entra(t);
+	}
+}
+
+bool telas_desenha(void)
+{
+	if (!pendente) {
+		return false;
+	}
+	telas_redesenha();
+	return true;
+}
+
+void telas_redesenha(void)
+{
+	pendente = false;
+	if (defs != NULL && defs[tela_atual].desenha != NULL) {
+		defs[tela_atual].desenha(ciclos[ciclo_atual]);
+	}
+}
+
+const t_ciclo *telas_ciclo(void)
+{
+	return ciclos[ciclo_atual];
+}
+
+void telas_set_ciclos(const t_ciclo *const *c, uint8_t n, uint8_t atual)
+{
+	ciclos = c;
+	n_ciclos = n;
+	ciclo_atual = atual < n ? atual : 0;
+}
+
+const char *telas_nome(enum tela t)
+{
+	return defs != NULL && t < N_TELAS && defs[t].nome != NULL ? defs[t].nome : "?";
+}
+
+uint8_t telas_ciclo_indice(void)
+{
+	return ciclo_atual;
+}
+
+struct botao *const *telas_botoes(uint8_t *n)
+{
+	*n = n_ativos;
+	return ativos;
+}
@@ -0,0 +1,156 @@
+/*
+ * telas.h
+ *
+ * Maquina de estados das telas. Cada tela tem um desenho e um conjunto de
+ * botoes; cada par (tela, evento) da tabela diz qual acao rodar e para
+ * qual tela ir. Trocar de tela e so uma consulta na tabela: os botoes
+ * ativos sao ponteiros, nada e copiado.
+ *
+ * As definicoes das telas (desenho e botoes) ficam em telas_defs.c e a
+ * tabela de transicoes em telas_fluxo.c. Nem o motor nem as tabelas
+ * dependem do ASF, para poderem ser compilados e exercitados no host.
+ */
+
+#ifndef TELAS_H_
+#define TELAS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lavagens.h"
+
+/* Botoes fixos de uma tela + icone do ciclo (editor: 2 por campo + 2) */
+#define TELAS_MAX_BOTOES   16
+
+/* Numero de botoes de um conjunto */
+#define TELAS_N(tab)       (sizeof(tab) / sizeof((tab)[0]))
+
+/** \brief Telas da interface, usadas para separar as metricas por tela */
+enum tela {
+	TELA_CARROSSEL = 0,    // escolha do ciclo (fabrica e do usuario)
+	TELA_MENU,             // home + iniciar
+	TELA_LAVANDO,          // contagem regressiva
+	TELA_CONCLUIDA,        // lavagem concluida
+	TELA_PORTA_ABERTA,     // aviso de porta aberta
+	TELA_PORTA_TRANCADA,   // aviso de porta trancada
+	TELA_EDITOR,           // parametros de um programa do usuario
+	TELA_AGENDA,           // horario do inicio agendado
+	TELA_AGENDADA,         // esperando o horario (tela apaga e dorme)
+	N_TELAS
+};
+
+/** \brief Eventos que podem trocar de tela */
+enum tela_evento {
+	TELA_EV_ESCOLHE = 0,   // toque no icone do ciclo
+	TELA_EV_ANTERIOR,      // seta esquerda
+	TELA_EV_PROXIMO,       // seta direita
+	TELA_EV_HOME,
+	TELA_EV_INICIA,        // play
+	TELA_EV_OK,
+	TELA_EV_FIM,           // tempo da lavagem acabou
+	TELA_EV_EDITA,         // editar o ciclo atual
+	TELA_EV_AGENDA,        // agendar o ciclo atual
+	N_TELA_EV
+};
+
+/** \brief O que fazer antes de trocar de tela */
+enum tela_acao {
+	TELA_IGNORA = 0,       // evento nao vale nesta tela (entrada vazia da tabela)
+	TELA_TROCA,            // so troca de tela
+	TELA_ANTERIOR,         // ciclo anterior do carrossel
+	TELA_PROXIMO,          // proximo ciclo do carrossel
+	TELA_INICIA,           // comeca o ciclo atual (pode ser recusado)
+	TELA_PAUSA,            // pausa / retoma a lavagem, sem trocar de tela
+	TELA_EDITA,            // abre o editor com o ciclo atual (pode ser recusado)
+	TELA_SALVA,            // salva o programa editado (pode ser recusado)
+	TELA_ARMA,             // arma o inicio agendado do ciclo atual (pode ser recusado)
+};
+
+struct tela_transicao {
+	uint8_t acao;          // enum tela_acao
+	uint8_t proxima;       // enum tela
+	uint8_t recusada;      // enum tela se a acao for recusada
+};
+
+struct tela_def {
+	const char *nome;
+	/* Desenha a tela inteira */
+	void (*desenha)(const t_ciclo *ciclo);
+	struct botao *const *botoes;
+	uint8_t n_botoes;
+	/* O icone do ciclo atual (t_ciclo.botao) entra antes dos fixos */
+	bool botao_ciclo;
+};
+
+/* Ganchos das acoes que mexem fora da interface (todos opcionais) */
+struct tela_ops {
+	/* TELA_INICIA; false recusa (ex.: porta aberta) */
+	bool (*inicia)(const t_ciclo *ciclo);
+	/* TELA_PAUSA */
+	void (*pausa)(void);
+	/* Avisado a cada troca de tela, para pedir o desenho */
+	void (*mudou)(enum tela t);
+	/* TELA_EDITA; false recusa (ex.: sem espaco para outro programa) */
+	bool (*edita)(const t_ciclo *ciclo);
+	/* TELA_SALVA; o gancho troca a lista do carrossel (telas_set_ciclos) */
+	bool (*salva)(void);
+	/* TELA_ARMA; false recusa (ex.: nao da tempo de terminar no horario) */
+	bool (*arma)(const t_ciclo *ciclo);
+};
+
+/* tela x evento da interface (telas_fluxo.c) */
+extern const struct tela_transicao telas_fluxo[N_TELAS][N_TELA_EV];
+
+/**
+ * \brief Liga o motor as tabelas.
+ *
+ * \param telas   N_TELAS definicoes, na ordem de enum tela
+ * \param tabela  N_TELAS x N_TELA_EV transicoes
+ * \param ciclos  ponteiros para os programas do carrossel, em ordem (circular)
+ * \param n       quantos programas
+ */
+void telas_init(const struct tela_def *telas,
+		const struct tela_transicao (*tabela)[N_TELA_EV],
+		const t_ciclo *const *ciclos, uint8_t n, const struct tela_ops *ops);
+
+/**
+ * \brief Aplica um evento a tela atual. So muda o estado e os botoes
+ * ativos; o desenho fica para telas_desenha.
+ *
+ * \return false se o evento nao vale na tela atual
+ */
+bool telas_evento(enum tela_evento ev);
+
+/** \brief Vai direto para uma tela (boot, avisos da porta, fim da lavagem) */
+void telas_vai(enum tela t);
+
+/**
+ * \brief Desenha a tela atual se ela mudou desde o ultimo desenho. Trocas
+ * seguidas (ex.: tres toques na seta) custam um desenho so, o da ultima.
+ *
+ * \return false se nao havia troca pendente
+ */
+bool telas_desenha(void);
+
+/** \brief Redesenha a tela atual sem mudar o estado */
+void telas_redesenha(void);
+
+const t_ciclo *telas_ciclo(void);
+
+/**
+ * \brief Troca a lista do carrossel (programa salvo ou lido da flash) e
+ * seleciona \a atual. Nao redesenha.
+ */
+void telas_set_ciclos(const t_ciclo *const *c, uint8_t n, uint8_t atual);
+
+/** \brief Nome da tela na tabela do telas_init ("?" antes dele) */
+const char *telas_nome(enum tela t);
+
+/** \brief Posicao do ciclo atual no carrossel (0 = primeiro) */
+uint8_t telas_ciclo_indice(void);
+
+/** \brief Botoes ativos da tela atual, para o teste de toque */
+struct botao *const *telas_botoes(uint8_t *n);
+
+extern volatile enum tela tela_atual;
+
+#endif /* TELAS_H_ */
@@ -0,0 +1,125 @@
+/*
+ * telas_defs.c
+ *
+ * Botoes e definicoes das telas (ver telas_defs.h).
+ */
+
+#include <stddef.h>
+#include "telas_defs.h"
+#include "agenda.h"
+
+struct botao botaoLavagemDiaria;
+struct botao botaoLavagemPesada;
+struct botao botaoLavagemRapida;
+struct botao botaoLavagemEnxague;
+struct botao botaoLavagemCentrifuga;
+struct botao botaoLavagemUsuario;
+struct botao botaoDireita;
+struct botao botaoEsquerda;
+struct botao botaoLock;
+struct botao botaoUnlock;
+struct botao botaoHome;
+struct botao botaoPlayPause;
+struct botao botaoOk;
+struct botao imageNop;
+struct botao botaoEditar;
+struct botao botaoSalvar;
+struct botao botaoVoltar;
+struct botao botaoAgendar;
+struct botao botaoModo;
+struct botao botoesCampo[N_CAMPOS][2];
+struct botao botoesHorario[4];
+const int passos_horario[4] = {-60, 60, -AGENDA_PASSO_MIN, AGENDA_PASSO_MIN};
+
+/* Botoes fixos de cada tela; o icone do ciclo entra pelo botao_ciclo */
+static struct botao *const botoes_carrossel[] = {&botaoDireita, &botaoEsquerda, &botaoUnlock, &botaoLock};
+static struct botao *const botoes_menu[] = {&botaoHome, &botaoPlayPause, &botaoEditar, &botaoAgendar, &botaoUnlock, &botaoLock};
+static struct botao *const botoes_ok[] = {&botaoOk};
+
+static struct botao *const botoes_lavando[] = {&botaoPlayPause};
+
+static struct botao *const botoes_editor[] = {
+	&botoesCampo[CAMPO_ENXAGUE_MIN][0], &botoesCampo[CAMPO_ENXAGUE_MIN][1],
+	&botoesCampo[CAMPO_ENXAGUES][0],    &botoesCampo[CAMPO_ENXAGUES][1],
+	&botoesCampo[CAMPO_RPM][0],         &botoesCampo[CAMPO_RPM][1],
+	&botoesCampo[CAMPO_CENTRIF_MIN][0], &botoesCampo[CAMPO_CENTRIF_MIN][1],
+	&botoesCampo[CAMPO_PESADO][0],      &botoesCampo[CAMPO_PESADO][1],
+	&botoesCampo[CAMPO_BOLHAS][0],      &botoesCampo[CAMPO_BOLHAS][1],
+	&botaoVoltar, &botaoSalvar,
+};
+
+static struct botao *const botoes_agenda[] = {
+	&botaoModo,
+	&botoesHorario[0], &botoesHorario[1], &botoesHorario[2], &botoesHorario[3],
+	&botaoVoltar, &botaoSalvar,
+};
+static struct botao *const botoes_agendada[] = {&botaoVoltar};
+
+const struct tela_def telas_defs[N_TELAS] = {
+	[TELA_CARROSSEL]      = {"carrossel", draw_cycle_page,   botoes_carrossel, TELAS_N(botoes_carrossel), true},
+	[TELA_MENU]           = {"menu",      draw_laundry_menu, botoes_menu,      TELAS_N(botoes_menu),      false},
+	[TELA_LAVANDO]        = {"lavando",   draw_working,      botoes_lavando,   TELAS_N(botoes_lavando),   false},
+	[TELA_CONCLUIDA]      = {"concluida", draw_done_laundry, botoes_ok,        TELAS_N(botoes_ok),        false},
+	[TELA_PORTA_ABERTA]   = {"aberta",    draw_door_open,    botoes_ok,        TELAS_N(botoes_ok),        false},
+	[TELA_PORTA_TRANCADA] = {"trancada",  draw_locked_door,  NULL,             0,                        false},
+	[TELA_EDITOR]         = {"editor",    draw_editor,       botoes_editor,    TELAS_N(botoes_editor),    false},
+	[TELA_AGENDA]         = {"agenda",    draw_schedule,     botoes_agenda,    TELAS_N(botoes_agenda),    false},
+	[TELA_AGENDADA]       = {"agendada",  draw_scheduled,    botoes_agendada,  TELAS_N(botoes_agendada),  false},
+};
+
+static void botao_poe(struct botao *b, uint16_t x, uint16_t y, uint16_t size_x, uint16_t size_y,
+		void (*p_handler)(void)){
+	b->x = x;
+	b->y = y;
+	b->size_x = size_x;
+	b->size_y = size_y;
+	b->p_handler = p_handler;
+}
+
+void botoes_init(void){
+	/* Icone do ciclo: um por programa, todos no mesmo lugar */
+	botao_poe(&botaoLavagemDiaria,     150, 50, 180, 180, lavagem_callback);
+	botao_poe(&botaoLavagemPesada,     150, 50, 180, 180, lavagem_callback);
+	botao_poe(&botaoLavagemRapida,     150, 50, 180, 180, lavagem_callback);
+	botao_poe(&botaoLavagemEnxague,    150, 50, 180, 180, lavagem_callback);
+	botao_poe(&botaoLavagemCentrifuga, 150, 50, 180, 180, lavagem_callback);
+	botao_poe(&botaoLavagemUsuario,    150, 50, 180, 180, lavagem_callback);
+
+	botao_poe(&botaoDireita,  400, 90,  75,  110, slice_right_callback);
+	botao_poe(&botaoEsquerda, 20,  90,  75,  110, slice_left_callback);
+	botao_poe(&botaoUnlock,   400, 240, 70,  70,  unlock_callback);
+	botao_poe(&botaoLock,     20,  240, 70,  70,  lock_callback);
+	botao_poe(&botaoHome,     20,  90,  100, 100, home_callback);
+	botao_poe(&botaoPlayPause, 380, 90, 100, 100, play_pause_callback);
+	botao_poe(&botaoOk,       175, 105, 100, 100, ok_callback);
+	botao_poe(&imageNop,      115, 35,  251, 251, NULL);
+
+	/* Teclas de texto (widget_tecla), sem icone */
+	botao_poe(&botaoEditar,   100, 245, 125, 45, edit_callback);
+	botao_poe(&botaoAgendar,  245, 245, 140, 45, schedule_callback);
+	botao_poe(&botaoModo,     20,  45,  220, 40, mode_callback);
+	botao_poe(&botaoVoltar,   20,  268, 130, 44, home_callback);
+	botao_poe(&botaoSalvar,   330, 268, 135, 44, ok_callback);
+
+	for(int c = 0; c < N_CAMPOS; c++){
+		for(int s = 0; s < 2; s++){
+			botao_poe(&botoesCampo[c][s], s ? EDITOR_MAIS_X : EDITOR_MENOS_X, EDITOR_Y(c),
+					EDITOR_TECLA_W, EDITOR_TECLA_H, field_callback);
+		}
+	}
+
+	/* Hora - e + a esquerda do horario, minuto - e + a direita */
+	for(int i = 0; i < 4; i++){
+		botao_poe(&botoesHorario[i], (i < 2 ? 20 : 330) + (i % 2) * 75, 100, 60, 44, time_callback);
+	}
+}
+
+struct botao *processa_touch(struct botao *const *botoes, uint8_t n, uint32_t x, uint32_t y){
+	for (int i=0; i<n; i++){
+		struct botao *b = botoes[i];
+		if (((x >= b->x) && (x <= b->x + b->size_x)) && ((y >= b->y) && (y <= b->y + b->size_y))){
+			return b;
+		}
+	}
+	return NULL;
+}
@@ -0,0 +1,67 @@
+/*
+ * telas_defs.h
+ *
+ * Telas da lavadora para o motor do telas.h: posicao e callback de cada
+ * botao e quais botoes e qual desenho valem em cada tela. As imagens, os
+ * desenhos e os callbacks ficam em main.c; a tabela nao depende do ASF, e
+ * o loopback do host (tools/host/loopback.c) liga nela os seus callbacks.
+ */
+
+#ifndef TELAS_DEFS_H_
+#define TELAS_DEFS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "buttons.h"
+#include "programas.h"
+#include "telas.h"
+
+/* Linhas do editor de programas e suas teclas - e + */
+#define EDITOR_Y(campo)  (34 + (campo) * 38)
+#define EDITOR_TECLA_W   60
+#define EDITOR_TECLA_H   32
+#define EDITOR_MENOS_X   330
+#define EDITOR_MAIS_X    405
+
+/* - e + de cada campo do editor */
+extern struct botao botoesCampo[N_CAMPOS][2];
+/* Hora -, hora +, minuto -, minuto + do agendamento */
+extern struct botao botoesHorario[4];
+extern const int passos_horario[4];
+
+/* N_TELAS definicoes para o telas_init */
+extern const struct tela_def telas_defs[N_TELAS];
+
+/* Callbacks dos botoes */
+void lock_callback(void);
+void unlock_callback(void);
+void slice_left_callback(void);
+void slice_right_callback(void);
+void lavagem_callback(void);
+void play_pause_callback(void);
+void home_callback(void);
+void ok_callback(void);
+void edit_callback(void);
+void field_callback(void);
+void schedule_callback(void);
+void mode_callback(void);
+void time_callback(void);
+
+/* Desenho de cada tela */
+void draw_cycle_page(const t_ciclo *ciclo);
+void draw_laundry_menu(const t_ciclo *ciclo);
+void draw_working(const t_ciclo *ciclo);
+void draw_done_laundry(const t_ciclo *ciclo);
+void draw_door_open(const t_ciclo *ciclo);
+void draw_locked_door(const t_ciclo *ciclo);
+void draw_editor(const t_ciclo *ciclo);
+void draw_schedule(const t_ciclo *ciclo);
+void draw_scheduled(const t_ciclo *ciclo);
+
+/** \brief Posicao e callback de todos os botoes (as imagens sao do main.c) */
+void botoes_init(void);
+
+/** \brief Botao de \p botoes que contem o ponto (pixels), ou NULL */
+struct botao *processa_touch(struct botao *const *botoes, uint8_t n, uint32_t x, uint32_t y);
+
+#endif /* TELAS_DEFS_H_ */
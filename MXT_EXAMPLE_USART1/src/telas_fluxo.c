@@ -0,0 +1,49 @@
+/*
+ * telas_fluxo.c
+ *
+ * Tabela de transicoes das telas (ver telas.h). Fica fora do main.c para
+ * o teste do host (tools/host) usar a mesma tabela da placa.
+ */
+
+#include "telas.h"
+
+/* tela x evento -> {acao, proxima, se recusada}; o que nao esta aqui e ignorado */
+const struct tela_transicao telas_fluxo[N_TELAS][N_TELA_EV] = {
+	[TELA_CARROSSEL] = {
+		[TELA_EV_ESCOLHE]  = {TELA_TROCA,    TELA_MENU},
+		[TELA_EV_ANTERIOR] = {TELA_ANTERIOR, TELA_CARROSSEL},
+		[TELA_EV_PROXIMO]  = {TELA_PROXIMO,  TELA_CARROSSEL},
+	},
+	[TELA_MENU] = {
+		[TELA_EV_HOME]     = {TELA_TROCA,    TELA_CARROSSEL},
+		[TELA_EV_INICIA]   = {TELA_INICIA,   TELA_LAVANDO, TELA_PORTA_ABERTA},
+		[TELA_EV_EDITA]    = {TELA_EDITA,    TELA_EDITOR,  TELA_MENU},
+		[TELA_EV_AGENDA]   = {TELA_TROCA,    TELA_AGENDA},
+	},
+	[TELA_LAVANDO] = {
+		[TELA_EV_INICIA]   = {TELA_PAUSA,    TELA_LAVANDO},
+		[TELA_EV_FIM]      = {TELA_TROCA,    TELA_CONCLUIDA},
+	},
+	[TELA_CONCLUIDA] = {
+		[TELA_EV_OK]       = {TELA_TROCA,    TELA_CARROSSEL},
+	},
+	[TELA_PORTA_ABERTA] = {
+		[TELA_EV_OK]       = {TELA_TROCA,    TELA_CARROSSEL},
+	},
+	[TELA_PORTA_TRANCADA] = {
+		[TELA_EV_FIM]      = {TELA_TROCA,    TELA_CONCLUIDA},
+	},
+	[TELA_EDITOR] = {
+		[TELA_EV_OK]       = {TELA_SALVA,    TELA_MENU,    TELA_EDITOR},
+		[TELA_EV_HOME]     = {TELA_TROCA,    TELA_MENU},
+	},
+	[TELA_AGENDA] = {
+		[TELA_EV_OK]       = {TELA_ARMA,     TELA_AGENDADA, TELA_AGENDA},
+		[TELA_EV_HOME]     = {TELA_TROCA,    TELA_MENU},
+	},
+	/* O alarme do RTC entra como INICIA; cancelar (ou a porta) volta ao menu */
+	[TELA_AGENDADA] = {
+		[TELA_EV_INICIA]   = {TELA_INICIA,   TELA_LAVANDO,  TELA_PORTA_ABERTA},
+		[TELA_EV_HOME]     = {TELA_TROCA,    TELA_MENU},
+	},
+};
@@ -0,0 +1,79 @@
+/*
+ * telemetry.c
+ *
+ * Quadros binarios de telemetria (ver telemetry.h).
+ */
+
+#include "telemetry.h"
+#include "uart_dma.h"
+
+uint8_t telemetry_crc8(uint8_t crc, const uint8_t *data, uint32_t len)
+{
+	while (len--) {
+		crc ^= *data++;
+		for (int i = 0; i < 8; i++) {
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static inline uint8_t *put16(uint8_t *p, uint16_t v)
+{
+	*p++ = v & 0xFF;
+	*p++ = v >> 8;
+	return p;
+}
+
+static inline uint8_t *put32(uint8_t *p, uint32_t v)
+{
+	p = put16(p, v & 0xFFFF);
+	return put16(p, v >> 16);
+}
+
+bool telemetry_send(uint8_t type, const uint8_t *payload, uint8_t len)
+{
+	uint8_t frame[4 + TELEM_MAX_PAYLOAD + 1];
+	uint32_t n = 0;
+
+	/* Quadro inteiro ou nada: meio quadro so atrapalha o decodificador */
+	if (uart_dma_free() < (uint32_t)len + 5) {
+		return false;
+	}
+
+	frame[n++] = TELEM_SYNC0;
+	frame[n++] = TELEM_SYNC1;
+	frame[n++] = type;
+	frame[n++] = len;
+	for (uint32_t i = 0; i < len; i++) {
+		frame[n++] = payload[i];
+	}
+	frame[n] = telemetry_crc8(0, &frame[2], n - 2);
+	n++;
+
+	return uart_dma_write(frame, n) == n;
+}
+
+bool telemetry_touch(const struct mxt_touch_event *ev, uint32_t timestamp)
+{
+	uint8_t payload[11];
+	uint8_t *p = payload;
+
+	*p++ = ev->id;
+	*p++ = ev->status;
+	p = put16(p, ev->x);
+	p = put16(p, ev->y);
+	*p++ = ev->size;
+	p = put32(p, timestamp);
+
+	return telemetry_send(TELEM_TOUCH, payload, p - payload);
+}
+
+void telemetry_init(void)
+{
+	uint8_t payload[5];
+	uint8_t *p = put32(payload, sysclk_get_cpu_hz());
+
+	*p++ = TELEM_VERSION;
+	telemetry_send(TELEM_HELLO, payload, p - payload);
+}
@@ -0,0 +1,48 @@
+/*
+ * telemetry.h
+ *
+ * Quadros binarios de telemetria enviados pela USART de console
+ * (via uart_dma, sem bloquear).
+ *
+ * Formato de um quadro (little-endian):
+ *
+ *   0xA5 0x5A | tipo (1) | tamanho (1) | payload (tamanho) | crc8 (1)
+ *
+ * O crc8 (polinomio 0x07) cobre tipo, tamanho e payload. O decodificador
+ * do lado do PC esta em tools/telemetry_decode.py.
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <asf.h>
+
+#define TELEM_SYNC0          0xA5
+#define TELEM_SYNC1          0x5A
+#define TELEM_MAX_PAYLOAD    255
+
+enum telem_type {
+	TELEM_HELLO = 0x00,  // cpu_hz (4), versao (1)
+	TELEM_TOUCH = 0x01,  // id (1), status (1), x (2), y (2), size (1), ciclos DWT (4)
+	TELEM_TRACE = 0x02,  // id do formato (2), ciclos DWT (4), argumentos (4 cada), ver trace.h
+	TELEM_ACK   = 0x03,  // seq (1), comando (1), resultado (1), ver remote.h
+	TELEM_STATE = 0x04,  // seq (1), tela (1), laundry_event (1), time_left (4), unlocked (1), porta (1), botoes (1)
+	TELEM_PERF  = 0x05,  // seq (1), tela (1), por estagio de latency.h: n, p50, p99, max (4 cada); uart descartados (4)
+	TELEM_SHOT_BEGIN = 0x06,  // captura de tela, ver screenshot.h
+	TELEM_SHOT_DATA  = 0x07,
+	TELEM_SHOT_END   = 0x08,
+};
+
+#define TELEM_VERSION        1
+
+void telemetry_init(void);
+
+/** \brief Monta e enfileira um quadro. Retorna false se nao coube. */
+bool telemetry_send(uint8_t type, const uint8_t *payload, uint8_t len);
+
+/** \brief Quadro TELEM_TOUCH com o evento cru lido do maXTouch */
+bool telemetry_touch(const struct mxt_touch_event *ev, uint32_t timestamp);
+
+uint8_t telemetry_crc8(uint8_t crc, const uint8_t *data, uint32_t len);
+
+#endif /* TELEMETRY_H_ */
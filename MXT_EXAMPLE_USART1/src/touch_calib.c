@@ -0,0 +1,245 @@
+/*
+ * touch_calib.c
+ *
+ * Calibracao afim do toque (ver touch_calib.h).
+ */
+
+#include <stdio.h>
+#include "touch_calib.h"
+#include "latency.h"
+
+#define Q16(v)  ((int32_t)((v) * (1L << TOUCH_CALIB_SHIFT)))
+
+/* Amostras minimas por alvo para aceitar o toque */
+#define MIN_SAMPLES  4
+
+/* Mapeamento original: x = 480 - 480 * tx / 4096, y = 320 - 320 * ty / 4096 */
+static const struct touch_calib calib_default = {
+	.a = -(ILI9488_LCD_WIDTH << TOUCH_CALIB_SHIFT) / 4096,
+	.b = 0,
+	.c = Q16(ILI9488_LCD_WIDTH),
+	.d = 0,
+	.e = -(ILI9488_LCD_HEIGHT << TOUCH_CALIB_SHIFT) / 4096,
+	.f = Q16(ILI9488_LCD_HEIGHT),
+};
+
+/* Alvos a ~10% das bordas, nao colineares */
+static const uint16_t targets[TOUCH_CALIB_POINTS][2] = {
+	{ ILI9488_LCD_WIDTH / 10,     ILI9488_LCD_HEIGHT / 10 },
+	{ ILI9488_LCD_WIDTH * 9 / 10, ILI9488_LCD_HEIGHT / 2 },
+	{ ILI9488_LCD_WIDTH / 2,      ILI9488_LCD_HEIGHT * 9 / 10 },
+};
+
+static struct touch_calib calib;      // orientacao nativa
+static struct touch_calib active;     // com a orientacao aplicada
+static uint8_t orientation;
+
+const struct touch_calib *touch_calib_default(void)
+{
+	return &calib_default;
+}
+
+const struct touch_calib *touch_calib_get(void)
+{
+	return &calib;
+}
+
+const struct touch_calib *touch_calib_active(void)
+{
+	return &active;
+}
+
+/* Compoe a matriz nativa com a transformacao da orientacao do LCD */
+static void update_active(void)
+{
+	struct touch_calib m = calib;
+
+	if (orientation & ILI9488_FLIP_X) {
+		m.a = -m.a;
+		m.b = -m.b;
+		m.c = Q16(ILI9488_LCD_WIDTH - 1) - m.c;
+	}
+	if (orientation & ILI9488_FLIP_Y) {
+		m.d = -m.d;
+		m.e = -m.e;
+		m.f = Q16(ILI9488_LCD_HEIGHT - 1) - m.f;
+	}
+	if (orientation & ILI9488_SWITCH_XY) {
+		struct touch_calib s = {
+			.a = m.d, .b = m.e, .c = m.f,
+			.d = m.a, .e = m.b, .f = m.c,
+		};
+		m = s;
+	}
+	active = m;
+}
+
+void touch_calib_init(void)
+{
+	calib = calib_default;
+	orientation = 0;
+	update_active();
+}
+
+void touch_calib_set_orientation(uint8_t flags)
+{
+	ili9488_set_orientation(flags);
+	orientation = flags;
+	update_active();
+}
+
+/* A matriz tem que levar o centro do toque para dentro da tela */
+static bool calib_is_sane(const struct touch_calib *m)
+{
+	uint32_t x, y;
+
+	if (m->a == 0 && m->b == 0) {
+		return false;
+	}
+	if (m->d == 0 && m->e == 0) {
+		return false;
+	}
+	touch_calib_apply(m, 2048, 2048, &x, &y);
+	return x < ILI9488_LCD_WIDTH && y < ILI9488_LCD_HEIGHT;
+}
+
+bool touch_calib_load(const struct touch_calib *cal)
+{
+	if (!calib_is_sane(cal)) {
+		return false;
+	}
+	calib = *cal;
+	update_active();
+	return true;
+}
+
+static void draw_target(uint16_t x, uint16_t y, uint32_t color)
+{
+	ili9488_set_foreground_color(COLOR_CONVERT(color));
+	ili9488_draw_line(x - 12, y, x + 12, y);
+	ili9488_draw_line(x, y - 12, x, y + 12);
+	ili9488_draw_circle(x, y, 6);
+}
+
+static bool expired(uint32_t start)
+{
+	return latency_cycles_to_us(latency_now() - start) / 1000 > TOUCH_CALIB_TIMEOUT_MS;
+}
+
+/*
+ * Espera um toque completo e devolve a media das amostras. Retorna false
+ * se ninguem tocar no alvo ate TOUCH_CALIB_TIMEOUT_MS.
+ */
+static bool read_point(struct mxt_device *device, int32_t *tx, int32_t *ty)
+{
+	struct mxt_touch_event ev;
+	int32_t sx, sy, n;
+	uint32_t start = latency_now();
+
+	while (true) {
+		sx = sy = n = 0;
+		while (true) {
+			if (expired(start)) {
+				return false;
+			}
+			if (!mxt_is_message_pending(device)
+					|| mxt_read_touch_event(device, &ev) != STATUS_OK) {
+				continue;
+			}
+			if (ev.id != 0) {
+				continue;
+			}
+			if (ev.status & MXT_RELEASE_EVENT) {
+				break;
+			}
+			if (ev.status & MXT_DETECT_EVENT) {
+				sx += ev.x;
+				sy += ev.y;
+				n++;
+			}
+		}
+		if (n >= MIN_SAMPLES) {
+			*tx = sx / n;
+			*ty = sy / n;
+			return true;
+		}
+	}
+}
+
+/*
+ * Resolve [x y 1] * [a d; b e; c f] = [X Y] para os 3 pontos pela regra
+ * de Cramer. So roda na calibracao, entao pode usar float.
+ */
+static bool solve(const int32_t raw[][2], struct touch_calib *m)
+{
+	float x0 = raw[0][0], y0 = raw[0][1];
+	float x1 = raw[1][0], y1 = raw[1][1];
+	float x2 = raw[2][0], y2 = raw[2][1];
+	float det = x0 * (y1 - y2) - y0 * (x1 - x2) + (x1 * y2 - x2 * y1);
+	float k = (float)(1L << TOUCH_CALIB_SHIFT) / det;
+
+	if (det > -1.0f && det < 1.0f) {
+		return false;
+	}
+
+	for (int axis = 0; axis < 2; axis++) {
+		float v0 = targets[0][axis], v1 = targets[1][axis], v2 = targets[2][axis];
+		float p = v0 * (y1 - y2) - y0 * (v1 - v2) + (v1 * y2 - v2 * y1);
+		float q = x0 * (v1 - v2) - v0 * (x1 - x2) + (x1 * v2 - x2 * v1);
+		float r = x0 * (y1 * v2 - y2 * v1) - y0 * (x1 * v2 - x2 * v1)
+				+ v0 * (x1 * y2 - x2 * y1);
+		int32_t *row = axis ? &m->d : &m->a;
+		row[0] = (int32_t)(p * k);
+		row[1] = (int32_t)(q * k);
+		row[2] = (int32_t)(r * k);
+	}
+	return true;
+}
+
+bool touch_calib_run(struct mxt_device *device)
+{
+	int32_t raw[TOUCH_CALIB_POINTS][2];
+	struct touch_calib m;
+	uint8_t saved = orientation;
+	bool ok = true;
+
+	/* Alvos sempre na orientacao nativa */
+	if (saved) {
+		touch_calib_set_orientation(0);
+	}
+
+	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_WHITE));
+	ili9488_draw_filled_rectangle(0, 0, ILI9488_LCD_WIDTH - 1, ILI9488_LCD_HEIGHT - 1);
+	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_BLACK));
+	ili9488_draw_string(150, 140, (const uint8_t *)"TOQUE NOS ALVOS");
+
+	for (int i = 0; i < TOUCH_CALIB_POINTS && ok; i++) {
+		draw_target(targets[i][0], targets[i][1], COLOR_RED);
+		ok = read_point(device, &raw[i][0], &raw[i][1]);
+		draw_target(targets[i][0], targets[i][1], COLOR_WHITE);
+		if (ok) {
+			printf("calib %d: alvo (%d,%d) toque (%ld,%ld)\n\r", i,
+					targets[i][0], targets[i][1], (long)raw[i][0], (long)raw[i][1]);
+		}
+		else {
+			printf("calib %d: sem toque em %d ms\n\r", i, TOUCH_CALIB_TIMEOUT_MS);
+		}
+	}
+
+	/* Sem solucao os coeficientes nem foram escritos */
+	if (ok && !solve(raw, &m)) {
+		printf("calib rejeitada: toques sem solucao\n\r");
+		ok = false;
+	}
+	else if (ok) {
+		ok = touch_calib_load(&m);
+		printf("calib %s: a=%ld b=%ld c=%ld d=%ld e=%ld f=%ld\n\r",
+				ok ? "ok" : "rejeitada",
+				(long)m.a, (long)m.b, (long)m.c, (long)m.d, (long)m.e, (long)m.f);
+	}
+
+	if (saved) {
+		touch_calib_set_orientation(saved);
+	}
+	return ok;
+}
@@ -0,0 +1,74 @@
+/*
+ * touch_calib.h
+ *
+ * Calibracao do toque: matriz afim 2x3 em ponto fixo (Q16) que leva as
+ * coordenadas do maXTouch (0-4095) para pixels da tela.
+ *
+ *   x_tela = (a * x + b * y + c) >> 16
+ *   y_tela = (d * x + e * y + f) >> 16
+ *
+ * A matriz calibrada vale para a orientacao nativa do LCD; ao mudar a
+ * orientacao com touch_calib_set_orientation a matriz efetiva e
+ * recalculada uma vez, e o caminho quente continua so multiplica-desloca.
+ */
+
+#ifndef TOUCH_CALIB_H_
+#define TOUCH_CALIB_H_
+
+#include <asf.h>
+
+#define TOUCH_CALIB_SHIFT   16
+
+struct touch_calib {
+	int32_t a, b, c;
+	int32_t d, e, f;
+};
+
+/* Pontos-alvo da calibracao (pixels, orientacao nativa) */
+#define TOUCH_CALIB_POINTS  3
+
+/* Tempo maximo esperando o toque em cada alvo (abaixo da volta do DWT) */
+#define TOUCH_CALIB_TIMEOUT_MS  10000
+
+void touch_calib_init(void);
+
+/** \brief Troca a matriz de calibracao (orientacao nativa) */
+bool touch_calib_load(const struct touch_calib *cal);
+
+/** \brief Matriz de calibracao atual (orientacao nativa) */
+const struct touch_calib *touch_calib_get(void);
+
+/** \brief Matriz de fabrica, gravada em flash */
+const struct touch_calib *touch_calib_default(void);
+
+/**
+ * \brief Chama ili9488_set_orientation e ajusta a matriz efetiva para a
+ * mesma orientacao.
+ */
+void touch_calib_set_orientation(uint8_t flags);
+
+/** \brief Converte um ponto do maXTouch para pixels da tela */
+static inline void touch_calib_apply(const struct touch_calib *m,
+		uint16_t tx, uint16_t ty, uint32_t *sx, uint32_t *sy)
+{
+	int32_t x = (m->a * tx + m->b * ty + m->c) >> TOUCH_CALIB_SHIFT;
+	int32_t y = (m->d * tx + m->e * ty + m->f) >> TOUCH_CALIB_SHIFT;
+
+	*sx = (x < 0) ? 0 : (uint32_t)x;
+	*sy = (y < 0) ? 0 : (uint32_t)y;
+}
+
+/** \brief Matriz efetiva (ja com a orientacao aplicada) */
+const struct touch_calib *touch_calib_active(void);
+
+/**
+ * \brief Rotina de calibracao de 3 pontos: desenha um alvo por vez, le o
+ * toque medio em cada um e calcula a nova matriz. Bloqueia ate terminar
+ * ou ate um alvo ficar TOUCH_CALIB_TIMEOUT_MS sem toque.
+ *
+ * \return true se a matriz calculada foi aceita; false tambem no timeout,
+ * e a matriz anterior continua valendo
+ */
+bool touch_calib_run(struct mxt_device *device);
+
+#endif /* TOUCH_CALIB_H_ */
@@ -0,0 +1,177 @@
+/*
+ * touch_filter.c
+ *
+ * Filtro de toque (ver touch_filter.h).
+ *
+ * As coordenadas do maXTouch (12 bits) sao levadas para q15 com << 3,
+ * passam pela mediana e pelo IIR e voltam para 12 bits na saida.
+ */
+
+#include <string.h>
+#include "touch_filter.h"
+#include "latency.h"
+
+#define AXES 2
+
+enum finger_state {
+	FINGER_UP = 0,
+	FINGER_DOWN,
+	FINGER_SUPPRESSED,  // toque cancelado pelo controlador
+};
+
+struct finger {
+	uint8_t state;
+	uint8_t n;                                  // amostras na janela
+	uint8_t head;                               // proxima posicao na janela
+	q15_t   window[AXES][TOUCH_FILTER_MAX_MEDIAN];
+	q15_t   iir[AXES];                          // saida do IIR
+	q15_t   out[AXES];                          // ultima posicao entregue
+	uint32_t t_down;                            // ciclo do DWT no toque
+};
+
+static struct finger fingers[TOUCH_FILTER_MAX_IDS];
+
+static struct touch_filter_config config = {
+	.median_n     = TOUCH_FILTER_MEDIAN_N,
+	.iir_alpha    = TOUCH_FILTER_IIR_ALPHA,
+	.jitter       = TOUCH_FILTER_JITTER,
+	.min_press_ms = TOUCH_FILTER_MIN_PRESS_MS,
+};
+
+void touch_filter_init(void)
+{
+	memset(fingers, 0, sizeof(fingers));
+}
+
+void touch_filter_set_config(const struct touch_filter_config *cfg)
+{
+	config = *cfg;
+	if (config.median_n < 1) {
+		config.median_n = 1;
+	}
+	if (config.median_n > TOUCH_FILTER_MAX_MEDIAN) {
+		config.median_n = TOUCH_FILTER_MAX_MEDIAN;
+	}
+	config.median_n |= 1;
+	touch_filter_init();
+}
+
+const struct touch_filter_config *touch_filter_get_config(void)
+{
+	return &config;
+}
+
+static q15_t median(const q15_t *w, uint8_t n)
+{
+	q15_t s[TOUCH_FILTER_MAX_MEDIAN];
+
+	/* insertion sort: no maximo 5 elementos */
+	for (uint8_t i = 0; i < n; i++) {
+		q15_t v = w[i];
+		int8_t j = i - 1;
+		while (j >= 0 && s[j] > v) {
+			s[j + 1] = s[j];
+			j--;
+		}
+		s[j + 1] = v;
+	}
+	return s[n / 2];
+}
+
+static void finger_start(struct finger *f, const q15_t *raw)
+{
+	f->state = FINGER_DOWN;
+	f->n = 0;
+	f->head = 0;
+	f->t_down = latency_now();
+	for (int a = 0; a < AXES; a++) {
+		f->iir[a] = raw[a];
+		f->out[a] = raw[a];
+	}
+}
+
+/* Retorna true se a saida mudou alem do limiar de jitter */
+static bool finger_update(struct finger *f, const q15_t *raw)
+{
+	q15_t med[AXES], diff[AXES];
+	uint8_t n;
+
+	for (int a = 0; a < AXES; a++) {
+		f->window[a][f->head] = raw[a];
+	}
+	f->head = (f->head + 1) % config.median_n;
+	if (f->n < config.median_n) {
+		f->n++;
+	}
+
+	/* Com a janela incompleta usa a mediana do que ja tem (n impar) */
+	n = f->n | 1;
+	if (n > f->n) {
+		n -= 2;
+	}
+	for (int a = 0; a < AXES; a++) {
+		med[a] = median(f->window[a], n);
+	}
+
+	/* iir += alpha * (med - iir) */
+	arm_sub_q15(med, f->iir, diff, AXES);
+	arm_scale_q15(diff, config.iir_alpha, 0, diff, AXES);
+	arm_add_q15(f->iir, diff, f->iir, AXES);
+
+	/* Limiar de jitter contra a ultima posicao entregue */
+	arm_sub_q15(f->iir, f->out, diff, AXES);
+	arm_abs_q15(diff, diff, AXES);
+	if (diff[0] < (config.jitter << 3) && diff[1] < (config.jitter << 3)) {
+		return false;
+	}
+	f->out[0] = f->iir[0];
+	f->out[1] = f->iir[1];
+	return true;
+}
+
+static uint32_t finger_age_ms(const struct finger *f)
+{
+	return latency_cycles_to_us(latency_now() - f->t_down) / 1000;
+}
+
+enum touch_filter_result touch_filter_process(const struct mxt_touch_event *in,
+		struct mxt_touch_event *out)
+{
+	struct finger *f;
+	q15_t raw[AXES];
+	enum touch_filter_result res = TOUCH_FILTER_NONE;
+
+	if (in->id >= TOUCH_FILTER_MAX_IDS) {
+		return TOUCH_FILTER_NONE;
+	}
+	f = &fingers[in->id];
+	raw[0] = (q15_t)((in->x & 0x0FFF) << 3);
+	raw[1] = (q15_t)((in->y & 0x0FFF) << 3);
+
+	if (in->status & MXT_SUPPRESS_EVENT) {
+		/* palma / toque grande: descarta ate o proximo press */
+		f->state = FINGER_SUPPRESSED;
+	}
+	else if (in->status & MXT_RELEASE_EVENT) {
+		if (f->state == FINGER_DOWN
+				&& finger_age_ms(f) >= config.min_press_ms) {
+			res = TOUCH_FILTER_TAP;
+		}
+		f->state = FINGER_UP;
+	}
+	else if (in->status & (MXT_PRESS_EVENT | MXT_DETECT_EVENT)) {
+		if (f->state == FINGER_UP || (in->status & MXT_PRESS_EVENT)) {
+			finger_start(f, raw);
+			finger_update(f, raw);
+			res = TOUCH_FILTER_DOWN;
+		}
+		else if (f->state == FINGER_DOWN && finger_update(f, raw)) {
+			res = TOUCH_FILTER_MOVE;
+		}
+	}
+
+	*out = *in;
+	out->x = f->out[0] >> 3;
+	out->y = f->out[1] >> 3;
+	return res;
+}
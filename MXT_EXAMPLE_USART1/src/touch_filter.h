@@ -0,0 +1,44 @@
+/*
+ * touch_filter.h
+ *
+ * Filtro e debounce dos toques do maXTouch antes de chegarem em
+ * processa_touch: mediana de N + IIR em q15 (CMSIS-DSP), limiar de
+ * jitter e duracao minima de toque. Estado fixo por id de toque.
+ */
+
+#ifndef TOUCH_FILTER_H_
+#define TOUCH_FILTER_H_
+
+#include <asf.h>
+#include <arm_math.h>
+#include "conf_touch_filter.h"
+
+struct touch_filter_config {
+	uint8_t  median_n;      // janela da mediana (1..TOUCH_FILTER_MAX_MEDIAN, impar)
+	q15_t    iir_alpha;     // ganho do IIR
+	uint16_t jitter;        // limiar de movimento (unidades do maXTouch)
+	uint16_t min_press_ms;  // duracao minima de um toque valido
+};
+
+enum touch_filter_result {
+	TOUCH_FILTER_NONE = 0,  // nada para a interface (ruido, fantasma, etc.)
+	TOUCH_FILTER_DOWN,      // dedo confirmado na tela
+	TOUCH_FILTER_MOVE,      // dedo moveu alem do limiar de jitter
+	TOUCH_FILTER_TAP,       // dedo saiu depois de um toque valido
+};
+
+void touch_filter_init(void);
+void touch_filter_set_config(const struct touch_filter_config *cfg);
+const struct touch_filter_config *touch_filter_get_config(void);
+
+/**
+ * \brief Passa um evento cru pelo filtro.
+ *
+ * \param in  Evento lido de mxt_read_touch_event
+ * \param out Evento com x/y filtrados (valido se o retorno != NONE)
+ * \return O que o evento significa para a interface
+ */
+enum touch_filter_result touch_filter_process(const struct mxt_touch_event *in,
+		struct mxt_touch_event *out);
+
+#endif /* TOUCH_FILTER_H_ */
@@ -0,0 +1,120 @@
+/*
+ * touch_tracker.c
+ *
+ * Tabela de dedos do maXTouch (ver touch_tracker.h).
+ */
+
+#include <string.h>
+#include "touch_tracker.h"
+#include "latency.h"
+#include "trace.h"
+
+static struct touch_track tracks[TOUCH_TRACKER_MAX_IDS];
+static uint8_t n_ids = TOUCH_TRACKER_MAX_IDS;
+
+/* id do dedo primario, ou -1 se nenhum */
+static int8_t primary = -1;
+
+void touch_tracker_init(uint8_t num_touch)
+{
+	memset(tracks, 0, sizeof(tracks));
+	for (uint8_t i = 0; i < TOUCH_TRACKER_MAX_IDS; i++) {
+		tracks[i].id = i;
+	}
+	n_ids = min(max(num_touch, 1), TOUCH_TRACKER_MAX_IDS);
+	primary = -1;
+}
+
+uint32_t touch_tracker_age_ms(const struct touch_track *t)
+{
+	return latency_cycles_to_us(latency_now() - t->t_down) / 1000;
+}
+
+uint8_t touch_tracker_active(void)
+{
+	uint8_t n = 0;
+
+	for (uint8_t i = 0; i < n_ids; i++) {
+		if (tracks[i].state == TRACK_DOWN) {
+			n++;
+		}
+	}
+	return n;
+}
+
+const struct touch_track *touch_tracker_get(uint8_t id)
+{
+	return (id < n_ids) ? &tracks[id] : NULL;
+}
+
+static void release(struct touch_track *t)
+{
+	t->state = TRACK_FREE;
+	t->primary = false;
+	if (primary == t->id) {
+		primary = -1;
+	}
+}
+
+/* Dedos que sairam no evento anterior voltam a ficar livres */
+static void expire(void)
+{
+	for (uint8_t i = 0; i < n_ids; i++) {
+		if (tracks[i].state == TRACK_UP) {
+			release(&tracks[i]);
+		}
+	}
+}
+
+void touch_tracker_overflow(void)
+{
+	TRACE("fila do maXTouch estourou, %u dedo(s) liberado(s)",
+			touch_tracker_active());
+	for (uint8_t i = 0; i < n_ids; i++) {
+		if (tracks[i].state != TRACK_FREE) {
+			release(&tracks[i]);
+		}
+	}
+}
+
+const struct touch_track *touch_tracker_update(const struct mxt_touch_event *ev)
+{
+	struct touch_track *t;
+	uint32_t now = latency_now();
+
+	if (ev->id >= n_ids) {
+		return NULL;
+	}
+	expire();
+	t = &tracks[ev->id];
+
+	/* PRESS num dedo que ainda estava na tela: o release anterior se
+	 * perdeu, entao e um toque novo */
+	if (t->state == TRACK_DOWN && (ev->status & MXT_PRESS_EVENT)) {
+		TRACE("dedo %u sem release, novo toque", t->id);
+		release(t);
+	}
+
+	if (ev->status & (MXT_RELEASE_EVENT | MXT_SUPPRESS_EVENT)) {
+		if (t->state == TRACK_DOWN) {
+			t->state = TRACK_UP;
+		}
+	}
+	else if (ev->status & MXT_DETECT_EVENT) {
+		if (t->state != TRACK_DOWN) {
+			t->state = TRACK_DOWN;
+			t->t_down = now;
+			/* So vira primario se a tela estava livre: um segundo dedo
+			 * nunca rouba o lugar, nem depois que o primeiro sai */
+			t->primary = (touch_tracker_active() == 1 && primary < 0);
+			if (t->primary) {
+				primary = ev->id;
+			}
+		}
+	}
+	t->x = ev->x;
+	t->y = ev->y;
+	t->t_last = now;
+
+	return t;
+}
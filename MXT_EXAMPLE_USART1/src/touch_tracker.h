@@ -0,0 +1,67 @@
+/*
+ * touch_tracker.h
+ *
+ * Tabela de dedos do maXTouch, indexada pelo id do report T9
+ * (touch_event.id). Guarda estado, ultima posicao e idade de cada dedo e
+ * elege um dedo primario: so ele gera acoes na interface, os outros
+ * (ex.: mao apoiada no vidro) sao ignorados.
+ *
+ * Sem alocacao dinamica: tabela fixa de TOUCH_TRACKER_MAX_IDS entradas,
+ * das quais so as primeiras NUMTOUCH (configuracao do T9) sao usadas.
+ */
+
+#ifndef TOUCH_TRACKER_H_
+#define TOUCH_TRACKER_H_
+
+#include <asf.h>
+#include "conf_touch_filter.h"
+
+#define TOUCH_TRACKER_MAX_IDS     TOUCH_FILTER_MAX_IDS
+
+/* Posicao do NUMTOUCH dentro do objeto T9 */
+#define MXT_T9_NUMTOUCH           14
+
+enum touch_track_state {
+	TRACK_FREE = 0,
+	TRACK_DOWN,
+	TRACK_UP,       // acabou de sair; vale so para o evento atual
+};
+
+struct touch_track {
+	uint8_t  id;
+	uint8_t  state;
+	bool     primary;
+	uint16_t x;        // ultima posicao (unidades do maXTouch)
+	uint16_t y;
+	uint32_t t_down;   // ciclo do DWT quando encostou
+	uint32_t t_last;   // ciclo do DWT da ultima mensagem
+};
+
+/** \brief Limpa a tabela; \p num_touch vem do NUMTOUCH do T9 */
+void touch_tracker_init(uint8_t num_touch);
+
+/**
+ * \brief Atualiza o dedo do evento (ja filtrado).
+ *
+ * \return Entrada do dedo, ou NULL se o id esta fora do NUMTOUCH
+ */
+const struct touch_track *touch_tracker_update(const struct mxt_touch_event *ev);
+
+const struct touch_track *touch_tracker_get(uint8_t id);
+
+/**
+ * \brief A fila de mensagens do maXTouch estourou (bit OFL do T6).
+ *
+ * Releases podem ter se perdido: libera todos os dedos. Um dedo que
+ * continua na tela volta com o proximo DETECT. Silencio sozinho nunca
+ * libera um dedo, porque o maXTouch nao manda nada com o dedo parado.
+ */
+void touch_tracker_overflow(void);
+
+/** \brief Quantos dedos estao na tela */
+uint8_t touch_tracker_active(void);
+
+/** \brief Ha quanto tempo (ms) o dedo esta na tela */
+uint32_t touch_tracker_age_ms(const struct touch_track *t);
+
+#endif /* TOUCH_TRACKER_H_ */
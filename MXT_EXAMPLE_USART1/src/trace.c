@@ -0,0 +1,103 @@
+/*
+ * trace.c
+ *
+ * Log binario adiado (ver trace.h).
+ */
+
+#include "trace.h"
+#include "latency.h"
+#include "telemetry.h"
+#include "events.h"
+
+#define BUF_MASK   (TRACE_BUF_WORDS - 1)
+
+/*
+ * Registro no buffer: cabecalho (id << 16 | nargs), timestamp, argumentos.
+ * So o main (trace_flush) avanca tail; qualquer um escreve em head com as
+ * interrupcoes desligadas.
+ */
+static uint32_t buf[TRACE_BUF_WORDS];
+static volatile uint32_t head;
+static volatile uint32_t tail;
+static volatile uint32_t lost;
+static uint32_t lost_sent;
+
+void trace_init(void)
+{
+	head = tail = lost = lost_sent = 0;
+}
+
+void trace_write(uint32_t id, const uint32_t *args, uint32_t nargs)
+{
+	uint32_t ts = latency_now();
+	irqflags_t flags = cpu_irq_save();
+
+	if (TRACE_BUF_WORDS - (head - tail) < nargs + 2) {
+		lost++;
+	}
+	else {
+		buf[head++ & BUF_MASK] = (id << 16) | nargs;
+		buf[head++ & BUF_MASK] = ts;
+		for (uint32_t i = 0; i < nargs; i++) {
+			buf[head++ & BUF_MASK] = args[i];
+		}
+	}
+	cpu_irq_restore(flags);
+	event_post(EV_TRACE);
+}
+
+static inline uint8_t *put32(uint8_t *p, uint32_t v)
+{
+	for (int i = 0; i < 4; i++) {
+		*p++ = v & 0xFF;
+		v >>= 8;
+	}
+	return p;
+}
+
+/* Payload TELEM_TRACE: id (2), ciclos DWT (4), argumentos (4 cada) */
+static bool send_record(uint16_t id, uint32_t ts, const uint32_t *args, uint32_t nargs)
+{
+	uint8_t payload[6 + 4 * TRACE_MAX_ARGS];
+	uint8_t *p = payload;
+
+	*p++ = id & 0xFF;
+	*p++ = id >> 8;
+	p = put32(p, ts);
+	for (uint32_t i = 0; i < nargs; i++) {
+		p = put32(p, args[i]);
+	}
+	return telemetry_send(TELEM_TRACE, payload, p - payload);
+}
+
+void trace_flush(void)
+{
+	uint32_t l = lost;
+
+	if (l != lost_sent) {
+		uint32_t n = l - lost_sent;
+		if (!send_record(TRACE_ID_LOST, latency_now(), &n, 1)) {
+			return;
+		}
+		lost_sent = l;
+	}
+
+	while (tail != head) {
+		uint32_t hdr = buf[tail & BUF_MASK];
+		uint32_t nargs = min(hdr & 0xFF, TRACE_MAX_ARGS);
+		uint32_t rec[2 + TRACE_MAX_ARGS];
+
+		for (uint32_t i = 0; i < nargs + 2; i++) {
+			rec[i] = buf[(tail + i) & BUF_MASK];
+		}
+		if (!send_record(hdr >> 16, rec[1], &rec[2], nargs)) {
+			return;
+		}
+		tail += nargs + 2;
+	}
+}
+
+uint32_t trace_lost(void)
+{
+	return lost;
+}
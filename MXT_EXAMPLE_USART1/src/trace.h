@@ -0,0 +1,61 @@
+/*
+ * trace.h
+ *
+ * Log binario adiado. Cada TRACE() guarda so um id do formato, o
+ * timestamp do DWT e os argumentos crus (ate TRACE_MAX_ARGS inteiros de
+ * 32 bits) num buffer em RAM; trace_flush() manda os registros como
+ * quadros TELEM_TRACE pela telemetria.
+ *
+ * As strings de formato ficam na secao .log_fmt, que o flash.ld marca
+ * como INFO: estao no ELF mas nao ocupam flash. O id e o endereco da
+ * string dentro dessa secao. tools/trace_decode.py junta a captura com o
+ * Debug/MXT_EXAMPLE_USART1.elf e reconstroi o texto.
+ *
+ * Argumentos: inteiros (%d %u %x %c) ou ponteiros para strings constantes
+ * (%s, convertidos com (uint32_t)); float nao e suportado.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <asf.h>
+
+#define TRACE_MAX_ARGS     4
+
+/* Tamanho do buffer em palavras de 32 bits (potencia de 2) */
+#define TRACE_BUF_WORDS    256
+
+/* Id reservado: "registros perdidos", argumento = quantidade */
+#define TRACE_ID_LOST      0xFFFF
+
+#define TRACE_STR_(x)      #x
+#define TRACE_STR(x)       TRACE_STR_(x)
+
+/* Separa "arquivo:linha" do formato dentro da string da secao */
+#define TRACE_SEP          "\x1f"
+
+#define TRACE(fmt, ...) do { \
+	static const char trace_fmt_[] __attribute__((section(".log_fmt"), used)) \
+			= __FILE__ ":" TRACE_STR(__LINE__) TRACE_SEP fmt; \
+	const uint32_t trace_args_[] = {0, ##__VA_ARGS__}; \
+	_Static_assert(sizeof(trace_args_) / 4 - 1 <= TRACE_MAX_ARGS, \
+			"TRACE: argumentos demais"); \
+	trace_write((uint32_t)trace_fmt_, &trace_args_[1], \
+			sizeof(trace_args_) / 4 - 1); \
+} while (0)
+
+void trace_init(void);
+
+/** \brief Guarda um registro; chamado pela macro TRACE. Pode rodar em interrupcao. */
+void trace_write(uint32_t id, const uint32_t *args, uint32_t nargs);
+
+/**
+ * \brief Manda os registros pendentes pela telemetria enquanto couberem
+ * no buffer da USART. Chamar no loop principal.
+ */
+void trace_flush(void);
+
+/** \brief Registros descartados por buffer cheio desde o init */
+uint32_t trace_lost(void);
+
+#endif /* TRACE_H_ */
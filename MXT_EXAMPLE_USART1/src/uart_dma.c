@@ -0,0 +1,254 @@
+/*
+ * uart_dma.c
+ *
+ * Buffer circular de TX da USART de console esvaziado pelo XDMAC
+ * (ver uart_dma.h).
+ */
+
+#include <string.h>
+#include <stdio_serial.h>
+#include "conf_uart_serial.h"
+#include "dma.h"
+#include "uart_dma.h"
+#include "events.h"
+
+#define TX_MASK  (UART_DMA_TX_SIZE - 1)
+
+static uint8_t tx_buf[UART_DMA_TX_SIZE] DMA_ALIGNED;
+
+/* head: proximo byte a escrever (main), tail: proximo byte a enviar (DMA) */
+static volatile uint32_t head;
+static volatile uint32_t tail;
+static volatile uint32_t in_flight;
+static volatile bool polled;
+static enum uart_dma_policy policy = UART_DMA_DEFAULT_POLICY;
+static struct uart_dma_stats stats;
+
+/* Dispara a transferencia do trecho continuo entre tail e head */
+static void kick(void)
+{
+	XdmacChid *ch = &XDMAC->XDMAC_CHID[DMA_CH_UART_TX];
+	uint32_t start, len;
+
+	if (in_flight || head == tail) {
+		return;
+	}
+
+	start = tail & TX_MASK;
+	len = head - tail;
+	if (start + len > UART_DMA_TX_SIZE) {
+		len = UART_DMA_TX_SIZE - start;
+	}
+
+	dma_clean_dcache(&tx_buf[start], len);
+
+	(void)ch->XDMAC_CIS;
+	ch->XDMAC_CSA = (uint32_t)&tx_buf[start];
+	ch->XDMAC_CUBC = XDMAC_CUBC_UBLEN(len);
+	in_flight = len;
+	XDMAC->XDMAC_GE = (1u << DMA_CH_UART_TX);
+}
+
+static void tx_done(uint32_t status)
+{
+	if (status & XDMAC_CIS_BIS) {
+		tail += in_flight;
+		in_flight = 0;
+		kick();
+		event_post(EV_UART_TX);
+	}
+}
+
+/*
+ * Descarta os \p n bytes mais antigos que o DMA ainda nao pegou. O trecho
+ * em voo fica intacto, o resto e puxado para tras; so acontece em
+ * estouro, e copiar 2 KB leva poucos microssegundos.
+ */
+static void discard_oldest(uint32_t n)
+{
+	uint32_t to = tail + in_flight;
+	uint32_t from = to + n;
+
+	while (from != head) {
+		tx_buf[to & TX_MASK] = tx_buf[from & TX_MASK];
+		to++;
+		from++;
+	}
+	head = to;
+	stats.overwritten += n;
+}
+
+/* Copia para o buffer; chamada com as interrupcoes desligadas */
+static void push(const uint8_t *data, uint32_t n)
+{
+	uint32_t start = head & TX_MASK;
+	uint32_t first = min(n, UART_DMA_TX_SIZE - start);
+
+	memcpy(&tx_buf[start], data, first);
+	memcpy(&tx_buf[0], data + first, n - first);
+	head += n;
+	stats.written += n;
+	stats.high_water = max(stats.high_water, head - tail);
+}
+
+static void write_polled(const uint8_t *data, uint32_t len)
+{
+	while (len--) {
+		while (!usart_is_tx_ready(USART_SERIAL_EXAMPLE)) {
+		}
+		usart_write(USART_SERIAL_EXAMPLE, *data++);
+	}
+}
+
+/* So da para esperar o DMA se a interrupcao dele puder rodar */
+static bool can_block(void)
+{
+	return __get_IPSR() == 0 && cpu_irq_is_enabled();
+}
+
+static int putchar_dma(void volatile *usart, char c)
+{
+	(void)usart;
+	uart_dma_write((const uint8_t *)&c, 1);
+	return 0;
+}
+
+void uart_dma_init(void)
+{
+	XdmacChid *ch = &XDMAC->XDMAC_CHID[DMA_CH_UART_TX];
+
+	head = tail = in_flight = 0;
+	polled = false;
+	memset(&stats, 0, sizeof(stats));
+
+	XDMAC->XDMAC_GD = (1u << DMA_CH_UART_TX);
+	(void)ch->XDMAC_CIS;
+
+	ch->XDMAC_CDA = (uint32_t)&USART_SERIAL_EXAMPLE->US_THR;
+	ch->XDMAC_CC = XDMAC_CC_TYPE_PER_TRAN
+			| XDMAC_CC_MBSIZE_SINGLE
+			| XDMAC_CC_DSYNC_MEM2PER
+			| XDMAC_CC_CSIZE_CHK_1
+			| XDMAC_CC_DWIDTH_BYTE
+			| XDMAC_CC_SIF_AHB_IF0
+			| XDMAC_CC_DIF_AHB_IF1
+			| XDMAC_CC_SAM_INCREMENTED_AM
+			| XDMAC_CC_DAM_FIXED_AM
+			| XDMAC_CC_PERID(DMA_PERID_USART1_TX);
+	ch->XDMAC_CNDC = 0;
+	ch->XDMAC_CBC = 0;
+	ch->XDMAC_CDS_MSP = 0;
+	ch->XDMAC_CSUS = 0;
+	ch->XDMAC_CDUS = 0;
+
+	dma_set_callback(DMA_CH_UART_TX, tx_done);
+	ch->XDMAC_CIE = XDMAC_CIE_BIE;
+	XDMAC->XDMAC_GIE = (1u << DMA_CH_UART_TX);
+}
+
+void uart_dma_stdio(void)
+{
+	/* stdio_serial_init ja desligou o buffer do newlib (setbuf) */
+	ptr_put = putchar_dma;
+}
+
+void uart_dma_set_policy(enum uart_dma_policy p)
+{
+	policy = p;
+}
+
+uint32_t uart_dma_free(void)
+{
+	return UART_DMA_TX_SIZE - (head - tail);
+}
+
+uint32_t uart_dma_dropped(void)
+{
+	return stats.dropped;
+}
+
+void uart_dma_get_stats(struct uart_dma_stats *s)
+{
+	irqflags_t flags = cpu_irq_save();
+	*s = stats;
+	cpu_irq_restore(flags);
+}
+
+uint32_t uart_dma_write(const uint8_t *data, uint32_t len)
+{
+	irqflags_t flags;
+	uint32_t done = 0;
+	bool waited = false;
+	bool may_block = policy == UART_DMA_BLOCK && can_block();
+
+	if (polled) {
+		write_polled(data, len);
+		return len;
+	}
+
+	flags = cpu_irq_save();
+	while (done < len) {
+		uint32_t n = min(len - done, uart_dma_free());
+
+		if (n < len - done && policy == UART_DMA_OLDEST) {
+			/* O que esta em voo nao pode ser descartado */
+			uint32_t room = UART_DMA_TX_SIZE - in_flight;
+			uint32_t skip = len - done > room ? len - done - room : 0;
+
+			stats.overwritten += skip;
+			done += skip;
+			discard_oldest(min(len - done - uart_dma_free(),
+					head - tail - in_flight));
+			n = min(len - done, uart_dma_free());
+		}
+
+		push(data + done, n);
+		done += n;
+		kick();
+
+		if (done == len) {
+			break;
+		}
+		if (!may_block) {
+			stats.dropped += len - done;
+			break;
+		}
+
+		/* Abre a janela para a interrupcao do DMA liberar espaco */
+		if (!waited) {
+			stats.blocked++;
+			waited = true;
+		}
+		cpu_irq_restore(flags);
+		while (uart_dma_free() == 0) {
+		}
+		flags = cpu_irq_save();
+	}
+	cpu_irq_restore(flags);
+
+	return done;
+}
+
+void uart_dma_flush_on_fault(void)
+{
+	XdmacChid *ch = &XDMAC->XDMAC_CHID[DMA_CH_UART_TX];
+
+	XDMAC->XDMAC_GID = (1u << DMA_CH_UART_TX);
+
+	/* Quanto do trecho em voo ja saiu: o CUBC conta o que falta */
+	if (in_flight) {
+		uint32_t left = dma_channel_busy(DMA_CH_UART_TX) ?
+				(ch->XDMAC_CUBC & XDMAC_CUBC_UBLEN_Msk) : 0;
+		XDMAC->XDMAC_GD = (1u << DMA_CH_UART_TX);
+		while (dma_channel_busy(DMA_CH_UART_TX)) {
+		}
+		tail += in_flight - left;
+		in_flight = 0;
+	}
+
+	polled = true;
+	while (head != tail) {
+		write_polled(&tx_buf[tail & TX_MASK], 1);
+		tail++;
+	}
+}
@@ -0,0 +1,68 @@
+/*
+ * uart_dma.h
+ *
+ * Transmissao nao bloqueante na USART de console: os bytes vao para um
+ * buffer circular e o XDMAC esvazia o buffer para o US_THR.
+ *
+ * Depois de uart_dma_stdio() o printf tambem passa pelo buffer, entao um
+ * log numa callback custa a copia dos bytes e nao o tempo de transmissao.
+ */
+
+#ifndef UART_DMA_H_
+#define UART_DMA_H_
+
+#include <asf.h>
+
+/* Tamanho do buffer circular (potencia de 2) */
+#define UART_DMA_TX_SIZE   2048
+
+/* O que fazer quando o buffer nao tem espaco para tudo */
+enum uart_dma_policy {
+	UART_DMA_DROP,      // descarta o que nao coube (o novo)
+	UART_DMA_OLDEST,    // descarta o mais antigo que ainda nao foi ao DMA
+	UART_DMA_BLOCK,     // espera o DMA liberar espaco (vira DROP em interrupcao)
+};
+
+#ifndef UART_DMA_DEFAULT_POLICY
+#define UART_DMA_DEFAULT_POLICY   UART_DMA_BLOCK
+#endif
+
+struct uart_dma_stats {
+	uint32_t written;      // bytes aceitos
+	uint32_t dropped;      // bytes novos descartados (DROP, ou BLOCK sem poder esperar)
+	uint32_t overwritten;  // bytes antigos descartados (OLDEST)
+	uint32_t blocked;      // escritas que tiveram que esperar (BLOCK)
+	uint32_t high_water;   // maior ocupacao do buffer
+};
+
+void uart_dma_init(void);
+
+/** \brief Redireciona o printf (ptr_put do stdio da ASF) para o buffer */
+void uart_dma_stdio(void);
+
+void uart_dma_set_policy(enum uart_dma_policy policy);
+
+/**
+ * \brief Copia \p len bytes para o buffer e dispara o DMA se estiver parado.
+ *
+ * \return Quantidade de bytes aceitos (menor que \p len se nao coube)
+ */
+uint32_t uart_dma_write(const uint8_t *data, uint32_t len);
+
+/** \brief Espaco livre no buffer, em bytes */
+uint32_t uart_dma_free(void);
+
+/** \brief Bytes descartados por falta de espaco desde o init */
+uint32_t uart_dma_dropped(void);
+
+void uart_dma_get_stats(struct uart_dma_stats *stats);
+
+/**
+ * \brief Para o DMA e envia por polling o que ainda esta no buffer.
+ *
+ * Para os handlers de falha: depois dela toda escrita (inclusive printf)
+ * vai direto para o US_THR, sem depender de interrupcoes.
+ */
+void uart_dma_flush_on_fault(void);
+
+#endif /* UART_DMA_H_ */
@@ -0,0 +1,213 @@
+/*
+ * vibra.c
+ *
+ * Amostragem da vibracao em buffer duplo e FFT no loop (ver vibra.h).
+ */
+
+#include <stdio.h>
+#include "vibra.h"
+#include "dma.h"
+#include "events.h"
+#include "latency.h"
+#include "motor.h"
+
+static uint16_t amostras[2][DESBALANCO_N] DMA_ALIGNED;
+static float janela[DESBALANCO_N];
+
+static volatile uint8_t enchendo;        // buffer que o DMA (ou o modelo) escreve
+static volatile int8_t cheio = -1;       // buffer esperando o loop
+static volatile uint16_t rpm_inicio[2];
+static volatile uint16_t rpm_fim[2];
+
+static struct vibra_stats stats;
+
+/* Na interrupcao: troca de buffer e avisa o loop */
+static void buffer_cheio(void)
+{
+	uint8_t b = enchendo;
+	uint16_t ref = motor_referencia();
+
+	if (cheio >= 0) {
+		stats.perdidas++;
+	}
+	rpm_fim[b] = ref;
+	cheio = b;
+	enchendo = b ^ 1;
+	rpm_inicio[b ^ 1] = ref;
+	event_post(EV_VIBRA);
+}
+
+#if VIBRA_MODELO
+
+static uint16_t n_amostra;
+
+void TC1_Handler(void)
+{
+	(void)VIBRA_TC->TC_CHANNEL[VIBRA_TC_CANAL].TC_SR;
+
+	int32_t lsb = VIBRA_ZERO + (int32_t)(motor_vibracao_g() * VIBRA_LSB_POR_G);
+	amostras[enchendo][n_amostra] = lsb < 0 ? 0 : lsb > 4095 ? 4095 : (uint16_t)lsb;
+	if (++n_amostra == DESBALANCO_N) {
+		n_amostra = 0;
+		buffer_cheio();
+	}
+}
+
+#else
+
+static struct dma_desc_v1 desc[2] DMA_ALIGNED;
+
+static void dma_cb(uint32_t status)
+{
+	/* Um bloco por descritor: o DMA ja seguiu para o outro buffer */
+	if (status & XDMAC_CIS_BIS) {
+		buffer_cheio();
+	}
+}
+
+static void afec_dma_init(void)
+{
+	XdmacChid *ch = &XDMAC->XDMAC_CHID[DMA_CH_VIBRA];
+	Afec *afec = VIBRA_AFEC;
+
+	/* AFEC0 canal 0, disparado pelo TIOA1 (TRIG2), 12 bits */
+	pmc_enable_periph_clk(VIBRA_AFEC_ID);
+	afec->AFEC_CR = AFEC_CR_SWRST;
+	afec->AFEC_MR = AFEC_MR_TRGEN_EN | AFEC_MR_TRGSEL_AFEC_TRIG2
+			| AFEC_MR_PRESCAL(sysclk_get_peripheral_hz() / VIBRA_AFE_HZ - 1)
+			| AFEC_MR_STARTUP_SUT64 | AFEC_MR_ONE
+			| AFEC_MR_TRACKTIM(15) | AFEC_MR_TRANSFER(2);
+	afec->AFEC_EMR = AFEC_EMR_RES_NO_AVERAGE;
+	afec->AFEC_ACR = AFEC_ACR_IBCTL(1) | AFEC_ACR_PGA0EN | AFEC_ACR_PGA1EN;
+	afec->AFEC_CSELR = VIBRA_AFEC_CANAL;
+	afec->AFEC_COCR = 0x200;      // entrada simples: meio da escala do offset
+	afec->AFEC_CHER = 1u << VIBRA_AFEC_CANAL;
+
+	/* Dois descritores em anel, cada um com um buffer */
+	for (int i = 0; i < 2; i++) {
+		desc[i].mbr_nda = (uint32_t)&desc[i ^ 1];
+		desc[i].mbr_ubc = DMA_UBC_NVIEW_1 | DMA_UBC_NDEN | DMA_UBC_NDE
+				| DMA_UBC_UBLEN(DESBALANCO_N);
+		desc[i].mbr_da = (uint32_t)amostras[i];
+	}
+	dma_clean_dcache(desc, sizeof(desc));
+
+	XDMAC->XDMAC_GD = (1u << DMA_CH_VIBRA);
+	(void)ch->XDMAC_CIS;
+	ch->XDMAC_CSA = (uint32_t)&afec->AFEC_LCDR;
+	ch->XDMAC_CC = XDMAC_CC_TYPE_PER_TRAN
+			| XDMAC_CC_MBSIZE_SINGLE
+			| XDMAC_CC_DSYNC_PER2MEM
+			| XDMAC_CC_CSIZE_CHK_1
+			| XDMAC_CC_DWIDTH_HALFWORD
+			| XDMAC_CC_SIF_AHB_IF1
+			| XDMAC_CC_DIF_AHB_IF0
+			| XDMAC_CC_SAM_FIXED_AM
+			| XDMAC_CC_DAM_INCREMENTED_AM
+			| XDMAC_CC_PERID(DMA_PERID_AFEC0);
+	ch->XDMAC_CNDA = (uint32_t)&desc[0];
+	ch->XDMAC_CNDC = XDMAC_CNDC_NDVIEW_NDV1
+			| XDMAC_CNDC_NDDUP_DST_PARAMS_UPDATED
+			| XDMAC_CNDC_NDE_DSCR_FETCH_EN;
+	ch->XDMAC_CBC = 0;
+	ch->XDMAC_CDS_MSP = 0;
+	ch->XDMAC_CSUS = 0;
+	ch->XDMAC_CDUS = 0;
+
+	dma_set_callback(DMA_CH_VIBRA, dma_cb);
+	ch->XDMAC_CIE = XDMAC_CIE_BIE;
+	XDMAC->XDMAC_GIE = (1u << DMA_CH_VIBRA);
+	XDMAC->XDMAC_GE = (1u << DMA_CH_VIBRA);
+}
+
+#endif
+
+void vibra_init(void)
+{
+	TcChannel *tc = &VIBRA_TC->TC_CHANNEL[VIBRA_TC_CANAL];
+	uint32_t rc = sysclk_get_peripheral_hz() / 32 / VIBRA_HZ;
+
+	if (!desbalanco_init()) {
+		printf("vibra: FFT de %u pontos nao suportada\n\r", DESBALANCO_N);
+		return;
+	}
+
+	/* TC0 canal 1: MCK/32, TIOA1 sobe no RA e desce no RC a VIBRA_HZ */
+	pmc_enable_periph_clk(VIBRA_TC_ID);
+	tc->TC_CCR = TC_CCR_CLKDIS;
+	tc->TC_IDR = 0xFFFFFFFF;
+	tc->TC_CMR = TC_CMR_TCCLKS_TIMER_CLOCK3 | TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC
+			| TC_CMR_ACPA_SET | TC_CMR_ACPC_CLEAR;
+	tc->TC_RA = rc / 2;
+	tc->TC_RC = rc;
+
+#if VIBRA_MODELO
+	/* Mesma prioridade do laco do motor: le o modelo sem ser interrompida */
+	tc->TC_IER = TC_IER_CPCS;
+	NVIC_ClearPendingIRQ(VIBRA_TC_IRQn);
+	NVIC_SetPriority(VIBRA_TC_IRQn, 1);
+	NVIC_EnableIRQ(VIBRA_TC_IRQn);
+#else
+	afec_dma_init();
+#endif
+	tc->TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG;
+}
+
+bool vibra_processa(struct vibra_janela *j)
+{
+	irqflags_t flags = cpu_irq_save();
+	int8_t b = cheio;
+	cheio = -1;
+	cpu_irq_restore(flags);
+
+	if (b < 0) {
+		return false;
+	}
+
+	uint32_t t0 = latency_now();
+
+#if !VIBRA_MODELO
+	dma_invalidate_dcache(amostras[b], sizeof(amostras[b]));
+#endif
+	for (int i = 0; i < DESBALANCO_N; i++) {
+		janela[i] = (float)((int32_t)amostras[b][i] - VIBRA_ZERO) / VIBRA_LSB_POR_G;
+	}
+	j->rpm = motor_rpm();
+	j->freq_hz = j->rpm / 60.0f;
+	j->estavel = rpm_inicio[b] != 0 && rpm_inicio[b] == rpm_fim[b];
+	j->amplitude_g = desbalanco_amplitude_g(janela, VIBRA_HZ, j->freq_hz);
+
+	uint32_t us = latency_cycles_to_us(latency_now() - t0);
+	stats.janelas++;
+	stats.ultima_us = us;
+	if (us > stats.max_us) {
+		stats.max_us = us;
+	}
+	if (us > VIBRA_ORCAMENTO_US) {
+		stats.acima++;
+	}
+	if (j->estavel && j->amplitude_g > stats.pior_g) {
+		stats.pior_g = j->amplitude_g;
+	}
+	return true;
+}
+
+void vibra_stats_reset(void)
+{
+	struct vibra_stats zero = {0};
+	irqflags_t flags = cpu_irq_save();
+	stats = zero;
+	cpu_irq_restore(flags);
+}
+
+void vibra_dump(void)
+{
+	printf("vibra: %s a %u Hz, janela de %u, %lu janelas, %lu perdidas\n\r",
+			VIBRA_MODELO ? "modelo" : "AFEC0", VIBRA_HZ, DESBALANCO_N,
+			(unsigned long)stats.janelas, (unsigned long)stats.perdidas);
+	printf("  FFT ultima %lu us, pior %lu us, %lu acima de %u us; pior %lu mg (limiar %lu)\n\r",
+			(unsigned long)stats.ultima_us, (unsigned long)stats.max_us,
+			(unsigned long)stats.acima, VIBRA_ORCAMENTO_US,
+			(unsigned long)(stats.pior_g * 1000.0f + 0.5f),
+			(unsigned long)(DESBALANCO_LIMIAR_G * 1000.0f + 0.5f));
+}
@@ -0,0 +1,78 @@
+/*
+ * vibra.h
+ *
+ * Aquisicao do acelerometro do gabinete. O TC0 canal 1 gera o TIOA1 a
+ * VIBRA_HZ, que dispara o AFEC0 (canal 0, PD30); o XDMAC copia cada
+ * conversao para um de dois buffers, encadeados em anel por descritores.
+ * Quando um buffer enche o DMA passa para o outro e o loop principal
+ * recebe EV_VIBRA para fazer a FFT (desbalanco.h) fora da interrupcao.
+ *
+ * O kit nao tem acelerometro: com VIBRA_MODELO a interrupcao do TC0
+ * canal 1 escreve nos mesmos buffers a aceleracao do modelo do tambor
+ * (tambor.h) convertida para contagens do ADC.
+ */
+
+#ifndef VIBRA_H_
+#define VIBRA_H_
+
+#include <asf.h>
+#include "desbalanco.h"
+
+#ifndef VIBRA_MODELO
+#define VIBRA_MODELO         1
+#endif
+
+/* Taxa de amostragem: DESBALANCO_N amostras = 1,28 s */
+#ifndef VIBRA_HZ
+#define VIBRA_HZ             200
+#endif
+
+/* Sensor analogico de 300 mV/g centrado em 1,65 V no ADC de 12 bits */
+#define VIBRA_ZERO           2048
+#define VIBRA_LSB_POR_G      372
+
+/* A FFT roda no loop e tem que caber num periodo do laco do motor */
+#ifndef VIBRA_ORCAMENTO_US
+#define VIBRA_ORCAMENTO_US   1000
+#endif
+
+#define VIBRA_TC             TC0
+#define VIBRA_TC_ID          ID_TC1
+#define VIBRA_TC_CANAL       1
+#define VIBRA_TC_IRQn        TC1_IRQn
+
+#define VIBRA_AFEC           AFEC0
+#define VIBRA_AFEC_ID        ID_AFEC0
+#define VIBRA_AFEC_CANAL     0
+#define VIBRA_AFE_HZ         20000000
+
+struct vibra_janela {
+	float amplitude_g;     // na rotacao do tambor
+	float freq_hz;
+	uint16_t rpm;          // tambor no fim da janela
+	bool estavel;          // referencia igual e nao nula do inicio ao fim
+};
+
+struct vibra_stats {
+	uint32_t janelas;
+	uint32_t perdidas;     // buffer cheio antes do loop ler o anterior
+	uint32_t acima;        // processamentos acima do orcamento
+	uint32_t max_us;
+	uint32_t ultima_us;
+	float pior_g;          // maior amplitude em janela estavel
+};
+
+/** \brief Liga o timer de amostragem (e o AFEC e o DMA sem VIBRA_MODELO) */
+void vibra_init(void);
+
+/**
+ * \brief Processa o buffer que encheu. Chamada no EV_VIBRA.
+ *
+ * \return false se nao havia janela nova
+ */
+bool vibra_processa(struct vibra_janela *j);
+
+void vibra_stats_reset(void);
+void vibra_dump(void);
+
+#endif /* VIBRA_H_ */
@@ -0,0 +1,453 @@
+/*
+ * widgets.c
+ *
+ * Widgets retidos com redesenho por invalidacao (ver widgets.h).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "widgets.h"
+#include "render.h"
+#include "anim.h"
+
+static struct widget pool[WIDGETS_MAX];
+static uint8_t n_widgets;
+static bool tela_inteira = true;
+
+static bool sobrepoe_area(const struct widget *a, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+	return a->x < x + w && x < a->x + a->w &&
+			a->y < y + h && y < a->y + a->h;
+}
+
+static bool sobrepoe(const struct widget *a, const struct widget *b)
+{
+	return sobrepoe_area(a, b->x, b->y, b->w, b->h);
+}
+
+static void apaga_area(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+	if (w == 0 || h == 0) {
+		return;
+	}
+	ili9488_set_foreground_color(COLOR_CONVERT(WIDGET_FUNDO));
+	ili9488_draw_filled_rectangle(x, y, x + w - 1, y + h - 1);
+}
+
+static void apaga(const struct widget *w)
+{
+	apaga_area(w->x, w->y, w->w, w->h);
+}
+
+/* Area antiga menos a atual: ate quatro faixas (em cima, embaixo, esquerda, direita) */
+static void apaga_sobra(const struct widget *w)
+{
+	int32_t ax0 = w->antes.x, ay0 = w->antes.y;
+	int32_t ax1 = ax0 + w->antes.w, ay1 = ay0 + w->antes.h;
+	int32_t bx0 = w->x, by0 = w->y;
+	int32_t bx1 = bx0 + w->w, by1 = by0 + w->h;
+
+	if (bx0 >= ax1 || bx1 <= ax0 || by0 >= ay1 || by1 <= ay0) {
+		apaga_area(ax0, ay0, ax1 - ax0, ay1 - ay0);
+		return;
+	}
+	if (by0 > ay0) apaga_area(ax0, ay0, ax1 - ax0, by0 - ay0);
+	if (by1 < ay1) apaga_area(ax0, by1, ax1 - ax0, ay1 - by1);
+
+	int32_t y0 = by0 > ay0 ? by0 : ay0;
+	int32_t y1 = by1 < ay1 ? by1 : ay1;
+	if (bx0 > ax0) apaga_area(ax0, y0, bx0 - ax0, y1 - y0);
+	if (bx1 < ax1) apaga_area(bx1, y0, ax1 - bx1, y1 - y0);
+}
+
+/* Widgets que pintam o proprio fundo nao precisam ser apagados antes */
+static bool opaco(const struct widget *w)
+{
+	return w->tipo == WIDGET_IMAGEM || w->tipo == WIDGET_BOTAO ||
+			w->tipo == WIDGET_PROGRESSO ||
+			/* Contorno so pinta a borda; basta ele nao mudar de area */
+			(w->tipo == WIDGET_RETANGULO && (w->u.retangulo.cheio || !w->area_mudou));
+}
+
+static void desenha_pixmap(uint16_t x, uint16_t y, const tImage *img)
+{
+	ili9488_draw_pixmap(x, y, img->width, img->height, img->data);
+}
+
+static void desenha_imagem(const struct widget *w)
+{
+	desenha_pixmap(w->x, w->y, w->u.imagem);
+}
+
+static void desenha_botao(const struct widget *w)
+{
+	desenha_pixmap(w->x, w->y, w->u.botao->image);
+}
+
+static void desenha_texto(const struct widget *w)
+{
+	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_BLACK));
+	ili9488_draw_string(w->x, w->y, (const uint8_t *)w->u.texto);
+}
+
+static void desenha_contagem(const struct widget *w)
+{
+	char txt[12];
+
+	sprintf(txt, "%02d", w->u.contagem.valor);
+	font_draw_text(w->u.contagem.fonte, txt, w->x, w->y, 1);
+}
+
+static void desenha_progresso(const struct widget *w)
+{
+	int max = w->u.progresso.max > 0 ? w->u.progresso.max : 1;
+	int valor = w->u.progresso.valor;
+	uint32_t cheio;
+
+	if (valor < 0) valor = 0;
+	if (valor > max) valor = max;
+	cheio = (uint32_t)(w->w - 2) * valor / max;
+
+	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_BLACK));
+	ili9488_draw_rectangle(w->x, w->y, w->x + w->w - 1, w->y + w->h - 1);
+	if (cheio > 0) {
+		ili9488_set_foreground_color(COLOR_CONVERT(w->u.progresso.cor));
+		ili9488_draw_filled_rectangle(w->x + 1, w->y + 1, w->x + cheio, w->y + w->h - 2);
+	}
+	if (cheio < (uint32_t)(w->w - 2)) {
+		ili9488_set_foreground_color(COLOR_CONVERT(WIDGET_FUNDO));
+		ili9488_draw_filled_rectangle(w->x + 1 + cheio, w->y + 1, w->x + w->w - 2, w->y + w->h - 2);
+	}
+}
+
+static void desenha_retangulo(const struct widget *w)
+{
+	if (w->w == 0 || w->h == 0) {
+		return;
+	}
+	ili9488_set_foreground_color(COLOR_CONVERT(w->u.retangulo.cor));
+	if (w->u.retangulo.cheio) {
+		ili9488_draw_filled_rectangle(w->x, w->y, w->x + w->w - 1, w->y + w->h - 1);
+	}
+	else {
+		/* Contorno de 2 px */
+		ili9488_draw_rectangle(w->x, w->y, w->x + w->w - 1, w->y + w->h - 1);
+		ili9488_draw_rectangle(w->x + 1, w->y + 1, w->x + w->w - 2, w->y + w->h - 2);
+	}
+}
+
+static void desenha_tecla(const struct widget *w)
+{
+	uint16_t larg = strlen(w->u.texto) * WIDGET_TEXTO_W;
+
+	ili9488_set_foreground_color(COLOR_CONVERT(COLOR_BLACK));
+	ili9488_draw_rectangle(w->x, w->y, w->x + w->w - 1, w->y + w->h - 1);
+	ili9488_draw_rectangle(w->x + 1, w->y + 1, w->x + w->w - 2, w->y + w->h - 2);
+	ili9488_draw_string(w->x + (w->w - larg) / 2, w->y + (w->h - WIDGET_TEXTO_H) / 2,
+			(const uint8_t *)w->u.texto);
+}
+
+static struct widget *novo(uint8_t tipo, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+		void (*desenha)(const struct widget *w))
+{
+	if (n_widgets >= WIDGETS_MAX) {
+		return NULL;
+	}
+
+	struct widget *wd = &pool[n_widgets++];
+	memset(wd, 0, sizeof(*wd));
+	wd->tipo = tipo;
+	wd->x = x;
+	wd->y = y;
+	wd->w = w;
+	wd->h = h;
+	wd->visivel = true;
+	wd->sujo = true;
+	wd->desenha = desenha;
+	return wd;
+}
+
+void widgets_limpa(void)
+{
+	/* Animacoes apontam para widgets do pool que vao ser reaproveitados */
+	anim_cancela_todas();
+	n_widgets = 0;
+	tela_inteira = true;
+}
+
+struct widget *widget_imagem(uint16_t x, uint16_t y, const tImage *imagem)
+{
+	struct widget *w = novo(WIDGET_IMAGEM, x, y, imagem->width, imagem->height, desenha_imagem);
+
+	if (w != NULL) {
+		w->u.imagem = imagem;
+	}
+	return w;
+}
+
+struct widget *widget_botao(const struct botao *botao)
+{
+	struct widget *w = novo(WIDGET_BOTAO, botao->x, botao->y,
+			botao->image->width, botao->image->height, desenha_botao);
+
+	if (w != NULL) {
+		w->u.botao = botao;
+	}
+	return w;
+}
+
+struct widget *widget_texto(uint16_t x, uint16_t y, const char *texto)
+{
+	struct widget *w = novo(WIDGET_TEXTO, x, y, 0, WIDGET_TEXTO_H, desenha_texto);
+
+	if (w != NULL) {
+		strncpy(w->u.texto, texto, WIDGET_TEXTO_MAX - 1);
+		w->w = strlen(w->u.texto) * WIDGET_TEXTO_W;
+	}
+	return w;
+}
+
+struct widget *widget_contagem(uint16_t x, uint16_t y, const tFont *fonte,
+		uint8_t digitos, int valor)
+{
+	uint16_t larg = 0, alt = 0;
+
+	/* Caixa do maior algarismo, para o apagar cobrir qualquer valor */
+	for (char c = '0'; c <= '9'; c++) {
+		if (c < fonte->start_char || c > fonte->end_char) {
+			continue;
+		}
+		const tImage *img = fonte->chars[c - fonte->start_char].image;
+		if (img->width > larg) larg = img->width;
+		if (img->height > alt) alt = img->height;
+	}
+
+	struct widget *w = novo(WIDGET_CONTAGEM, x, y, digitos * (larg + 1), alt, desenha_contagem);
+	if (w != NULL) {
+		w->u.contagem.fonte = fonte;
+		w->u.contagem.max = 1;
+		while (digitos-- > 0) {
+			w->u.contagem.max *= 10;
+		}
+		w->u.contagem.max--;
+		w->u.contagem.valor = valor < w->u.contagem.max ? valor : w->u.contagem.max;
+	}
+	return w;
+}
+
+struct widget *widget_progresso(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+		uint32_t cor, int max)
+{
+	struct widget *wd = novo(WIDGET_PROGRESSO, x, y, w, h, desenha_progresso);
+
+	if (wd != NULL) {
+		wd->u.progresso.cor = cor;
+		wd->u.progresso.max = max;
+	}
+	return wd;
+}
+
+struct widget *widget_retangulo(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+		uint32_t cor, bool cheio)
+{
+	struct widget *wd = novo(WIDGET_RETANGULO, x, y, w, h, desenha_retangulo);
+
+	if (wd != NULL) {
+		wd->u.retangulo.cor = cor;
+		wd->u.retangulo.cheio = cheio;
+	}
+	return wd;
+}
+
+struct widget *widget_tecla(const struct botao *botao, const char *rotulo)
+{
+	struct widget *w = novo(WIDGET_TECLA, botao->x, botao->y, botao->size_x, botao->size_y,
+			desenha_tecla);
+
+	if (w != NULL) {
+		strncpy(w->u.texto, rotulo, WIDGET_TEXTO_MAX - 1);
+	}
+	return w;
+}
+
+void widget_invalida(struct widget *w)
+{
+	if (w == NULL || w->sujo) {
+		return;
+	}
+	w->sujo = true;
+	render_pede(RENDER_WIDGETS);
+
+	/* Quem esta por cima precisa ser redesenhado depois; quem esta por
+	 * baixo tambem, se a area vai ser apagada */
+	bool vai_apagar = !w->visivel || !opaco(w);
+	for (struct widget *o = pool; o < pool + n_widgets; o++) {
+		if (o != w && (o > w || vai_apagar) && sobrepoe(o, w)) {
+			o->sujo = true;
+		}
+	}
+}
+
+void widget_mostra(struct widget *w, bool visivel)
+{
+	if (w == NULL || w->visivel == visivel) {
+		return;
+	}
+	w->visivel = visivel;
+	w->sujo = false;
+	widget_invalida(w);
+}
+
+void widget_texto_set(struct widget *w, const char *texto)
+{
+	if (w == NULL || (w->tipo != WIDGET_TEXTO && w->tipo != WIDGET_TECLA) ||
+			strncmp(w->u.texto, texto, WIDGET_TEXTO_MAX - 1) == 0) {
+		return;
+	}
+	strncpy(w->u.texto, texto, WIDGET_TEXTO_MAX - 1);
+	/* Caixa nunca encolhe: o apagar do proximo quadro cobre o texto antigo.
+	 * A da tecla e a do botao */
+	uint16_t larg = strlen(w->u.texto) * WIDGET_TEXTO_W;
+	if (w->tipo == WIDGET_TEXTO && larg > w->w) {
+		w->w = larg;
+	}
+	widget_invalida(w);
+}
+
+void widget_valor_set(struct widget *w, int valor)
+{
+	if (w == NULL) {
+		return;
+	}
+	if (w->tipo == WIDGET_CONTAGEM) {
+		if (valor > w->u.contagem.max) {
+			valor = w->u.contagem.max;
+		}
+		if (w->u.contagem.valor != valor) {
+			w->u.contagem.valor = valor;
+			widget_invalida(w);
+		}
+	}
+	else if (w->tipo == WIDGET_PROGRESSO && w->u.progresso.valor != valor) {
+		w->u.progresso.valor = valor;
+		widget_invalida(w);
+	}
+}
+
+void widget_cor_set(struct widget *w, uint32_t cor)
+{
+	if (w == NULL) {
+		return;
+	}
+	if (w->tipo == WIDGET_RETANGULO && w->u.retangulo.cor != cor) {
+		w->u.retangulo.cor = cor;
+		widget_invalida(w);
+	}
+	else if (w->tipo == WIDGET_PROGRESSO && w->u.progresso.cor != cor) {
+		w->u.progresso.cor = cor;
+		widget_invalida(w);
+	}
+}
+
+/* Guarda a area atual (a que esta na tela) antes da primeira mudanca do quadro */
+static void muda_area(struct widget *w, uint16_t x, uint16_t y, uint16_t larg, uint16_t alt)
+{
+	if (!w->area_mudou) {
+		w->antes.x = w->x;
+		w->antes.y = w->y;
+		w->antes.w = w->w;
+		w->antes.h = w->h;
+		w->area_mudou = true;
+	}
+	widget_invalida(w);
+	w->x = x;
+	w->y = y;
+	w->w = larg;
+	w->h = alt;
+	w->sujo = false;
+	widget_invalida(w);
+
+	/* O que estava embaixo da area antiga aparece de novo */
+	for (struct widget *o = pool; o < pool + n_widgets; o++) {
+		if (o != w && sobrepoe_area(o, w->antes.x, w->antes.y, w->antes.w, w->antes.h)) {
+			o->sujo = true;
+		}
+	}
+}
+
+void widget_move(struct widget *w, uint16_t x, uint16_t y)
+{
+	if (w != NULL && (w->x != x || w->y != y)) {
+		muda_area(w, x, y, w->w, w->h);
+	}
+}
+
+void widget_tamanho(struct widget *w, uint16_t larg, uint16_t alt)
+{
+	if (w != NULL && (w->w != larg || w->h != alt)) {
+		muda_area(w, w->x, w->y, larg, alt);
+	}
+}
+
+void widgets_invalida_tudo(void)
+{
+	tela_inteira = true;
+	render_pede(RENDER_WIDGETS);
+}
+
+uint32_t widgets_frame(void)
+{
+	uint32_t n = 0;
+	struct widget *w;
+
+	if (tela_inteira) {
+		ili9488_set_foreground_color(COLOR_CONVERT(WIDGET_FUNDO));
+		ili9488_draw_filled_rectangle(0, 0, ILI9488_LCD_WIDTH-1, ILI9488_LCD_HEIGHT-1);
+		for (w = pool; w < pool + n_widgets; w++) {
+			w->sujo = true;
+			w->apagado = true;
+		}
+		tela_inteira = false;
+	}
+
+	/* Primeiro apaga tudo o que mudou, depois desenha de baixo para cima */
+	for (w = pool; w < pool + n_widgets; w++) {
+		if (!w->sujo || w->apagado) {
+			continue;
+		}
+		if (!w->visivel || !opaco(w)) {
+			if (w->area_mudou) {
+				apaga_area(w->antes.x, w->antes.y, w->antes.w, w->antes.h);
+			}
+			apaga(w);
+		}
+		else if (w->area_mudou) {
+			/* Opaco: so o que a area nova nao cobre, sem piscar */
+			apaga_sobra(w);
+		}
+	}
+	for (w = pool; w < pool + n_widgets; w++) {
+		if (w->sujo && w->visivel) {
+			w->desenha(w);
+			n++;
+		}
+		w->sujo = false;
+		w->apagado = false;
+		w->area_mudou = false;
+	}
+	return n;
+}
+
+void font_draw_text(const tFont *font, const char *text, int x, int y, int spacing) {
+	const char *p = text;
+	while(*p != '\0') {
+		char letter = *p;
+		int letter_offset = letter - font->start_char;
+		if(letter >= font->start_char && letter <= font->end_char) {
+			const tChar *current_char = font->chars + letter_offset;
+			ili9488_draw_pixmap(x, y, current_char->image->width, current_char->image->height, current_char->image->data);
+			x += current_char->image->width + spacing;
+		}
+		p++;
+	}
+}
@@ -0,0 +1,119 @@
+/*
+ * widgets.h
+ *
+ * Camada de widgets retida: cada tela monta uma lista de widgets (imagem,
+ * texto, botao, tecla, contagem, barra de progresso) tirados de um pool
+ * estatico. A ordem de criacao e a ordem z. Mudancas de estado so marcam
+ * o widget afetado como sujo e pedem um quadro (render.h); widgets_frame
+ * redesenha apenas os sujos.
+ */
+
+#ifndef WIDGETS_H_
+#define WIDGETS_H_
+
+#include <asf.h>
+#include "image_types.h"
+#include "buttons.h"
+
+#define WIDGETS_MAX        32
+#define WIDGET_TEXTO_MAX   24
+
+/* Cor de fundo de todas as telas */
+#define WIDGET_FUNDO       COLOR_WHITE
+
+/* Caractere do ili9488_draw_string, com o espaco */
+#define WIDGET_TEXTO_W     (10 + 2)
+#define WIDGET_TEXTO_H     14
+
+enum widget_tipo {
+	WIDGET_IMAGEM = 0,
+	WIDGET_TEXTO,
+	WIDGET_BOTAO,
+	WIDGET_CONTAGEM,
+	WIDGET_PROGRESSO,
+	WIDGET_RETANGULO,
+	WIDGET_TECLA,
+	N_WIDGET_TIPOS
+};
+
+struct widget {
+	uint16_t x;
+	uint16_t y;
+	uint16_t w;
+	uint16_t h;
+	uint8_t tipo;            // enum widget_tipo
+	bool visivel;
+	bool sujo;
+	bool apagado;            // area ja pintada com o fundo neste quadro
+	bool area_mudou;         // moveu ou mudou de tamanho desde o ultimo quadro
+	struct {
+		uint16_t x, y, w, h;
+	} antes;                 // area ocupada no ultimo quadro
+	void (*desenha)(const struct widget *w);
+	union {
+		const tImage *imagem;
+		const struct botao *botao;
+		char texto[WIDGET_TEXTO_MAX];
+		struct {
+			const tFont *fonte;
+			int valor;
+			int max;           // 99 com 2 digitos
+		} contagem;
+		struct {
+			int valor;
+			int max;
+			uint32_t cor;
+		} progresso;
+		struct {
+			uint32_t cor;
+			bool cheio;
+		} retangulo;
+	} u;
+};
+
+/** \brief Descarta os widgets da tela anterior; o proximo quadro repinta tudo */
+void widgets_limpa(void);
+
+struct widget *widget_imagem(uint16_t x, uint16_t y, const tImage *imagem);
+struct widget *widget_botao(const struct botao *botao);
+struct widget *widget_texto(uint16_t x, uint16_t y, const char *texto);
+/**
+ * \brief Numero em fonte grande com espaco para \a digitos algarismos;
+ * valor maior que cabe mostra o maximo (99 com 2 digitos)
+ */
+struct widget *widget_contagem(uint16_t x, uint16_t y, const tFont *fonte,
+		uint8_t digitos, int valor);
+struct widget *widget_progresso(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+		uint32_t cor, int max);
+/** \brief Retangulo cheio ou so o contorno (destaque de botao, sublinhado) */
+struct widget *widget_retangulo(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+		uint32_t cor, bool cheio);
+/** \brief Botao sem icone: contorno na area de toque com o rotulo no meio */
+struct widget *widget_tecla(const struct botao *botao, const char *rotulo);
+
+/* Os setters aceitam NULL (widget que nao existe na tela atual) e so
+ * invalidam quando o valor muda */
+void widget_invalida(struct widget *w);
+void widget_mostra(struct widget *w, bool visivel);
+void widget_texto_set(struct widget *w, const char *texto);
+void widget_valor_set(struct widget *w, int valor);
+/** \brief Cor de retangulo ou barra de progresso */
+void widget_cor_set(struct widget *w, uint32_t cor);
+/* Mover ou redimensionar apaga a area antiga no proximo quadro */
+void widget_move(struct widget *w, uint16_t x, uint16_t y);
+void widget_tamanho(struct widget *w, uint16_t larg, uint16_t alt);
+
+/** \brief Marca a tela inteira para ser repintada */
+void widgets_invalida_tudo(void);
+
+/**
+ * \brief Redesenha os widgets sujos em ordem z.
+ *
+ * \return quantos widgets foram desenhados
+ */
+uint32_t widgets_frame(void);
+
+/** \brief Texto com uma fonte tFont (so os caracteres entre start_char e end_char) */
+void font_draw_text(const tFont *font, const char *text, int x, int y, int spacing);
+
+#endif /* WIDGETS_H_ */
@@ -0,0 +1,24 @@
+/*
+ * botoes_host.c
+ *
+ * Botoes do buttons.h para os testes do host. Na placa sao definidos em
+ * main.c com as imagens; aqui so precisam existir, porque o catalogo
+ * (lavagens.c) e as telas guardam ponteiros para eles.
+ */
+
+#include "buttons.h"
+
+struct botao botaoLavagemDiaria;
+struct botao botaoLavagemPesada;
+struct botao botaoLavagemRapida;
+struct botao botaoLavagemEnxague;
+struct botao botaoLavagemCentrifuga;
+struct botao botaoLavagemUsuario;
+struct botao botaoDireita;
+struct botao botaoEsquerda;
+struct botao botaoLock;
+struct botao botaoUnlock;
+struct botao botaoHome;
+struct botao botaoPlayPause;
+struct botao botaoOk;
+struct botao imageNop;
@@ -0,0 +1,38 @@
+/*
+ * arm_math.h (host)
+ *
+ * O pedaco do CMSIS-DSP que desbalanco.c usa, para o teste do host. A
+ * FFT e uma DFT de referencia em double, com a mesma saida empacotada do
+ * arm_rfft_fast_f32: [X0, X(N/2), Re X1, Im X1, Re X2, ...].
+ */
+
+#ifndef ARM_MATH_H
+#define ARM_MATH_H
+
+#include <stdint.h>
+
+typedef float float32_t;
+
+#define PI  3.14159265358979f
+
+typedef enum {
+	ARM_MATH_SUCCESS = 0,
+	ARM_MATH_ARGUMENT_ERROR = -1,
+} arm_status;
+
+typedef struct {
+	uint16_t fftLenRFFT;
+} arm_rfft_fast_instance_f32;
+
+arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *s, uint16_t fftLen);
+void arm_rfft_fast_f32(const arm_rfft_fast_instance_f32 *s, float32_t *p, float32_t *pOut,
+		uint8_t ifftFlag);
+
+float32_t arm_cos_f32(float32_t x);
+arm_status arm_sqrt_f32(float32_t in, float32_t *pOut);
+void arm_mean_f32(const float32_t *pSrc, uint32_t blockSize, float32_t *pResult);
+void arm_offset_f32(const float32_t *pSrc, float32_t offset, float32_t *pDst, uint32_t blockSize);
+void arm_mult_f32(const float32_t *pSrcA, const float32_t *pSrcB, float32_t *pDst,
+		uint32_t blockSize);
+
+#endif /* ARM_MATH_H */
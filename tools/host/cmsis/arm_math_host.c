@@ -0,0 +1,84 @@
+/*
+ * arm_math_host.c
+ *
+ * CMSIS-DSP de referencia para o host (ver arm_math.h).
+ */
+
+#include <math.h>
+#include "arm_math.h"
+
+arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *s, uint16_t fftLen)
+{
+	/* Mesmos tamanhos que a biblioteca aceita */
+	if (fftLen < 32 || fftLen > 4096 || (fftLen & (fftLen - 1)) != 0) {
+		return ARM_MATH_ARGUMENT_ERROR;
+	}
+	s->fftLenRFFT = fftLen;
+	return ARM_MATH_SUCCESS;
+}
+
+void arm_rfft_fast_f32(const arm_rfft_fast_instance_f32 *s, float32_t *p, float32_t *pOut,
+		uint8_t ifftFlag)
+{
+	int n = s->fftLenRFFT;
+
+	(void)ifftFlag;    // so a direta e usada
+	for (int k = 0; k <= n / 2; k++) {
+		double re = 0.0, im = 0.0;
+		for (int i = 0; i < n; i++) {
+			double w = 2.0 * M_PI * k * i / n;
+			re += p[i] * cos(w);
+			im -= p[i] * sin(w);
+		}
+		if (k == 0) {
+			pOut[0] = (float32_t)re;
+		}
+		else if (k == n / 2) {
+			pOut[1] = (float32_t)re;
+		}
+		else {
+			pOut[2 * k] = (float32_t)re;
+			pOut[2 * k + 1] = (float32_t)im;
+		}
+	}
+}
+
+float32_t arm_cos_f32(float32_t x)
+{
+	return cosf(x);
+}
+
+arm_status arm_sqrt_f32(float32_t in, float32_t *pOut)
+{
+	if (in < 0.0f) {
+		*pOut = 0.0f;
+		return ARM_MATH_ARGUMENT_ERROR;
+	}
+	*pOut = sqrtf(in);
+	return ARM_MATH_SUCCESS;
+}
+
+void arm_mean_f32(const float32_t *pSrc, uint32_t blockSize, float32_t *pResult)
+{
+	double soma = 0.0;
+
+	for (uint32_t i = 0; i < blockSize; i++) {
+		soma += pSrc[i];
+	}
+	*pResult = (float32_t)(soma / blockSize);
+}
+
+void arm_offset_f32(const float32_t *pSrc, float32_t offset, float32_t *pDst, uint32_t blockSize)
+{
+	for (uint32_t i = 0; i < blockSize; i++) {
+		pDst[i] = pSrc[i] + offset;
+	}
+}
+
+void arm_mult_f32(const float32_t *pSrcA, const float32_t *pSrcB, float32_t *pDst,
+		uint32_t blockSize)
+{
+	for (uint32_t i = 0; i < blockSize; i++) {
+		pDst[i] = pSrcA[i] * pSrcB[i];
+	}
+}
@@ -0,0 +1,377 @@
+/*
+ * loopback.c
+ *
+ * Placa de mentira para o tools/remote.py: le os comandos do remote.h na
+ * entrada padrao e responde na saida padrao, com o mesmo quadro.
+ *
+ * As telas, os botoes e os programas sao os da placa (telas.c,
+ * telas_fluxo.c, telas_defs.c, programas.c, ciclo.c, estima.c, agenda.c,
+ * kv.c com a flash simulada); daqui sao so os callbacks (os mesmos do
+ * main.c, sem desenho) e o relogio: cada comando recebido vale um segundo
+ * da placa, um minuto do programa com CICLO_ESCALA. As fases por sensor
+ * terminam no tempo nominal.
+ *
+ * O filtro de toque e as metricas de latencia dependem do ASF: TOUCH,
+ * PERF e SHOT respondem REMOTE_UNSUPPORTED. Os tempos medidos atraves do
+ * loopback sao do PC, nao da placa. O alarme do agendamento nao dispara.
+ *
+ *   remote.py loopback state
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "telas_defs.h"
+#include "agenda.h"
+#include "ciclo.h"
+#include "estima.h"
+#include "kv.h"
+#include "kv_flash_host.h"
+
+/* remote.h e telemetry.h incluem o ASF: so os numeros do protocolo */
+#define SYNC0              0xA5
+#define SYNC1              0x5A
+#define TELEM_ACK          0x03
+#define TELEM_STATE        0x04
+
+enum remote_cmd {
+	REMOTE_TOUCH  = 0x80,
+	REMOTE_TAP    = 0x81,
+	REMOTE_STATE  = 0x82,
+	REMOTE_PERF   = 0x83,
+	REMOTE_REDRAW = 0x84,
+	REMOTE_SHOT   = 0x85,
+	REMOTE_CLOCK  = 0x86,
+};
+
+enum remote_status {
+	REMOTE_OK = 0,
+	REMOTE_MISS,
+	REMOTE_BAD_ARGS,
+	REMOTE_UNKNOWN,
+	REMOTE_UNSUPPORTED,
+	REMOTE_BUSY,
+};
+
+/* Relogio da placa por comando recebido */
+#define LOOPBACK_PASSO_MS  1000
+
+static bool unlocked_flag = true;
+static bool door_open;
+static int32_t time_left;
+static const struct botao *botao_tocado;
+
+static struct ciclo_exec lavagem;
+static bool lavando;
+static struct estima_modelo modelo_tempo;
+static struct estima estimativa;
+
+/* RTC: comeca meio-dia de 1/1/2024, acertado por REMOTE_CLOCK */
+static uint32_t relogio_s = 12 * 3600;
+static struct agenda_data hoje = {2024, 1, 1};
+static struct agenda agenda;
+static struct agenda_plano plano;
+
+/* Callbacks dos botoes, como os do main.c */
+static void ui_evento(enum tela_evento ev){
+	if(unlocked_flag){
+		telas_evento(ev);
+	}
+}
+
+void home_callback(void){ ui_evento(TELA_EV_HOME); }
+void ok_callback(void){ ui_evento(TELA_EV_OK); }
+void play_pause_callback(void){ ui_evento(TELA_EV_INICIA); }
+void lavagem_callback(void){ ui_evento(TELA_EV_ESCOLHE); }
+void edit_callback(void){ ui_evento(TELA_EV_EDITA); }
+void schedule_callback(void){ ui_evento(TELA_EV_AGENDA); }
+void slice_right_callback(void){ ui_evento(TELA_EV_PROXIMO); }
+void slice_left_callback(void){ ui_evento(TELA_EV_ANTERIOR); }
+
+void mode_callback(void){
+	if(unlocked_flag){
+		agenda_troca_modo(&agenda);
+	}
+}
+
+void time_callback(void){
+	for(int i = 0; i < 4 && unlocked_flag; i++){
+		if(botao_tocado == &botoesHorario[i]){
+			agenda_ajusta(&agenda, passos_horario[i]);
+		}
+	}
+}
+
+void field_callback(void){
+	for(int c = 0; c < N_CAMPOS && unlocked_flag; c++){
+		for(int s = 0; s < 2; s++){
+			if(botao_tocado == &botoesCampo[c][s]){
+				programas_ajusta(c, s ? 1 : -1);
+			}
+		}
+	}
+}
+
+void unlock_callback(void){
+	unlocked_flag = false;
+}
+
+/* Na placa o motor tambem precisa estar parado; aqui ele para com o ciclo */
+void lock_callback(void){
+	if(time_left <= 0){
+		unlocked_flag = true;
+	}
+}
+
+/* Sem LCD: so o que os desenhos fazem alem de desenhar */
+void draw_cycle_page(const t_ciclo *ciclo){}
+void draw_laundry_menu(const t_ciclo *ciclo){}
+void draw_working(const t_ciclo *ciclo){}
+void draw_done_laundry(const t_ciclo *ciclo){}
+void draw_door_open(const t_ciclo *ciclo){}
+void draw_locked_door(const t_ciclo *ciclo){}
+void draw_editor(const t_ciclo *ciclo){}
+void draw_scheduled(const t_ciclo *ciclo){}
+
+void draw_schedule(const t_ciclo *ciclo){
+	agenda_sugere(&agenda, relogio_s);
+}
+
+/* Acoes das telas, como as do main.c */
+static bool start_cycle(const t_ciclo *ciclo){
+	if(door_open){
+		return false;
+	}
+	ciclo_inicia(&lavagem, ciclo, CICLO_ESCALA);
+	estima_inicia(&estimativa, &modelo_tempo, &lavagem);
+	time_left = (estimativa.mostrado_s + 59) / 60;
+	lavando = true;
+	return true;
+}
+
+static void pause_cycle(void){
+	ciclo_pausa(&lavagem, !lavagem.pausado);
+}
+
+static bool save_program(void){
+	int i = programas_salva();
+	uint8_t n;
+	const t_ciclo *const *lista = programas_lista(&n);
+
+	if(i < 0){
+		return false;
+	}
+	programas_grava();
+	telas_set_ciclos(lista, n, i);
+	return true;
+}
+
+static bool arm_schedule(const t_ciclo *ciclo){
+	return agenda_planeja(&agenda, relogio_s, &hoje,
+			estima_relogio_s(&modelo_tempo, ciclo, CICLO_ESCALA), &plano);
+}
+
+static const struct tela_ops ops_telas = {
+	.inicia = start_cycle,
+	.pausa  = pause_cycle,
+	.edita  = programas_edita,
+	.salva  = save_program,
+	.arma   = arm_schedule,
+};
+
+/* cycle_tick do main.c para um passo do relogio */
+static void avanca(void){
+	uint32_t ms = 0;
+
+	relogio_s = (relogio_s + LOOPBACK_PASSO_MS / 1000) % AGENDA_DIA_S;
+	if(!lavando || lavagem.pausado){
+		return;
+	}
+	while(ms < LOOPBACK_PASSO_MS && !ciclo_terminou(&lavagem)){
+		const struct fase *f = ciclo_fase(&lavagem);
+
+		if(f->externo && lavagem.fase_s >= f->dur_s){
+			ciclo_conclui_fase(&lavagem, f->dur_s);
+			continue;
+		}
+		ciclo_avanca_ms(&lavagem, CICLO_TICK_MS);
+		ms += CICLO_TICK_MS;
+	}
+
+	if(ciclo_terminou(&lavagem)){
+		estima_fim(&estimativa, &lavagem);
+		lavando = false;
+		time_left = 0;
+		telas_evento(TELA_EV_FIM);
+		return;
+	}
+	time_left = (estima_atualiza(&estimativa, &lavagem) + 59) / 60;
+	if(time_left < 1){
+		time_left = 1;
+	}
+}
+
+static uint8_t crc8(const uint8_t *p, uint32_t n){
+	uint8_t crc = 0;
+
+	while(n--){
+		crc ^= *p++;
+		for(int i = 0; i < 8; i++){
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static void envia(uint8_t tipo, const uint8_t *payload, uint8_t n){
+	uint8_t q[4 + 255 + 1];
+
+	q[0] = SYNC0;
+	q[1] = SYNC1;
+	q[2] = tipo;
+	q[3] = n;
+	memcpy(&q[4], payload, n);
+	q[4 + n] = crc8(&q[2], n + 2);
+	if(write(STDOUT_FILENO, q, n + 5) != n + 5){
+		perror("loopback");
+	}
+}
+
+static void ack(uint8_t cmd, uint8_t seq, enum remote_status status){
+	uint8_t p[3] = {seq, cmd, status};
+
+	envia(TELEM_ACK, p, sizeof(p));
+}
+
+static void put32(uint8_t **p, uint32_t v){
+	for(int i = 0; i < 4; i++){
+		*(*p)++ = v & 0xFF;
+		v >>= 8;
+	}
+}
+
+static uint16_t get16(const uint8_t *p){
+	return p[0] | (p[1] << 8);
+}
+
+/* dispatch_tap do main.c, sem as marcas de latencia */
+static bool dispatch_tap(uint32_t x, uint32_t y){
+	uint8_t n;
+	struct botao *const *botoes = telas_botoes(&n);
+	struct botao *b = processa_touch(botoes, n, x, y);
+
+	if(b == NULL){
+		return false;
+	}
+	botao_tocado = b;
+	b->p_handler();
+	return true;
+}
+
+/* remote_command do main.c */
+static void comando(uint8_t cmd, uint8_t seq, const uint8_t *args, uint8_t len){
+	uint8_t payload[16];
+	uint8_t *p = payload;
+
+	avanca();
+	switch(cmd){
+		case REMOTE_TAP:
+			if(len < 4) break;
+			ack(cmd, seq, dispatch_tap(get16(&args[0]), get16(&args[2])) ? REMOTE_OK : REMOTE_MISS);
+			return;
+
+		case REMOTE_STATE: {
+			uint8_t n_botoes;
+			telas_botoes(&n_botoes);
+			*p++ = seq;
+			*p++ = tela_atual;
+			*p++ = telas_ciclo_indice();
+			put32(&p, time_left);
+			*p++ = unlocked_flag;
+			*p++ = door_open;
+			*p++ = n_botoes;
+			envia(TELEM_STATE, payload, p - payload);
+			return;
+		}
+
+		case REMOTE_REDRAW:
+			if(tela_atual == TELA_PORTA_TRANCADA){
+				ack(cmd, seq, REMOTE_UNSUPPORTED);
+				return;
+			}
+			telas_redesenha();
+			ack(cmd, seq, REMOTE_OK);
+			return;
+
+		case REMOTE_CLOCK:
+			if(len < 8 || args[2] < 1 || args[2] > 12 || args[3] < 1 || args[3] > 31 ||
+					args[5] > 23 || args[6] > 59 || args[7] > 59) break;
+			hoje.ano = get16(&args[0]);
+			hoje.mes = args[2];
+			hoje.dia = args[3];
+			relogio_s = args[5] * 3600 + args[6] * 60 + args[7];
+			ack(cmd, seq, REMOTE_OK);
+			return;
+
+		case REMOTE_TOUCH:
+		case REMOTE_PERF:
+		case REMOTE_SHOT:
+			ack(cmd, seq, REMOTE_UNSUPPORTED);
+			return;
+
+		default:
+			ack(cmd, seq, REMOTE_UNKNOWN);
+			return;
+	}
+	ack(cmd, seq, REMOTE_BAD_ARGS);
+}
+
+/* Quadro do remote.h; bytes fora de um quadro (console) sao ignorados */
+static void recebe(uint8_t c){
+	static uint8_t q[2 + 255 + 1];
+	static uint32_t n;
+
+	if(n == 0 && c != SYNC0) return;
+	if(n == 1 && c != SYNC1){
+		n = (c == SYNC0);
+		return;
+	}
+	if(n >= 2){
+		q[n - 2] = c;
+	}
+	n++;
+	if(n < 4 || n < 5u + q[1]){
+		return;
+	}
+	n = 0;
+	if(crc8(q, q[1] + 2) != q[2 + q[1]] || q[1] < 1){
+		fprintf(stderr, "loopback: quadro invalido\n");
+		return;
+	}
+	comando(q[0], q[2], &q[3], q[1] - 1);
+	/* Na placa o desenho pendente sai no loop principal */
+	telas_desenha();
+}
+
+int main(void){
+	uint8_t buf[256];
+	ssize_t n;
+	uint8_t n_ciclos;
+	const t_ciclo *const *lista;
+
+	kv_flash_host_formata();
+	kv_init();
+	estima_modelo_init(&modelo_tempo);
+	programas_carrega(&modelo_tempo);
+	lista = programas_lista(&n_ciclos);
+	botoes_init();
+	telas_init(telas_defs, telas_fluxo, lista, n_ciclos, &ops_telas);
+	telas_vai(TELA_CARROSSEL);
+
+	while((n = read(STDIN_FILENO, buf, sizeof(buf))) > 0){
+		for(ssize_t i = 0; i < n; i++){
+			recebe(buf[i]);
+		}
+	}
+	return 0;
+}
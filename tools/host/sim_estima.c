@@ -0,0 +1,145 @@
+/*
+ * sim_estima.c
+ *
+ * Simulacao da estimativa de tempo (estima.c) no host, com o mesmo laco
+ * do cycle_tick do main.c: ciclo_avanca_ms em passos de CICLO_TICK_MS,
+ * encher e drenar terminados pelo modelo da agua (agua.c) e as rampas
+ * pela rampa em S (rampa.c) e pelo tambor (tambor.c) a MOTOR_HZ, como no
+ * motor.c. A distribuicao nao repete: a vibracao nao e simulada.
+ *
+ *   sim_estima [execucoes] [semente]
+ *
+ * Roda os programas do catalogo em rodizio, cada um com pressao da rede e
+ * filtro sorteados, e imprime o estima_dump no fim. Sai com erro se a
+ * estimativa errar mais, em media, que a contagem fixa.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "agua.h"
+#include "ciclo.h"
+#include "estima.h"
+#include "rampa.h"
+#include "tambor.h"
+
+/* Como motor.h, que depende do ASF */
+#define MOTOR_HZ               1000
+#define MOTOR_CARGA_KG         5
+#define MOTOR_CARGA_PESADA_KG  8
+
+static const struct rampa_limites limites_normal = {
+	CICLO_ACEL_RPM_S, CICLO_FREIO_RPM_S, CICLO_JERK_RPM_S2,
+};
+static const struct rampa_limites limites_pesado = {
+	CICLO_ACEL_PESADO_RPM_S, CICLO_FREIO_RPM_S, CICLO_JERK_RPM_S2,
+};
+
+static struct rampa rampa;
+static struct tambor tambor;
+static uint32_t sorteio;
+
+/* motor_alvo do motor.c */
+static void motor_alvo(uint16_t rpm, bool pesado)
+{
+	if (RAMPA_Q16(rpm) != rampa.alvo) {
+		if (rampa_parada(&rampa) && rampa.v == 0) {
+			tambor_init(&tambor, pesado ? MOTOR_CARGA_PESADA_KG : MOTOR_CARGA_KG, ++sorteio);
+		}
+		rampa_alvo(&rampa, rpm, pesado ? &limites_pesado : &limites_normal);
+	}
+}
+
+/* Interrupcoes do TC0 durante \p ms */
+static void motor_anda(uint32_t ms)
+{
+	for (uint32_t i = 0; i < ms * MOTOR_HZ / 1000; i++) {
+		rampa_passo(&rampa);
+		tambor_passo(&tambor, (float)rampa.v / 65536.0f, 1.0f / MOTOR_HZ);
+	}
+}
+
+static uint16_t motor_rpm(void)
+{
+	return tambor.rpm > 0.0f ? (uint16_t)(tambor.rpm + 0.5f) : 0;
+}
+
+/* check_phase_sensor do main.c */
+static void sensores(struct ciclo_exec *e, struct agua *a, uint8_t *vista, uint32_t *fim_agua_s)
+{
+	const struct fase *f = ciclo_fase(e);
+
+	if (f == NULL) {
+		return;
+	}
+	if (e->atual != *vista) {
+		*vista = e->atual;
+		*fim_agua_s = f->tipo == FASE_ENCHE ? agua_enche_s(a)
+				: f->tipo == FASE_DRENA ? agua_drena_s(a) : 0;
+	}
+	switch (f->tipo) {
+		case FASE_ENCHE:
+		case FASE_DRENA:
+			if (e->fase_s >= *fim_agua_s) {
+				ciclo_conclui_fase(e, *fim_agua_s);
+			}
+			break;
+		case FASE_SOBE:
+			if (rampa_rpm(&rampa) == f->rpm) {
+				ciclo_conclui_fase(e, e->fase_s);
+			}
+			break;
+		case FASE_DESCE:
+			if (rampa_parada(&rampa) && motor_rpm() == 0) {
+				ciclo_conclui_fase(e, e->fase_s);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+static void roda(struct estima_modelo *m, const t_ciclo *c, uint32_t semente)
+{
+	struct ciclo_exec e;
+	struct estima s;
+	struct agua a;
+	uint8_t vista = CICLO_MAX_FASES;
+	uint32_t fim_agua_s = 0;
+
+	agua_init(&a, c->heavy ? MOTOR_CARGA_PESADA_KG : MOTOR_CARGA_KG, semente);
+	ciclo_inicia(&e, c, CICLO_ESCALA);
+	estima_inicia(&s, m, &e);
+
+	while (!ciclo_terminou(&e)) {
+		ciclo_avanca_ms(&e, CICLO_TICK_MS);
+		sensores(&e, &a, &vista, &fim_agua_s);
+		motor_alvo(ciclo_rpm(&e), c->heavy);
+		motor_anda(CICLO_TICK_MS);
+		if (!ciclo_terminou(&e)) {
+			estima_atualiza(&s, &e);
+		}
+	}
+	estima_fim(&s, &e);
+}
+
+int main(int argc, char **argv)
+{
+	static struct estima_modelo m;
+	int execucoes = argc > 1 ? atoi(argv[1]) : 40;
+	uint32_t semente = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 1;
+
+	estima_modelo_init(&m);
+	rampa_init(&rampa, MOTOR_HZ);
+	tambor_init(&tambor, MOTOR_CARGA_KG, semente);
+	sorteio = semente;
+
+	for (int i = 0; i < execucoes; i++) {
+		roda(&m, &lavagens[i % n_lavagens], semente * 7919u + (uint32_t)i);
+	}
+
+	printf("%d execucoes, semente %lu\n", execucoes, (unsigned long)semente);
+	estima_dump(&m);
+	printf("\n");
+
+	return m.stats.soma_erro_s < m.stats.soma_erro_fixo_s ? 0 : 1;
+}
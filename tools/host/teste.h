@@ -0,0 +1,31 @@
+/*
+ * teste.h
+ *
+ * Conferencia minima dos testes do host: CONFERE imprime a linha que
+ * falhou e conta a falha; main devolve teste_fim().
+ */
+
+#ifndef TESTE_H_
+#define TESTE_H_
+
+#include <stdio.h>
+
+static int teste_falhas;
+
+#define CONFERE(cond, ...)                                                 \
+	do {                                                                   \
+		if (!(cond)) {                                                     \
+			teste_falhas++;                                                \
+			printf("%s:%d: falhou: %s: ", __FILE__, __LINE__, #cond);      \
+			printf(__VA_ARGS__);                                           \
+			printf("\n");                                                  \
+		}                                                                  \
+	} while (0)
+
+static inline int teste_fim(const char *nome)
+{
+	printf("%s: %s\n", nome, teste_falhas ? "FALHOU" : "ok");
+	return teste_falhas ? 1 : 0;
+}
+
+#endif /* TESTE_H_ */
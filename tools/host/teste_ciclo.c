@@ -0,0 +1,125 @@
+/*
+ * teste_ciclo.c
+ *
+ * Roda cada programa do catalogo (lavagens.c), e alguns casos de borda,
+ * com o relogio acelerado: ciclo_avanca_ms em passos de CICLO_TICK_MS,
+ * como a tarefa do main.c. As fases por sensor terminam com
+ * ciclo_conclui_fase no tempo nominal, antes ou depois dele.
+ *
+ * Confere a ordem das fases, que feito_s chega em total_s e que, com o
+ * sensor no nominal, o total e o ciclo_total_s do programa.
+ */
+
+#include <string.h>
+#include "ciclo.h"
+#include "teste.h"
+
+#define ESCALA  1000
+
+/* Fases que o programa deveria ter, na ordem */
+static uint8_t esperadas(const t_ciclo *c, uint8_t *tipo, uint8_t *rodada)
+{
+	uint8_t n = 0;
+
+#define ESPERA(t, r) do { tipo[n] = (t); rodada[n] = (r); n++; } while (0)
+	/* Sem tempo de enxague e so centrifugacao: nao enche */
+	if (c->enxagueTempo > 0) {
+		ESPERA(FASE_ENCHE, 0);
+		ESPERA(FASE_LAVA, 0);
+		ESPERA(FASE_DRENA, 0);
+		for (int i = 1; i <= c->enxagueQnt && i <= CICLO_MAX_ENXAGUES; i++) {
+			ESPERA(FASE_ENCHE, i);
+			ESPERA(FASE_ENXAGUE, i);
+			ESPERA(FASE_DRENA, i);
+		}
+	}
+	if (c->centrifugacaoRPM > 0 && c->centrifugacaoTempo > 0) {
+		ESPERA(FASE_DISTRIBUI, 0);
+		ESPERA(FASE_SOBE, 0);
+		ESPERA(FASE_CENTRIFUGA, 0);
+		ESPERA(FASE_DESCE, 0);
+	}
+#undef ESPERA
+	return n;
+}
+
+/*
+ * Anda o programa ate o fim. \p desvio_s: segundos que o sensor leva a
+ * mais (ou a menos) que a nominal em cada fase por sensor.
+ */
+static void roda(const t_ciclo *c, int desvio_s)
+{
+	struct ciclo_exec e;
+	uint8_t tipo[CICLO_MAX_FASES], rodada[CICLO_MAX_FASES];
+	uint8_t n = esperadas(c, tipo, rodada);
+	uint8_t vistas = 0;
+	uint32_t nominal = ciclo_total_s(c);
+	int32_t ajuste = 0;
+	uint32_t passos = 0;
+
+	ciclo_inicia(&e, c, ESCALA);
+	CONFERE(e.n_fases == n, "%s: %u fases, esperadas %u", c->nome, e.n_fases, n);
+	CONFERE(e.total_s == nominal, "%s: total %u, nominal %u", c->nome, e.total_s, nominal);
+
+	while (!ciclo_terminou(&e) && passos++ < 10000000) {
+		const struct fase *f = ciclo_fase(&e);
+
+		if (vistas == e.atual) {
+			CONFERE(vistas < n && f->tipo == tipo[vistas] && f->rodada == rodada[vistas],
+					"%s: fase %u e %s/%u", c->nome, vistas,
+					ciclo_fase_nome(f->tipo), f->rodada);
+			vistas++;
+		}
+
+		if (f->externo) {
+			int32_t alvo = (int32_t)f->dur_s + desvio_s;
+			if (alvo < 1) {
+				alvo = 1;
+			}
+			if ((int32_t)e.fase_s >= alvo) {
+				ajuste += alvo - (int32_t)f->dur_s;
+				ciclo_conclui_fase(&e, (uint32_t)alvo);
+				continue;
+			}
+		}
+		ciclo_avanca_ms(&e, CICLO_TICK_MS);
+		CONFERE(e.feito_s <= e.total_s, "%s: feito %u > total %u", c->nome, e.feito_s, e.total_s);
+	}
+
+	CONFERE(ciclo_terminou(&e), "%s: nao terminou", c->nome);
+	CONFERE(vistas == n, "%s: %u de %u fases", c->nome, vistas, n);
+	CONFERE(e.feito_s == e.total_s, "%s: feito %u, total %u", c->nome, e.feito_s, e.total_s);
+	CONFERE((int32_t)e.total_s == (int32_t)nominal + ajuste,
+			"%s: total %u, nominal %u + sensor %d", c->nome, e.total_s, nominal, ajuste);
+	CONFERE(ciclo_restante_s(&e) == 0 && ciclo_progresso(&e) == 1000,
+			"%s: restante %u, progresso %u", c->nome,
+			ciclo_restante_s(&e), ciclo_progresso(&e));
+	printf("  %-8s sensor %+3d s: %2u fases, %5u s, %u passos de %u ms\n",
+			c->nome, desvio_s, n, e.total_s, passos, CICLO_TICK_MS);
+}
+
+/* Bordas: sem enxague, sem centrifugacao, enxagues no maximo */
+static const t_ciclo bordas[] = {
+	{ .nome = "SECO",   .enxagueTempo = 5,  .enxagueQnt = 0,
+	  .centrifugacaoRPM = 600,  .centrifugacaoTempo = 2 },
+	{ .nome = "MOLHADO", .enxagueTempo = 3, .enxagueQnt = 1 },
+	{ .nome = "MAXIMO", .enxagueTempo = 20, .enxagueQnt = CICLO_MAX_ENXAGUES,
+	  .centrifugacaoRPM = LAVAGEM_RPM_MAX, .centrifugacaoTempo = 15, .heavy = true },
+};
+
+int main(void)
+{
+	static const int desvios[] = { 0, -30, 45 };
+
+	for (unsigned d = 0; d < sizeof(desvios) / sizeof(desvios[0]); d++) {
+		for (uint8_t i = 0; i < n_lavagens; i++) {
+			CONFERE(lavagens[i].total_s == ciclo_total_s(&lavagens[i]),
+					"%s: total_s do catalogo %u", lavagens[i].nome, lavagens[i].total_s);
+			roda(&lavagens[i], desvios[d]);
+		}
+		for (unsigned i = 0; i < sizeof(bordas) / sizeof(bordas[0]); i++) {
+			roda(&bordas[i], desvios[d]);
+		}
+	}
+	return teste_fim("ciclo");
+}
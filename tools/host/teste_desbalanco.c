@@ -0,0 +1,154 @@
+/*
+ * teste_desbalanco.c
+ *
+ * Janela de Hann + FFT + detector (desbalanco.c) com o CMSIS-DSP trocado
+ * por uma DFT de referencia (cmsis/). Confere:
+ *
+ * - senoides de amplitude conhecida, com gravidade, ruido e uma vibracao
+ *   de outra frequencia: amplitude medida e decisao contra
+ *   DESBALANCO_LIMIAR_G na rotacao da distribuicao (1,5 Hz);
+ * - que o bin de 1,5 Hz nao enxerga vibracao longe da rotacao;
+ * - o modelo do tambor (tambor.c) girando a CICLO_DISTRIBUI_RPM.
+ */
+
+#include <math.h>
+#include "ciclo.h"
+#include "desbalanco.h"
+#include "tambor.h"
+#include "teste.h"
+
+/* Como vibra.h, que depende do ASF */
+#define VIBRA_HZ      200.0f
+
+#define ROTACAO_HZ    (CICLO_DISTRIBUI_RPM / 60.0f)
+
+static uint32_t semente = 1;
+
+/* Normal(0, 1) por Box-Muller, repetivel */
+static float normal(void)
+{
+	float u1, u2;
+
+	semente = semente * 1664525u + 1013904223u;
+	u1 = ((semente >> 8) + 1.0f) / 16777217.0f;
+	semente = semente * 1664525u + 1013904223u;
+	u2 = (semente >> 8) / 16777216.0f;
+	return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2);
+}
+
+/* 1 g de gravidade + senoide + interferencia + ruido branco */
+static void gera(float *x, float amp_g, float freq_hz, float fase,
+		float outra_g, float outra_hz, float ruido_g)
+{
+	for (int i = 0; i < DESBALANCO_N; i++) {
+		float t = i / VIBRA_HZ;
+		x[i] = 1.0f + amp_g * sinf(2.0f * (float)M_PI * freq_hz * t + fase)
+				+ outra_g * sinf(2.0f * (float)M_PI * outra_hz * t)
+				+ ruido_g * normal();
+	}
+}
+
+static void senoide(float amp_g, float freq_hz, float ruido_g)
+{
+	float x[DESBALANCO_N];
+	float pior = 0.0f;
+	bool decidiu_errado = false;
+
+	/* Varias fases: a rotacao cai entre bins e o resultado nao pode
+	 * depender de onde a janela comeca */
+	for (int f = 0; f < 8; f++) {
+		gera(x, amp_g, freq_hz, f * (float)M_PI / 4, 0.05f, 12.0f, ruido_g);
+		float medido = desbalanco_amplitude_g(x, VIBRA_HZ, ROTACAO_HZ);
+		float erro = fabsf(medido - amp_g);
+
+		pior = fmaxf(pior, erro);
+		if ((medido > DESBALANCO_LIMIAR_G) != (amp_g > DESBALANCO_LIMIAR_G)) {
+			decidiu_errado = true;
+		}
+	}
+	printf("  %.3f g a %.2f Hz, ruido %.3f g: pior erro %.4f g\n",
+			amp_g, freq_hz, ruido_g, pior);
+
+	/* Erro: 10% da amplitude mais o ruido que cai nos tres bins */
+	CONFERE(pior <= 0.1f * amp_g + 2.0f * ruido_g / sqrtf(DESBALANCO_N / 8),
+			"%.3f g a %.2f Hz: erro %.4f g", amp_g, freq_hz, pior);
+	/* Longe do limiar a decisao nao pode errar */
+	if (fabsf(amp_g - DESBALANCO_LIMIAR_G) >= 0.25f * DESBALANCO_LIMIAR_G) {
+		CONFERE(!decidiu_errado, "%.3f g a %.2f Hz: decisao errada", amp_g, freq_hz);
+	}
+}
+
+/* Vibracao forte fora da rotacao nao aparece no bin de 1,5 Hz */
+static void fora_do_bin(float freq_hz)
+{
+	float x[DESBALANCO_N];
+
+	gera(x, 0.2f, freq_hz, 0.3f, 0.0f, 0.0f, 0.0f);
+	float medido = desbalanco_amplitude_g(x, VIBRA_HZ, ROTACAO_HZ);
+	printf("  0.200 g a %.2f Hz: %.4f g no bin da rotacao\n", freq_hz, medido);
+	CONFERE(medido < DESBALANCO_LIMIAR_G / 4, "%.2f Hz vazou %.4f g", freq_hz, medido);
+}
+
+/* Modelo do tambor girando na distribuicao, amostrado como o TC1 faz */
+static void tambor(uint32_t seed, float carga_kg)
+{
+	struct tambor t;
+	float x[DESBALANCO_N];
+
+	tambor_init(&t, carga_kg, seed);
+	/* Sobe devagar e assenta: a roupa gruda acima de TAMBOR_RPM_GRUDA */
+	for (int i = 0; i < 20 * 1000; i++) {
+		float ref = fminf(CICLO_DISTRIBUI_RPM, i * CICLO_DISTRIBUI_RPM / 5000.0f);
+		tambor_passo(&t, ref, 0.001f);
+	}
+	for (int i = 0; i < DESBALANCO_N; i++) {
+		for (int j = 0; j < 5; j++) {
+			tambor_passo(&t, CICLO_DISTRIBUI_RPM, 0.001f);
+		}
+		x[i] = tambor_vibracao_g(&t);
+	}
+
+	float w = CICLO_DISTRIBUI_RPM * 2.0f * (float)M_PI / 60.0f;
+	float esperado = t.desbalanco_kg * TAMBOR_RAIO_M * w * w /
+			((TAMBOR_MASSA_KG + carga_kg) * 9.81f);
+	float medido = desbalanco_amplitude_g(x, VIBRA_HZ, ROTACAO_HZ);
+
+	printf("  tambor %.0f kg, %.2f kg fora do centro: esperado %.4f g, medido %.4f g, %s\n",
+			carga_kg, t.desbalanco_kg, esperado, medido,
+			medido > DESBALANCO_LIMIAR_G ? "desbalanceado" : "ok");
+	CONFERE(fabsf(medido - esperado) <= 0.1f * esperado + 0.002f,
+			"tambor: esperado %.4f g, medido %.4f g", esperado, medido);
+	if (fabsf(esperado - DESBALANCO_LIMIAR_G) >= 0.25f * DESBALANCO_LIMIAR_G) {
+		CONFERE((medido > DESBALANCO_LIMIAR_G) == (esperado > DESBALANCO_LIMIAR_G),
+				"tambor: decisao errada com %.4f g", esperado);
+	}
+}
+
+int main(void)
+{
+	static const float amps[] = { 0.005f, 0.01f, 0.015f, 0.025f, 0.04f, 0.08f };
+
+	CONFERE(desbalanco_init(), "desbalanco_init falhou");
+
+	/* A rotacao da distribuicao cai no bin 2 (1,5 Hz * 256 / 200 Hz = 1,92) */
+	CONFERE((int)(ROTACAO_HZ * DESBALANCO_N / VIBRA_HZ + 0.5f) == 2, "bin da rotacao");
+
+	for (unsigned i = 0; i < sizeof(amps) / sizeof(amps[0]); i++) {
+		senoide(amps[i], ROTACAO_HZ, 0.0f);
+		senoide(amps[i], ROTACAO_HZ, 0.01f);
+		/* Rotacao um pouco fora do nominal (escorregamento do motor) */
+		senoide(amps[i], ROTACAO_HZ * 0.95f, 0.01f);
+		senoide(amps[i], ROTACAO_HZ * 1.05f, 0.01f);
+	}
+
+	fora_do_bin(6.0f);
+	fora_do_bin(12.0f);
+	fora_do_bin(25.0f);
+
+	/* Sementes com desbalanceamento dos dois lados do limiar */
+	static const uint32_t sementes[] = { 1, 7, 42, 1234, 31337, 99991, 424242, 2718281 };
+	for (unsigned i = 0; i < sizeof(sementes) / sizeof(sementes[0]); i++) {
+		tambor(sementes[i], 4.0f + i % 5);
+	}
+	return teste_fim("desbalanco");
+}
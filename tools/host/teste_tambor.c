@@ -0,0 +1,122 @@
+/*
+ * teste_tambor.c
+ *
+ * Rampa em S (rampa.c) seguida pelo modelo do tambor (tambor.c), no
+ * mesmo passo de 1 / MOTOR_HZ da interrupcao do motor.c. Para cada rampa
+ * e carga confere:
+ *
+ * - a duracao da referencia contra rampa_duracao_ms e o tempo que a
+ *   linha do tempo do ciclo reserva para ela (CICLO_RAMPA_S);
+ * - aceleracao e jerk da referencia dentro dos limites;
+ * - sobressinal do tambor e rpm assentado depois da rampa.
+ */
+
+#include <math.h>
+#include "ciclo.h"
+#include "rampa.h"
+#include "tambor.h"
+#include "teste.h"
+
+/* Como motor.h, que depende do ASF */
+#define MOTOR_HZ        1000
+
+/* Sobressinal e erro de regime aceitos, em fracao do alvo */
+#define SOBRE_MAX       0.01f
+#define ASSENTA_S       5
+
+static const struct rampa_limites normal = {
+	CICLO_ACEL_RPM_S, CICLO_FREIO_RPM_S, CICLO_JERK_RPM_S2,
+};
+static const struct rampa_limites pesado = {
+	CICLO_ACEL_PESADO_RPM_S, CICLO_FREIO_RPM_S, CICLO_JERK_RPM_S2,
+};
+
+static void roda(uint16_t de, uint16_t para, bool heavy, float carga_kg)
+{
+	const struct rampa_limites *lim = heavy ? &pesado : &normal;
+	uint32_t lim_a = de < para ? lim->acel : lim->freio;
+	struct rampa r;
+	struct tambor t;
+	uint32_t ticks = 0, ideal_ms, reserva_ms;
+	float a_max = 0.0f, j_max = 0.0f, sobre = 0.0f;
+	int32_t a_ant;
+
+	rampa_init(&r, MOTOR_HZ);
+	tambor_init(&t, carga_kg, 1);
+
+	/* Parte ja no rpm inicial, parado em regime */
+	if (de > 0) {
+		rampa_alvo(&r, de, &(struct rampa_limites){ 1000, 1000, 60000 });
+		while (!rampa_parada(&r)) {
+			rampa_passo(&r);
+		}
+		for (int i = 0; i < 30 * MOTOR_HZ; i++) {
+			tambor_passo(&t, (float)r.v / 65536.0f, 1.0f / MOTOR_HZ);
+		}
+	}
+
+	ideal_ms = rampa_duracao_ms(de, para, lim);
+	reserva_ms = 1000 * (de < para ? CICLO_RAMPA_S(para - de, lim->acel)
+			: CICLO_RAMPA_S(de - para, lim->freio));
+	rampa_alvo(&r, para, lim);
+	a_ant = r.a;
+
+	while (!rampa_parada(&r) && ticks < 600 * MOTOR_HZ) {
+		rampa_passo(&r);
+		ticks++;
+
+		/* Aceleracao da propria rampa: derivar v em Q16 so mede o
+		 * arredondamento de cada tick. O tick que encosta no alvo zera o
+		 * resto da aceleracao de uma vez (rampa_passo) e fica fora do jerk */
+		float v = (float)r.v / 65536.0f;
+		a_max = fmaxf(a_max, fabsf((float)r.a / 65536.0f));
+		if (!rampa_parada(&r)) {
+			j_max = fmaxf(j_max, fabsf((float)(r.a - a_ant) / 65536.0f) * MOTOR_HZ);
+		}
+		a_ant = r.a;
+
+		float rpm = tambor_passo(&t, v, 1.0f / MOTOR_HZ);
+		if (para > 0) {
+			sobre = fmaxf(sobre, rpm - para);
+		}
+	}
+
+	/* Mais ASSENTA_S no alvo */
+	float rpm = t.rpm;
+	for (int i = 0; i < ASSENTA_S * MOTOR_HZ; i++) {
+		rpm = tambor_passo(&t, (float)r.v / 65536.0f, 1.0f / MOTOR_HZ);
+		if (para > 0) {
+			sobre = fmaxf(sobre, rpm - para);
+		}
+	}
+
+	uint32_t ms = ticks * 1000 / MOTOR_HZ;
+	printf("  %4u -> %4u rpm %-6s %.0f kg: %6u ms (ideal %6u, reserva %6u), "
+			"a %.1f rpm/s, jerk %.1f rpm/s2, sobressinal %.2f rpm\n",
+			de, para, heavy ? "pesado" : "normal", carga_kg, ms, ideal_ms,
+			reserva_ms, a_max, j_max, sobre);
+
+	CONFERE(rampa_rpm(&r) == para, "rampa parou em %u", rampa_rpm(&r));
+	CONFERE(ms + 50 >= ideal_ms && ms <= ideal_ms + ideal_ms / 100 + 50,
+			"duracao %u ms, ideal %u", ms, ideal_ms);
+	CONFERE(ms <= reserva_ms, "duracao %u ms passa da reserva %u", ms, reserva_ms);
+	CONFERE(a_max <= lim_a * 1.01f, "aceleracao %.2f > %u", a_max, lim_a);
+	CONFERE(j_max <= lim->jerk * 1.01f, "jerk %.2f > %u", j_max, lim->jerk);
+	CONFERE(sobre <= para * SOBRE_MAX, "sobressinal %.2f rpm", sobre);
+	CONFERE(fabsf(rpm - para) <= fmaxf(para * SOBRE_MAX, 1.0f),
+			"tambor em %.1f rpm, alvo %u", rpm, para);
+}
+
+int main(void)
+{
+	for (float kg = 5.0f; kg <= 8.0f; kg += 1.0f) {
+		roda(0, 1200, false, kg);
+		roda(0, 1200, true, kg);
+		roda(CICLO_DISTRIBUI_RPM, 1200, false, kg);
+		roda(CICLO_DISTRIBUI_RPM, 900, true, kg);
+		roda(1200, 0, false, kg);
+	}
+	/* Variacao curta: triangulo, a aceleracao nao chega no limite */
+	roda(CICLO_DISTRIBUI_RPM, 100, false, 5.0f);
+	return teste_fim("tambor");
+}
@@ -0,0 +1,186 @@
+/*
+ * teste_telas.c
+ *
+ * Percorre a tabela de transicoes da placa (telas_fluxo.c) com o motor
+ * das telas (telas.c), inclusive as acoes recusadas: iniciar com a porta
+ * aberta, editor sem espaco, salvar invalido e agenda sem horario.
+ */
+
+#include <string.h>
+#include "telas.h"
+#include "teste.h"
+
+static bool porta_aberta;
+static bool edita_ok, salva_ok, arma_ok;
+static int iniciados, pausas, mudancas;
+static int desenhos[N_TELAS];
+
+static bool inicia(const t_ciclo *c)
+{
+	(void)c;
+	iniciados++;
+	return !porta_aberta;
+}
+
+static void pausa(void)
+{
+	pausas++;
+}
+
+static void mudou(enum tela t)
+{
+	(void)t;
+	mudancas++;
+}
+
+static bool edita(const t_ciclo *c)
+{
+	(void)c;
+	return edita_ok;
+}
+
+static bool salva(void)
+{
+	return salva_ok;
+}
+
+static bool arma(const t_ciclo *c)
+{
+	(void)c;
+	return arma_ok;
+}
+
+static void desenha(const t_ciclo *c)
+{
+	(void)c;
+	desenhos[tela_atual]++;
+}
+
+static const struct tela_ops ops = {
+	.inicia = inicia,
+	.pausa = pausa,
+	.mudou = mudou,
+	.edita = edita,
+	.salva = salva,
+	.arma = arma,
+};
+
+static struct tela_def defs[N_TELAS];
+static const t_ciclo *ciclos[UINT8_MAX];
+
+static const char *const nomes[N_TELAS] = {
+	"carrossel", "menu", "lavando", "concluida", "aberta", "trancada",
+	"editor", "agenda", "agendada",
+};
+
+/* Aplica o evento e confere o retorno e a tela de chegada */
+static void passo(int linha, enum tela_evento ev, bool aceito, enum tela esperada)
+{
+	bool r = telas_evento(ev);
+
+	CONFERE(r == aceito, "linha %d: evento %d devolveu %d", linha, ev, r);
+	CONFERE(tela_atual == esperada, "linha %d: tela %s, esperada %s",
+			linha, nomes[tela_atual], nomes[esperada]);
+}
+
+#define PASSO(ev, aceito, tela) passo(__LINE__, ev, aceito, tela)
+
+/* Toda entrada usada aponta para uma tela que existe */
+static void confere_tabela(void)
+{
+	for (int t = 0; t < N_TELAS; t++) {
+		for (int e = 0; e < N_TELA_EV; e++) {
+			const struct tela_transicao *tr = &telas_fluxo[t][e];
+			if (tr->acao == TELA_IGNORA) {
+				continue;
+			}
+			CONFERE(tr->proxima < N_TELAS, "%s/%d: proxima %u", nomes[t], e, tr->proxima);
+			CONFERE(tr->recusada < N_TELAS, "%s/%d: recusada %u", nomes[t], e, tr->recusada);
+		}
+	}
+}
+
+int main(void)
+{
+	for (int t = 0; t < N_TELAS; t++) {
+		defs[t].nome = nomes[t];
+		defs[t].desenha = desenha;
+	}
+	confere_tabela();
+
+	for (uint8_t i = 0; i < n_lavagens; i++) {
+		ciclos[i] = &lavagens[i];
+	}
+	telas_init(defs, telas_fluxo, ciclos, n_lavagens, &ops);
+	for (int t = 0; t < N_TELAS; t++) {
+		CONFERE(telas_nome(t) == nomes[t], "nome da tela %d", t);
+	}
+	CONFERE(strcmp(telas_nome(N_TELAS), "?") == 0, "nome fora da tabela");
+	telas_vai(TELA_CARROSSEL);
+	CONFERE(telas_desenha(), "boot sem desenho");
+
+	/* Carrossel circular; tres trocas seguidas custam um desenho */
+	memset(desenhos, 0, sizeof(desenhos));
+	PASSO(TELA_EV_PROXIMO, true, TELA_CARROSSEL);
+	PASSO(TELA_EV_PROXIMO, true, TELA_CARROSSEL);
+	PASSO(TELA_EV_ANTERIOR, true, TELA_CARROSSEL);
+	CONFERE(telas_ciclo_indice() == 1, "indice %u", telas_ciclo_indice());
+	CONFERE(telas_desenha() && !telas_desenha(), "trocas nao coalesceram");
+	CONFERE(desenhos[TELA_CARROSSEL] == 1, "%d desenhos", desenhos[TELA_CARROSSEL]);
+	PASSO(TELA_EV_ANTERIOR, true, TELA_CARROSSEL);
+	PASSO(TELA_EV_ANTERIOR, true, TELA_CARROSSEL);
+	CONFERE(telas_ciclo_indice() == n_lavagens - 1, "nao deu a volta: %u", telas_ciclo_indice());
+	CONFERE(telas_ciclo() == &lavagens[n_lavagens - 1], "ciclo errado");
+
+	/* Eventos que nao valem na tela sao ignorados */
+	PASSO(TELA_EV_OK, false, TELA_CARROSSEL);
+	PASSO(TELA_EV_INICIA, false, TELA_CARROSSEL);
+	CONFERE(iniciados == 0, "INICIA fora do menu chamou o gancho");
+
+	/* Porta aberta recusa o inicio e mostra o aviso */
+	PASSO(TELA_EV_ESCOLHE, true, TELA_MENU);
+	porta_aberta = true;
+	PASSO(TELA_EV_INICIA, true, TELA_PORTA_ABERTA);
+	CONFERE(iniciados == 1, "gancho inicia chamado %d vezes", iniciados);
+	PASSO(TELA_EV_OK, true, TELA_CARROSSEL);
+
+	/* Porta fechada: lava, pausa sem trocar de tela, termina */
+	porta_aberta = false;
+	PASSO(TELA_EV_ESCOLHE, true, TELA_MENU);
+	PASSO(TELA_EV_INICIA, true, TELA_LAVANDO);
+	mudancas = 0;
+	PASSO(TELA_EV_INICIA, true, TELA_LAVANDO);
+	CONFERE(pausas == 1 && mudancas == 0, "pausa: %d pausas, %d trocas", pausas, mudancas);
+	PASSO(TELA_EV_HOME, false, TELA_LAVANDO);
+	PASSO(TELA_EV_FIM, true, TELA_CONCLUIDA);
+	PASSO(TELA_EV_OK, true, TELA_CARROSSEL);
+
+	/* Editor: recusado sem espaco, salvar invalido fica no editor */
+	PASSO(TELA_EV_ESCOLHE, true, TELA_MENU);
+	edita_ok = false;
+	PASSO(TELA_EV_EDITA, true, TELA_MENU);
+	edita_ok = true;
+	PASSO(TELA_EV_EDITA, true, TELA_EDITOR);
+	salva_ok = false;
+	PASSO(TELA_EV_OK, true, TELA_EDITOR);
+	salva_ok = true;
+	PASSO(TELA_EV_OK, true, TELA_MENU);
+
+	/* Agenda: horario impossivel recusa; armada, o alarme entra como
+	 * INICIA e a porta aberta ainda recusa */
+	PASSO(TELA_EV_AGENDA, true, TELA_AGENDA);
+	arma_ok = false;
+	PASSO(TELA_EV_OK, true, TELA_AGENDA);
+	arma_ok = true;
+	PASSO(TELA_EV_OK, true, TELA_AGENDADA);
+	porta_aberta = true;
+	PASSO(TELA_EV_INICIA, true, TELA_PORTA_ABERTA);
+	PASSO(TELA_EV_OK, true, TELA_CARROSSEL);
+
+	/* Porta trancada so sai com o fim da lavagem */
+	telas_vai(TELA_PORTA_TRANCADA);
+	PASSO(TELA_EV_OK, false, TELA_PORTA_TRANCADA);
+	PASSO(TELA_EV_FIM, true, TELA_CONCLUIDA);
+
+	return teste_fim("telas");
+}
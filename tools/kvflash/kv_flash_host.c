@@ -0,0 +1,140 @@
+/*
+ * kv_flash_host.c
+ *
+ * Flash do kv simulada no PC (ver kv_flash_host.h).
+ */
+
+#include <string.h>
+#include "kv_flash_host.h"
+
+#define GRANULOS             (KV_FLASH_BYTES / KV_FLASH_GRANULO)
+#define BLOCOS               (KV_FLASH_BYTES / KV_FLASH_BLOCO)
+
+static uint8_t memoria[KV_FLASH_BYTES];
+static uint8_t programado[GRANULOS];
+static uint32_t apagamentos[BLOCOS];
+static uint32_t resta = UINT32_MAX;    // bytes ate a energia cair
+static bool desligado;
+static struct kv_flash_host_stats stats;
+
+/* Conta um byte escrito; false quando a energia acabou de cair */
+static bool gasta(void)
+{
+	if (desligado) {
+		return false;
+	}
+	if (resta == UINT32_MAX) {
+		return true;
+	}
+	if (resta == 0) {
+		desligado = true;
+		stats.cortes++;
+		return false;
+	}
+	resta--;
+	return true;
+}
+
+void kv_flash_host_formata(void)
+{
+	memset(memoria, 0xFF, sizeof(memoria));
+	memset(programado, 0, sizeof(programado));
+	memset(apagamentos, 0, sizeof(apagamentos));
+	memset(&stats, 0, sizeof(stats));
+	resta = UINT32_MAX;
+	desligado = false;
+}
+
+void kv_flash_host_corta(uint32_t bytes)
+{
+	resta = bytes;
+}
+
+void kv_flash_host_liga(void)
+{
+	resta = UINT32_MAX;
+	desligado = false;
+}
+
+uint8_t *kv_flash_host_memoria(void)
+{
+	return memoria;
+}
+
+void kv_flash_host_stats(struct kv_flash_host_stats *st)
+{
+	*st = stats;
+	st->max_apagamentos = 0;
+	st->min_apagamentos = UINT32_MAX;
+	for (uint32_t b = 0; b < BLOCOS; b++) {
+		if (apagamentos[b] > st->max_apagamentos) {
+			st->max_apagamentos = apagamentos[b];
+		}
+		if (apagamentos[b] < st->min_apagamentos) {
+			st->min_apagamentos = apagamentos[b];
+		}
+	}
+}
+
+void kv_flash_le(uint32_t endereco, void *dst, uint32_t n)
+{
+	memcpy(dst, memoria + endereco, n);
+}
+
+bool kv_flash_programa(uint32_t endereco, const void *src, uint32_t n)
+{
+	const uint8_t *p = src;
+
+	if (endereco % KV_FLASH_GRANULO || n % KV_FLASH_GRANULO ||
+			endereco + n > KV_FLASH_BYTES) {
+		stats.violacoes++;
+		return false;
+	}
+	for (uint32_t i = 0; i < n; i++) {
+		uint32_t g = (endereco + i) / KV_FLASH_GRANULO;
+
+		if (!gasta()) {
+			/* Granulo pela metade: o resto fica como estava */
+			return false;
+		}
+		if (i % KV_FLASH_GRANULO == 0) {
+			if (programado[g]) {
+				stats.violacoes++;
+			}
+			programado[g] = 1;
+			stats.programados++;
+		}
+		if (p[i] & ~memoria[endereco + i]) {
+			stats.violacoes++;
+		}
+		memoria[endereco + i] &= p[i];
+	}
+	return true;
+}
+
+bool kv_flash_apaga(uint32_t endereco)
+{
+	if (endereco % KV_FLASH_BLOCO || endereco >= KV_FLASH_BYTES) {
+		stats.violacoes++;
+		return false;
+	}
+	if (desligado) {
+		return false;
+	}
+	apagamentos[endereco / KV_FLASH_BLOCO]++;
+	for (uint32_t i = 0; i < KV_FLASH_BLOCO; i += KV_FLASH_GRANULO) {
+		/* Corte no meio: os granulos seguintes ficam com o conteudo velho */
+		if (!gasta()) {
+			return false;
+		}
+		memset(memoria + endereco + i, 0xFF, KV_FLASH_GRANULO);
+		programado[(endereco + i) / KV_FLASH_GRANULO] = 0;
+	}
+	stats.apagados++;
+	return true;
+}
+
+uint32_t kv_flash_pior_us(void)
+{
+	return 0;
+}
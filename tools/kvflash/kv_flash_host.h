@@ -0,0 +1,41 @@
+/*
+ * kv_flash_host.h
+ *
+ * Flash do kv (kv_flash.h) simulada em RAM para rodar o kv.c no PC.
+ * Confere as regras da flash (programar so desce bits, granulo programado
+ * uma vez) e simula a energia caindo depois de N bytes escritos: o
+ * granulo ou bloco em andamento fica pela metade e tudo falha ate
+ * kv_flash_host_liga.
+ *
+ *   cc -I../../MXT_EXAMPLE_USART1/src kv_flash_host.c \
+ *       ../../MXT_EXAMPLE_USART1/src/kv.c seu_teste.c
+ */
+
+#ifndef KV_FLASH_HOST_H_
+#define KV_FLASH_HOST_H_
+
+#include <stdint.h>
+#include "kv_flash.h"
+
+struct kv_flash_host_stats {
+	uint32_t programados;      // granulos
+	uint32_t apagados;         // blocos
+	uint32_t violacoes;        // granulo programado duas vezes ou bit subindo
+	uint32_t cortes;
+	uint32_t max_apagamentos;  // bloco mais gasto
+	uint32_t min_apagamentos;  // bloco menos gasto
+};
+
+/** \brief Flash toda apagada, energia ligada */
+void kv_flash_host_formata(void);
+
+/** \brief A energia cai quando mais \a bytes tiverem sido escritos (0 = agora) */
+void kv_flash_host_corta(uint32_t bytes);
+
+/** \brief Volta a energia (a flash fica como o corte deixou) */
+void kv_flash_host_liga(void);
+
+uint8_t *kv_flash_host_memoria(void);
+void kv_flash_host_stats(struct kv_flash_host_stats *st);
+
+#endif /* KV_FLASH_HOST_H_ */
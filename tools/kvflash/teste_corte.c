@@ -0,0 +1,141 @@
+/*
+ * teste_corte.c
+ *
+ * Falta de energia no kv.c: gravacoes e remocoes aleatorias, manutencao
+ * aos pedacos e a energia caindo em pontos sorteados (no meio de um
+ * registro, de uma compactacao ou de um apagamento). Depois de cada corte
+ * a placa "reinicia" (kv_init) e o teste confere:
+ *
+ * - todo valor confirmado (kv_grava devolveu true) continua la;
+ * - a gravacao cortada ficou com o valor velho ou com o novo, inteiro;
+ * - a flash nunca foi programada fora das regras.
+ *
+ * No fim confere que o desgaste ficou espalhado pela area toda.
+ *
+ *   teste_corte [operacoes] [semente]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "kv.h"
+#include "kv_flash_host.h"
+#include "teste.h"
+
+#define CHAVES      6
+
+struct valor {
+	uint16_t n;                // 0 = chave ausente
+	uint8_t dados[KV_MAX_DADOS];
+};
+
+static struct valor confirmado[CHAVES + 1];
+static struct valor pendente[CHAVES + 1];
+static bool tem_pendente[CHAVES + 1];
+
+static uint32_t cortes(void)
+{
+	struct kv_flash_host_stats st;
+
+	kv_flash_host_stats(&st);
+	return st.cortes;
+}
+
+static bool igual(const struct valor *v, const uint8_t *lido, uint16_t n)
+{
+	return v->n == n && memcmp(v->dados, lido, n) == 0;
+}
+
+/* Volta a energia, reinicia e confere cada chave */
+static void reinicia(int op)
+{
+	uint8_t lido[KV_MAX_DADOS];
+
+	kv_flash_host_liga();
+	kv_init();
+	for (int k = 1; k <= CHAVES; k++) {
+		uint16_t n = kv_le(k, lido, sizeof(lido));
+		bool ok = igual(&confirmado[k], lido, n) ||
+				(tem_pendente[k] && igual(&pendente[k], lido, n));
+
+		CONFERE(ok, "operacao %d: chave %d com %u bytes, confirmado %u%s", op, k, n,
+				confirmado[k].n, tem_pendente[k] ? " (gravacao cortada)" : "");
+		confirmado[k].n = n;
+		memcpy(confirmado[k].dados, lido, n);
+		tem_pendente[k] = false;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int operacoes = argc > 1 ? atoi(argv[1]) : 50000;
+	unsigned semente = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 0) : 1;
+	struct kv_flash_host_stats st;
+	uint32_t confirmadas = 0;
+
+	srand(semente);
+	kv_flash_host_formata();
+	kv_init();
+
+	for (int i = 0; i < operacoes; i++) {
+		int k = 1 + rand() % CHAVES;
+		struct valor novo;
+		uint32_t antes;
+		bool ok;
+
+		/* Uma vez a cada ~20 operacoes a energia vai cair em algum ponto
+		 * das proximas escritas */
+		if (rand() % 20 == 0) {
+			kv_flash_host_corta(rand() % (3 * KV_FLASH_BLOCO));
+		}
+
+		if (rand() % 10 == 0) {
+			novo.n = 0;
+		}
+		else {
+			novo.n = 1 + rand() % KV_MAX_DADOS;
+			for (uint16_t j = 0; j < novo.n; j++) {
+				novo.dados[j] = (uint8_t)rand();
+			}
+		}
+
+		antes = cortes();
+		ok = novo.n ? kv_grava(k, novo.dados, novo.n) : kv_remove(k);
+		if (cortes() != antes) {
+			pendente[k] = novo;
+			tem_pendente[k] = true;
+			reinicia(i);
+			continue;
+		}
+		if (ok) {
+			confirmado[k] = novo;
+			confirmadas++;
+		}
+
+		/* Manutencao aos pedacos, como o kv_tick entre outras tarefas */
+		for (int m = rand() % 8; m > 0 && kv_manutencao(); m--) {
+		}
+		if (cortes() != antes) {
+			reinicia(i);
+		}
+	}
+	kv_flash_host_liga();
+	while (kv_manutencao()) {
+	}
+	reinicia(operacoes);
+
+	kv_flash_host_stats(&st);
+	printf("  %d operacoes (semente %u), %u confirmadas, %u cortes, %u blocos apagados, "
+			"desgaste %u a %u\n", operacoes, semente, confirmadas, st.cortes, st.apagados,
+			st.min_apagamentos, st.max_apagamentos);
+	kv_dump();
+
+	CONFERE(st.cortes > 0, "nenhum corte");
+	CONFERE(st.violacoes == 0, "%u violacoes da flash", st.violacoes);
+	/* O registro cortado forca a compactacao antes de o segundo bloco do
+	 * segmento ser usado, e bloco em branco nao e apagado: o primeiro bloco
+	 * de cada segmento gasta mais que o segundo, mas nenhum pode ficar
+	 * parado nem gastar o dobro de outro */
+	CONFERE(st.min_apagamentos > 0 && st.max_apagamentos <= 2 * st.min_apagamentos,
+			"desgaste desigual: %u a %u", st.min_apagamentos, st.max_apagamentos);
+	return teste_fim("kv corte");
+}
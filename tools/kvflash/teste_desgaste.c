@@ -0,0 +1,79 @@
+/*
+ * teste_desgaste.c
+ *
+ * Rodizio dos segmentos do kv.c: muitas gravacoes, com a manutencao
+ * rodando ate acabar depois de cada uma, com e sem reset (kv_init) entre
+ * as gravacoes. No fim todo bloco da area tem que ter sido apagado e a
+ * diferenca entre o mais e o menos gasto fica em KV_BLOCOS de folga.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "kv.h"
+#include "kv_flash_host.h"
+#include "teste.h"
+
+#define GRAVACOES   20000
+#define CHAVES      4
+#define FOLGA       2      // apagamentos entre o bloco mais e o menos gasto
+
+static uint8_t valor[CHAVES + 1][KV_MAX_DADOS];
+static uint16_t tamanho[CHAVES + 1];
+
+static void confere(const char *quando)
+{
+	uint8_t lido[KV_MAX_DADOS];
+
+	for (int k = 1; k <= CHAVES; k++) {
+		uint16_t n = kv_le(k, lido, sizeof(lido));
+		CONFERE(n == tamanho[k] && memcmp(lido, valor[k], n) == 0,
+				"%s: chave %d com %u bytes, esperado %u", quando, k, n, tamanho[k]);
+	}
+}
+
+static void roda(bool reset)
+{
+	struct kv_flash_host_stats st;
+
+	kv_flash_host_formata();
+	memset(tamanho, 0, sizeof(tamanho));
+	srand(1);
+	kv_init();
+	kv_stats_reset();
+
+	for (int i = 0; i < GRAVACOES; i++) {
+		int k = 1 + rand() % CHAVES;
+		uint16_t n = 16 + rand() % 300;
+
+		for (uint16_t j = 0; j < n; j++) {
+			valor[k][j] = (uint8_t)rand();
+		}
+		if (kv_grava(k, valor[k], n)) {
+			tamanho[k] = n;
+		}
+		while (kv_manutencao()) {
+		}
+		if (reset) {
+			kv_init();
+			confere("depois do reset");
+		}
+	}
+	confere("fim");
+
+	kv_flash_host_stats(&st);
+	printf("  %s: %u blocos apagados, bloco mais gasto %u, menos gasto %u\n",
+			reset ? "reset a cada gravacao" : "sem reset",
+			st.apagados, st.max_apagamentos, st.min_apagamentos);
+	kv_dump();
+	CONFERE(st.violacoes == 0, "%u violacoes da flash", st.violacoes);
+	CONFERE(st.min_apagamentos > 0, "bloco nunca usado");
+	CONFERE(st.max_apagamentos - st.min_apagamentos <= FOLGA,
+			"desgaste desigual: %u a %u", st.min_apagamentos, st.max_apagamentos);
+}
+
+int main(void)
+{
+	roda(false);
+	roda(true);
+	return teste_fim("kv desgaste");
+}
@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+"""
+Cliente do controle remoto da interface (MXT_EXAMPLE_USART1/src/remote.h).
+
+Uso:
+    remote.py /dev/ttyACM0 state
+    remote.py /dev/ttyACM0 tap 240 140
+    remote.py /dev/ttyACM0 touch 240 140       # toque cru, passa pelo filtro
+    remote.py /dev/ttyACM0 perf 1
+    remote.py /dev/ttyACM0 redraw
+    remote.py /dev/ttyACM0 clock               # acerta o RTC com a hora do PC
+    remote.py /dev/ttyACM0 bench 1000 --csv tempos.csv
+    remote.py loopback bench 5000              # sem placa (CI)
+
+A porta "loopback" troca a placa por tools/host/build/loopback (make -C
+tools/host): o telas.c, a tabela de telas e botoes (telas_defs.c) e os
+programas do firmware compilados para o PC. Cada comando vale um segundo da
+placa. O filtro de toque e as metricas de latencia so existem na placa:
+touch, swipe e perf respondem "nao suportado", e os tempos do bench medem o
+PC e o pipe, nao a placa.
+"""
+
+import argparse
+import os
+import random
+import select
+import struct
+import subprocess
+import sys
+import time
+
+from telemetry_decode import FrameParser, crc8, u16, u32
+
+SYNC = bytes([0xA5, 0x5A])
+
+REMOTE_TOUCH = 0x80
+REMOTE_TAP = 0x81
+REMOTE_STATE = 0x82
+REMOTE_PERF = 0x83
+REMOTE_REDRAW = 0x84
+REMOTE_CLOCK = 0x86
+
+TELEM_ACK = 0x03
+TELEM_STATE = 0x04
+TELEM_PERF = 0x05
+
+STATUS = ["ok", "fora dos botoes", "argumentos invalidos", "desconhecido", "nao suportado", "ocupado"]
+TELAS = ["carrossel", "menu", "lavando", "concluida", "porta aberta", "porta trancada", "editor",
+         "agenda", "agendada"]
+STAGES = ["chg->read", "read->callback", "callback->redraw", "total"]
+
+# Bits de status do T9 (mxt_device_1.h)
+MXT_DETECT, MXT_PRESS, MXT_RELEASE, MXT_MOVE = 0x80, 0x40, 0x20, 0x10
+
+# Tempo minimo de toque do filtro (conf_touch_filter.h), com folga
+MIN_PRESS_S = 0.040
+
+LCD_W, LCD_H = 480, 320
+
+LOOPBACK = os.path.join(os.path.dirname(os.path.abspath(__file__)), "host", "build", "loopback")
+
+
+def frame(ftype, payload):
+    body = bytes([ftype, len(payload)]) + payload
+    return SYNC + body + bytes([crc8(body)])
+
+
+def px_to_raw(x, y):
+    """Inverso da calibracao padrao (touch_calib.c): pixels -> unidades do maXTouch."""
+    return int((LCD_W - x) * 65536 / 7680), int((LCD_H - y) * 65536 / 5120)
+
+
+class Remote:
+    def __init__(self, port, timeout=1.0):
+        self.port = port
+        self.timeout = timeout
+        self.seq = 0
+        self.replies = []
+        self.parser = FrameParser(self._frame, lambda t: sys.stderr.write(t.decode("latin-1")))
+
+    def _frame(self, ftype, payload):
+        if ftype in (TELEM_ACK, TELEM_STATE, TELEM_PERF):
+            self.replies.append((ftype, payload))
+
+    def request(self, cmd, args=b""):
+        self.seq = (self.seq + 1) & 0xFF
+        seq = self.seq
+        self.port.write(frame(cmd, bytes([seq]) + args))
+        deadline = time.monotonic() + self.timeout
+        while time.monotonic() < deadline:
+            for i, (ftype, payload) in enumerate(self.replies):
+                if payload and payload[0] == seq:
+                    del self.replies[i]
+                    return ftype, payload
+            data = self.port.read(256)
+            if data:
+                self.parser.feed(data)
+        raise TimeoutError("sem resposta ao comando 0x%02x" % cmd)
+
+    def _ack(self, cmd, args=b""):
+        ftype, payload = self.request(cmd, args)
+        if ftype != TELEM_ACK or len(payload) < 3:
+            raise IOError("resposta inesperada %r" % (payload,))
+        return payload[2]
+
+    def tap(self, x, y):
+        """Toque ja em pixels, direto nos botoes. Retorna o status do ack."""
+        return self._ack(REMOTE_TAP, struct.pack("<HH", x, y))
+
+    def touch(self, status, raw_x, raw_y):
+        return self._ack(REMOTE_TOUCH, struct.pack("<BHH", status, raw_x, raw_y))
+
+    def touch_tap(self, x, y, hold=MIN_PRESS_S):
+        """Toque cru (pressiona, espera, solta) pelo mesmo caminho do mxt_handler."""
+        rx, ry = px_to_raw(x, y)
+        self.touch(MXT_DETECT | MXT_PRESS, rx, ry)
+        time.sleep(hold)
+        return self.touch(MXT_RELEASE, rx, ry)
+
+    def swipe(self, x0, y0, x1, y1, steps=8, duration=0.2):
+        self.touch(MXT_DETECT | MXT_PRESS, *px_to_raw(x0, y0))
+        for i in range(1, steps + 1):
+            time.sleep(duration / steps)
+            x = x0 + (x1 - x0) * i // steps
+            y = y0 + (y1 - y0) * i // steps
+            self.touch(MXT_DETECT | MXT_MOVE, *px_to_raw(x, y))
+        return self.touch(MXT_RELEASE, *px_to_raw(x1, y1))
+
+    def state(self):
+        _, p = self.request(REMOTE_STATE)
+        return {
+            "tela": TELAS[p[1]] if p[1] < len(TELAS) else p[1],
+            "laundry_event": p[2],
+            "time_left": struct.unpack_from("<i", p, 3)[0],
+            "unlocked": bool(p[7]),
+            "door_open": bool(p[8]),
+            "botoes": p[9],
+        }
+
+    def perf(self, tela):
+        ftype, p = self.request(REMOTE_PERF, bytes([tela]))
+        if ftype == TELEM_ACK:
+            raise IOError("perf: %s" % STATUS[p[2]])
+        stages = {}
+        for i, name in enumerate(STAGES):
+            off = 2 + 16 * i
+            stages[name] = dict(zip(("n", "p50_us", "p99_us", "max_us"),
+                                    (u32(p, off + 4 * k) for k in range(4))))
+        return {"tela": TELAS[p[1]], "stages": stages, "uart_dropped": u32(p, 2 + 16 * len(STAGES))}
+
+    def redraw(self):
+        return self._ack(REMOTE_REDRAW)
+
+    def clock(self, t=None):
+        """Acerta o RTC (agendamento) com a hora local do PC ou com \a t."""
+        t = time.localtime(t)
+        return self._ack(REMOTE_CLOCK, struct.pack("<HBBBBBB", t.tm_year, t.tm_mon, t.tm_mday,
+                                                   t.tm_wday + 1, t.tm_hour, t.tm_min, t.tm_sec))
+
+
+class Loopback:
+    """
+    tools/host/build/loopback (make -C tools/host): as telas, os botoes e os
+    programas do firmware compilados para o PC, falando o protocolo pela
+    entrada e saida padrao.
+    """
+
+    FONTE = "loopback no PC"
+
+    def __init__(self, path=LOOPBACK):
+        if not os.path.exists(path):
+            raise SystemExit("%s nao existe: make -C tools/host" % path)
+        self.proc = subprocess.Popen([path], stdin=subprocess.PIPE, stdout=subprocess.PIPE, bufsize=0)
+
+    def write(self, data):
+        self.proc.stdin.write(data)
+
+    def read(self, n):
+        ready, _, _ = select.select([self.proc.stdout], [], [], 0.05)
+        return os.read(self.proc.stdout.fileno(), n) if ready else b""
+
+
+def fonte(port):
+    """De onde vem os tempos: "placa" ou "loopback no PC"."""
+    return getattr(port, "FONTE", "placa")
+
+
+def bench(remote, n, csv, origem):
+    """Toques aleatorios nos botoes; tempo de ida e volta de cada comando."""
+    rng = random.Random(1)
+    times = []
+    out = open(csv, "w") if csv else None
+    if out:
+        out.write("# tempos: %s\n" % origem)
+        out.write("i,x,y,status,tela,rtt_us\n")
+    for i in range(n):
+        x, y = rng.randrange(LCD_W), rng.randrange(LCD_H)
+        t0 = time.perf_counter()
+        status = remote.tap(x, y)
+        rtt = int((time.perf_counter() - t0) * 1e6)
+        times.append(rtt)
+        if out:
+            out.write("%d,%d,%d,%d,%s,%d\n" % (i, x, y, status, remote.state()["tela"], rtt))
+    times.sort()
+    print("%d toques (%s): p50 %d us, p99 %d us, max %d us"
+          % (n, origem, times[n // 2], times[n * 99 // 100], times[-1]))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port", help="porta serial (precisa de pyserial) ou loopback")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--csv", help="saida do bench")
+    ap.add_argument("cmd", choices=["state", "tap", "touch", "swipe", "perf", "redraw", "clock", "bench"])
+    ap.add_argument("args", nargs="*", type=int)
+    args = ap.parse_args()
+
+    if args.port == "loopback":
+        port = Loopback()
+    else:
+        import serial
+        port = serial.Serial(args.port, args.baud, timeout=0.05)
+
+    r = Remote(port)
+    if args.cmd == "state":
+        print(r.state())
+    elif args.cmd == "tap":
+        print(STATUS[r.tap(*args.args[:2])])
+    elif args.cmd == "touch":
+        print(STATUS[r.touch_tap(*args.args[:2])])
+    elif args.cmd == "swipe":
+        print(STATUS[r.swipe(*args.args[:4])])
+    elif args.cmd == "perf":
+        try:
+            p = r.perf(args.args[0] if args.args else 0)
+        except IOError as e:
+            sys.exit(str(e))
+        print("tela %s (%s), uart descartados %d" % (p["tela"], fonte(port), p["uart_dropped"]))
+        for name, s in p["stages"].items():
+            print("  %-18s n=%-6d p50=%-6d p99=%-6d max=%d" % (
+                name, s["n"], s["p50_us"], s["p99_us"], s["max_us"]))
+    elif args.cmd == "redraw":
+        print(STATUS[r.redraw()])
+    elif args.cmd == "clock":
+        print(STATUS[r.clock()])
+    elif args.cmd == "bench":
+        bench(r, args.args[0] if args.args else 1000, args.csv, fonte(port))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""
+Monta PNGs a partir da captura de tela da placa (MXT_EXAMPLE_USART1/src/screenshot.h).
+
+Uso:
+    screenshot.py /dev/ttyACM0 -o tela.png     # pede a captura e espera
+    screenshot.py captura.bin -o tela.png      # le quadros ja capturados
+
+Cada captura completa vira um PNG; com varias capturas no arquivo, as
+seguintes ganham o id no nome (tela_2.png, ...).
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+from telemetry_decode import FrameParser, open_source, u16, u32
+
+TELEM_SHOT_BEGIN = 0x06
+TELEM_SHOT_DATA = 0x07
+TELEM_SHOT_END = 0x08
+
+REMOTE_SHOT = 0x85
+
+
+def rle_decode(data, npx):
+    """RLE do screenshot.h -> lista de pixels RGB565."""
+    px = []
+    i = 0
+    while i < len(data) and len(px) < npx:
+        n = data[i]
+        i += 1
+        if n & 0x80:
+            px.extend([u16(data, i)] * ((n & 0x7F) + 1))
+            i += 2
+        else:
+            for _ in range(n + 1):
+                px.append(u16(data, i))
+                i += 2
+    return px
+
+
+def rgb565_to_rgb(p):
+    r, g, b = (p >> 11) & 0x1F, (p >> 5) & 0x3F, p & 0x1F
+    return bytes(((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)))
+
+
+def write_png(path, width, height, rows):
+    def chunk(tag, data):
+        return (struct.pack(">I", len(data)) + tag + data
+                + struct.pack(">I", zlib.crc32(tag + data) & 0xFFFFFFFF))
+
+    raw = b"".join(b"\0" + rows.get(y, b"\0\0\0" * width) for y in range(height))
+    with open(path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n")
+        f.write(chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, 2, 0, 0, 0)))
+        f.write(chunk(b"IDAT", zlib.compress(raw, 6)))
+        f.write(chunk(b"IEND", b""))
+
+
+class ShotAssembler:
+    def __init__(self, out_path):
+        self.out_path = out_path
+        self.shot = None
+        self.saved = []
+
+    def frame(self, ftype, p):
+        if ftype == TELEM_SHOT_BEGIN and len(p) >= 6:
+            self.shot = {"id": p[0], "w": u16(p, 1), "h": u16(p, 3), "bands": {}, "rows": {}}
+        elif self.shot is None or not p or p[0] != self.shot["id"]:
+            return
+        elif ftype == TELEM_SHOT_DATA and len(p) >= 8:
+            y, nrows, total, off = u16(p, 1), p[3], u16(p, 4), u16(p, 6)
+            band = self.shot["bands"].setdefault(y, bytearray(total))
+            band[off:off + len(p) - 8] = p[8:]
+            if off + len(p) - 8 >= total:
+                self._band(y, nrows, bytes(band))
+        elif ftype == TELEM_SHOT_END and len(p) >= 5:
+            self._save(u32(p, 1))
+
+    def _band(self, y, nrows, data):
+        w = self.shot["w"]
+        px = rle_decode(data, w * nrows)
+        for r in range(nrows):
+            self.shot["rows"][y + r] = b"".join(rgb565_to_rgb(v) for v in px[r * w:(r + 1) * w])
+
+    def _save(self, worst_us):
+        s = self.shot
+        path = self.out_path
+        if self.saved:
+            base, dot, ext = path.rpartition(".")
+            path = "%s_%d.%s" % (base, s["id"], ext) if dot else "%s_%d" % (path, s["id"])
+        write_png(path, s["w"], s["h"], s["rows"])
+        missing = s["h"] - len(s["rows"])
+        sys.stderr.write("# %s: %dx%d, %d linhas faltando, faixa mais lenta %d us\n"
+                         % (path, s["w"], s["h"], missing, worst_us))
+        self.saved.append(path)
+        self.shot = None
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("source", help="porta serial ou arquivo .bin")
+    ap.add_argument("-o", "--out", default="tela.png")
+    ap.add_argument("--baud", type=int, default=115200)
+    args = ap.parse_args()
+
+    shots = ShotAssembler(args.out)
+    parser = FrameParser(shots.frame, lambda t: None)
+    src = open_source(args.source, args.baud)
+
+    live = hasattr(src, "in_waiting")
+    if live:
+        from remote import frame
+        src.write(frame(REMOTE_SHOT, bytes([0])))
+
+    try:
+        while not (live and shots.saved):
+            data = src.read(4096)
+            if not data:
+                if live:
+                    continue
+                break
+            parser.feed(data)
+    except KeyboardInterrupt:
+        pass
+    if not shots.saved:
+        sys.stderr.write("# nenhuma captura completa\n")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
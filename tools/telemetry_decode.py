@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""
+Decodificador da telemetria binaria da USART de console
+(MXT_EXAMPLE_USART1/src/telemetry.h).
+
+Uso:
+    telemetry_decode.py /dev/ttyACM0            # porta serial (precisa de pyserial)
+    telemetry_decode.py captura.bin             # arquivo capturado
+    telemetry_decode.py captura.bin --csv t.csv
+
+Os quadros viram linhas CSV (tempo em us, id, status, x, y, size). O texto
+impresso pelo printf entre quadros vai para a stderr.
+"""
+
+import argparse
+import sys
+
+SYNC0 = 0xA5
+SYNC1 = 0x5A
+
+TELEM_HELLO = 0x00
+TELEM_TOUCH = 0x01
+
+STATUS_BITS = [
+    (0x80, "DETECT"), (0x40, "PRESS"), (0x20, "RELEASE"), (0x10, "MOVE"),
+    (0x08, "VECTOR"), (0x04, "AMP"), (0x02, "SUPPRESS"), (0x01, "UNGRIP"),
+]
+
+
+def crc8(data, crc=0):
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def u16(b, i):
+    return b[i] | (b[i + 1] << 8)
+
+
+def u32(b, i):
+    return u16(b, i) | (u16(b, i + 2) << 16)
+
+
+def status_names(status):
+    return "|".join(name for bit, name in STATUS_BITS if status & bit) or "-"
+
+
+class FrameParser:
+    """Separa quadros validos do resto do fluxo (texto, lixo)."""
+
+    def __init__(self, on_frame, on_text):
+        self.buf = bytearray()
+        self.on_frame = on_frame
+        self.on_text = on_text
+        self.bad_crc = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(bytes([SYNC0, SYNC1]))
+            if start < 0:
+                # guarda o ultimo byte: pode ser o inicio de um sync
+                keep = 1 if self.buf[-1:] == bytes([SYNC0]) else 0
+                self._text(self.buf[:len(self.buf) - keep])
+                del self.buf[:len(self.buf) - keep]
+                return
+            self._text(self.buf[:start])
+            del self.buf[:start]
+            if len(self.buf) < 4:
+                return
+            length = self.buf[3]
+            total = 4 + length + 1
+            if len(self.buf) < total:
+                return
+            frame = bytes(self.buf[:total])
+            if crc8(frame[2:-1]) != frame[-1]:
+                self.bad_crc += 1
+                del self.buf[:1]
+                continue
+            del self.buf[:total]
+            self.on_frame(frame[2], frame[4:-1])
+
+    def _text(self, data):
+        if data:
+            self.on_text(bytes(data))
+
+
+class TouchDecoder:
+    """Converte os ciclos do DWT (32 bits) em us continuos."""
+
+    def __init__(self, out):
+        self.out = out
+        self.cpu_hz = 300000000
+        self.last = None
+        self.wraps = 0
+        self.count = 0
+        out.write("t_us,id,status,status_names,x,y,size\n")
+
+    def frame(self, ftype, payload):
+        if ftype == TELEM_HELLO and len(payload) >= 5:
+            self.cpu_hz = u32(payload, 0)
+            self.last = None
+            self.wraps = 0
+            sys.stderr.write("# hello: cpu %d Hz, versao %d\n" % (self.cpu_hz, payload[4]))
+        elif ftype == TELEM_TOUCH and len(payload) >= 11:
+            ts = u32(payload, 7)
+            if self.last is not None and ts < self.last:
+                self.wraps += 1
+            self.last = ts
+            t_us = ((self.wraps << 32) + ts) * 1000000 // self.cpu_hz
+            status = payload[1]
+            self.out.write("%d,%d,0x%02x,%s,%d,%d,%d\n" % (
+                t_us, payload[0], status, status_names(status),
+                u16(payload, 2), u16(payload, 4), payload[6]))
+            self.count += 1
+
+
+def open_source(path, baud):
+    try:
+        import serial  # noqa: pyserial e opcional para arquivos
+        if not path.endswith(".bin"):
+            return serial.Serial(path, baud, timeout=0.1)
+    except ImportError:
+        pass
+    return open(path, "rb")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("source", help="porta serial ou arquivo .bin")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--csv", help="arquivo de saida (padrao: stdout)")
+    args = ap.parse_args()
+
+    out = open(args.csv, "w") if args.csv else sys.stdout
+    touch = TouchDecoder(out)
+    parser = FrameParser(touch.frame,
+                         lambda t: sys.stderr.write(t.decode("latin-1")))
+
+    src = open_source(args.source, args.baud)
+    try:
+        while True:
+            data = src.read(4096)
+            if not data:
+                if hasattr(src, "in_waiting"):
+                    continue
+                break
+            parser.feed(data)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        out.flush()
+        sys.stderr.write("# %d toques, %d quadros com crc invalido\n"
+                         % (touch.count, parser.bad_crc))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""
+Reconstroi o log binario do TRACE (MXT_EXAMPLE_USART1/src/trace.h).
+
+Uso:
+    trace_decode.py captura.bin                 # usa o ELF padrao do Debug
+    trace_decode.py /dev/ttyACM0 --elf outro.elf
+
+O id de cada registro e o endereco da string de formato na secao .log_fmt
+do ELF; argumentos %s sao ponteiros lidos das secoes carregadas (.text,
+.relocate). Os quadros de toque sao ignorados e o texto do printf vai para
+a stderr, como no telemetry_decode.py.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+from telemetry_decode import FrameParser, TELEM_HELLO, open_source, u16, u32
+
+TELEM_TRACE = 0x02
+TRACE_ID_LOST = 0xFFFF
+TRACE_SEP = "\x1f"
+
+DEFAULT_ELF = os.path.join(os.path.dirname(__file__), "..", "MXT_EXAMPLE_USART1",
+                           "Debug", "MXT_EXAMPLE_USART1.elf")
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+# %[flags][largura][.precisao][tamanho]conversao
+FMT_SPEC = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diouxXcsp%])")
+
+
+class Elf:
+    """Leitor minimo de ELF (so o que o decodificador precisa)."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        d = self.data
+        if d[:4] != b"\x7fELF":
+            raise ValueError("%s nao e um ELF" % path)
+        is64 = d[4] == 2
+        end = "<" if d[5] == 1 else ">"
+        if is64:
+            shoff, = struct.unpack_from(end + "Q", d, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", d, 0x3A)
+            shfmt = end + "IIQQQQIIQQ"
+        else:
+            shoff, = struct.unpack_from(end + "I", d, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", d, 0x2E)
+            shfmt = end + "IIIIIIIIII"
+
+        raw = [struct.unpack_from(shfmt, d, shoff + i * shentsize) for i in range(shnum)]
+        strtab = raw[shstrndx]
+        self.sections = []
+        for name, stype, flags, addr, offset, size, _, _, _, _ in raw:
+            n = d[strtab[4] + name:d.index(b"\0", strtab[4] + name)].decode()
+            self.sections.append((n, stype, flags, addr, offset, size))
+
+    def section(self, name):
+        for n, stype, _, addr, offset, size in self.sections:
+            if n == name:
+                return addr, self.data[offset:offset + size]
+        return None
+
+    def read_cstring(self, addr):
+        """String C num endereco do alvo, procurando nas secoes carregadas."""
+        for _, stype, flags, base, offset, size in self.sections:
+            if flags & SHF_ALLOC and stype != SHT_NOBITS and base <= addr < base + size:
+                start = offset + addr - base
+                stop = self.data.find(b"\0", start, offset + size)
+                return self.data[start:stop if stop >= 0 else offset + size].decode("latin-1")
+        return None
+
+
+def format_c(fmt, args, elf):
+    """Aplica um formato printf a argumentos de 32 bits crus."""
+    out = []
+    pos = 0
+    args = list(args)
+    for m in FMT_SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, _, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if not args:
+            out.append("<?>")
+            continue
+        v = args.pop(0)
+        spec = "%" + flags + width + ("." + prec if prec else "")
+        if conv in "di":
+            out.append((spec + "d") % (v - (1 << 32) if v & 0x80000000 else v))
+        elif conv == "u":
+            out.append((spec + "d") % v)
+        elif conv in "oxX":
+            out.append((spec + conv) % v)
+        elif conv == "c":
+            out.append((spec + "c") % chr(v & 0xFF))
+        elif conv == "p":
+            out.append("0x%08x" % v)
+        else:
+            s = elf.read_cstring(v)
+            out.append((spec + "s") % (s if s is not None else "<0x%08x>" % v))
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+class TraceDecoder:
+    def __init__(self, elf, out):
+        self.elf = elf
+        self.out = out
+        sec = elf.section(".log_fmt")
+        if sec is None:
+            raise ValueError("ELF sem secao .log_fmt (firmware sem TRACE?)")
+        self.fmt_base, self.fmt_data = sec
+        self.cpu_hz = 300000000
+        self.last = None
+        self.wraps = 0
+        self.count = 0
+        self.lost = 0
+
+    def lookup(self, msg_id):
+        off = msg_id - self.fmt_base
+        if not 0 <= off < len(self.fmt_data):
+            return None, None
+        end = self.fmt_data.index(b"\0", off)
+        where, _, fmt = self.fmt_data[off:end].decode("latin-1").partition(TRACE_SEP)
+        return where, fmt
+
+    def frame(self, ftype, payload):
+        if ftype == TELEM_HELLO and len(payload) >= 5:
+            self.cpu_hz = u32(payload, 0)
+            self.last = None
+            self.wraps = 0
+        elif ftype == TELEM_TRACE and len(payload) >= 6:
+            msg_id = u16(payload, 0)
+            ts = u32(payload, 2)
+            args = [u32(payload, i) for i in range(6, len(payload) - 3, 4)]
+            if self.last is not None and ts < self.last:
+                self.wraps += 1
+            self.last = ts
+            t_us = ((self.wraps << 32) + ts) * 1000000 // self.cpu_hz
+
+            if msg_id == TRACE_ID_LOST:
+                self.lost += args[0] if args else 0
+                line = "*** %d registros perdidos" % (args[0] if args else 0)
+                where = "-"
+            else:
+                where, fmt = self.lookup(msg_id)
+                if fmt is None:
+                    line = "<id 0x%04x desconhecido> %s" % (msg_id, args)
+                    where = "?"
+                else:
+                    line = format_c(fmt, args, self.elf)
+            self.out.write("%10.3f ms  %-24s %s\n" % (t_us / 1000.0, where, line))
+            self.count += 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("source", help="porta serial ou arquivo .bin")
+    ap.add_argument("--elf", default=DEFAULT_ELF, help="firmware que gerou a captura")
+    ap.add_argument("--baud", type=int, default=115200)
+    args = ap.parse_args()
+
+    trace = TraceDecoder(Elf(args.elf), sys.stdout)
+    parser = FrameParser(trace.frame,
+                         lambda t: sys.stderr.write(t.decode("latin-1")))
+
+    src = open_source(args.source, args.baud)
+    try:
+        while True:
+            data = src.read(4096)
+            if not data:
+                if hasattr(src, "in_waiting"):
+                    continue
+                break
+            parser.feed(data)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sys.stdout.flush()
+        sys.stderr.write("# %d registros, %d perdidos, %d quadros com crc invalido\n"
+                         % (trace.count, trace.lost, parser.bad_crc))
+
+
+if __name__ == "__main__":
+    main()